@@ -41,12 +41,15 @@ RTTI_DEF2(ossimEsriShapeFileFilter,
 
 static const ossimTrace traceDebug("ossimEsriShapeFileFilter:debug");
 
+static const char LAZY_LOAD_KW[] = "lazy_load";
+
 ossimEsriShapeFileFilter::ossimEsriShapeFileFilter(ossimImageSource* inputSource)
    :ossimAnnotationSource(inputSource),
     ossimViewInterface(),
     theCoordinateSystem(OSSIM_GEOGRAPHIC_SPACE),
     theUnitType(OSSIM_METERS),
     theTree((SHPTree*)0),
+    theLazyLoadFlag(true),
     theMaxQuadTreeLevels(10),
     thePenColor(255,255,255),
     theBrushColor(255,255,255),
@@ -126,6 +129,24 @@ bool ossimEsriShapeFileFilter::addObject(ossimAnnotationObject* /*anObject*/)
 void ossimEsriShapeFileFilter::computeBoundingRect()
 {
 //   ossimAnnotationSource::computeBoundingRect();
+
+   if(theMappedShapeFile.isOpen())
+   {
+      // Shapes are not all loaded; use the file bounds.
+      theBoundingRect.makeNan();
+      if(theImageGeometry.valid())
+      {
+         double minX, minY, maxX, maxY;
+         theMappedShapeFile.getBounds(minX, minY, maxX, maxY);
+         ossimDpt p1, p2, p3, p4;
+         theImageGeometry->worldToLocal(ossimGpt(maxY, minX), p1);
+         theImageGeometry->worldToLocal(ossimGpt(maxY, maxX), p2);
+         theImageGeometry->worldToLocal(ossimGpt(minY, maxX), p3);
+         theImageGeometry->worldToLocal(ossimGpt(minY, minX), p4);
+         theBoundingRect = ossimDrect(p1, p2, p3, p4);
+      }
+      return;
+   }
    
    std::multimap<int, ossimAnnotationObject*>::iterator iter = theShapeCache.begin();
    
@@ -170,7 +191,8 @@ void ossimEsriShapeFileFilter::drawAnnotations(ossimRefPtr<ossimImageData> tile)
 {
    ossimAnnotationSource::drawAnnotations(tile);
    
-   if (!theTree||!theShapeFile.isOpen()) return;
+   const bool lazy = theMappedShapeFile.isOpen();
+   if (!lazy && (!theTree||!theShapeFile.isOpen())) return;
    if(theImageGeometry.valid())
    {
       ossimIrect rect = tile->getImageRectangle();
@@ -212,28 +234,87 @@ void ossimEsriShapeFileFilter::drawAnnotations(ossimRefPtr<ossimImageData> tile)
       boundsMax[0] = boundsRect.lr().x;
       boundsMax[1] = boundsRect.ul().y;
 
-      int n;
-      int *array=(int*)0;
+      std::vector<ossim_int32> ids;
+      
+      if(lazy)
+      {
+         // Polygons are stretched by the border after loading so widen the search.
+         theMappedShapeFile.findShapes(boundsMin[0] - theBorderSize,
+                                       boundsMin[1] - theBorderSize,
+                                       boundsMax[0] + theBorderSize,
+                                       boundsMax[1] + theBorderSize,
+                                       ids);
+         for(ossim_uint32 i = 0; i < ids.size(); ++i)
+         {
+            loadRecord(ids[i]);
+         }
+      }
+      else
+      {
+         int n;
+         int *array=(int*)0;
       
-      array = SHPTreeFindLikelyShapes(theTree,
-                                      boundsMin,
-                                      boundsMax,
-                                      &n);
+         array = SHPTreeFindLikelyShapes(theTree,
+                                         boundsMin,
+                                         boundsMax,
+                                         &n);
+         if(n&&array)
+         {
+            ids.assign(array, array+n);
+         }
+         if(array)
+         {
+            free(array);
+         }
+      }
       
       theImage->setCurrentImageData(tile);
-      if(n&&array)
+      for(ossim_uint32 i = 0; i < ids.size(); ++i)
       {
-         for(int i = 0; i < n; ++i)
+         std::pair<std::multimap<int, ossimAnnotationObject*>::iterator,
+                   std::multimap<int, ossimAnnotationObject*>::iterator> range =
+            theShapeCache.equal_range(ids[i]);
+         for(std::multimap<int, ossimAnnotationObject*>::iterator iter = range.first;
+             iter != range.second; ++iter)
          {
-            std::multimap<int, ossimAnnotationObject*>::iterator iter = theShapeCache.find(array[i]);
-            while( ((*iter).first == array[i]) && (iter != theShapeCache.end()) )
-            {
-               (*iter).second->draw(*theImage);
-               ++iter;
-            }
+            (*iter).second->draw(*theImage);
+         }
+      }
+   }
+}
+
+void ossimEsriShapeFileFilter::loadRecord(ossim_int32 record)
+{
+   if((record < 0) || (record >= (ossim_int32)theLoadedFlags.size()) ||
+      theLoadedFlags[record])
+   {
+      return;
+   }
+   theLoadedFlags[record] = true;
+
+   ossimShapeObject obj;
+   obj.setShape(theMappedShapeFile.readObject(record));
+   if(!obj.isLoaded())
+   {
+      return;
+   }
+
+   loadObject(obj);
+
+   if(theImageGeometry.valid())
+   {
+      std::pair<std::multimap<int, ossimAnnotationObject*>::iterator,
+                std::multimap<int, ossimAnnotationObject*>::iterator> range =
+         theShapeCache.equal_range(obj.getId());
+      for(std::multimap<int, ossimAnnotationObject*>::iterator iter = range.first;
+          iter != range.second; ++iter)
+      {
+         ossimGeoAnnotationObject* geoObj = PTR_CAST(ossimGeoAnnotationObject,
+                                                     (*iter).second);
+         if(geoObj)
+         {
+            geoObj->transform(theImageGeometry.get());
          }
-         
-         free(array);
       }
    }
 }
@@ -325,9 +406,35 @@ bool ossimEsriShapeFileFilter::loadShapeFile(const ossimFilename& shapeFile)
       SHPDestroyTree(theTree);
       theTree = (SHPTree*)0;
    }
-   theShapeFile.open(shapeFile);
+   theMappedShapeFile.close();
+   theShapeFile.close();
+   theLoadedFlags.clear();
    deleteCache();
    deleteAll();
+
+   if(theLazyLoadFlag && theMappedShapeFile.open(shapeFile, theMaxQuadTreeLevels))
+   {
+      //---
+      // Nothing is decoded here.  drawAnnotations asks the mapped file for the
+      // shapes under each tile and loads them on first use.
+      //---
+      theMappedShapeFile.getBounds(theMinArray[0], theMinArray[1],
+                                   theMaxArray[0], theMaxArray[1]);
+      theLoadedFlags.resize(theMappedShapeFile.getNumberOfShapes(), false);
+      
+      theCurrentObject = theShapeCache.begin();
+      if(theImageGeometry.valid())
+      {
+         transformObjects();
+      }
+      else
+      {
+         checkAndSetDefaultView();
+      }
+      return true;
+   }
+
+   theShapeFile.open(shapeFile);
    
    if(theShapeFile.isOpen())
    {
@@ -348,39 +455,7 @@ bool ossimEsriShapeFileFilter::loadShapeFile(const ossimFilename& shapeFile)
          
          if(obj.isLoaded())
          {
-            switch(obj.getType())
-            {
-               case SHPT_POLYGON:
-               case SHPT_POLYGONZ:
-               {
-                  loadPolygon(obj);
-                  break;
-               }
-               case SHPT_POINT:
-               case SHPT_POINTZ:
-               {
-                  loadPoint(obj);
-                  break;
-               }
-               case SHPT_ARC:
-               case SHPT_ARCZ:
-               {
-                  loadArc(obj);
-                  break;
-               }
-               case SHPT_NULL:
-               {
-                  break;
-               }
-               default:
-               {
-                  ossimNotify(ossimNotifyLevel_WARN)
-                     << "ossimEsriShapeFileFilter::loadShapeFile\n"
-                     << "SHAPE " << obj.getTypeByName()
-                     << " Not supported" <<  endl;
-                  break;
-               }
-            }
+            loadObject(obj);
          }
       }
       
@@ -398,6 +473,43 @@ bool ossimEsriShapeFileFilter::loadShapeFile(const ossimFilename& shapeFile)
    return true;
 }
 
+void ossimEsriShapeFileFilter::loadObject(ossimShapeObject& obj)
+{
+   switch(obj.getType())
+   {
+      case SHPT_POLYGON:
+      case SHPT_POLYGONZ:
+      {
+         loadPolygon(obj);
+         break;
+      }
+      case SHPT_POINT:
+      case SHPT_POINTZ:
+      {
+         loadPoint(obj);
+         break;
+      }
+      case SHPT_ARC:
+      case SHPT_ARCZ:
+      {
+         loadArc(obj);
+         break;
+      }
+      case SHPT_NULL:
+      {
+         break;
+      }
+      default:
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "ossimEsriShapeFileFilter::loadShapeFile\n"
+            << "SHAPE " << obj.getTypeByName()
+            << " Not supported" <<  endl;
+         break;
+      }
+   }
+}
+
 void ossimEsriShapeFileFilter::loadPolygon(ossimShapeObject& obj)
 {
    int starti = 0;
@@ -592,6 +704,11 @@ bool ossimEsriShapeFileFilter::saveState(ossimKeywordlist& kwl,
            theMaxQuadTreeLevels,
            true);
 
+   kwl.add(prefix,
+           LAZY_LOAD_KW,
+           (int)theLazyLoadFlag,
+           true);
+
    s = ossimString::toString((int)thePenColor.getR()) + " " +
        ossimString::toString((int)thePenColor.getG()) + " " +
        ossimString::toString((int)thePenColor.getB());
@@ -664,6 +781,7 @@ bool ossimEsriShapeFileFilter::loadState(const ossimKeywordlist& kwl,
    const char* thickness   = kwl.find(prefix, ossimKeywordNames::THICKNESS_KW);
    const char* pointWh     = kwl.find(prefix, ossimKeywordNames::POINT_WIDTH_HEIGHT_KW);
    const char* border_size = kwl.find(prefix, ossimKeywordNames::BORDER_SIZE_KW);
+   const char* lazyLoad    = kwl.find(prefix, LAZY_LOAD_KW);
    
    deleteCache();
 
@@ -704,6 +822,11 @@ bool ossimEsriShapeFileFilter::loadState(const ossimKeywordlist& kwl,
       theFillFlag = ossimString(fillFlag).toBool();
    }
 
+   if(lazyLoad)
+   {
+      theLazyLoadFlag = ossimString(lazyLoad).toBool();
+   }
+
    if(border_size)
    {
       istringstream input(border_size);
@@ -15,6 +15,8 @@
 #include <map>
 #include <shapefil.h>
 #include <ossimShapeFile.h>
+#include <ossimMappedShapeFile.h>
+#include <vector>
 #include <ossim/imaging/ossimAnnotationSource.h>
 #include <ossim/base/ossimRtti.h>
 #include <ossim/base/ossimViewInterface.h>
@@ -65,6 +67,11 @@ class ossimProjection;
  *
  *   filename:               // The esri shape file to be used
  *
+ *   lazy_load:              // 1 for true 0 for false.  Default is true.
+ *                           // Memory maps the shape file and only decodes
+ *                           // shapes that intersect a requested tile.  A .qix
+ *                           // index next to the .shp is used if present.
+ *
  * example Keyword list:  See ossimAnnotationSource for any additional keywords
  *
  *
@@ -72,6 +79,7 @@ class ossimProjection;
  * feature_name:
  * filename:
  * fill_flag:  0
+ * lazy_load:  1
  * max_quadtree_levels:  10
  * pen_color:  255 255 255
  * point_width_height:  1 1
@@ -114,8 +122,27 @@ public:
 
    virtual ossimFilename getFilename()const
       {
+         if(theMappedShapeFile.isOpen())
+         {
+            return theMappedShapeFile.getFilename();
+         }
          return theShapeFile.getFilename();
       }
+
+   virtual bool getLazyLoadFlag()const
+      {
+         return theLazyLoadFlag;
+      }
+
+   /*!
+    * If true (default) loadShapeFile memory maps the file and shapes are
+    * decoded as tiles that touch them are drawn.  Takes effect on the next
+    * loadShapeFile.
+    */
+   virtual void setLazyLoadFlag(bool flag)
+      {
+         theLazyLoadFlag = flag;
+      }
    virtual ossim_int32 getMaxQuadTreeLevels()const
       {
          return theMaxQuadTreeLevels;
@@ -239,6 +266,14 @@ protected:
 
    ossimShapeFile            theShapeFile;
 
+   /*!
+    * Used instead of theTree/theShapeFile when theLazyLoadFlag is set.
+    * theLoadedFlags marks records already decoded into theShapeCache.
+    */
+   ossimMappedShapeFile      theMappedShapeFile;
+   std::vector<bool>         theLoadedFlags;
+   bool                      theLazyLoadFlag;
+
    double                    theMinArray[4];
    double                    theMaxArray[4];
 
@@ -261,6 +296,17 @@ protected:
    void deleteCache();
    void checkAndSetDefaultView();
 
+   /*!
+    * Adds the annotation objects for one shape to theShapeCache.
+    */
+   virtual void loadObject(ossimShapeObject& obj);
+
+   /*!
+    * Decodes record from theMappedShapeFile if not already loaded and
+    * transforms its objects to the current view.
+    */
+   void loadRecord(ossim_int32 record);
+
    virtual void loadPolygon(ossimShapeObject& obj);
    virtual void loadPoint(ossimShapeObject& obj);
    virtual void loadArc(ossimShapeObject& obj);
@@ -16,6 +16,8 @@
 #include <ossim/base/ossimTrace.h>
 #include <ossim/imaging/ossimImageHandler.h>
 #include <ossim/imaging/ossimImageHandlerRegistry.h>
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
 static GDALDriver *poOssimGdalDriver = 0;
@@ -32,7 +34,10 @@ static const char OSSIM_ID[] = "$Id: ossimGdalDataset.cpp 23003 2014-11-24 17:13
 #endif
 
 ossimGdalDataset::ossimGdalDataset()
-   : theImageHandler(0)
+   : theImageHandler(0),
+     theWindow(0),
+     theWindowResLevel(0),
+     theWindowMutex()
 {
    if (!poOssimGdalDriver)
    {
@@ -126,6 +131,7 @@ void ossimGdalDataset::setImageHandler(ossimImageHandler* ih)
    }
 
    theImageHandler = ih;
+   theWindow = 0;
    init();
 }
 
@@ -181,11 +187,35 @@ void ossimGdalDataset::setGdalAcces(GDALAccess access)
    eAccess = access;
 }
 
+ossimRefPtr<ossimImageData> ossimGdalDataset::getWindow(const ossimIrect& rect,
+                                                        ossim_uint32 resLevel)
+{
+   std::lock_guard<std::mutex> lock(theWindowMutex);
+
+   if ( !theWindow.valid() || (theWindowResLevel != resLevel) ||
+        (theWindow->getImageRectangle() != rect) )
+   {
+      theWindow = 0;
+      ossimRefPtr<ossimImageData> id = theImageHandler->getTile(rect, resLevel);
+      if ( id.valid() )
+      {
+         // Handler reuses its tile so keep a copy.
+         theWindow = static_cast<ossimImageData*>( id->dup() );
+         theWindowResLevel = resLevel;
+      }
+   }
+
+   return theWindow;
+}
+
 ossimGdalDatasetRasterBand::ossimGdalDatasetRasterBand(ossimGdalDataset* ds,
                                                        int band,
-                                                       ossimImageHandler* ih)
+                                                       ossimImageHandler* ih,
+                                                       ossim_uint32 resLevel)
    : GDALPamRasterBand(),
-     theImageHandler(ih)
+     theImageHandler(ih),
+     theResLevel(resLevel),
+     theOverviews()
 
 {
    if (traceDebug())
@@ -203,8 +233,8 @@ ossimGdalDatasetRasterBand::ossimGdalDatasetRasterBand(ossimGdalDataset* ds,
    poDS     = ds;
    nBand    = band;
 
-   nRasterXSize     = theImageHandler->getImageRectangle(0).width();
-   nRasterYSize     = theImageHandler->getImageRectangle(0).height();
+   nRasterXSize     = theImageHandler->getImageRectangle(theResLevel).width();
+   nRasterYSize     = theImageHandler->getImageRectangle(theResLevel).height();
    
    // eAccess  = GA_ReadOnly;
    eAccess  = GA_Update;
@@ -226,10 +256,160 @@ ossimGdalDatasetRasterBand::ossimGdalDatasetRasterBand(ossimGdalDataset* ds,
 
    nBlockReads = 0;
    bForceCachedIO = false;
+
+   if ( theResLevel == 0 )
+   {
+      ossim_uint32 levels = theImageHandler->getNumberOfDecimationLevels();
+      for ( ossim_uint32 level = 1; level < levels; ++level )
+      {
+         theOverviews.push_back(
+            new ossimGdalDatasetRasterBand( ds, band, theImageHandler.get(), level ) );
+      }
+   }
 }
 
 ossimGdalDatasetRasterBand::~ossimGdalDatasetRasterBand()
 {
+   for ( std::vector<ossimGdalDatasetRasterBand*>::iterator i = theOverviews.begin();
+         i != theOverviews.end(); ++i )
+   {
+      delete *i;
+   }
+   theOverviews.clear();
+}
+
+int ossimGdalDatasetRasterBand::GetOverviewCount()
+{
+   if ( theOverviews.size() )
+   {
+      return static_cast<int>( theOverviews.size() );
+   }
+   return GDALPamRasterBand::GetOverviewCount();
+}
+
+GDALRasterBand* ossimGdalDatasetRasterBand::GetOverview( int i )
+{
+   if ( theOverviews.size() )
+   {
+      if ( (i >= 0) && (i < static_cast<int>(theOverviews.size())) )
+      {
+         return theOverviews[i];
+      }
+      return 0;
+   }
+   return GDALPamRasterBand::GetOverview( i );
+}
+
+ossim_uint32 ossimGdalDatasetRasterBand::getBestResLevel( int xSize, int ySize,
+                                                          int bufXSize, int bufYSize ) const
+{
+   ossim_uint32 result = 0;
+
+   // Reduction the caller asked for; pick the coarsest level that does not exceed it.
+   const double requested = std::min( static_cast<double>(xSize) / bufXSize,
+                                      static_cast<double>(ySize) / bufYSize );
+
+   const ossim_uint32 levels = theImageHandler->getNumberOfDecimationLevels();
+   for ( ossim_uint32 level = 1; level < levels; ++level )
+   {
+      ossimDpt decimation;
+      theImageHandler->getDecimationFactor( level, decimation );
+      if ( decimation.hasNans() || (decimation.x <= 0.0) ||
+           (1.0 / decimation.x > requested) )
+      {
+         break;
+      }
+      result = level;
+   }
+
+   return result;
+}
+
+CPLErr ossimGdalDatasetRasterBand::IRasterIO( GDALRWFlag eRWFlag,
+                                              int nXOff, int nYOff, int nXSize, int nYSize,
+                                              void* pData, int nBufXSize, int nBufYSize,
+                                              GDALDataType eBufType,
+                                              GSpacing nPixelSpace, GSpacing nLineSpace,
+                                              GDALRasterIOExtraArg* psExtraArg )
+{
+   ossimGdalDataset* ds = dynamic_cast<ossimGdalDataset*>( poDS );
+
+   if ( (eRWFlag != GF_Read) || (theResLevel != 0) || !ds || !theImageHandler.valid() ||
+        ( (nBufXSize >= nXSize) && (nBufYSize >= nYSize) ) ||
+        ( psExtraArg && (psExtraArg->eResampleAlg != GRIORA_NearestNeighbour) ) )
+   {
+      return GDALPamRasterBand::IRasterIO( eRWFlag, nXOff, nYOff, nXSize, nYSize,
+                                           pData, nBufXSize, nBufYSize, eBufType,
+                                           nPixelSpace, nLineSpace, psExtraArg );
+   }
+
+   const ossim_uint32 level = getBestResLevel( nXSize, nYSize, nBufXSize, nBufYSize );
+
+   ossimDpt decimation(1.0, 1.0);
+   if ( level )
+   {
+      theImageHandler->getDecimationFactor( level, decimation );
+   }
+
+   // Window in level space.
+   ossimIrect levelRect(
+      static_cast<ossim_int32>( std::floor( nXOff * decimation.x ) ),
+      static_cast<ossim_int32>( std::floor( nYOff * decimation.y ) ),
+      static_cast<ossim_int32>( std::ceil( (nXOff + nXSize) * decimation.x ) ) - 1,
+      static_cast<ossim_int32>( std::ceil( (nYOff + nYSize) * decimation.y ) ) - 1 );
+
+   ossimRefPtr<ossimImageData> id = ds->getWindow( levelRect, level );
+
+   GByte* dst = static_cast<GByte*>( pData );
+
+   if ( !id.valid() || !id->getBuf() || (id->getDataObjectStatus() == OSSIM_EMPTY) )
+   {
+      // Fill with the band's null so non-zero null data doesn't come back as 0.
+      double nullPix = theImageHandler->getNullPixelValue( nBand-1 );
+      for ( int line = 0; line < nBufYSize; ++line )
+      {
+         GDALCopyWords( &nullPix, GDT_Float64, 0,
+                        dst + line * nLineSpace, eBufType,
+                        static_cast<int>(nPixelSpace), nBufXSize );
+      }
+      return CE_None;
+   }
+
+   const int BPP     = static_cast<int>( id->getScalarSizeInBytes() );
+   const int W       = static_cast<int>( id->getWidth() );
+   const int H       = static_cast<int>( id->getHeight() );
+   const GByte* band = static_cast<const GByte*>( id->getBuf(nBand-1) );
+
+   // Nearest neighbor sample positions into the level window.
+   std::vector<int> xIdx( nBufXSize );
+   const double xStep = static_cast<double>(nXSize) / nBufXSize;
+   for ( int i = 0; i < nBufXSize; ++i )
+   {
+      int x = static_cast<int>( std::floor( (nXOff + (i + 0.5) * xStep) * decimation.x ) )
+         - levelRect.ul().x;
+      xIdx[i] = std::max( 0, std::min( W - 1, x ) );
+   }
+
+   std::vector<GByte> row( nBufXSize * BPP );
+   const double yStep = static_cast<double>(nYSize) / nBufYSize;
+   for ( int j = 0; j < nBufYSize; ++j )
+   {
+      int y = static_cast<int>( std::floor( (nYOff + (j + 0.5) * yStep) * decimation.y ) )
+         - levelRect.ul().y;
+      y = std::max( 0, std::min( H - 1, y ) );
+
+      const GByte* srcLine = band + static_cast<std::size_t>(y) * W * BPP;
+      for ( int i = 0; i < nBufXSize; ++i )
+      {
+         memcpy( &row[i * BPP], srcLine + xIdx[i] * BPP, BPP );
+      }
+
+      GDALCopyWords( &row.front(), eDataType, BPP,
+                     dst + j * nLineSpace, eBufType,
+                     static_cast<int>(nPixelSpace), nBufXSize );
+   }
+
+   return CE_None;
 }
 
 CPLErr ossimGdalDatasetRasterBand::IReadBlock(int nBlockXOff,
@@ -248,7 +428,7 @@ CPLErr ossimGdalDatasetRasterBand::IReadBlock(int nBlockXOff,
                    startPt.y+nBlockYSize-1);
    ossimIrect rect( startPt, endPt);
 
-   ossimRefPtr<ossimImageData> id = theImageHandler->getTile(rect, 0);
+   ossimRefPtr<ossimImageData> id = theImageHandler->getTile(rect, theResLevel);
    
    if (id.valid())
    {
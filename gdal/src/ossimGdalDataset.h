@@ -16,6 +16,9 @@
 #include <cpl_string.h>
 #include <ossim/base/ossimRefPtr.h>
 #include <ossim/imaging/ossimImageHandler.h>
+#include <ossim/imaging/ossimImageData.h>
+#include <mutex>
+#include <vector>
 
 class ossimGdalDatasetRasterBand;
 class ossimFilename;
@@ -79,10 +82,21 @@ private:
     * Initializes this object from the image handler.
     */
    void init();
+
+   /**
+    * @brief Gets rect at resLevel from the image handler.  The tile is kept
+    * so the other bands reading the same window do not hit the handler again.
+    */
+   ossimRefPtr<ossimImageData> getWindow(const ossimIrect& rect, ossim_uint32 resLevel);
    
    friend class ossimGdalDatasetRasterBand;
 
    ossimRefPtr<ossimImageHandler>  theImageHandler;
+
+   /** Last window read by ossimGdalDatasetRasterBand::IRasterIO. */
+   ossimRefPtr<ossimImageData>     theWindow;
+   ossim_uint32                    theWindowResLevel;
+   std::mutex                      theWindowMutex;
 };
 
 /**
@@ -100,10 +114,14 @@ public:
     * @param ds The parent data set.
     * @param band The "ONE" based band.
     * @param ih The pointer to the image handler.
+    * @param resLevel Reduced resolution level this band reads.  Level 0
+    * bands create a band for each of the handler's reduced resolution levels
+    * and expose them as gdal overviews.
     */
    ossimGdalDatasetRasterBand( ossimGdalDataset* ds,
                                int band,
-                               ossimImageHandler* ih);
+                               ossimImageHandler* ih,
+                               ossim_uint32 resLevel = 0 );
 
    /** virtual destructor */
    virtual ~ossimGdalDatasetRasterBand();
@@ -113,6 +131,15 @@ public:
     * serious is to be done with this data set with the gdal library.
     */
    virtual double GetNoDataValue( int *pbSuccess = 0 );
+
+   /**
+    * @return Number of image handler reduced resolution levels below full
+    * resolution, or gdal's external overview count if the handler has none.
+    */
+   virtual int GetOverviewCount();
+
+   /** @return Band for image handler reduced resolution level i+1. */
+   virtual GDALRasterBand* GetOverview( int i );
    
 protected:
 
@@ -134,8 +161,34 @@ protected:
                              int nBlockYOff,
                              void* pImage);
 
+   /**
+    * @brief Raster io override.
+    *
+    * Downsampled nearest neighbor reads are filled from a single getTile on
+    * the coarsest reduced resolution level that still has at least the
+    * buffer's resolution.  All other requests go to the default
+    * implementation.
+    */
+   virtual CPLErr IRasterIO( GDALRWFlag eRWFlag,
+                             int nXOff, int nYOff, int nXSize, int nYSize,
+                             void* pData, int nBufXSize, int nBufYSize,
+                             GDALDataType eBufType,
+                             GSpacing nPixelSpace, GSpacing nLineSpace,
+                             GDALRasterIOExtraArg* psExtraArg );
+
 private:
+
+   /**
+    * @return Best reduced resolution level for reading a window of
+    * xSize x ySize into a bufXSize x bufYSize buffer.
+    */
+   ossim_uint32 getBestResLevel( int xSize, int ySize, int bufXSize, int bufYSize ) const;
+
    ossimRefPtr<ossimImageHandler> theImageHandler;
+   ossim_uint32 theResLevel;
+
+   /** Bands for reduced resolution levels 1 to n (owned). */
+   std::vector<ossimGdalDatasetRasterBand*> theOverviews;
 };
 
 #endif /* End of "#ifndef ossimGdalDataset_HEADER" */
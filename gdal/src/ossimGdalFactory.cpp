@@ -22,10 +22,66 @@
 #include <ossim/base/ossimKeywordNames.h>
 
 #include <gdal.h>
+#include <gdal_priv.h>
 #include <ogrsf_frmts.h>
 
+#include <map>
+#include <mutex>
+#include <string>
+
 static const ossimTrace traceDebug("ossimGdalFactory:debug");
 
+namespace
+{
+   // Extension to driver short name of the last successful identify.
+   std::mutex extDriverMutex;
+   std::map<std::string, std::string> extDriverMap;
+
+   //---
+   // Finds the driver for an existing file without opening it.  GDAL reads
+   // the file header once and hands it to each driver's Identify.  The
+   // driver last seen for the extension is asked first on its own so scans
+   // of like files skip probing the whole driver list.  It is only trusted
+   // on a positive Identify; "unknown" or a driver without Identify would
+   // let GDAL try opening with it and a file of another format with this
+   // extension could land on the wrong driver.
+   //---
+   GDALDriverH identifyDriver( const ossimFilename& file )
+   {
+      const std::string ext = file.ext().downcase().string();
+      std::string cached;
+      {
+         std::lock_guard<std::mutex> lock( extDriverMutex );
+         std::map<std::string, std::string>::const_iterator i = extDriverMap.find( ext );
+         if ( i != extDriverMap.end() )
+         {
+            cached = i->second;
+         }
+      }
+
+      if ( cached.size() )
+      {
+         GDALDriver* driver = (GDALDriver*)GDALGetDriverByName( cached.c_str() );
+         if ( driver && driver->pfnIdentify )
+         {
+            GDALOpenInfo openInfo( file.c_str(), GA_ReadOnly );
+            if ( driver->pfnIdentify( &openInfo ) > 0 )
+            {
+               return (GDALDriverH)driver;
+            }
+         }
+      }
+
+      GDALDriverH driver = GDALIdentifyDriver( file.c_str(), 0 );
+      if ( driver && ext.size() )
+      {
+         std::lock_guard<std::mutex> lock( extDriverMutex );
+         extDriverMap[ext] = GDALGetDriverShortName( driver );
+      }
+      return driver;
+   }
+}
+
 RTTI_DEF1(ossimGdalFactory, "ossimGdalFactory", ossimImageHandlerFactoryBase);
 
 ossimGdalFactory* ossimGdalFactory::theInstance = 0;
@@ -69,6 +125,77 @@ ossimImageHandler* ossimGdalFactory::open(const ossimFilename& fileName,
    
    ossimRefPtr<ossimImageHandler> result;
 
+   //---
+   // Files on disk are identified up front so only the handler that can
+   // succeed is tried, with GDAL restricted to the identified driver.
+   // Subdataset names, connection strings and the like fall through to
+   // trying each handler in turn.
+   //---
+   if ( fileName.exists() )
+   {
+      GDALDriverH driver = identifyDriver( fileName );
+      if ( !driver )
+      {
+         if (traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG)
+               << "ossimGdalFactory::open(filename) DEBUG:"
+               << "\nno gdal driver identifies " << fileName << std::endl;
+         }
+         return 0;
+      }
+
+      const ossimString driverName = GDALGetDriverShortName( driver );
+      const bool isRaster = GDALGetMetadataItem( driver, GDAL_DCAP_RASTER, 0 ) != 0;
+      const bool isVector = GDALGetMetadataItem( driver, GDAL_DCAP_VECTOR, 0 ) != 0;
+
+      if (traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimGdalFactory::open(filename) DEBUG:"
+            << "\nidentified driver: " << driverName << std::endl;
+      }
+
+      if ( isRaster )
+      {
+         // Returns quickly on extension if not hdf.
+         result = new ossimHdfReader;
+         result->setOpenOverviewFlag(openOverview);
+         if(result->open(fileName))
+         {
+            return result.release();
+         }
+
+         ossimRefPtr<ossimGdalTileSource> gdalSource = new ossimGdalTileSource;
+         std::vector<ossimString> allowedDrivers(1, driverName);
+         gdalSource->setAllowedDrivers( allowedDrivers );
+         gdalSource->setOpenOverviewFlag(openOverview);
+         if ( gdalSource->open(fileName) )
+         {
+            return gdalSource.release();
+         }
+      }
+
+      if ( isVector )
+      {
+         // No need to set overview flag.
+         if ( fileName.ext().downcase() == "mdb" )
+         {
+            result = new ossimOgrVectorTileSource;
+         }
+         else
+         {
+            result = new ossimOgrGdalTileSource;
+         }
+         if(result->open(fileName))
+         {
+            return result.release();
+         }
+      }
+
+      return 0;
+   }
+
    //try hdf reader first
    if (traceDebug())
    {
@@ -20,6 +20,7 @@
 #include <ossim/base/ossimString.h>
 #include <ossim/base/ossimTrace.h>
 #include <ossim/elevation/ossimImageElevationHandler.h>
+#include <algorithm>
 #include <cmath>
 #include "ogrsf_frmts.h"
 
@@ -34,8 +35,7 @@ ossimGdalImageElevationDatabase::ossimGdalImageElevationDatabase()
    :
    ossimElevationCellDatabase(),
    m_poDataSet(NULL),
-   m_lastMapKey(0),
-   m_lastAccessedId(0)
+   m_cacheRwMutex()
 {
 }
 
@@ -123,20 +123,93 @@ double ossimGdalImageElevationDatabase::getHeightAboveEllipsoid(const ossimGpt&
    return h;
 }
 
+void ossimGdalImageElevationDatabase::getHeightsAboveMSL(const std::vector<ossimGpt>& gpts,
+                                                         std::vector<double>& heights)
+{
+   const std::size_t N = gpts.size();
+   heights.assign(N, ossim::nan());
+
+   if ( !N || !isSourceEnabled() )
+   {
+      return;
+   }
+
+   // Bucket the points by covering cell.  Points without coverage stay nan.
+   const ossimShpElevIndex* index = ossimShpElevIndex::getInstance(m_connectionString);
+   std::vector< std::pair<ossim_int64, ossim_uint32> > order;
+   order.reserve(N);
+   for ( ossim_uint32 i = 0; i < N; ++i )
+   {
+      ossim_int64 cellId = index->searchCell(gpts[i].lond(), gpts[i].latd());
+      if ( cellId >= 0 )
+      {
+         order.push_back( std::make_pair(cellId, i) );
+      }
+   }
+
+   // Sorting by (cell, input index) keeps each bucket in input order for locality.
+   std::sort(order.begin(), order.end());
+
+   std::size_t i = 0;
+   while ( i < order.size() )
+   {
+      const ossim_int64 cellId = order[i].first;
+
+      // One cache lookup/lock per bucket rather than per point.
+      ossimRefPtr<ossimElevCellHandler> handler = getOrCreateCellHandler(cellId);
+      if ( handler.valid() )
+      {
+         for ( ; (i < order.size()) && (order[i].first == cellId); ++i )
+         {
+            heights[order[i].second] = handler->getHeightAboveMSL(gpts[order[i].second]);
+         }
+         m_meanSpacing = handler->getMeanSpacingMeters();
+      }
+      else
+      {
+         while ( (i < order.size()) && (order[i].first == cellId) )
+         {
+            ++i;
+         }
+      }
+   }
+}
+
+void ossimGdalImageElevationDatabase::getHeightsAboveEllipsoid(const std::vector<ossimGpt>& gpts,
+                                                               std::vector<double>& heights)
+{
+   getHeightsAboveMSL(gpts, heights);
+
+   for ( std::size_t i = 0; i < heights.size(); ++i )
+   {
+      if ( !ossim::isnan(heights[i]) )
+      {
+         heights[i] += getOffsetFromEllipsoid(gpts[i]);
+      }
+   }
+}
+
 ossimRefPtr<ossimElevCellHandler> ossimGdalImageElevationDatabase::createCell(const ossimGpt& gpt)
 {
-   // cout << "********************" << std::endl;
-   // cout << "Searching for point " << gpt << std::endl;
-   // cout << searchShapefile(gpt.lond(), gpt.latd()) << std::endl;
-   // cout << "********************" << std::endl;
+   ossimRefPtr<ossimElevCellHandler> result = 0;
+
+   ossim_int64 cellId = ossimShpElevIndex::getInstance(m_connectionString)->searchCell(gpt.lond(), gpt.latd());
+   if ( cellId >= 0 )
+   {
+      result = createCell(cellId);
+   }
 
+   return result;
+}
+
+ossimRefPtr<ossimElevCellHandler> ossimGdalImageElevationDatabase::createCell(ossim_int64 cellId)
+{
    ossimRefPtr<ossimElevCellHandler> result = 0;
    
    // Need to disable elevation while loading the DEM image to prevent recursion:
    disableSource();
 
-   //std:string filename = searchShapefile(gpt.lond(), gpt.latd());
-   std:string filename = ossimShpElevIndex::getInstance(m_connectionString)->searchShapefile(gpt.lond(), gpt.latd());
+   std::string filename = ossimShpElevIndex::getInstance(m_connectionString)->getFilename(cellId);
 
    if ( filename.size() > 1 )  
    {
@@ -165,82 +238,69 @@ ossimRefPtr<ossimElevCellHandler> ossimGdalImageElevationDatabase::getOrCreateCe
    const ossimGpt& gpt)
 {
    ossimRefPtr<ossimElevCellHandler> result = 0;
-   
-   // Note: Must do mutex lock / unlock around any cach map access.
-   m_cacheMapMutex.lock();
 
-   if ( m_cacheMap.size() )
+   ossim_int64 cellId = ossimShpElevIndex::getInstance(m_connectionString)->searchCell(
+      gpt.lond(), gpt.latd());
+   if ( cellId >= 0 )
    {
-      //---
-      // Look in existing map for handler.
-      //
-      // Note: Cannot key off of id from gpt as cells can be any arbituary dimensions.
-      //---
-
-      CellMap::iterator lastAccessedCellIter = m_cacheMap.find(m_lastAccessedId);
-      CellMap::iterator iter = lastAccessedCellIter;
-        
-      // Check from last accessed to end.
-      while ( iter != m_cacheMap.end() )
-      {
-         if ( iter->second->m_handler->pointHasCoverage(gpt) )
-         {
-            result = iter->second->m_handler.get();
-            break;
-         }
-         ++iter;
-      }
-     
-      if ( result.valid() == false )
-      {
-         iter = m_cacheMap.begin();
-              
-         // Beginning to last accessed.
-         while ( iter != lastAccessedCellIter)
-         {
-            if ( iter->second->m_handler->pointHasCoverage(gpt) )
-            {
-               result = iter->second->m_handler.get();
-               break;
-            }
-            ++iter;
-         }
-      }
+      result = getOrCreateCellHandler(cellId);
+   }
+
+   return result;
+}
 
-      if ( result.valid() )
+ossimRefPtr<ossimElevCellHandler> ossimGdalImageElevationDatabase::getOrCreateCellHandler(
+   ossim_int64 cellId)
+{
+   ossimRefPtr<ossimElevCellHandler> result = 0;
+
+   //---
+   // The footprint index maps a point to a cell id in constant time.  The cell id is
+   // used as the m_cacheMap key so a cached handler is found with a map lookup instead of
+   // testing every cached handler for coverage.
+   //---
+   {
+      // Shared lock; any number of height lookups can search the cache at once.
+      ossimRwMutex::ReadLock lock(m_cacheRwMutex);
+
+      CellMap::iterator iter = m_cacheMap.find(static_cast<ossim_uint64>(cellId));
+      if ( iter != m_cacheMap.end() )
       {
-         m_lastAccessedId  = iter->second->m_id;
+         result = iter->second->m_handler.get();
+
+         // Readers share the lock; the timestamp write is serialized.
+         std::lock_guard<std::mutex> mapLock(m_cacheMapMutex);
          iter->second->updateTimestamp();
       }
    }
-   m_cacheMapMutex.unlock();
   
    if ( result.valid() == false )
    {
-      // Not in m_cacheMap.  Create a new cell for point if we have coverage.
-      result = createCell(gpt);
+      // Not in m_cacheMap.  Open the cell outside of any lock, it can be slow.
+      result = createCell(cellId);
 
       if(result.valid())
       {
-         std::lock_guard<std::mutex> lock(m_cacheMapMutex);
-
-         //---
-         // Add the cell to map.
-         // NOTE: ossimImageElevationDatabase::createCell sets m_lastAccessedId to that of
-         // the entries map key.
-         //---
+         ossimRwMutex::WriteLock lock(m_cacheRwMutex);
+         std::lock_guard<std::mutex> mapLock(m_cacheMapMutex);
 
-         m_cacheMap.insert(std::make_pair(m_lastMapKey,
-                                          new CellInfo(m_lastMapKey, result.get())));
-
-         ++m_lastMapKey;
-
-
-         // Check the map size and purge cells if needed.
-
-         if(m_cacheMap.size() > m_maxOpenCells)
+         // Another thread may have opened the same cell while we were.
+         CellMap::iterator iter = m_cacheMap.find(static_cast<ossim_uint64>(cellId));
+         if ( iter != m_cacheMap.end() )
+         {
+            result = iter->second->m_handler.get();
+            iter->second->updateTimestamp();
+         }
+         else
          {
-            flushCacheToMinOpenCells();
+            m_cacheMap.insert(std::make_pair(static_cast<ossim_uint64>(cellId),
+                                             new CellInfo(cellId, result.get())));
+
+            // Check the map size and purge cells if needed.
+            if(m_cacheMap.size() > m_maxOpenCells)
+            {
+               flushCacheToMinOpenCells();
+            }
          }
       }
    }
@@ -263,14 +323,8 @@ bool ossimGdalImageElevationDatabase::pointHasCoverage(const ossimGpt& gpt) cons
    // ossimImageElevationHandler::pointHasCoverage which does a real check from the
    // ossimImageGeometry of the image.
    //---
-   bool result = false;
-
-   // std:string filename = searchShapefile(gpt.lond(), gpt.latd());
-   std:string filename = ossimShpElevIndex::getInstance(m_connectionString)->searchShapefile(gpt.lond(), gpt.latd());
-
-   result = filename.size() > 1;
-
-   return result;
+   return ( ossimShpElevIndex::getInstance(m_connectionString)->searchCell(
+               gpt.lond(), gpt.latd()) >= 0 );
 }
 
 
@@ -348,10 +402,9 @@ bool ossimGdalImageElevationDatabase::saveState(ossimKeywordlist& kwl, const cha
 
 // Hidden from use:
 ossimGdalImageElevationDatabase::ossimGdalImageElevationDatabase(const ossimGdalImageElevationDatabase& copy)
-: ossimElevationCellDatabase(copy)
+: ossimElevationCellDatabase(copy),
+  m_cacheRwMutex()
 {
-   m_lastMapKey = copy.m_lastMapKey;
-   m_lastAccessedId = copy.m_lastAccessedId;
 }
 
 // Private container class:
@@ -22,7 +22,9 @@
 #include <ossim/base/ossimGrect.h>
 #include <ossim/base/ossimRefPtr.h>
 #include <ossim/base/ossimRtti.h>
+#include "ossimRwMutex.h"
 #include <map>
+#include <vector>
 
 class ossimString;
 class GDALDataset;
@@ -87,6 +89,26 @@ public:
     * @return Height above MSL.
     */
    virtual double getHeightAboveEllipsoid(const ossimGpt&);
+
+   /**
+    * @brief Get heights above MSL for an array of points.
+    *
+    * Points are bucketed by covering cell so each cell handler is looked up
+    * once per call instead of once per point.  Results are returned in input
+    * order; points without coverage are set to nan.
+    *
+    * @param gpts Points to query.
+    * @param heights Initialized by this to gpts.size() heights.
+    */
+   void getHeightsAboveMSL(const std::vector<ossimGpt>& gpts, std::vector<double>& heights);
+
+   /**
+    * @brief Get heights above ellipsoid for an array of points.
+    *
+    * Same as getHeightsAboveMSL with the geoid offset applied.
+    */
+   void getHeightsAboveEllipsoid(const std::vector<ossimGpt>& gpts,
+                                 std::vector<double>& heights);
    
    /**
     * Satisfies pure virtual ossimElevSource::pointHasCoverage
@@ -139,18 +161,28 @@ protected:
 
    virtual ossimRefPtr<ossimElevCellHandler> createCell(const ossimGpt& gpt);
 
+   /** @brief Opens the cell for a footprint index cell id. */
+   ossimRefPtr<ossimElevCellHandler> createCell(ossim_int64 cellId);
+
    // virtual ossim_uint64 createId(const ossimGpt& pt) const;
 
    /**
     * @brief Gets cell for point.
     *
     * This override ossimElevationCellDatabase::getOrCreateCellHandler as we cannot use
-    * the createId as our cells could be of any size.
+    * the createId as our cells could be of any size.  Instead the footprint index cell id
+    * is used as the m_cacheMap key.
     */
    virtual ossimRefPtr<ossimElevCellHandler> getOrCreateCellHandler(const ossimGpt& gpt);
 
+   /** @brief Gets cell for footprint index cell id, opening it if not cached. */
+   ossimRefPtr<ossimElevCellHandler> getOrCreateCellHandler(ossim_int64 cellId);
+
    /**
     * @brief Removes an entry from the m_cacheMap.
+    *
+    * Does not lock.  Reached from flushCacheToMinOpenCells on the insert
+    * path, which already holds m_cacheRwMutex exclusive.
     */
    virtual void remove(ossim_uint64 id);
 
@@ -187,8 +219,12 @@ private:
    void closeShapefile();
    std::string searchShapefile(double lon, double lat) const;
 
-   ossim_uint64       m_lastMapKey;
-   ossim_uint64       m_lastAccessedId;
+   /**
+    * Guards m_cacheMap.  Lookups take it shared, plus m_cacheMapMutex to
+    * touch a cell's timestamp; inserts and removes take it exclusive along
+    * with m_cacheMapMutex.
+    */
+   mutable ossimRwMutex m_cacheRwMutex;
 
    TYPE_DATA 
 };
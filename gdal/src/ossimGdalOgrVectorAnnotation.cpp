@@ -44,7 +44,10 @@
 #include <ossim/base/ossimUnitConversionTool.h>
 #include <ossim/support_data/ossimFgdcXmlDoc.h>
 #include <ogr_api.h>
+#include <algorithm>
+#include <future>
 #include <sstream>
+#include <thread>
 
 using namespace std;
 
@@ -56,6 +59,9 @@ RTTI_DEF2(ossimGdalOgrVectorAnnotation,
 static ossimOgcWktTranslator wktTranslator;
 static ossimTrace traceDebug("ossimGdalOgrVectorAnnotation:debug");
 
+// Rendered tiles kept; 128 three band 256x256 tiles is about 24 MB.
+static const ossim_uint32 MAX_CACHED_TILES = 128;
+
 static const char SHAPEFILE_COLORS_AUTO_KW[] =
    "shapefile_colors_auto";
 
@@ -218,7 +224,12 @@ ossimGdalOgrVectorAnnotation::ossimGdalOgrVectorAnnotation(ossimImageSource* inp
     m_needPenColor(false),
     m_geometryDistance(0.0),
     m_geometryDistanceType(OSSIM_UNIT_UNKNOWN),
-    m_layerName("")
+    m_layerName(""),
+    m_layerNames(),
+    m_tileList(),
+    m_tileMap(),
+    m_tileMutex(),
+    m_cacheTile(0)
 {
    // Pick up colors from preference file if set.
    getDefaults();
@@ -651,6 +662,7 @@ bool ossimGdalOgrVectorAnnotation::setView(ossimObject* baseObject)
          
          // Reproject the points to the current new projection.
          transformObjectsFromView();
+         clearTileCache();
          result = true;
          
       }
@@ -662,6 +674,7 @@ bool ossimGdalOgrVectorAnnotation::setView(ossimObject* baseObject)
             theImageGeometry = geom;
             // Reproject the points to the current new projection.
             transformObjectsFromView();
+            clearTileCache();
             result = true;
          }
       }
@@ -759,6 +772,204 @@ void ossimGdalOgrVectorAnnotation::computeBoundingRect()
    theImageBound.stretchOut();
 }
 
+bool ossimGdalOgrVectorAnnotation::TileKey::operator<(const TileKey& rhs) const
+{
+   if ( m_resLevel != rhs.m_resLevel ) return m_resLevel < rhs.m_resLevel;
+   if ( m_origin.y != rhs.m_origin.y ) return m_origin.y < rhs.m_origin.y;
+   if ( m_origin.x != rhs.m_origin.x ) return m_origin.x < rhs.m_origin.x;
+   if ( m_size.y != rhs.m_size.y ) return m_size.y < rhs.m_size.y;
+   if ( m_size.x != rhs.m_size.x ) return m_size.x < rhs.m_size.x;
+   return m_style < rhs.m_style;
+}
+
+ossimRefPtr<ossimImageData> ossimGdalOgrVectorAnnotation::getTile(
+   const ossimIrect& tileRect, ossim_uint32 resLevel)
+{
+   if ( !isSourceEnabled() || !isOpen() || getInput() )
+   {
+      return ossimAnnotationSource::getTile(tileRect, resLevel);
+   }
+
+   const TileKey key = getTileKey(tileRect, resLevel);
+   ossimRefPtr<ossimImageData> cached;
+   if ( !getCachedTile(key, cached) )
+   {
+      ossimRefPtr<ossimImageData> tile = ossimAnnotationSource::getTile(tileRect, resLevel);
+      if ( !tile.valid() )
+      {
+         return tile;
+      }
+      cached = static_cast<ossimImageData*>( tile->dup() );
+      addCachedTile(key, cached);
+   }
+
+   // Hand out a copy so callers cannot change the cached tile.
+   if ( !m_cacheTile.valid() ||
+        ( m_cacheTile->getNumberOfBands() != cached->getNumberOfBands() ) ||
+        ( m_cacheTile->getScalarType() != cached->getScalarType() ) )
+   {
+      m_cacheTile = static_cast<ossimImageData*>( cached->dup() );
+   }
+   else
+   {
+      m_cacheTile->setImageRectangle(tileRect);
+      m_cacheTile->loadTile(cached.get());
+      m_cacheTile->setDataObjectStatus(cached->getDataObjectStatus());
+   }
+   return m_cacheTile;
+}
+
+void ossimGdalOgrVectorAnnotation::getTiles(
+   const std::vector<ossimIrect>& rects,
+   ossim_uint32 resLevel,
+   std::vector< ossimRefPtr<ossimImageData> >& tiles)
+{
+   tiles.assign( rects.size(), ossimRefPtr<ossimImageData>() );
+
+   if ( !isSourceEnabled() || !isOpen() || getInput() )
+   {
+      for ( ossim_uint32 i = 0; i < rects.size(); ++i )
+      {
+         ossimRefPtr<ossimImageData> tile = getTile( rects[i], resLevel );
+         if ( tile.valid() )
+         {
+            tiles[i] = static_cast<ossimImageData*>( tile->dup() );
+         }
+      }
+      return;
+   }
+
+   // Load features here; the workers only read the tables.
+   if (theFeatureCacheTable.size() == 0)
+   {
+      initializeTables();
+   }
+
+   std::vector<TileKey> keys( rects.size() );
+   std::vector<ossim_uint32> misses;
+   for ( ossim_uint32 i = 0; i < rects.size(); ++i )
+   {
+      keys[i] = getTileKey( rects[i], resLevel );
+      ossimRefPtr<ossimImageData> cached;
+      if ( getCachedTile( keys[i], cached ) )
+      {
+         tiles[i] = static_cast<ossimImageData*>( cached->dup() );
+      }
+      else
+      {
+         misses.push_back( i );
+      }
+   }
+
+   const ossim_uint32 threads = std::max<ossim_uint32>( 1, std::thread::hardware_concurrency() );
+   for ( ossim_uint32 start = 0; start < misses.size(); start += threads )
+   {
+      const ossim_uint32 end = std::min<ossim_uint32>( start + threads, misses.size() );
+
+      std::vector< std::future< ossimRefPtr<ossimImageData> > > renders;
+      for ( ossim_uint32 i = start; i < end; ++i )
+      {
+         renders.push_back( std::async( std::launch::async,
+                                        &ossimGdalOgrVectorAnnotation::renderTile,
+                                        this, rects[ misses[i] ] ) );
+      }
+      for ( ossim_uint32 i = start; i < end; ++i )
+      {
+         const ossim_uint32 idx = misses[i];
+         tiles[idx] = renders[i - start].get();
+         addCachedTile( keys[idx], static_cast<ossimImageData*>( tiles[idx]->dup() ) );
+      }
+   }
+}
+
+ossimRefPtr<ossimImageData> ossimGdalOgrVectorAnnotation::renderTile(const ossimIrect& rect)
+{
+   ossimRefPtr<ossimImageData> tile = new ossimImageData( 0, OSSIM_UINT8,
+                                                          getNumberOfOutputBands(),
+                                                          rect.width(), rect.height() );
+   tile->setImageRectangle( rect );
+   tile->initialize();
+   tile->makeBlank();
+   drawFeatures( tile );
+   return tile;
+}
+
+ossimGdalOgrVectorAnnotation::TileKey ossimGdalOgrVectorAnnotation::getTileKey(
+   const ossimIrect& rect, ossim_uint32 resLevel) const
+{
+   TileKey key;
+   key.m_resLevel = resLevel;
+   key.m_origin   = rect.ul();
+   key.m_size     = ossimIpt( rect.width(), rect.height() );
+   key.m_style    = getStyleHash();
+   return key;
+}
+
+ossim_uint64 ossimGdalOgrVectorAnnotation::getStyleHash() const
+{
+   // FNV-1a over everything that changes how features are drawn.
+   std::ostringstream os;
+   os << (int)thePenColor.getR() << ' ' << (int)thePenColor.getG() << ' '
+      << (int)thePenColor.getB() << ' ' << (int)theBrushColor.getR() << ' '
+      << (int)theBrushColor.getG() << ' ' << (int)theBrushColor.getB() << ' '
+      << theFillFlag << ' ' << m_needPenColor << ' ' << (int)theThickness << ' '
+      << thePointWidthHeight << ' ' << m_geometryDistance << ' '
+      << m_geometryDistanceType << ' ' << m_layerName << ' ' << m_query << ' ';
+   for ( ossim_uint32 i = 0; i < theLayersToRenderFlagList.size(); ++i )
+   {
+      os << theLayersToRenderFlagList[i];
+   }
+
+   const std::string str = os.str();
+   ossim_uint64 hash = 14695981039346656037ULL;
+   for ( std::string::size_type i = 0; i < str.size(); ++i )
+   {
+      hash ^= static_cast<ossim_uint8>( str[i] );
+      hash *= 1099511628211ULL;
+   }
+   return hash;
+}
+
+bool ossimGdalOgrVectorAnnotation::getCachedTile(const TileKey& key,
+                                                 ossimRefPtr<ossimImageData>& tile)
+{
+   std::lock_guard<std::mutex> lock( m_tileMutex );
+   std::map<TileKey, TileList::iterator>::iterator i = m_tileMap.find( key );
+   if ( i == m_tileMap.end() )
+   {
+      return false;
+   }
+   m_tileList.splice( m_tileList.begin(), m_tileList, i->second );
+   tile = i->second->second;
+   return true;
+}
+
+void ossimGdalOgrVectorAnnotation::addCachedTile(const TileKey& key,
+                                                 ossimRefPtr<ossimImageData> tile)
+{
+   std::lock_guard<std::mutex> lock( m_tileMutex );
+   std::map<TileKey, TileList::iterator>::iterator i = m_tileMap.find( key );
+   if ( i != m_tileMap.end() )
+   {
+      m_tileList.erase( i->second );
+      m_tileMap.erase( i );
+   }
+   m_tileList.push_front( std::make_pair( key, tile ) );
+   m_tileMap[key] = m_tileList.begin();
+   if ( m_tileMap.size() > MAX_CACHED_TILES )
+   {
+      m_tileMap.erase( m_tileList.back().first );
+      m_tileList.pop_back();
+   }
+}
+
+void ossimGdalOgrVectorAnnotation::clearTileCache()
+{
+   std::lock_guard<std::mutex> lock( m_tileMutex );
+   m_tileMap.clear();
+   m_tileList.clear();
+}
+
 void ossimGdalOgrVectorAnnotation::drawAnnotations(
    ossimRefPtr<ossimImageData> tile)
 {
@@ -767,6 +978,12 @@ void ossimGdalOgrVectorAnnotation::drawAnnotations(
       initializeTables();
    }
 
+   drawFeatures(tile);
+}
+
+void ossimGdalOgrVectorAnnotation::drawFeatures(
+   ossimRefPtr<ossimImageData> tile)
+{
    if( theImageGeometry.valid())
    {
       list<long> featuresToRender;
@@ -1539,6 +1756,7 @@ void ossimGdalOgrVectorAnnotation::deleteTables()
    }
    
    theFeatureCacheTable.clear();
+   clearTileCache();
 }
 
 
@@ -15,6 +15,7 @@
 #define ossimGdalOgrVectorAnnotation_HEADER
 
 #include <map>
+#include <mutex>
 #include <vector>
 #include <list>
 #include <gdal.h>
@@ -58,6 +59,34 @@ public:
    virtual ossimIrect getBoundingRect(ossim_uint32 resLevel=0)const;
    virtual void computeBoundingRect();
 
+   /**
+    * @brief Gets a rendered tile.
+    *
+    * Rendered tiles are kept in a small LRU cache keyed by resolution level,
+    * tile rectangle and a hash of the drawing style, so panning back over
+    * an area or toggling a style does not redraw.  The cache is cleared
+    * when the features are reloaded or the view changes.  Not cached if an
+    * input is connected.
+    */
+   virtual ossimRefPtr<ossimImageData> getTile(const ossimIrect& tileRect,
+                                               ossim_uint32 resLevel=0);
+
+   /**
+    * @brief Renders several tiles concurrently.
+    *
+    * Features are loaded once on the calling thread and then drawn into
+    * each tile on its own thread; the feature table is only read while
+    * drawing.
+    *
+    * @param rects Tile rectangles to render.
+    * @param resLevel Reduced resolution level.
+    * @param tiles Initialized by this with one tile per rectangle.  Tiles
+    * are owned by the caller.
+    */
+   void getTiles(const std::vector<ossimIrect>& rects,
+                 ossim_uint32 resLevel,
+                 std::vector< ossimRefPtr<ossimImageData> >& tiles);
+
    virtual void drawAnnotations(ossimRefPtr<ossimImageData> tile);
 
 
@@ -123,6 +152,34 @@ protected:
    ossimUnitType                               m_geometryDistanceType;
    ossimString                                 m_layerName;
    std::vector<ossimString>                    m_layerNames;
+
+   /** Rendered tile cache key: resLevel, ul x, ul y, width, height, style. */
+   struct TileKey
+   {
+      bool operator<(const TileKey& rhs) const;
+      ossim_uint32 m_resLevel;
+      ossimIpt     m_origin;
+      ossimIpt     m_size;
+      ossim_uint64 m_style;
+   };
+   typedef std::list< std::pair< TileKey, ossimRefPtr<ossimImageData> > > TileList;
+
+   TileList                                    m_tileList;
+   std::map<TileKey, TileList::iterator>       m_tileMap;
+   std::mutex                                  m_tileMutex;
+   ossimRefPtr<ossimImageData>                 m_cacheTile;
+
+   TileKey getTileKey(const ossimIrect& rect, ossim_uint32 resLevel) const;
+   ossim_uint64 getStyleHash() const;
+   bool getCachedTile(const TileKey& key, ossimRefPtr<ossimImageData>& tile);
+   void addCachedTile(const TileKey& key, ossimRefPtr<ossimImageData> tile);
+   void clearTileCache();
+
+   /** @return New tile with the features drawn; no feature loading. */
+   ossimRefPtr<ossimImageData> renderTile(const ossimIrect& rect);
+
+   /** @brief Draws features into tile; reads the feature table only. */
+   void drawFeatures(ossimRefPtr<ossimImageData> tile);
    
    void computeDefaultView();
 
@@ -79,7 +79,9 @@ ossimGdalTileSource::ossimGdalTileSource()
       theAlphaChannelFlag(false),
       m_preservePaletteIndexesFlag(false),
       m_outputBandList(0),
-      m_isBlocked(false)
+      m_isBlocked(false),
+      m_rlevelBlockCache(),
+      m_allowedDrivers()
 {
    // Pick up any default settings from preference file if set.
    getDefaults();
@@ -126,6 +128,14 @@ void ossimGdalTileSource::close()
    theIsComplexFlag = false;
 }
 
+//*******************************************************************
+// Public Method:
+//*******************************************************************
+void ossimGdalTileSource::setAllowedDrivers( const std::vector<ossimString>& drivers )
+{
+   m_allowedDrivers = drivers;
+}
+
 //*******************************************************************
 // Public Method:
 //*******************************************************************
@@ -150,7 +160,22 @@ bool ossimGdalTileSource::open()
       // Note:  Cannot feed GDALOpen a NULL string!
       if (theImageFile.size())
       {
-         theDataset = GDALOpen(theImageFile.c_str(), GA_ReadOnly); 
+         if ( m_allowedDrivers.empty() )
+         {
+            theDataset = GDALOpen(theImageFile.c_str(), GA_ReadOnly);
+         }
+         else
+         {
+            std::vector<const char*> allowed;
+            for ( ossim_uint32 i = 0; i < m_allowedDrivers.size(); ++i )
+            {
+               allowed.push_back( m_allowedDrivers[i].c_str() );
+            }
+            allowed.push_back( 0 );
+            theDataset = GDALOpenEx( theImageFile.c_str(),
+                                     GDAL_OF_RASTER | GDAL_OF_READONLY,
+                                     &allowed.front(), 0, 0 );
+         }
          if( theDataset == 0 )
          {
             return false;
@@ -2195,6 +2220,20 @@ bool ossimGdalTileSource::isBlocked( int /* band */ )const
    return m_isBlocked;
 }
 
+bool ossimGdalTileSource::getNativeBlockSize( ossimIpt& size ) const
+{
+   GDALRasterBandH band = theDataset ? resolveRasterBand( 0, 1 ) : 0;
+   if ( band )
+   {
+      int xSize = 0;
+      int ySize = 0;
+      GDALGetBlockSize( band, &xSize, &ySize );
+      size = ossimIpt( xSize, ySize );
+      return true;
+   }
+   return false;
+}
+
 void ossimGdalTileSource::populateLut()
 {
    theLut = 0; // ossimRefPtr not a leak.
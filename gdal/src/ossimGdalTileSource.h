@@ -56,6 +56,18 @@ public:
     */   
    virtual bool open();
 
+   /**
+    * @brief Restricts the GDAL drivers tried when opening the file.
+    *
+    * Used by the factory once the driver has been identified so a failed
+    * open does not probe every registered driver.  Subdatasets are not
+    * restricted.
+    *
+    * @param drivers Driver short names, e.g. "GTiff".  Empty for no
+    * restriction (the default).
+    */
+   void setAllowedDrivers( const std::vector<ossimString>& drivers );
+
    /**
     *  Returns a pointer to a tile given an origin representing the upper
     *  left corner of the tile to grab from the image.
@@ -242,6 +254,14 @@ public:
 
    GDALDriverH getDriver();
 
+   /**
+    * @brief Gets the GDAL block size of the first band, which for chunked
+    * formats (HDF, netCDF) is the native chunk size.
+    * @param size Initialized by this.
+    * @return true on success, false if not open.
+    */
+   bool getNativeBlockSize(ossimIpt& size) const;
+
    virtual bool setOutputBandList(const std::vector<ossim_uint32>& band_list);
 
    /**
@@ -340,6 +360,7 @@ private:
    bool                        m_isBlocked;
 
    std::vector<ossimAppFixedTileCache::ossimAppFixedCacheId> m_rlevelBlockCache;
+   std::vector<ossimString>    m_allowedDrivers;
   
 TYPE_DATA
 };
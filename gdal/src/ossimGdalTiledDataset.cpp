@@ -13,13 +13,22 @@
 #include "ossimGdalType.h"
 
 #include <ossim/imaging/ossimImageSourceSequencer.h>
+#include <ossim/imaging/ossimImageChain.h>
 #include <ossim/imaging/ossimImageData.h>
 #include <ossim/imaging/ossimImageDataFactory.h>
+#include <ossim/imaging/ossimImageHandler.h>
+#include <ossim/base/ossimKeywordlist.h>
+#include <ossim/base/ossimObjectFactoryRegistry.h>
 #include <ossim/base/ossimProcessProgressEvent.h>
 #include <cpl_string.h>
+#include <algorithm>
+#include <thread>
 
 static GDALDriver	*poMEMTiledDriver = NULL;
 
+// Largest window, all bands, IRasterIO reads with one getTile.
+static const GIntBig MAX_WINDOW_BYTES = 64 * 1024 * 1024;
+
 #include <ossim/base/ossimTrace.h>
 static ossimTrace traceDebug(ossimString("ossimGdalTiledDataset:debug"));
 
@@ -82,6 +91,116 @@ CPLErr MEMTiledRasterBand::IReadBlock( int nBlockXOff,
                                        int nBlockYOff,
                                        void * pImage )
 
+{
+   if ( theDataset->theTiledBlockFlag )
+   {
+      return readTileBlock( nBlockXOff, nBlockYOff, pImage );
+   }
+   return readScanlineBlock( nBlockXOff, nBlockYOff, pImage );
+}
+
+CPLErr MEMTiledRasterBand::readTileBlock( int nBlockXOff,
+                                          int nBlockYOff,
+                                          void * pImage )
+{
+   if (!theDataset->theData)  // Check for a valid buffer.
+   {
+      return CE_None;
+   }
+
+   const MEMTiledDataset::TileRow row = theDataset->getTileRow(nBlockYOff);
+
+   const ossimImageData* tile = 0;
+   if ( nBlockXOff < static_cast<int>(row.size()) )
+   {
+      tile = row[nBlockXOff].get();
+   }
+
+   copyTile( tile, pImage );
+
+   return CE_None;
+}
+
+void MEMTiledRasterBand::copyTile( const ossimImageData* tile, void* pImage ) const
+{
+   if ( tile && tile->getBuf() &&
+        ( tile->getDataObjectStatus() != OSSIM_EMPTY ) &&
+        ( static_cast<int>(tile->getWidth())  == nBlockXSize ) &&
+        ( static_cast<int>(tile->getHeight()) == nBlockYSize ) )
+   {
+      memcpy( pImage, tile->getBuf(nBand-1), tile->getSizePerBandInBytes() );
+   }
+   else
+   {
+      copyNulls( pImage, nBlockXSize * nBlockYSize );
+   }
+}
+
+CPLErr MEMTiledRasterBand::IRasterIO( GDALRWFlag eRWFlag,
+                                      int nXOff, int nYOff, int nXSize, int nYSize,
+                                      void * pData, int nBufXSize, int nBufYSize,
+                                      GDALDataType eBufType,
+                                      GSpacing nPixelSpace, GSpacing nLineSpace,
+                                      GDALRasterIOExtraArg* psExtraArg )
+{
+   //---
+   // Large, non resampled reads skip the block cache and go to the chain with
+   // one getTile for the whole window.  Windows over MAX_WINDOW_BYTES go
+   // through the blocks so the image is not held in memory twice.  Note:
+   // MEMRasterBand::IRasterIO is bypassed on purpose as it reads the
+   // (unused) band memory directly.
+   //---
+   const GIntBig WINDOW_BYTES = static_cast<GIntBig>( nXSize ) * nYSize *
+      poDS->GetRasterCount() * ( GDALGetDataTypeSize( eDataType ) / 8 );
+   if ( ( eRWFlag == GF_Read ) && theDataset->theTiledBlockFlag &&
+        theDataset->theData.valid() &&
+        ( nBufXSize == nXSize ) && ( nBufYSize == nYSize ) &&
+        ( nXSize >= nBlockXSize ) && ( nYSize >= nBlockYSize ) &&
+        ( WINDOW_BYTES <= MAX_WINDOW_BYTES ) )
+   {
+      ossimIpt ul( theDataset->theAreaOfInterest.ul().x + nXOff,
+                   theDataset->theAreaOfInterest.ul().y + nYOff );
+      ossimIrect rect( ul.x, ul.y, ul.x + nXSize - 1, ul.y + nYSize - 1 );
+
+      ossimRefPtr<ossimImageData> window = theDataset->getWindow( rect );
+
+      if ( window.valid() && window->getBuf() &&
+           ( window->getDataObjectStatus() != OSSIM_EMPTY ) )
+      {
+         const int BPP = static_cast<int>( window->getScalarSizeInBytes() );
+         const GSpacing SRC_LINE = static_cast<GSpacing>( nXSize ) * BPP;
+         const GByte* src = static_cast<const GByte*>( window->getBuf(nBand-1) );
+         GByte* dst = static_cast<GByte*>( pData );
+         for ( int line = 0; line < nYSize; ++line )
+         {
+            GDALCopyWords( const_cast<GByte*>( src + line * SRC_LINE ), eDataType, BPP,
+                           dst + line * nLineSpace, eBufType,
+                           static_cast<int>( nPixelSpace ), nXSize );
+         }
+      }
+      else
+      {
+         // Empty window, fill with nulls converted to the buffer type.
+         double nullPix = theDataset->theData->getNullPix( nBand-1 );
+         GByte* dst = static_cast<GByte*>( pData );
+         for ( int line = 0; line < nYSize; ++line )
+         {
+            GDALCopyWords( &nullPix, GDT_Float64, 0,
+                           dst + line * nLineSpace, eBufType,
+                           static_cast<int>( nPixelSpace ), nXSize );
+         }
+      }
+      return CE_None;
+   }
+
+   return GDALRasterBand::IRasterIO( eRWFlag, nXOff, nYOff, nXSize, nYSize,
+                                     pData, nBufXSize, nBufYSize, eBufType,
+                                     nPixelSpace, nLineSpace, psExtraArg );
+}
+
+CPLErr MEMTiledRasterBand::readScanlineBlock( int nBlockXOff,
+                                              int nBlockYOff,
+                                              void * pImage )
 {
 #if 0
    if (traceDebug())
@@ -309,7 +428,17 @@ MEMTiledDataset::MEMTiledDataset()
    theTileSize(),
    theAreaOfInterest(),
    theJustCreatedFlag(false),
-   theSetNoDataValueFlag(true)
+   theSetNoDataValueFlag(true),
+   theTiledBlockFlag(true),
+   thePrefetchThreads(0),
+   theClones(),
+   theClonesInitializedFlag(false),
+   theRow(),
+   theRowIndex(-1),
+   thePrefetch(),
+   thePrefetchRow(-1),
+   theWindow(),
+   theMutex()
 {
 }
 
@@ -321,7 +450,17 @@ MEMTiledDataset::MEMTiledDataset(ossimImageSourceSequencer* iface)
    theTileSize(),
    theAreaOfInterest(),
    theJustCreatedFlag(false),
-   theSetNoDataValueFlag(true)
+   theSetNoDataValueFlag(true),
+   theTiledBlockFlag(true),
+   thePrefetchThreads(0),
+   theClones(),
+   theClonesInitializedFlag(false),
+   theRow(),
+   theRowIndex(-1),
+   thePrefetch(),
+   thePrefetchRow(-1),
+   theWindow(),
+   theMutex()
 {
    create(theInterface);
 }
@@ -334,6 +473,7 @@ MEMTiledDataset::~MEMTiledDataset()
 
 {
     FlushCache();
+    waitForPrefetch();
 }
 
 /************************************************************************/
@@ -424,6 +564,11 @@ void MEMTiledDataset::create(ossimImageSourceSequencer* iface)
                                     0,
                                     TRUE );
          rasterBand->theDataset = this;
+         if (theTiledBlockFlag)
+         {
+            rasterBand->nBlockXSize = theTileSize.x;
+            rasterBand->nBlockYSize = theTileSize.y;
+         }
          if (theSetNoDataValueFlag)
          {
             rasterBand->SetNoDataValue(theInterface->getNullPixelValue(band));
@@ -455,6 +600,211 @@ void MEMTiledDataset::setNoDataValueFlag(bool flag)
    theSetNoDataValueFlag = flag;
 }
 
+void MEMTiledDataset::setTiledBlockFlag(bool flag)
+{
+   theTiledBlockFlag = flag;
+}
+
+void MEMTiledDataset::setPrefetchThreads(ossim_uint32 threads)
+{
+   thePrefetchThreads = threads;
+}
+
+ossim_uint32 MEMTiledDataset::getNumberOfTilesHorizontal() const
+{
+   return (theAreaOfInterest.width() + theTileSize.x - 1) / theTileSize.x;
+}
+
+ossim_uint32 MEMTiledDataset::getNumberOfTilesVertical() const
+{
+   return (theAreaOfInterest.height() + theTileSize.y - 1) / theTileSize.y;
+}
+
+void MEMTiledDataset::initClones()
+{
+   theClonesInitializedFlag = true;
+
+   if ( !theInterface || !thePrefetchThreads )
+   {
+      return;
+   }
+
+   //---
+   // Only a chain or an image handler can be duplicated from its own state.
+   // Other sources come back disconnected, or empty in the case of memory
+   // sources.
+   //---
+   ossimImageSource* input = dynamic_cast<ossimImageSource*>(theInterface->getInput(0));
+   if ( !input ||
+        ( !dynamic_cast<ossimImageChain*>(input) && !dynamic_cast<ossimImageHandler*>(input) ) )
+   {
+      return;
+   }
+
+   ossimKeywordlist kwl;
+   if ( !input->saveState(kwl) )
+   {
+      return;
+   }
+
+   ossim_uint32 threads = std::min(thePrefetchThreads, getNumberOfTilesHorizontal());
+   for ( ossim_uint32 i = 0; i < threads; ++i )
+   {
+      ossimRefPtr<ossimObject> obj = ossimObjectFactoryRegistry::instance()->createObject(kwl);
+      ossimRefPtr<ossimImageSource> clone = dynamic_cast<ossimImageSource*>(obj.get());
+      if ( !clone.valid() )
+      {
+         break;
+      }
+      clone->initialize();
+
+      // A clone that does not look like the input would return wrong tiles.
+      if ( ( clone->getBoundingRect() != input->getBoundingRect() ) ||
+           ( clone->getNumberOfOutputBands() != input->getNumberOfOutputBands() ) ||
+           ( clone->getOutputScalarType() != input->getOutputScalarType() ) )
+      {
+         theClones.clear();
+         break;
+      }
+      theClones.push_back(clone);
+   }
+
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "MEMTiledDataset::initClones DEBUG: cloned input chains: "
+         << theClones.size() << std::endl;
+   }
+}
+
+void MEMTiledDataset::loadTiles(ossimImageSource* source,
+                                const ossimIrect& aoi,
+                                const ossimIpt& tileSize,
+                                ossim_int32 row,
+                                ossim_uint32 start,
+                                ossim_uint32 step,
+                                TileRow* tiles)
+{
+   for ( ossim_uint32 i = start; i < tiles->size(); i += step )
+   {
+      ossimIpt origin( aoi.ul().x + tileSize.x * static_cast<ossim_int32>(i),
+                       aoi.ul().y + tileSize.y * row );
+      ossimRefPtr<ossimImageData> data =
+         source->getTile( ossimIrect( origin.x,
+                                      origin.y,
+                                      origin.x + tileSize.x - 1,
+                                      origin.y + tileSize.y - 1 ) );
+
+      // Sources reuse their tile so keep a copy.
+      if ( data.valid() && data->getBuf() )
+      {
+         (*tiles)[i] = static_cast<ossimImageData*>( data->dup() );
+      }
+   }
+}
+
+MEMTiledDataset::TileRow MEMTiledDataset::loadTileRow(ossim_int32 row)
+{
+   TileRow tiles( getNumberOfTilesHorizontal() );
+
+   if ( theClones.size() > 1 )
+   {
+      // Split the row across the clones, one thread each.
+      std::vector<std::thread> workers;
+      ossim_uint32 step = static_cast<ossim_uint32>( theClones.size() );
+      for ( ossim_uint32 i = 0; i < step; ++i )
+      {
+         workers.push_back( std::thread( &MEMTiledDataset::loadTiles, theClones[i].get(),
+                                         theAreaOfInterest, theTileSize, row, i, step,
+                                         &tiles ) );
+      }
+      for ( ossim_uint32 i = 0; i < workers.size(); ++i )
+      {
+         workers[i].join();
+      }
+   }
+   else if ( theClones.size() == 1 )
+   {
+      loadTiles( theClones[0].get(), theAreaOfInterest, theTileSize, row, 0, 1, &tiles );
+   }
+   else if ( theInterface )
+   {
+      loadTiles( theInterface, theAreaOfInterest, theTileSize, row, 0, 1, &tiles );
+   }
+
+   return tiles;
+}
+
+void MEMTiledDataset::startPrefetch(ossim_int32 row)
+{
+   // Only prefetch with cloned chains; the sequencer belongs to the caller's thread.
+   if ( theClones.size() && ( row < static_cast<ossim_int32>(getNumberOfTilesVertical()) ) )
+   {
+      thePrefetchRow = row;
+      thePrefetch = std::async( std::launch::async, &MEMTiledDataset::loadTileRow, this, row );
+   }
+}
+
+void MEMTiledDataset::waitForPrefetch()
+{
+   if ( thePrefetch.valid() )
+   {
+      thePrefetch.wait();
+      thePrefetch = std::future<TileRow>();
+   }
+   thePrefetchRow = -1;
+}
+
+MEMTiledDataset::TileRow MEMTiledDataset::getTileRow(ossim_int32 row)
+{
+   std::lock_guard<std::mutex> lock(theMutex);
+
+   if ( row != theRowIndex )
+   {
+      if ( !theClonesInitializedFlag )
+      {
+         initClones();
+      }
+
+      if ( ( row == thePrefetchRow ) && thePrefetch.valid() )
+      {
+         theRow = thePrefetch.get();
+         thePrefetchRow = -1;
+      }
+      else
+      {
+         waitForPrefetch();
+         theRow = loadTileRow(row);
+      }
+      theRowIndex = row;
+
+      // Consumers walk the image top to bottom; start on the next row now.
+      startPrefetch(row + 1);
+   }
+
+   return theRow;
+}
+
+ossimRefPtr<ossimImageData> MEMTiledDataset::getWindow(const ossimIrect& rect)
+{
+   std::lock_guard<std::mutex> lock(theMutex);
+
+   if ( !theWindow.valid() || ( theWindow->getImageRectangle() != rect ) )
+   {
+      theWindow = 0;
+      if ( theInterface )
+      {
+         ossimRefPtr<ossimImageData> data = theInterface->getTile(rect);
+         if ( data.valid() )
+         {
+            theWindow = static_cast<ossimImageData*>( data->dup() );
+         }
+      }
+   }
+
+   return theWindow;
+}
+
 /************************************************************************/
 /*                          GDALRegister_MEM()                          */
 /************************************************************************/
@@ -18,8 +18,12 @@
 #include <ossim/base/ossimListenerManager.h>
 #include <ossim/base/ossimIpt.h>
 #include <ossim/base/ossimIrect.h>
+#include <future>
+#include <mutex>
+#include <vector>
 
 class MEMTiledRasterBand;
+class ossimImageSource;
 class ossimImageSourceSequencer;
 class ossimImageData;
 
@@ -41,10 +45,61 @@ private:
     * value.
     */
    bool theSetNoDataValueFlag;
-   
+
+   /**
+    * If true (default) blocks are one ossim tile in size, else one scanline
+    * by full image width.
+    */
+   bool theTiledBlockFlag;
+
+   /** Number of cloned input chains used to fetch tiles. 0 disables. */
+   ossim_uint32 thePrefetchThreads;
+
+   typedef std::vector< ossimRefPtr<ossimImageData> > TileRow;
+
+   /** Cloned input chains; empty if the input could not be cloned. */
+   std::vector< ossimRefPtr<ossimImageSource> > theClones;
+   bool         theClonesInitializedFlag;
+
+   /** Current row of tiles in tiled block mode. */
+   TileRow      theRow;
+   ossim_int32  theRowIndex;
+
+   /** Background load of the row after theRowIndex. */
+   std::future<TileRow> thePrefetch;
+   ossim_int32  thePrefetchRow;
+
+   /** Last window read through MEMTiledRasterBand::IRasterIO. */
+   ossimRefPtr<ossimImageData> theWindow;
+
+   std::mutex   theMutex;
+
    void create(ossimImageSourceSequencer* iface);
 
- 
+   /**
+    * @return Copy of the row of tiles, using the prefetched row if available.
+    * A copy since another band may replace theRow once the lock is released.
+    */
+   TileRow getTileRow(ossim_int32 row);
+
+   /** @return Full window for rect, cached for the other bands. */
+   ossimRefPtr<ossimImageData> getWindow(const ossimIrect& rect);
+
+   /** Fetches tile row from the clones in parallel or theInterface. */
+   TileRow loadTileRow(ossim_int32 row);
+
+   /** Fetches every nth tile of row starting at column start from source. */
+   static void loadTiles(ossimImageSource* source, const ossimIrect& aoi,
+                         const ossimIpt& tileSize, ossim_int32 row,
+                         ossim_uint32 start, ossim_uint32 step, TileRow* tiles);
+
+   ossim_uint32 getNumberOfTilesHorizontal() const;
+   ossim_uint32 getNumberOfTilesVertical() const;
+
+   void initClones();
+   void startPrefetch(ossim_int32 row);
+   void waitForPrefetch();
+
 
 public:
    MEMTiledDataset();
@@ -67,6 +122,21 @@ public:
     * performed.  If false it will be bypassed.
     */
    void setNoDataValueFlag(bool flag);
+
+   /**
+    * If true (default) raster bands use blocks of the input tile size and
+    * reads go to getTile directly.  If false the old single scanline block
+    * layout is used.  Must be called before create.
+    */
+   void setTiledBlockFlag(bool flag);
+
+   /**
+    * Sets the number of cloned input chains used to fetch tiles in the
+    * background.  Default is 0, which fetches synchronously from the
+    * sequencer only.  Only an image chain or image handler input is cloned.
+    * Must be called before the first read.
+    */
+   void setPrefetchThreads(ossim_uint32 threads);
 };
 
 /************************************************************************/
@@ -93,13 +163,32 @@ public:
    
     virtual        ~MEMTiledRasterBand();
 
-    // should override RasterIO eventually.
-    
     virtual CPLErr IReadBlock( int, int, void * );
     virtual CPLErr IWriteBlock( int, int, void * );
 
+    /**
+     * Reads windows at least one tile in size, and at most 64 MiB across
+     * all bands, with a single getTile call on the input.  Everything else
+     * goes through the block cache.
+     */
+    virtual CPLErr IRasterIO( GDALRWFlag eRWFlag,
+                              int nXOff, int nYOff, int nXSize, int nYSize,
+                              void * pData, int nBufXSize, int nBufYSize,
+                              GDALDataType eBufType,
+                              GSpacing nPixelSpace, GSpacing nLineSpace,
+                              GDALRasterIOExtraArg* psExtraArg );
+
 private:
 
+    /** Original one scanline block read. */
+    CPLErr readScanlineBlock( int nBlockXOff, int nBlockYOff, void* pImage );
+
+    /** Block read for one ossim tile sized block. */
+    CPLErr readTileBlock( int nBlockXOff, int nBlockYOff, void* pImage );
+
+    /** Copies this band of tile to pImage or nulls if tile is empty. */
+    void copyTile( const ossimImageData* tile, void* pImage ) const;
+
     /**
      * Copies null values to pImage.
      * @param pImage Buffer to copy to.
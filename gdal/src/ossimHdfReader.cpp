@@ -10,10 +10,14 @@
 // $Id: ossimHdfReader.cpp 2645 2011-05-26 15:21:34Z oscar.kramer $
 
 //Std includes
+#include <algorithm>
+#include <future>
 #include <set>
+#include <thread>
 
 //ossim includes
 #include <ossimHdfReader.h>
+#include <ossim/base/ossimCommon.h>
 #include <ossim/base/ossimScalarTypeLut.h>
 #include <ossim/base/ossimTrace.h>
 #include <ossim/base/ossimUnitTypeLut.h>
@@ -28,6 +32,10 @@ static const char OSSIM_ID[] = "$Id";
 
 static ossimTrace traceDebug("ossimHdfReader:debug");
 
+// Target size of a strip chunk.  Row counts are clamped to the limits below.
+static const ossim_uint32 CHUNK_BYTES    = 1 << 20;
+static const ossim_int32  MIN_CHUNK_ROWS = 16;
+
 RTTI_DEF1_INST(ossimHdfReader, "ossimHdfReader", ossimImageHandler)
 
 bool doubleEquals(ossim_float64 left, ossim_float64 right, ossim_float64 epsilon) 
@@ -42,7 +50,16 @@ ossimHdfReader::ossimHdfReader()
     m_numberOfBands(0),
     m_scalarType(OSSIM_SCALAR_UNKNOWN),
     m_currentEntryRender(0),
-    m_tile(0)
+    m_tile(0),
+    m_current(),
+    m_entrySources()
+{
+}
+
+ossimHdfReader::EntrySource::EntrySource()
+   : m_source(0),
+     m_chunkSize(0, 0),
+     m_cacheId(-1)
 {
 }
 
@@ -164,6 +181,9 @@ bool ossimHdfReader::open()
       m_gdalTileSource->setCurrentEntry(m_currentEntryRender);
       m_numberOfBands = m_gdalTileSource->getNumberOfInputBands();
 
+      m_current.m_source = m_gdalTileSource;
+      initChunkCache(m_current);
+
       m_tile = ossimImageDataFactory::instance()->create(this, this);
       m_tile->initialize();
       
@@ -190,6 +210,193 @@ bool ossimHdfReader::open()
    return result;
 }
 
+bool ossimHdfReader::getEntryTiles(const ossimIrect& rect,
+                                   const std::vector<ossim_uint32>& entries,
+                                   std::vector< ossimRefPtr<ossimImageData> >& tiles)
+{
+   tiles.assign( entries.size(), ossimRefPtr<ossimImageData>() );
+   if ( !isOpen() )
+   {
+      return false;
+   }
+
+   // Handles are opened here so the workers never touch m_entrySources.
+   std::vector<EntrySource*> sources( entries.size() );
+   for ( ossim_uint32 i = 0; i < entries.size(); ++i )
+   {
+      sources[i] = getEntrySource( entries[i] );
+   }
+
+   const ossim_uint32 threads = std::max<ossim_uint32>( 1, std::thread::hardware_concurrency() );
+   bool status = true;
+   for ( ossim_uint32 start = 0; start < sources.size(); start += threads )
+   {
+      const ossim_uint32 end = std::min<ossim_uint32>( start + threads, sources.size() );
+
+      std::vector< std::future< ossimRefPtr<ossimImageData> > > reads;
+      for ( ossim_uint32 i = start; i < end; ++i )
+      {
+         reads.push_back( std::async( std::launch::async, &ossimHdfReader::readEntryTile,
+                                      sources[i], rect ) );
+      }
+      for ( ossim_uint32 i = start; i < end; ++i )
+      {
+         tiles[i] = reads[i - start].get();
+         if ( !tiles[i].valid() )
+         {
+            status = false;
+         }
+      }
+   }
+
+   return status;
+}
+
+ossimRefPtr<ossimImageData> ossimHdfReader::readEntryTile(EntrySource* entry,
+                                                          const ossimIrect& rect)
+{
+   ossimRefPtr<ossimImageData> tile;
+   if ( entry && entry->m_source.valid() )
+   {
+      tile = ossimImageDataFactory::instance()->create( 0, entry->m_source.get() );
+      tile->setImageRectangle( rect );
+      tile->initialize();
+
+      ossimIrect imageRect = entry->m_source->getImageRectangle( 0 );
+      if ( imageRect.intersects( rect ) )
+      {
+         ossimIrect clipRect = rect.clipToRect( imageRect );
+         if ( rect.completely_within( clipRect ) == false )
+         {
+            tile->makeBlank();
+         }
+         loadTile( *entry, clipRect, tile.get() );
+      }
+      else
+      {
+         tile->makeBlank();
+      }
+      tile->validate();
+   }
+   return tile;
+}
+
+ossimHdfReader::EntrySource* ossimHdfReader::getEntrySource(ossim_uint32 entry)
+{
+   std::map<ossim_uint32, EntrySource>::iterator i = m_entrySources.find( entry );
+   if ( i == m_entrySources.end() )
+   {
+      i = m_entrySources.insert( std::make_pair( entry, EntrySource() ) ).first;
+
+      // Not open so this opens the file straight to the entry's subdataset.
+      ossimRefPtr<ossimGdalTileSource> source = new ossimGdalTileSource;
+      source->setFilename( theImageFile );
+      if ( source->setCurrentEntry( entry ) )
+      {
+         i->second.m_source = source;
+         initChunkCache( i->second );
+      }
+      else if (traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimHdfReader::getEntrySource DEBUG: could not open entry "
+            << entry << std::endl;
+      }
+   }
+   return i->second.m_source.valid() ? &(i->second) : 0;
+}
+
+void ossimHdfReader::initChunkCache(EntrySource& entry) const
+{
+   deleteChunkCache( entry );
+
+   //---
+   // Two dimensional chunks are already cached block by block in
+   // ossimGdalTileSource.  Strip organized subdatasets (GDAL block of one
+   // row) are read in runs of whole rows so neighboring tiles share a read.
+   //---
+   ossimIpt block;
+   if ( !entry.m_source.valid() || !entry.m_source->getNativeBlockSize( block ) ||
+        ( ( block.x > 1 ) && ( block.y > 1 ) ) )
+   {
+      return;
+   }
+
+   ossimIrect imageRect = entry.m_source->getImageRectangle( 0 );
+   const ossim_uint32 rowBytes = imageRect.width() *
+      entry.m_source->getNumberOfOutputBands() *
+      ossim::scalarSizeInBytes( entry.m_source->getOutputScalarType() );
+   if ( rowBytes == 0 )
+   {
+      return;
+   }
+
+   ossim_int32 rows = static_cast<ossim_int32>( CHUNK_BYTES / rowBytes );
+   rows = std::max( rows, MIN_CHUNK_ROWS );
+   rows = std::min( rows, static_cast<ossim_int32>( imageRect.height() ) );
+
+   entry.m_chunkSize = ossimIpt( imageRect.width(), rows );
+   imageRect.stretchToTileBoundary( entry.m_chunkSize );
+   entry.m_cacheId =
+      ossimAppFixedTileCache::instance()->newTileCache( imageRect, entry.m_chunkSize );
+}
+
+void ossimHdfReader::deleteChunkCache(EntrySource& entry) const
+{
+   if ( entry.m_cacheId >= 0 )
+   {
+      ossimAppFixedTileCache::instance()->deleteCache( entry.m_cacheId );
+      entry.m_cacheId = -1;
+   }
+}
+
+void ossimHdfReader::loadTile(EntrySource& entry, const ossimIrect& clipRect,
+                              ossimImageData* tile)
+{
+   if ( entry.m_cacheId < 0 )
+   {
+      ossimRefPtr<ossimImageData> data = entry.m_source->getTile( clipRect, 0 );
+      if ( data.valid() && data->getBuf() )
+      {
+         tile->loadTile( data->getBuf(), clipRect, OSSIM_BSQ );
+      }
+      return;
+   }
+
+   ossimAppFixedTileCache* cache = ossimAppFixedTileCache::instance();
+   const ossimIrect imageRect = entry.m_source->getImageRectangle( 0 );
+   const ossimIpt& chunk = entry.m_chunkSize;
+
+   ossimIrect alignedRect = clipRect;
+   alignedRect.stretchToTileBoundary( chunk );
+
+   for ( ossim_int32 y = alignedRect.ul().y; y <= alignedRect.lr().y; y += chunk.y )
+   {
+      for ( ossim_int32 x = alignedRect.ul().x; x <= alignedRect.lr().x; x += chunk.x )
+      {
+         ossimRefPtr<ossimImageData> data = cache->getTile( entry.m_cacheId, ossimIpt( x, y ) );
+         if ( !data.valid() )
+         {
+            ossimIrect chunkRect( x, y, x + chunk.x - 1, y + chunk.y - 1 );
+            chunkRect = chunkRect.clipToRect( imageRect );
+
+            ossimRefPtr<ossimImageData> chunkData = entry.m_source->getTile( chunkRect, 0 );
+            if ( !chunkData.valid() || !chunkData->getBuf() )
+            {
+               continue;
+            }
+            data = cache->addTile( entry.m_cacheId, chunkData.get(), true );
+         }
+
+         if ( data.valid() && data->getBuf() )
+         {
+            const ossimIrect dataRect = data->getImageRectangle();
+            tile->loadTile( data->getBuf(), dataRect, dataRect.clipToRect( clipRect ), OSSIM_BSQ );
+         }
+      }
+   }
+}
+
 bool ossimHdfReader::isSDSDataset(ossimString fileName)
 {
   std::vector<ossimString> fileList = fileName.split(":");
@@ -213,6 +420,17 @@ void ossimHdfReader::close()
 {
    m_tile = 0;
 
+   deleteChunkCache(m_current);
+   m_current.m_source = 0;
+
+   std::map<ossim_uint32, EntrySource>::iterator i = m_entrySources.begin();
+   while ( i != m_entrySources.end() )
+   {
+      deleteChunkCache(i->second);
+      ++i;
+   }
+   m_entrySources.clear();
+
    if (m_gdalTileSource.valid())
    {
       m_gdalTileSource = 0;
@@ -278,7 +496,11 @@ bool ossimHdfReader::getTile(ossimImageData* result,
                result->makeBlank();
             }
 
-            if (m_gdalTileSource.valid())
+            if ( (resLevel == 0) && m_current.m_source.valid() )
+            {
+               loadTile(m_current, clipRect, result);
+            }
+            else if (m_gdalTileSource.valid())
             {
                ossimRefPtr<ossimImageData> imageData =
                   m_gdalTileSource->getTile(tile_rect, resLevel);
@@ -23,6 +23,7 @@
 #include <ossim/support_data/ossimJ2kSizRecord.h>
 #include <ossim/imaging/ossimAppFixedTileCache.h>
 #include <ossimGdalTileSource.h>
+#include <map>
 
 // Forward class declarations.
 class ossimImageData;
@@ -186,8 +187,54 @@ public:
 
    virtual bool setOutputBandList(const std::vector<ossim_uint32>& band_list);
 
+   /**
+    * @brief Reads the same rectangle from several entries (subdatasets) at
+    * once.
+    *
+    * Each entry is read through its own GDAL handle, opened on first use
+    * and kept until close, so the reads run concurrently.  Overviews and
+    * the output band list of the current entry do not apply.
+    *
+    * @param rect Full resolution rectangle to read.
+    * @param entries Entry indexes to read.
+    * @param tiles Initialized by this with one tile per entry, null for
+    * entries that could not be read.
+    * @return true if every entry was read.
+    */
+   bool getEntryTiles(const ossimIrect& rect,
+                      const std::vector<ossim_uint32>& entries,
+                      std::vector< ossimRefPtr<ossimImageData> >& tiles);
+
 private:
 
+   /**
+    * Source for one entry plus its chunk cache.  Strip organized subdatasets
+    * are read in chunks of whole rows and cached; two dimensional chunks are
+    * already cached by ossimGdalTileSource.
+    */
+   struct EntrySource
+   {
+      EntrySource();
+      ossimRefPtr<ossimGdalTileSource>              m_source;
+      ossimIpt                                      m_chunkSize;
+      ossimAppFixedTileCache::ossimAppFixedCacheId  m_cacheId;
+   };
+
+   void initChunkCache(EntrySource& entry) const;
+   void deleteChunkCache(EntrySource& entry) const;
+   EntrySource* getEntrySource(ossim_uint32 entry);
+
+   /**
+    * @brief Fills the clip rectangle of the tile from the entry, going
+    * through the chunk cache if it has one.
+    */
+   static void loadTile(EntrySource& entry, const ossimIrect& clipRect,
+                        ossimImageData* tile);
+
+   /** @brief Reads a full tile from an entry; run on worker threads. */
+   static ossimRefPtr<ossimImageData> readEntryTile(EntrySource* entry,
+                                                    const ossimIrect& rect);
+
   bool isSDSDataset(ossimString fileName);
 
   ossimRefPtr<ossimGdalTileSource>                              m_gdalTileSource;
@@ -196,6 +243,12 @@ private:
   ossimScalarType                                               m_scalarType;
   ossim_uint32                                                  m_currentEntryRender;
   ossimRefPtr<ossimImageData>                                   m_tile;
+
+  /** Chunk cache of the current entry; m_source is m_gdalTileSource. */
+  EntrySource                                                   m_current;
+
+  /** Independent handles used by getEntryTiles. */
+  std::map<ossim_uint32, EntrySource>                           m_entrySources;
 TYPE_DATA
 };
 
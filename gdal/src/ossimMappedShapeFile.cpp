@@ -0,0 +1,798 @@
+//*******************************************************************
+//
+// License:  See top level LICENSE.txt file.
+//
+// Description: Memory mapped, read only ESRI shape file with a quadtree
+// index.
+//
+//*************************************************************************
+// $Id$
+
+#include <ossimMappedShapeFile.h>
+#include <ossim/base/ossimNotify.h>
+#include <ossim/base/ossimTrace.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+static const ossimTrace traceDebug("ossimMappedShapeFile:debug");
+
+namespace
+{
+   // Shape files mix byte orders so everything is assembled from bytes.
+
+   ossim_int32 readBE32(const ossim_uint8* p)
+   {
+      return static_cast<ossim_int32>( (ossim_uint32(p[0]) << 24) | (ossim_uint32(p[1]) << 16) |
+                                       (ossim_uint32(p[2]) << 8)  |  ossim_uint32(p[3]) );
+   }
+
+   ossim_int32 readLE32(const ossim_uint8* p)
+   {
+      return static_cast<ossim_int32>( (ossim_uint32(p[3]) << 24) | (ossim_uint32(p[2]) << 16) |
+                                       (ossim_uint32(p[1]) << 8)  |  ossim_uint32(p[0]) );
+   }
+
+   double readLEDouble(const ossim_uint8* p)
+   {
+      ossim_uint64 bits = 0;
+      for ( int i = 7; i >= 0; --i )
+      {
+         bits = (bits << 8) | p[i];
+      }
+      double d;
+      std::memcpy(&d, &bits, sizeof(d));
+      return d;
+   }
+
+   ossim_int32 read32(const ossim_uint8* p, bool bigEndian)
+   {
+      return bigEndian ? readBE32(p) : readLE32(p);
+   }
+
+   double readDouble(const ossim_uint8* p, bool bigEndian)
+   {
+      if ( !bigEndian )
+      {
+         return readLEDouble(p);
+      }
+      ossim_uint8 tmp[8];
+      for ( int i = 0; i < 8; ++i )
+      {
+         tmp[i] = p[7 - i];
+      }
+      return readLEDouble(tmp);
+   }
+
+   void writeLE32(std::vector<ossim_uint8>& out, ossim_int32 v)
+   {
+      ossim_uint32 u = static_cast<ossim_uint32>(v);
+      for ( int i = 0; i < 4; ++i )
+      {
+         out.push_back( static_cast<ossim_uint8>( (u >> (8 * i)) & 0xff ) );
+      }
+   }
+
+   void writeLEDouble(std::vector<ossim_uint8>& out, double d)
+   {
+      ossim_uint64 bits;
+      std::memcpy(&bits, &d, sizeof(d));
+      for ( int i = 0; i < 8; ++i )
+      {
+         out.push_back( static_cast<ossim_uint8>( (bits >> (8 * i)) & 0xff ) );
+      }
+   }
+
+   bool isPointType(int type)
+   {
+      return (type == SHPT_POINT) || (type == SHPT_POINTZ) || (type == SHPT_POINTM);
+   }
+
+   bool isMultiPointType(int type)
+   {
+      return (type == SHPT_MULTIPOINT) || (type == SHPT_MULTIPOINTZ) ||
+         (type == SHPT_MULTIPOINTM);
+   }
+
+   bool hasZ(int type)
+   {
+      return (type == SHPT_POINTZ) || (type == SHPT_ARCZ) || (type == SHPT_POLYGONZ) ||
+         (type == SHPT_MULTIPOINTZ) || (type == SHPT_MULTIPATCH);
+   }
+
+   // .shp/.shx file header size and .qix header size.
+   const ossim_uint32 SHP_HEADER_SIZE = 100;
+   const ossim_uint32 QIX_HEADER_SIZE = 16;
+}
+
+//---
+// MappedFile
+//---
+
+ossimMappedShapeFile::MappedFile::MappedFile()
+   : m_data(0),
+     m_size(0)
+#if defined(_WIN32)
+   , m_file(0),
+     m_mapping(0)
+#endif
+{
+}
+
+ossimMappedShapeFile::MappedFile::~MappedFile()
+{
+   close();
+}
+
+bool ossimMappedShapeFile::MappedFile::open(const ossimFilename& file)
+{
+   close();
+
+#if defined(_WIN32)
+   HANDLE h = CreateFileA( file.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+   if ( h == INVALID_HANDLE_VALUE )
+   {
+      return false;
+   }
+   LARGE_INTEGER size;
+   if ( !GetFileSizeEx(h, &size) || (size.QuadPart == 0) )
+   {
+      CloseHandle(h);
+      return false;
+   }
+   HANDLE mapping = CreateFileMappingA( h, 0, PAGE_READONLY, 0, 0, 0 );
+   if ( !mapping )
+   {
+      CloseHandle(h);
+      return false;
+   }
+   void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+   if ( !view )
+   {
+      CloseHandle(mapping);
+      CloseHandle(h);
+      return false;
+   }
+   m_file    = h;
+   m_mapping = mapping;
+   m_data    = static_cast<const ossim_uint8*>(view);
+   m_size    = static_cast<ossim_uint64>(size.QuadPart);
+#else
+   int fd = ::open( file.c_str(), O_RDONLY );
+   if ( fd < 0 )
+   {
+      return false;
+   }
+   struct stat st;
+   if ( (fstat(fd, &st) != 0) || (st.st_size == 0) )
+   {
+      ::close(fd);
+      return false;
+   }
+   void* view = mmap( 0, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0 );
+   ::close(fd); // Mapping stays valid.
+   if ( view == MAP_FAILED )
+   {
+      return false;
+   }
+   m_data = static_cast<const ossim_uint8*>(view);
+   m_size = static_cast<ossim_uint64>(st.st_size);
+#endif
+
+   return true;
+}
+
+void ossimMappedShapeFile::MappedFile::close()
+{
+   if ( m_data )
+   {
+#if defined(_WIN32)
+      UnmapViewOfFile( m_data );
+      CloseHandle( static_cast<HANDLE>(m_mapping) );
+      CloseHandle( static_cast<HANDLE>(m_file) );
+      m_mapping = 0;
+      m_file    = 0;
+#else
+      munmap( const_cast<ossim_uint8*>(m_data), static_cast<size_t>(m_size) );
+#endif
+      m_data = 0;
+      m_size = 0;
+   }
+}
+
+//---
+// ossimMappedShapeFile
+//---
+
+ossimMappedShapeFile::ossimMappedShapeFile()
+   : m_filename(),
+     m_shp(),
+     m_shx(),
+     m_shapeType(SHPT_NULL),
+     m_numberOfShapes(0),
+     m_nodes()
+{
+   m_boundsMin[0] = m_boundsMin[1] = 0.0;
+   m_boundsMax[0] = m_boundsMax[1] = 0.0;
+}
+
+ossimMappedShapeFile::~ossimMappedShapeFile()
+{
+   close();
+}
+
+bool ossimMappedShapeFile::open(const ossimFilename& file, ossim_int32 maxDepth)
+{
+   close();
+
+   // Match the case of the .shp extension for the sidecar files.
+   const bool upper = ( file.ext() == file.ext().upcase() );
+
+   ossimFilename shxFile = file;
+   shxFile.setExtension( upper ? "SHX" : "shx" );
+
+   if ( !m_shp.open(file) || !m_shx.open(shxFile) ||
+        (m_shp.size() < SHP_HEADER_SIZE) || (m_shx.size() < SHP_HEADER_SIZE) ||
+        (readBE32(m_shp.data()) != 9994) )
+   {
+      if (traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimMappedShapeFile::open DEBUG: Could not map: " << file << "\n";
+      }
+      close();
+      return false;
+   }
+
+   m_filename       = file;
+   m_shapeType      = readLE32( m_shp.data() + 32 );
+   m_numberOfShapes = static_cast<ossim_int32>( (m_shx.size() - SHP_HEADER_SIZE) / 8 );
+   m_boundsMin[0]   = readLEDouble( m_shp.data() + 36 );
+   m_boundsMin[1]   = readLEDouble( m_shp.data() + 44 );
+   m_boundsMax[0]   = readLEDouble( m_shp.data() + 52 );
+   m_boundsMax[1]   = readLEDouble( m_shp.data() + 60 );
+
+   ossimFilename qixFile = file;
+   qixFile.setExtension( upper ? "QIX" : "qix" );
+   if ( !readIndex(qixFile) )
+   {
+      buildIndex(maxDepth);
+   }
+
+   return true;
+}
+
+void ossimMappedShapeFile::close()
+{
+   m_shp.close();
+   m_shx.close();
+   m_nodes.clear();
+   m_filename.clear();
+   m_shapeType      = SHPT_NULL;
+   m_numberOfShapes = 0;
+}
+
+bool ossimMappedShapeFile::isOpen() const
+{
+   return ( m_shp.data() != 0 );
+}
+
+const ossimFilename& ossimMappedShapeFile::getFilename() const
+{
+   return m_filename;
+}
+
+int ossimMappedShapeFile::getShapeType() const
+{
+   return m_shapeType;
+}
+
+ossim_int32 ossimMappedShapeFile::getNumberOfShapes() const
+{
+   return m_numberOfShapes;
+}
+
+void ossimMappedShapeFile::getBounds(double& minX, double& minY,
+                                     double& maxX, double& maxY) const
+{
+   minX = m_boundsMin[0];
+   minY = m_boundsMin[1];
+   maxX = m_boundsMax[0];
+   maxY = m_boundsMax[1];
+}
+
+const ossim_uint8* ossimMappedShapeFile::getRecord(ossim_int32 record,
+                                                   ossim_uint32& contentLength) const
+{
+   if ( (record < 0) || (record >= m_numberOfShapes) )
+   {
+      return 0;
+   }
+
+   const ossim_uint8* shx = m_shx.data() + SHP_HEADER_SIZE + 8 * record;
+
+   // Offsets and lengths are in 16 bit words.
+   ossim_uint64 offset = static_cast<ossim_uint64>( readBE32(shx) ) * 2;
+   contentLength       = static_cast<ossim_uint32>( readBE32(shx + 4) ) * 2;
+
+   if ( (contentLength < 4) || (offset + 8 + contentLength > m_shp.size()) )
+   {
+      return 0;
+   }
+
+   return m_shp.data() + offset + 8;
+}
+
+bool ossimMappedShapeFile::getRecordBounds(ossim_int32 record,
+                                           double& minX, double& minY,
+                                           double& maxX, double& maxY) const
+{
+   ossim_uint32 length = 0;
+   const ossim_uint8* p = getRecord(record, length);
+   if ( !p )
+   {
+      return false;
+   }
+
+   int type = readLE32(p);
+   if ( isPointType(type) && (length >= 20) )
+   {
+      minX = maxX = readLEDouble(p + 4);
+      minY = maxY = readLEDouble(p + 12);
+      return true;
+   }
+   if ( (type != SHPT_NULL) && (length >= 36) )
+   {
+      minX = readLEDouble(p + 4);
+      minY = readLEDouble(p + 12);
+      maxX = readLEDouble(p + 20);
+      maxY = readLEDouble(p + 28);
+      return true;
+   }
+   return false;
+}
+
+void ossimMappedShapeFile::findShapes(double minX, double minY, double maxX, double maxY,
+                                      std::vector<ossim_int32>& ids) const
+{
+   ids.clear();
+   if ( m_nodes.empty() )
+   {
+      return;
+   }
+
+   const double qmin[2] = { minX, minY };
+   const double qmax[2] = { maxX, maxY };
+
+   std::vector<ossim_int32> candidates;
+   query(0, qmin, qmax, candidates);
+   std::sort(candidates.begin(), candidates.end());
+
+   // Tree nodes only bound their shapes loosely; check the record bounds.
+   double x0, y0, x1, y1;
+   for ( std::size_t i = 0; i < candidates.size(); ++i )
+   {
+      if ( getRecordBounds(candidates[i], x0, y0, x1, y1) &&
+           (x0 <= maxX) && (x1 >= minX) && (y0 <= maxY) && (y1 >= minY) )
+      {
+         ids.push_back(candidates[i]);
+      }
+   }
+}
+
+SHPObject* ossimMappedShapeFile::readObject(ossim_int32 record) const
+{
+   ossim_uint32 length = 0;
+   const ossim_uint8* p = getRecord(record, length);
+   if ( !p )
+   {
+      return 0;
+   }
+
+   const ossim_uint8* end = p + length;
+   const int type = readLE32(p);
+
+   if ( isPointType(type) )
+   {
+      if ( length < 20 )
+      {
+         return 0;
+      }
+      double x = readLEDouble(p + 4);
+      double y = readLEDouble(p + 12);
+      double z = ( (type == SHPT_POINTZ) && (length >= 28) ) ? readLEDouble(p + 20) : 0.0;
+      return SHPCreateObject( type, record, 0, 0, 0, 1, &x, &y, &z, 0 );
+   }
+
+   if ( (type == SHPT_NULL) || (length < 40) )
+   {
+      return 0;
+   }
+
+   ossim_int32 nParts  = 0;
+   ossim_int32 nPoints = 0;
+   const ossim_uint8* cur = 0;
+
+   std::vector<int> partStart;
+   std::vector<int> partType;
+
+   if ( isMultiPointType(type) )
+   {
+      nPoints = readLE32(p + 36);
+      cur     = p + 40;
+   }
+   else
+   {
+      if ( length < 44 )
+      {
+         return 0;
+      }
+      nParts  = readLE32(p + 36);
+      nPoints = readLE32(p + 40);
+      cur     = p + 44;
+
+      if ( (nParts < 0) || (cur + 4 * nParts > end) )
+      {
+         return 0;
+      }
+      partStart.resize(nParts);
+      for ( ossim_int32 i = 0; i < nParts; ++i, cur += 4 )
+      {
+         partStart[i] = readLE32(cur);
+      }
+      if ( type == SHPT_MULTIPATCH )
+      {
+         if ( cur + 4 * nParts > end )
+         {
+            return 0;
+         }
+         partType.resize(nParts);
+         for ( ossim_int32 i = 0; i < nParts; ++i, cur += 4 )
+         {
+            partType[i] = readLE32(cur);
+         }
+      }
+   }
+
+   if ( (nPoints < 0) || (cur + 16 * static_cast<ossim_uint64>(nPoints) > end) )
+   {
+      return 0;
+   }
+
+   std::vector<double> x(nPoints);
+   std::vector<double> y(nPoints);
+   for ( ossim_int32 i = 0; i < nPoints; ++i, cur += 16 )
+   {
+      x[i] = readLEDouble(cur);
+      y[i] = readLEDouble(cur + 8);
+   }
+
+   std::vector<double> z;
+   if ( hasZ(type) && (cur + 16 + 8 * static_cast<ossim_uint64>(nPoints) <= end) )
+   {
+      cur += 16; // z range
+      z.resize(nPoints);
+      for ( ossim_int32 i = 0; i < nPoints; ++i, cur += 8 )
+      {
+         z[i] = readLEDouble(cur);
+      }
+   }
+
+   return SHPCreateObject( type, record, nParts,
+                           nParts ? &partStart.front() : 0,
+                           partType.size() ? &partType.front() : 0,
+                           nPoints,
+                           nPoints ? &x.front() : 0,
+                           nPoints ? &y.front() : 0,
+                           z.size() ? &z.front() : 0,
+                           0 );
+}
+
+bool ossimMappedShapeFile::readIndex(const ossimFilename& qixFile)
+{
+   MappedFile qix;
+   if ( !qixFile.exists() || !qix.open(qixFile) || (qix.size() < QIX_HEADER_SIZE) )
+   {
+      return false;
+   }
+
+   const ossim_uint8* buf = qix.data();
+   if ( std::memcmp(buf, "SQT", 3) != 0 )
+   {
+      return false;
+   }
+
+   // Byte order: 1 = LSB, 2 = MSB, 0 = native (old files, assume LSB).
+   const bool swap = ( buf[3] == 2 );
+
+   if ( read32(buf + 8, swap) != m_numberOfShapes )
+   {
+      if (traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimMappedShapeFile::readIndex DEBUG: Stale index ignored: " << qixFile << "\n";
+      }
+      return false;
+   }
+
+   m_nodes.clear();
+   ossim_int32 root = -1;
+   if ( readNode(buf, qix.size(), QIX_HEADER_SIZE, swap, root) == 0 )
+   {
+      m_nodes.clear();
+      return false;
+   }
+
+   return true;
+}
+
+ossim_uint64 ossimMappedShapeFile::readNode(const ossim_uint8* buf, ossim_uint64 size,
+                                            ossim_uint64 pos, bool swap,
+                                            ossim_int32& nodeIndex)
+{
+   // offset(4) bounds(32) count(4) ids(4*count) nSubNodes(4)
+   if ( pos + 40 > size )
+   {
+      return 0;
+   }
+
+   nodeIndex = static_cast<ossim_int32>( m_nodes.size() );
+   m_nodes.push_back( Node() );
+
+   Node node;
+   node.m_min[0] = readDouble(buf + pos + 4,  swap);
+   node.m_min[1] = readDouble(buf + pos + 12, swap);
+   node.m_max[0] = readDouble(buf + pos + 20, swap);
+   node.m_max[1] = readDouble(buf + pos + 28, swap);
+   node.m_children[0] = node.m_children[1] = node.m_children[2] = node.m_children[3] = -1;
+
+   ossim_int32 count = read32(buf + pos + 36, swap);
+   pos += 40;
+   if ( (count < 0) || (pos + 4 * static_cast<ossim_uint64>(count) + 4 > size) )
+   {
+      return 0;
+   }
+   node.m_ids.resize(count);
+   for ( ossim_int32 i = 0; i < count; ++i, pos += 4 )
+   {
+      node.m_ids[i] = read32(buf + pos, swap);
+   }
+
+   ossim_int32 nSubNodes = read32(buf + pos, swap);
+   pos += 4;
+   if ( (nSubNodes < 0) || (nSubNodes > 4) )
+   {
+      return 0;
+   }
+
+   for ( ossim_int32 i = 0; i < nSubNodes; ++i )
+   {
+      ossim_int32 child = -1;
+      pos = readNode(buf, size, pos, swap, child);
+      if ( pos == 0 )
+      {
+         return 0;
+      }
+      node.m_children[i] = child;
+   }
+
+   m_nodes[nodeIndex] = node;
+   return pos;
+}
+
+void ossimMappedShapeFile::buildIndex(ossim_int32 maxDepth)
+{
+   m_nodes.clear();
+
+   Node root;
+   root.m_min[0] = m_boundsMin[0];
+   root.m_min[1] = m_boundsMin[1];
+   root.m_max[0] = m_boundsMax[0];
+   root.m_max[1] = m_boundsMax[1];
+   root.m_children[0] = root.m_children[1] = root.m_children[2] = root.m_children[3] = -1;
+   m_nodes.push_back(root);
+
+   if ( maxDepth <= 0 )
+   {
+      maxDepth = 10;
+   }
+
+   double bmin[2];
+   double bmax[2];
+   for ( ossim_int32 id = 0; id < m_numberOfShapes; ++id )
+   {
+      if ( getRecordBounds(id, bmin[0], bmin[1], bmax[0], bmax[1]) )
+      {
+         insert(0, id, bmin, bmax, 1, maxDepth);
+      }
+   }
+}
+
+void ossimMappedShapeFile::insert(ossim_int32 node, ossim_int32 id,
+                                  const double* bmin, const double* bmax,
+                                  ossim_int32 depth, ossim_int32 maxDepth)
+{
+   if ( depth < maxDepth )
+   {
+      //---
+      // Quadrants made like shapelib's SHPTreeSplitBounds: halve the longer
+      // axis, then halve each half along its longer axis.
+      //---
+      double qmin[4][2];
+      double qmax[4][2];
+      const double* nmin = m_nodes[node].m_min;
+      const double* nmax = m_nodes[node].m_max;
+
+      double hmin[2][2];
+      double hmax[2][2];
+      int axis = ( (nmax[0] - nmin[0]) >= (nmax[1] - nmin[1]) ) ? 0 : 1;
+      for ( int h = 0; h < 2; ++h )
+      {
+         hmin[h][0] = nmin[0]; hmin[h][1] = nmin[1];
+         hmax[h][0] = nmax[0]; hmax[h][1] = nmax[1];
+      }
+      double mid = nmin[axis] + (nmax[axis] - nmin[axis]) * 0.5;
+      hmax[0][axis] = mid;
+      hmin[1][axis] = mid;
+
+      for ( int h = 0; h < 2; ++h )
+      {
+         int a = ( (hmax[h][0] - hmin[h][0]) >= (hmax[h][1] - hmin[h][1]) ) ? 0 : 1;
+         double m = hmin[h][a] + (hmax[h][a] - hmin[h][a]) * 0.5;
+         for ( int q = 0; q < 2; ++q )
+         {
+            int k = h * 2 + q;
+            qmin[k][0] = hmin[h][0]; qmin[k][1] = hmin[h][1];
+            qmax[k][0] = hmax[h][0]; qmax[k][1] = hmax[h][1];
+         }
+         qmax[h * 2][a]     = m;
+         qmin[h * 2 + 1][a] = m;
+      }
+
+      for ( int k = 0; k < 4; ++k )
+      {
+         if ( (bmin[0] >= qmin[k][0]) && (bmax[0] <= qmax[k][0]) &&
+              (bmin[1] >= qmin[k][1]) && (bmax[1] <= qmax[k][1]) )
+         {
+            ossim_int32 child = m_nodes[node].m_children[k];
+            if ( child < 0 )
+            {
+               Node n;
+               n.m_min[0] = qmin[k][0]; n.m_min[1] = qmin[k][1];
+               n.m_max[0] = qmax[k][0]; n.m_max[1] = qmax[k][1];
+               n.m_children[0] = n.m_children[1] = n.m_children[2] = n.m_children[3] = -1;
+               child = static_cast<ossim_int32>( m_nodes.size() );
+               m_nodes.push_back(n); // Invalidates nmin/nmax.
+               m_nodes[node].m_children[k] = child;
+            }
+            insert(child, id, bmin, bmax, depth + 1, maxDepth);
+            return;
+         }
+      }
+   }
+
+   m_nodes[node].m_ids.push_back(id);
+}
+
+void ossimMappedShapeFile::query(ossim_int32 node, const double* qmin, const double* qmax,
+                                 std::vector<ossim_int32>& ids) const
+{
+   const Node& n = m_nodes[node];
+   if ( (n.m_min[0] > qmax[0]) || (n.m_max[0] < qmin[0]) ||
+        (n.m_min[1] > qmax[1]) || (n.m_max[1] < qmin[1]) )
+   {
+      return;
+   }
+
+   ids.insert( ids.end(), n.m_ids.begin(), n.m_ids.end() );
+
+   for ( int k = 0; k < 4; ++k )
+   {
+      if ( n.m_children[k] >= 0 )
+      {
+         query(n.m_children[k], qmin, qmax, ids);
+      }
+   }
+}
+
+ossim_uint32 ossimMappedShapeFile::subtreeSize(ossim_int32 node) const
+{
+   // Bytes written for the children of node, the .qix "offset" field.
+   ossim_uint32 size = 0;
+   const Node& n = m_nodes[node];
+   for ( int k = 0; k < 4; ++k )
+   {
+      if ( n.m_children[k] >= 0 )
+      {
+         const Node& c = m_nodes[ n.m_children[k] ];
+         size += 44 + 4 * static_cast<ossim_uint32>( c.m_ids.size() ) +
+            subtreeSize( n.m_children[k] );
+      }
+   }
+   return size;
+}
+
+ossim_int32 ossimMappedShapeFile::treeDepth(ossim_int32 node) const
+{
+   ossim_int32 depth = 0;
+   for ( int k = 0; k < 4; ++k )
+   {
+      if ( m_nodes[node].m_children[k] >= 0 )
+      {
+         depth = std::max( depth, treeDepth( m_nodes[node].m_children[k] ) );
+      }
+   }
+   return depth + 1;
+}
+
+void ossimMappedShapeFile::writeNode(std::vector<ossim_uint8>& out, ossim_int32 node) const
+{
+   const Node& n = m_nodes[node];
+
+   writeLE32( out, static_cast<ossim_int32>( subtreeSize(node) ) );
+   writeLEDouble( out, n.m_min[0] );
+   writeLEDouble( out, n.m_min[1] );
+   writeLEDouble( out, n.m_max[0] );
+   writeLEDouble( out, n.m_max[1] );
+   writeLE32( out, static_cast<ossim_int32>( n.m_ids.size() ) );
+   for ( std::size_t i = 0; i < n.m_ids.size(); ++i )
+   {
+      writeLE32( out, n.m_ids[i] );
+   }
+
+   ossim_int32 nSubNodes = 0;
+   for ( int k = 0; k < 4; ++k )
+   {
+      if ( n.m_children[k] >= 0 ) ++nSubNodes;
+   }
+   writeLE32( out, nSubNodes );
+   for ( int k = 0; k < 4; ++k )
+   {
+      if ( n.m_children[k] >= 0 )
+      {
+         writeNode( out, n.m_children[k] );
+      }
+   }
+}
+
+bool ossimMappedShapeFile::writeIndex(const ossimFilename& qixFile) const
+{
+   if ( m_nodes.empty() )
+   {
+      return false;
+   }
+
+   std::vector<ossim_uint8> out;
+   out.push_back('S');
+   out.push_back('Q');
+   out.push_back('T');
+   out.push_back(1); // LSB byte order
+   out.push_back(1); // version
+   out.push_back(0);
+   out.push_back(0);
+   out.push_back(0);
+   writeLE32( out, m_numberOfShapes );
+
+   writeLE32( out, treeDepth(0) );
+
+   writeNode( out, 0 );
+
+   std::ofstream os( qixFile.c_str(), std::ios::out | std::ios::binary );
+   if ( !os.good() )
+   {
+      return false;
+   }
+   os.write( reinterpret_cast<const char*>( &out.front() ),
+             static_cast<std::streamsize>( out.size() ) );
+   return os.good();
+}
@@ -0,0 +1,146 @@
+//*******************************************************************
+//
+// License:  See top level LICENSE.txt file.
+//
+// Description: Memory mapped, read only ESRI shape file with a quadtree
+// index.
+//
+//*************************************************************************
+// $Id$
+
+#ifndef ossimMappedShapeFile_HEADER
+#define ossimMappedShapeFile_HEADER 1
+
+#include <shapefil.h>
+
+#include <ossim/plugin/ossimPluginConstants.h>
+#include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimFilename.h>
+#include <vector>
+
+/**
+ * @class ossimMappedShapeFile
+ *
+ * Read only shape file access through memory mapped .shp and .shx files.
+ *
+ * Nothing is decoded at open.  Record bounds are read straight from the
+ * mapped bytes and geometry is only decoded for records a caller asks for.
+ * Bounding box queries go through a quadtree that is read from a .qix file
+ * next to the .shp if one exists (shapelib/MapServer "SQT" layout), or built
+ * from the record bounds otherwise.  Shapes that do not intersect the query
+ * are never materialized.
+ */
+class OSSIM_PLUGINS_DLL ossimMappedShapeFile
+{
+public:
+   ossimMappedShapeFile();
+   ~ossimMappedShapeFile();
+
+   /**
+    * @brief Maps file.shp and file.shx and loads or builds the index.
+    * @param file The .shp file.
+    * @param maxDepth Quadtree depth used when no .qix is found.
+    * @return true on success.
+    */
+   bool open(const ossimFilename& file, ossim_int32 maxDepth = 10);
+
+   void close();
+
+   bool isOpen() const;
+
+   const ossimFilename& getFilename() const;
+
+   /** @return SHPT_* shape type from the .shp header. */
+   int getShapeType() const;
+
+   ossim_int32 getNumberOfShapes() const;
+
+   /** @brief Gets the file bounds from the .shp header. */
+   void getBounds(double& minX, double& minY, double& maxX, double& maxY) const;
+
+   /**
+    * @brief Gets the bounds of one record from the mapped bytes.
+    * @return false for null shapes or bad record.
+    */
+   bool getRecordBounds(ossim_int32 record,
+                        double& minX, double& minY,
+                        double& maxX, double& maxY) const;
+
+   /**
+    * @brief Finds records whose bounds intersect the box.
+    * @param ids Initialized by this in ascending record order.
+    */
+   void findShapes(double minX, double minY, double maxX, double maxY,
+                   std::vector<ossim_int32>& ids) const;
+
+   /**
+    * @brief Decodes one record.
+    * @return New SHPObject the caller must free with SHPDestroyObject, or 0
+    * for null shapes or bad record.
+    */
+   SHPObject* readObject(ossim_int32 record) const;
+
+   /** @brief Writes the quadtree to a .qix file. */
+   bool writeIndex(const ossimFilename& qixFile) const;
+
+private:
+   ossimMappedShapeFile(const ossimMappedShapeFile&);
+   ossimMappedShapeFile& operator=(const ossimMappedShapeFile&);
+
+   /** Read only view of a whole file. */
+   class MappedFile
+   {
+   public:
+      MappedFile();
+      ~MappedFile();
+      bool open(const ossimFilename& file);
+      void close();
+      const ossim_uint8* data() const { return m_data; }
+      ossim_uint64 size() const { return m_size; }
+   private:
+      MappedFile(const MappedFile&);
+      MappedFile& operator=(const MappedFile&);
+      const ossim_uint8* m_data;
+      ossim_uint64       m_size;
+#if defined(_WIN32)
+      void*              m_file;
+      void*              m_mapping;
+#endif
+   };
+
+   struct Node
+   {
+      double                   m_min[2];
+      double                   m_max[2];
+      std::vector<ossim_int32> m_ids;
+      ossim_int32              m_children[4];
+   };
+
+   /** @return Pointer to record content (after the 8 byte header) or 0. */
+   const ossim_uint8* getRecord(ossim_int32 record, ossim_uint32& contentLength) const;
+
+   bool readIndex(const ossimFilename& qixFile);
+   ossim_uint64 readNode(const ossim_uint8* buf, ossim_uint64 size, ossim_uint64 pos,
+                         bool swap, ossim_int32& nodeIndex);
+   void buildIndex(ossim_int32 maxDepth);
+   void insert(ossim_int32 node, ossim_int32 id, const double* bmin, const double* bmax,
+               ossim_int32 depth, ossim_int32 maxDepth);
+   void query(ossim_int32 node, const double* qmin, const double* qmax,
+              std::vector<ossim_int32>& ids) const;
+   ossim_uint32 subtreeSize(ossim_int32 node) const;
+   ossim_int32 treeDepth(ossim_int32 node) const;
+   void writeNode(std::vector<ossim_uint8>& out, ossim_int32 node) const;
+
+   ossimFilename     m_filename;
+   MappedFile        m_shp;
+   MappedFile        m_shx;
+   int               m_shapeType;
+   ossim_int32       m_numberOfShapes;
+   double            m_boundsMin[2];
+   double            m_boundsMax[2];
+
+   /** Quadtree nodes; m_nodes[0] is the root. */
+   std::vector<Node> m_nodes;
+};
+
+#endif /* ossimMappedShapeFile_HEADER */
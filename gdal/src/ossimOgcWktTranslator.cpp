@@ -44,6 +44,12 @@ static const double SEMI_MINOR_AXIS_WGS84 = 6356752.3142;
 
 static ossimTrace traceDebug("ossimOgcWktTranslator:debug");
 
+// Shared by every translator instance; plugins each keep a static translator.
+ossimOgcWktTranslator::Memo<std::string>
+ossimOgcWktTranslator::theFromKwlCache;
+ossimOgcWktTranslator::Memo<ossimOgcWktTranslator::ToKwlResult>
+ossimOgcWktTranslator::theToKwlCache;
+
 //*******************************************************************
 // Public Function:
 //*******************************************************************
@@ -57,6 +63,54 @@ ossimOgcWktTranslator::ossimOgcWktTranslator()
 #define USER_DEFINED  32767
 ossimString ossimOgcWktTranslator::fromOssimKwl(const ossimKeywordlist &kwl,
                                                 const char *prefix)const
+{
+   //---
+   // Key on exactly the keywords fromOssimKwlUncached reads: the unprefixed
+   // type/datum and the prefixed projection parameters.  Tie points, gsd and
+   // the like differ per image and would defeat the cache.
+   //---
+   static const char* const PROJECTION_KWS[] =
+   {
+      ossimKeywordNames::ZONE_KW,
+      ossimKeywordNames::HEMISPHERE_KW,
+      ossimKeywordNames::STD_PARALLEL_1_KW,
+      ossimKeywordNames::STD_PARALLEL_2_KW,
+      ossimKeywordNames::ORIGIN_LATITUDE_KW,
+      ossimKeywordNames::CENTRAL_MERIDIAN_KW,
+      ossimKeywordNames::SCALE_FACTOR_KW,
+      ossimKeywordNames::PCS_CODE_KW,
+      ossimKeywordNames::FALSE_EASTING_NORTHING_UNITS_KW,
+      ossimKeywordNames::FALSE_EASTING_NORTHING_KW,
+      ossimKeywordNames::FALSE_EASTING_KW,
+      ossimKeywordNames::FALSE_NORTHING_KW
+   };
+   
+   const char* lookup = kwl.find(ossimKeywordNames::TYPE_KW);
+   std::string key = lookup ? lookup : "";
+   key += '\n';
+   lookup = kwl.find(ossimKeywordNames::DATUM_KW);
+   key += lookup ? lookup : "";
+   for ( size_t i = 0; i < sizeof(PROJECTION_KWS) / sizeof(PROJECTION_KWS[0]); ++i )
+   {
+      // Missing and empty differ; the false easting/northing units are tested for presence.
+      lookup = kwl.find(prefix, PROJECTION_KWS[i]);
+      key += lookup ? '\n' : '\r';
+      key += lookup ? lookup : "";
+   }
+
+   std::string wkt;
+   if ( theFromKwlCache.get( key, wkt ) )
+   {
+      return ossimString( wkt );
+   }
+
+   ossimString result = fromOssimKwlUncached( kwl, prefix );
+   theFromKwlCache.put( key, result.string() );
+   return result;
+}
+
+ossimString ossimOgcWktTranslator::fromOssimKwlUncached(const ossimKeywordlist &kwl,
+                                                        const char *prefix)const
 {
    ossimString projType = kwl.find(ossimKeywordNames::TYPE_KW);
    ossimString datumType = kwl.find(ossimKeywordNames::DATUM_KW);
@@ -549,6 +603,37 @@ ossimString ossimOgcWktTranslator::fromOssimKwl(const ossimKeywordlist &kwl,
 bool ossimOgcWktTranslator::toOssimKwl( const ossimString& wktString,
                                         ossimKeywordlist &kwl,
                                         const char *prefix)const
+{
+   // Translate once without a prefix and replay the keywords under the
+   // caller's prefix.  Failed translations are cached too since they may
+   // still have added keywords.
+   ToKwlResult result;
+   if ( !theToKwlCache.get( wktString.string(), result ) )
+   {
+      ossimKeywordlist tmpKwl;
+      result.first = toOssimKwlUncached( wktString, tmpKwl, 0 );
+      result.second = tmpKwl.getMap();
+      theToKwlCache.put( wktString.string(), result );
+   }
+
+   for ( ossimKeywordlist::KeywordMap::const_iterator i = result.second.begin();
+         i != result.second.end(); ++i )
+   {
+      kwl.add( prefix, i->first.c_str(), i->second.c_str(), true );
+   }
+
+   return result.first;
+}
+
+void ossimOgcWktTranslator::clearCache()
+{
+   theFromKwlCache.clear();
+   theToKwlCache.clear();
+}
+
+bool ossimOgcWktTranslator::toOssimKwlUncached( const ossimString& wktString,
+                                                ossimKeywordlist &kwl,
+                                                const char *prefix)const
 
 {
    static const char MODULE[] = "ossimOgcWktTranslator::toOssimKwl";
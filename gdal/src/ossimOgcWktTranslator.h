@@ -21,8 +21,11 @@
 #include <ossim/base/ossimCommon.h>
 #include <ossim/base/ossimString.h>
 
+#include <list>
 #include <map>
+#include <mutex>
 #include <string>
+#include <utility>
 
 class ossimKeywordlist;
 
@@ -37,6 +40,15 @@ public:
    
    ossimString fromOssimKwl(const ossimKeywordlist& kwl,
                             const char* prefix=NULL)const;
+
+   /**
+    * @brief Clears the translation caches.
+    *
+    * toOssimKwl and fromOssimKwl results are memoized process wide, keyed by
+    * the WKT string and by the projection keywords respectively, so repeated
+    * opens of same-CRS images skip the OGR/PROJ lookups.
+    */
+   static void clearCache();
    /*!
     * Returns the empty string if the datum is not found
     *
@@ -57,7 +69,76 @@ protected:
 
    void initializeDatumTable();
    void initializeProjectionTable();
-   
+
+private:
+
+   bool toOssimKwlUncached(const ossimString& wktString,
+                           ossimKeywordlist& kwl,
+                           const char* prefix)const;
+
+   ossimString fromOssimKwlUncached(const ossimKeywordlist& kwl,
+                                    const char* prefix)const;
+
+   /** Bounded, thread safe least recently used map from string keys. */
+   template <class V> class Memo
+   {
+   public:
+      Memo() : m_mutex(), m_list(), m_map() {}
+
+      bool get(const std::string& key, V& value)
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         typename Map::iterator i = m_map.find(key);
+         if ( i == m_map.end() )
+         {
+            return false;
+         }
+         m_list.splice(m_list.begin(), m_list, i->second);
+         value = i->second->second;
+         return true;
+      }
+
+      void put(const std::string& key, const V& value)
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         typename Map::iterator i = m_map.find(key);
+         if ( i != m_map.end() )
+         {
+            m_list.splice(m_list.begin(), m_list, i->second);
+            i->second->second = value;
+            return;
+         }
+         m_list.push_front(std::make_pair(key, value));
+         m_map[key] = m_list.begin();
+         if ( m_map.size() > MAX_ENTRIES )
+         {
+            m_map.erase(m_list.back().first);
+            m_list.pop_back();
+         }
+      }
+
+      void clear()
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_map.clear();
+         m_list.clear();
+      }
+
+   private:
+      enum { MAX_ENTRIES = 512 };
+      typedef std::list< std::pair<std::string, V> > List;
+      typedef std::map<std::string, typename List::iterator> Map;
+
+      std::mutex m_mutex;
+      List       m_list;
+      Map        m_map;
+   };
+
+   /** toOssimKwl return status and the unprefixed keywords it added. */
+   typedef std::pair< bool, std::map<std::string, std::string> > ToKwlResult;
+
+   static Memo<std::string> theFromKwlCache;
+   static Memo<ToKwlResult> theToKwlCache;
 };
 
 #endif
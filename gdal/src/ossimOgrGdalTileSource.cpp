@@ -114,6 +114,13 @@ ossimRefPtr<ossimImageData> ossimOgrGdalTileSource::getTile(
    return theAnnotationSource->getTile(tileRect, resLevel);
 }
 
+void ossimOgrGdalTileSource::getTiles(
+   const std::vector<ossimIrect>& rects, ossim_uint32 resLevel,
+   std::vector< ossimRefPtr<ossimImageData> >& tiles)
+{
+   theAnnotationSource->getTiles(rects, resLevel, tiles);
+}
+
 ossim_uint32 ossimOgrGdalTileSource::getNumberOfInputBands() const
 {
    return theAnnotationSource->getNumberOfOutputBands();
@@ -66,6 +66,14 @@ public:
    virtual ossimRefPtr<ossimImageData> getTile(const ossimIrect& tileRect,
                                                ossim_uint32 resLevel=0);
 
+   /**
+    * @brief Renders several tiles concurrently.
+    * @see ossimGdalOgrVectorAnnotation::getTiles
+    */
+   void getTiles(const std::vector<ossimIrect>& rects,
+                 ossim_uint32 resLevel,
+                 std::vector< ossimRefPtr<ossimImageData> >& tiles);
+
    /*!
     *  Returns the number of bands in the image.
     *  Satisfies pure virtual from ImageHandler class.
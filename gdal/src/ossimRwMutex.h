@@ -0,0 +1,107 @@
+//----------------------------------------------------------------------------
+//
+// File: ossimRwMutex.h
+//
+// License:  MIT
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: Reader-writer mutex for C++11 builds.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#ifndef ossimRwMutex_HEADER
+#define ossimRwMutex_HEADER 1
+
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @class ossimRwMutex
+ *
+ * Minimal reader-writer lock.  Any number of readers may hold the lock at
+ * once; a writer waits for them to drain and blocks new readers while it is
+ * waiting so lookups cannot starve insertions.
+ *
+ * Use the ossimRwMutex::ReadLock and ossimRwMutex::WriteLock scoped guards.
+ */
+class ossimRwMutex
+{
+public:
+   ossimRwMutex()
+      : m_mutex(),
+        m_cond(),
+        m_readers(0),
+        m_writersWaiting(0),
+        m_writing(false)
+   {}
+
+   void lockShared()
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this]{ return !m_writing && (m_writersWaiting == 0); });
+      ++m_readers;
+   }
+
+   void unlockShared()
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if ( --m_readers == 0 )
+      {
+         m_cond.notify_all();
+      }
+   }
+
+   void lock()
+   {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      ++m_writersWaiting;
+      m_cond.wait(lock, [this]{ return !m_writing && (m_readers == 0); });
+      --m_writersWaiting;
+      m_writing = true;
+   }
+
+   void unlock()
+   {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_writing = false;
+      m_cond.notify_all();
+   }
+
+   /** @brief Scoped shared (reader) lock. */
+   class ReadLock
+   {
+   public:
+      explicit ReadLock(ossimRwMutex& m) : m_rw(m) { m_rw.lockShared(); }
+      ~ReadLock() { m_rw.unlockShared(); }
+   private:
+      ReadLock(const ReadLock&);
+      ReadLock& operator=(const ReadLock&);
+      ossimRwMutex& m_rw;
+   };
+
+   /** @brief Scoped exclusive (writer) lock. */
+   class WriteLock
+   {
+   public:
+      explicit WriteLock(ossimRwMutex& m) : m_rw(m) { m_rw.lock(); }
+      ~WriteLock() { m_rw.unlock(); }
+   private:
+      WriteLock(const WriteLock&);
+      WriteLock& operator=(const WriteLock&);
+      ossimRwMutex& m_rw;
+   };
+
+private:
+   ossimRwMutex(const ossimRwMutex&);
+   ossimRwMutex& operator=(const ossimRwMutex&);
+
+   std::mutex              m_mutex;
+   std::condition_variable m_cond;
+   int                     m_readers;
+   int                     m_writersWaiting;
+   bool                    m_writing;
+};
+
+#endif /* ossimRwMutex_HEADER */
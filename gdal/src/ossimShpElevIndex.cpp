@@ -1,54 +1,209 @@
 #include <ossimShpElevIndex.h>
+#include <ossim/base/ossimNotify.h>
+#include <algorithm>
+#include <cmath>
 
-
-ossimShpElevIndex::ossimShpElevIndex( std::string shpFileName ) : poMemDS( 0 ) 
+namespace
 {
-    GDALDriver *poMemDriver = GetGDALDriverManager()->GetDriverByName( "MEMORY" );
+   // Upper bound on grid dimension so a huge shapefile cannot blow up memory.
+   const ossim_uint32 MAX_BINS_PER_AXIS = 1024;
 
-    poMemDS = poMemDriver->Create( "memData", 0, 0, 0, GDT_Unknown, NULL );
-    poMemDS->Open( "memData", 1 );
+   // True if geometry is an axis aligned rectangle, i.e. equal to its envelope.
+   bool isEnvelope( const OGRGeometry* geom, const OGREnvelope& env )
+   {
+      if ( wkbFlatten( geom->getGeometryType() ) != wkbPolygon )
+      {
+         return false;
+      }
+
+      const OGRPolygon* poly = static_cast<const OGRPolygon*>( geom );
+      const OGRLinearRing* ring = poly->getExteriorRing();
+      if ( !ring || poly->getNumInteriorRings() || ( ring->getNumPoints() > 5 ) )
+      {
+         return false;
+      }
+
+      for ( int i = 0; i < ring->getNumPoints(); ++i )
+      {
+         const double x = ring->getX( i );
+         const double y = ring->getY( i );
+         if ( ( ( x != env.MinX ) && ( x != env.MaxX ) ) ||
+              ( ( y != env.MinY ) && ( y != env.MaxY ) ) )
+         {
+            return false;
+         }
+      }
+      return true;
+   }
+}
 
+ossimShpElevIndex::ossimShpElevIndex( std::string shpFileName )
+   : m_cells(),
+     m_extent(),
+     m_bins(),
+     m_binCols(0),
+     m_binRows(0),
+     m_binWidth(0.0),
+     m_binHeight(0.0)
+{
     GDALDataset *poShpDS = (GDALDataset*) GDALOpenEx( shpFileName.c_str(), GDAL_OF_VECTOR, NULL, NULL, NULL );
 
     if( poShpDS == NULL )
     {
         std::cerr <<  "Open failed for: " << shpFileName << std::endl;
     }
-    else 
+    else
     {
         OGRLayer  *poShpLayer = poShpDS->GetLayer( 0 );
-
-        poMemDS->CopyLayer( poShpLayer, poShpLayer->GetName(), NULL );
-        std::cout << poMemDS->GetLayer(0)->GetFeatureCount() << std::endl;
+        int filenameIdx = poShpLayer->GetLayerDefn()->GetFieldIndex( "filename" );
+        OGRFeature *poFeature;
+
+        poShpLayer->ResetReading();
+        while( ( poFeature = poShpLayer->GetNextFeature() ) != NULL )
+        {
+           OGRGeometry* geom = poFeature->GetGeometryRef();
+           if ( geom && !geom->IsEmpty() )
+           {
+              Cell cell;
+              geom->getEnvelope( &cell.m_envelope );
+              cell.m_filename = ( filenameIdx >= 0 ) ?
+                 poFeature->GetFieldAsString( filenameIdx ) : "";
+              cell.m_geometry = isEnvelope( geom, cell.m_envelope ) ? 0 : geom->clone();
+              m_extent.Merge( cell.m_envelope );
+              m_cells.push_back( cell );
+           }
+           OGRFeature::DestroyFeature( poFeature );
+        }
         GDALClose( poShpDS );
+
+        buildGrid();
+
+        ossimNotify(ossimNotifyLevel_INFO)
+           << "ossimShpElevIndex: indexed " << m_cells.size() << " cells from "
+           << shpFileName << std::endl;
     }
 }
 
-ossimShpElevIndex::~ossimShpElevIndex() 
+ossimShpElevIndex::~ossimShpElevIndex()
 {
-    GDALClose( poMemDS );
+   for ( std::vector<Cell>::iterator i = m_cells.begin(); i != m_cells.end(); ++i )
+   {
+      delete i->m_geometry;
+   }
 }
 
-std::string ossimShpElevIndex::searchShapefile(double lon, double lat) const
+void ossimShpElevIndex::buildGrid()
+{
+   if ( m_cells.empty() )
+   {
+      return;
+   }
+
+   // Roughly one footprint per bin for a regular tiling of cells.
+   ossim_uint32 n = static_cast<ossim_uint32>(
+      std::ceil( std::sqrt( static_cast<double>( m_cells.size() ) ) ) );
+   n = std::max<ossim_uint32>( 1, std::min( n, MAX_BINS_PER_AXIS ) );
+
+   m_binCols   = n;
+   m_binRows   = n;
+   m_binWidth  = ( m_extent.MaxX - m_extent.MinX ) / m_binCols;
+   m_binHeight = ( m_extent.MaxY - m_extent.MinY ) / m_binRows;
+   if ( m_binWidth <= 0.0 )
+   {
+      m_binCols  = 1;
+      m_binWidth = 1.0;
+   }
+   if ( m_binHeight <= 0.0 )
+   {
+      m_binRows   = 1;
+      m_binHeight = 1.0;
+   }
+
+   m_bins.resize( m_binCols * m_binRows );
+
+   for ( ossim_uint32 id = 0; id < m_cells.size(); ++id )
+   {
+      const OGREnvelope& env = m_cells[id].m_envelope;
+      ossim_uint32 c0 = std::min<ossim_uint32>( m_binCols - 1, static_cast<ossim_uint32>(
+         std::floor( ( env.MinX - m_extent.MinX ) / m_binWidth ) ) );
+      ossim_uint32 c1 = std::min<ossim_uint32>( m_binCols - 1, static_cast<ossim_uint32>(
+         std::floor( ( env.MaxX - m_extent.MinX ) / m_binWidth ) ) );
+      ossim_uint32 r0 = std::min<ossim_uint32>( m_binRows - 1, static_cast<ossim_uint32>(
+         std::floor( ( env.MinY - m_extent.MinY ) / m_binHeight ) ) );
+      ossim_uint32 r1 = std::min<ossim_uint32>( m_binRows - 1, static_cast<ossim_uint32>(
+         std::floor( ( env.MaxY - m_extent.MinY ) / m_binHeight ) ) );
+
+      for ( ossim_uint32 r = r0; r <= r1; ++r )
+      {
+         for ( ossim_uint32 c = c0; c <= c1; ++c )
+         {
+            m_bins[ r * m_binCols + c ].push_back( id );
+         }
+      }
+   }
+}
+
+bool ossimShpElevIndex::cellContains( const Cell& cell, double lon, double lat ) const
 {
-   std::string filename; 
+   const OGREnvelope& env = cell.m_envelope;
+   if ( ( lon < env.MinX ) || ( lon > env.MaxX ) || ( lat < env.MinY ) || ( lat > env.MaxY ) )
+   {
+      return false;
+   }
+   if ( !cell.m_geometry )
+   {
+      return true;
+   }
+   OGRPoint pt( lon, lat );
+   return cell.m_geometry->Intersects( &pt );
+}
 
-   ossimShpElevIndex::myMutex.lock();
-   OGRLayer  *poLayer = poMemDS->GetLayer( 0 );
-   OGRFeature *poFeature;
-   OGRPoint* ogrPoint = new OGRPoint( lon, lat );
+ossim_int64 ossimShpElevIndex::searchCell( double lon, double lat ) const
+{
+   if ( m_bins.empty() ||
+        ( lon < m_extent.MinX ) || ( lon > m_extent.MaxX ) ||
+        ( lat < m_extent.MinY ) || ( lat > m_extent.MaxY ) )
+   {
+      return -1;
+   }
 
-   poLayer->ResetReading();
-   poLayer->SetSpatialFilter( ogrPoint );
+   ossim_uint32 c = std::min<ossim_uint32>( m_binCols - 1, static_cast<ossim_uint32>(
+      ( lon - m_extent.MinX ) / m_binWidth ) );
+   ossim_uint32 r = std::min<ossim_uint32>( m_binRows - 1, static_cast<ossim_uint32>(
+      ( lat - m_extent.MinY ) / m_binHeight ) );
 
-   while( ( poFeature = poLayer->GetNextFeature() ) != NULL )
+   // Walk backwards so the last matching feature wins.
+   const std::vector<ossim_uint32>& bin = m_bins[ r * m_binCols + c ];
+   for ( std::vector<ossim_uint32>::const_reverse_iterator i = bin.rbegin(); i != bin.rend(); ++i )
    {
-      filename = poFeature->GetFieldAsString( poFeature->GetFieldIndex( "filename" ) );
-      OGRFeature::DestroyFeature( poFeature );
+      if ( cellContains( m_cells[*i], lon, lat ) )
+      {
+         return static_cast<ossim_int64>( *i );
+      }
    }
 
-   delete ogrPoint;
-   ossimShpElevIndex::myMutex.unlock();
+   return -1;
+}
+
+const std::string& ossimShpElevIndex::getFilename( ossim_int64 cellId ) const
+{
+   return m_cells[ static_cast<std::size_t>( cellId ) ].m_filename;
+}
+
+ossim_uint64 ossimShpElevIndex::getCellCount() const
+{
+   return m_cells.size();
+}
+
+std::string ossimShpElevIndex::searchShapefile(double lon, double lat) const
+{
+   std::string filename;
+
+   ossim_int64 id = searchCell( lon, lat );
+   if ( id >= 0 )
+   {
+      filename = getFilename( id );
+   }
 
    return filename;
 }
@@ -62,16 +217,10 @@ void ossimShpElevIndex::getBoundingRect(ossimGrect& rect) const
    // a geographic projection and there is a rotation this will include null coverage area.
    rect.makeNan();
 
-   ossimShpElevIndex::myMutex.lock();
-   OGRLayer  *poLayer = poMemDS->GetLayer( 0 );
-   OGREnvelope *poEnvelope = new OGREnvelope();
-   OGRErr status = poLayer->GetExtent( poEnvelope );   
-   ossimShpElevIndex::myMutex.unlock();
-
-   ossimGrect newRect( poEnvelope->MaxY, poEnvelope->MinX, poEnvelope->MinY, poEnvelope->MaxX );
-
-   rect.expandToInclude(newRect);
-
-    delete poEnvelope;
+   if ( m_cells.size() )
+   {
+      ossimGrect newRect( m_extent.MaxY, m_extent.MinX, m_extent.MinY, m_extent.MaxX );
 
+      rect.expandToInclude(newRect);
+   }
 }
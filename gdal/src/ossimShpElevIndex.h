@@ -1,9 +1,9 @@
 //----------------------------------------------------------------------------
 //
 // File: ossimGdalImageElevationDatabase.h
-// 
+//
 // License:  MIT
-// 
+//
 // See LICENSE.txt file in the top level directory for more details.
 //
 // Author:  Scott Bortman
@@ -16,13 +16,25 @@
 #ifndef ossimShpElevIndex_HEADER
 #define ossimShpElevIndex_HEADER 1
 #include "ogrsf_frmts.h"
+#include <ossim/base/ossimConstants.h>
 #include <ossim/base/ossimGrect.h>
 #include <atomic>
 #include <iostream>
 #include <future>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
+/**
+ * Footprint index for a DEM cell shapefile.
+ *
+ * The shapefile is read once at construction.  Cell envelopes, file names and
+ * (for non-rectangular footprints) geometries are held in memory and bucketed
+ * into a uniform lon/lat grid so a point lookup only tests the few footprints
+ * in its grid bin.  The index is immutable after construction so lookups need
+ * no locking.
+ */
 class ossimShpElevIndex
 {
 public:
@@ -41,12 +53,29 @@ public:
         shpElevIndex = new ossimShpElevIndex( shpFileName );
         instance.store( shpElevIndex, std::memory_order_release );
       }
-    }   
+    }
 
     return shpElevIndex;
   }
 
+  /**
+   * @return File name of the cell covering lon/lat, or empty string if none.
+   */
   std::string searchShapefile( double lon, double lat ) const;
+
+  /**
+   * @return Cell id (index into the footprint table) covering lon/lat, or -1
+   * if the point is not covered.  When footprints overlap the last feature
+   * in the shapefile wins, matching the OGR spatial filter behavior.
+   */
+  ossim_int64 searchCell( double lon, double lat ) const;
+
+  /** @return File name for cell id returned by searchCell. */
+  const std::string& getFilename( ossim_int64 cellId ) const;
+
+  /** @return Number of footprints in the index. */
+  ossim_uint64 getCellCount() const;
+
   void getBoundingRect(ossimGrect& rect) const;
 
 
@@ -56,10 +85,29 @@ private:
   ossimShpElevIndex( const ossimShpElevIndex& )= delete;
   ossimShpElevIndex& operator=( const ossimShpElevIndex& )= delete;
 
+  struct Cell
+  {
+    OGREnvelope  m_envelope;
+    std::string  m_filename;
+
+    /** Footprint geometry; null when the footprint is its own envelope. */
+    OGRGeometry* m_geometry;
+  };
+
+  void buildGrid();
+  bool cellContains( const Cell& cell, double lon, double lat ) const;
+
   static std::atomic<ossimShpElevIndex*> instance;
   static std::mutex myMutex;
 
-  GDALDataset *poMemDS;
+  std::vector<Cell> m_cells;
+  OGREnvelope       m_extent;
+
+  /** Grid bins, row major, each holding cell ids in ascending order. */
+  std::vector< std::vector<ossim_uint32> > m_bins;
+  ossim_uint32      m_binCols;
+  ossim_uint32      m_binRows;
+  double            m_binWidth;
+  double            m_binHeight;
 };
 #endif
-
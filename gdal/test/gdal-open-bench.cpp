@@ -0,0 +1,181 @@
+//---
+//
+// License: MIT
+//
+// File: gdal-open-bench.cpp
+//
+// Description: Open time for the gdal plugin with and without the
+// ossimOgcWktTranslator projection cache.
+//
+// Usage: gdal-open-bench [--dir <directory>] [--ext <tif>] [--passes <n>]
+//                        [--synthetic <n>]
+//
+// With --dir, every file with the extension is opened with
+// ossimGdalTileSource and its geometry built, once with the cache cleared
+// before each open and once with it warm.  Without --dir, the keyword list
+// to WKT translation is timed on UTM keyword lists that differ only in tie
+// point, as a mosaic of same zone images would.
+//
+// $Id$
+//---
+
+#include <ossim/base/ossimArgumentParser.h>
+#include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimDirectory.h>
+#include <ossim/base/ossimFilename.h>
+#include <ossim/base/ossimKeywordlist.h>
+#include <ossim/base/ossimKeywordNames.h>
+#include <ossim/base/ossimString.h>
+#include <ossim/imaging/ossimImageGeometry.h>
+#include <ossim/init/ossimInit.h>
+#include <gdal/src/ossimGdalTileSource.h>
+#include <gdal/src/ossimOgcWktTranslator.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/** @return Seconds to open every file once; clears the cache per open if cold. */
+static double openAll( const std::vector<ossimFilename>& files, bool cold, ossim_uint32& opened )
+{
+   opened = 0;
+   std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+   for ( size_t i = 0; i < files.size(); ++i )
+   {
+      if ( cold )
+      {
+         ossimOgcWktTranslator::clearCache();
+      }
+      ossimRefPtr<ossimGdalTileSource> ts = new ossimGdalTileSource();
+      ts->setFilename( files[i] );
+      if ( ts->open() && ts->getImageGeometry().valid() )
+      {
+         ++opened;
+      }
+   }
+   std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+   return std::chrono::duration<double>( t1 - t0 ).count();
+}
+
+/** @return Seconds to translate count UTM keyword lists to WKT. */
+static double translateAll( ossim_uint32 count, bool cold, ossim_uint32& translated )
+{
+   ossimOgcWktTranslator translator;
+   ossimKeywordlist kwl;
+   kwl.add( ossimKeywordNames::TYPE_KW, "ossimUtmProjection" );
+   kwl.add( ossimKeywordNames::DATUM_KW, "WGE" );
+   kwl.add( ossimKeywordNames::ZONE_KW, "17" );
+   kwl.add( ossimKeywordNames::HEMISPHERE_KW, "N" );
+   kwl.add( ossimKeywordNames::UNITS_KW, "meters" );
+   kwl.add( ossimKeywordNames::METERS_PER_PIXEL_X_KW, "0.5" );
+   kwl.add( ossimKeywordNames::METERS_PER_PIXEL_Y_KW, "0.5" );
+
+   translated = 0;
+   std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+   for ( ossim_uint32 i = 0; i < count; ++i )
+   {
+      if ( cold )
+      {
+         ossimOgcWktTranslator::clearCache();
+      }
+
+      // Each image of a mosaic has its own tie point.
+      kwl.add( ossimKeywordNames::TIE_POINT_EASTING_KW,
+               ossimString::toString( 500000.0 + ( i % 100 ) * 1000.0 ), true );
+      kwl.add( ossimKeywordNames::TIE_POINT_NORTHING_KW,
+               ossimString::toString( 4000000.0 + ( i / 100 ) * 1000.0 ), true );
+
+      if ( translator.fromOssimKwl( kwl ).size() )
+      {
+         ++translated;
+      }
+   }
+   std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+   return std::chrono::duration<double>( t1 - t0 ).count();
+}
+
+int main(int argc, char *argv[])
+{
+   ossimArgumentParser ap(&argc, argv);
+   ossimInit::instance()->addOptions(ap);
+   ossimInit::instance()->initialize(ap);
+
+   ossimFilename dir;
+   ossimString   ext       = "tif";
+   ossim_uint32  passes    = 1;
+   ossim_uint32  synthetic = 10000;
+
+   std::string s;
+   ossimArgumentParser::ossimParameter sp(s);
+   if ( ap.read("--dir", sp) )       dir       = s;
+   if ( ap.read("--ext", sp) )       ext       = s;
+   if ( ap.read("--passes", sp) )    passes    = ossimString(s).toUInt32();
+   if ( ap.read("--synthetic", sp) ) synthetic = ossimString(s).toUInt32();
+
+   if ( !passes || ( dir.empty() && !synthetic ) )
+   {
+      cout << "\nUsage: " << argv[0]
+           << " [--dir <directory>] [--ext <tif>] [--passes <n>] [--synthetic <n>]\n"
+           << endl;
+      return 1;
+   }
+
+   bool status = true;
+
+   if ( dir.size() )
+   {
+      std::vector<ossimFilename> files;
+      ossimDirectory d( dir );
+      d.findAllFilesThatMatch( files, ossimString(".*\\.") + ext + "$",
+                               ossimDirectory::OSSIM_DIR_FILES );
+      if ( files.empty() )
+      {
+         cout << "No *." << ext << " files in " << dir << endl;
+         return 1;
+      }
+
+      // First pass warms the file system cache so both timings see it.
+      ossim_uint32 opened = 0;
+      openAll( files, true, opened );
+
+      double coldSeconds = 0.0;
+      double warmSeconds = 0.0;
+      ossim_uint32 coldOpened = 0;
+      ossim_uint32 warmOpened = 0;
+      for ( ossim_uint32 i = 0; i < passes; ++i )
+      {
+         coldSeconds += openAll( files, true, coldOpened );
+         openAll( files, false, opened ); // Fill the cache.
+         warmSeconds += openAll( files, false, warmOpened );
+      }
+      status = ( coldOpened == files.size() ) && ( warmOpened == files.size() );
+
+      const double OPENS = (double)files.size() * passes;
+      cout << "files:         " << files.size()
+           << "\npasses:        " << passes
+           << "\nuncached:      " << ( coldSeconds > 0.0 ? OPENS / coldSeconds : 0.0 ) << " opens/s"
+           << "\ncached:        " << ( warmSeconds > 0.0 ? OPENS / warmSeconds : 0.0 ) << " opens/s"
+           << "\nsaved per open:" << ( coldSeconds - warmSeconds ) / OPENS * 1000.0 << " ms"
+           << "\nstatus:        " << ( status ? "ok" : "failed" )
+           << endl;
+   }
+   else
+   {
+      ossim_uint32 coldCount = 0;
+      ossim_uint32 warmCount = 0;
+      const double COLD = translateAll( synthetic, true, coldCount );
+      ossimOgcWktTranslator::clearCache();
+      const double WARM = translateAll( synthetic, false, warmCount );
+      status = ( coldCount == synthetic ) && ( warmCount == synthetic );
+
+      cout << "translations:  " << synthetic
+           << "\nuncached:      " << ( COLD > 0.0 ? synthetic / COLD : 0.0 ) << " per s"
+           << "\ncached:        " << ( WARM > 0.0 ? synthetic / WARM : 0.0 ) << " per s"
+           << "\nstatus:        " << ( status ? "ok" : "failed" )
+           << endl;
+   }
+
+   return status ? 0 : 1;
+}
@@ -28,6 +28,7 @@
 #include <istream>
 #include <iostream>
 #include <iomanip>
+#include <thread>
 
 static ossimTrace traceDebug(ossimString("ossimOpjCommon:degug"));
 
@@ -145,7 +146,8 @@ bool ossim::opj_decode( std::istream* in,
                         ossim_uint32 resLevel,
                         ossim_int32 format, // OPJ_CODEC_FORMAT
                         std::streamoff fileOffset,
-                        ossimImageData* tile)
+                        ossimImageData* tile,
+                        ossim_uint32 threads)
 {
    static const char MODULE[] = "ossimOpjDecoder::decode";
 
@@ -232,6 +234,8 @@ bool ossim::opj_decode( std::istream* in,
          throw ossimException(errMsg);
       }
 
+      ossim::setCodecThreads(codec, threads);
+
       // Read the main header of the codestream and if necessary the JP2 boxes.
       if ( opj_read_header(stream, codec, &image) == false )
       {
@@ -384,6 +388,26 @@ bool ossim::opj_decode( std::istream* in,
    
 } // End: ossim::opj_decode( ... )
 
+void ossim::setCodecThreads( void* codec, ossim_uint32 threads )
+{
+#if defined(OPJ_VERSION_MAJOR) && \
+   ( (OPJ_VERSION_MAJOR > 2) || ((OPJ_VERSION_MAJOR == 2) && (OPJ_VERSION_MINOR >= 2)) )
+   if ( threads == 0 )
+   {
+      threads = std::thread::hardware_concurrency();
+   }
+   if ( codec && ( threads > 1 ) && opj_has_thread_support() )
+   {
+      if ( opj_codec_set_threads( (opj_codec_t*)codec, (int)threads ) == OPJ_FALSE )
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "ossim::setCodecThreads WARNING: opj_codec_set_threads failed!"
+            << std::endl;
+      }
+   }
+#endif
+}
+
 bool ossim::copyOpjImage( opj_image* image, ossimImageData* tile )
 {
    bool status = false;
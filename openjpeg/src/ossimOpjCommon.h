@@ -44,8 +44,20 @@ namespace ossim
                     ossim_uint32 resLevel,
                     ossim_int32 format, // OPJ_CODEC_FORMAT
                     std::streamoff fileOffset, // for nitf
-                    ossimImageData* tile
+                    ossimImageData* tile,
+                    ossim_uint32 threads = 1 // see setCodecThreads
                     );
+
+   /**
+    * @brief Enables openjpeg's codec internal threading.
+    *
+    * Call between opj_setup_decoder and opj_read_header.  Does nothing for
+    * one thread or if openjpeg is older than 2.2 or built without threads.
+    *
+    * @param codec The opj_codec_t.
+    * @param threads Number of threads, 0 = hardware threads.
+    */
+   void setCodecThreads( void* codec, ossim_uint32 threads );
    
    bool copyOpjImage( opj_image* image, ossimImageData* tile );
    
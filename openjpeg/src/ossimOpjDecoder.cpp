@@ -0,0 +1,977 @@
+//----------------------------------------------------------------------------
+//
+// License:  See top level LICENSE.txt file
+//
+// Description: Persistent tile by tile decoder for one jp2/j2k codestream
+// using the openjpeg library.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#include <ossimOpjDecoder.h>
+#include <ossimOpjCommon.h>
+#include <ossim/base/ossimIrect.h>
+#include <ossim/base/ossimNotify.h>
+#include <ossim/base/ossimString.h>
+#include <ossim/base/ossimTrace.h>
+#include <ossim/imaging/ossimImageData.h>
+
+#include <openjpeg.h>
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+
+static ossimTrace traceDebug(ossimString("ossimOpjDecoder:debug"));
+
+// Markers:
+static const ossim_uint16 SOC_MARKER = 0xff4f; // start of codestream
+static const ossim_uint16 SIZ_MARKER = 0xff51; // image and tile size
+static const ossim_uint16 TLM_MARKER = 0xff55; // tile-part lengths
+static const ossim_uint16 PLM_MARKER = 0xff57; // packet lengths, main header
+static const ossim_uint16 PPM_MARKER = 0xff60; // packed packet headers
+static const ossim_uint16 SOT_MARKER = 0xff90; // start of tile-part
+static const ossim_uint16 EOC_MARKER = 0xffd9; // end of codestream
+
+// Jp2 box types:
+static const ossim_uint32 JP2H_BOX = 0x6a703268; // "jp2h" header
+static const ossim_uint32 JP2C_BOX = 0x6a703263; // "jp2c" codestream
+static const ossim_uint32 COLR_BOX = 0x636f6c72; // "colr" color
+static const ossim_uint32 PCLR_BOX = 0x70636c72; // "pclr" palette
+static const ossim_uint32 CDEF_BOX = 0x63646566; // "cdef" channel definition
+
+// SOT marker segment size, marker included.
+static const ossim_uint32 SOT_SIZE = 12;
+
+// Sanity limit on the main header.
+static const std::streamoff MAX_MAIN_HEADER = 16 * 1024 * 1024;
+
+//---
+// Whole codestream tiles are decoded, so past this many request areas per
+// tile openjpeg's windowed decode is cheaper.
+//---
+static const ossim_int64 MAX_TILE_TO_REQUEST_RATIO = 4;
+
+static ossim_uint32 getUint16( const ossim_uint8* p )
+{
+   return ( (ossim_uint32)p[0] << 8 ) | p[1];
+}
+
+static ossim_uint32 getUint32( const ossim_uint8* p )
+{
+   return ( (ossim_uint32)p[0] << 24 ) | ( (ossim_uint32)p[1] << 16 ) |
+          ( (ossim_uint32)p[2] << 8 ) | p[3];
+}
+
+static void putUint32( ossim_uint8* p, ossim_uint32 v )
+{
+   p[0] = (ossim_uint8)( v >> 24 );
+   p[1] = (ossim_uint8)( v >> 16 );
+   p[2] = (ossim_uint8)( v >> 8 );
+   p[3] = (ossim_uint8)( v );
+}
+
+/** @return ceil( v / 2^n ) */
+static ossim_int64 ceilDivPow2( ossim_int64 v, ossim_uint32 n )
+{
+   return ( v + ( (ossim_int64)1 << n ) - 1 ) >> n;
+}
+
+//---
+// Memory stream for openjpeg.  Holds the per tile codestream so openjpeg
+// never touches the file.
+//---
+struct ossimOpjMemoryStream
+{
+   const ossim_uint8* m_data;
+   OPJ_SIZE_T         m_size;
+   OPJ_SIZE_T         m_pos;
+};
+
+static OPJ_SIZE_T ossim_opj_memory_read( void* p_buffer,
+                                         OPJ_SIZE_T p_nb_bytes,
+                                         void* p_user_data )
+{
+   ossimOpjMemoryStream* mem = static_cast<ossimOpjMemoryStream*>(p_user_data);
+   if ( mem->m_pos >= mem->m_size )
+   {
+      return (OPJ_SIZE_T)-1;
+   }
+   OPJ_SIZE_T count = std::min( p_nb_bytes, mem->m_size - mem->m_pos );
+   memcpy( p_buffer, mem->m_data + mem->m_pos, count );
+   mem->m_pos += count;
+   return count;
+}
+
+static OPJ_OFF_T ossim_opj_memory_skip( OPJ_OFF_T p_nb_bytes, void* p_user_data )
+{
+   ossimOpjMemoryStream* mem = static_cast<ossimOpjMemoryStream*>(p_user_data);
+   if ( p_nb_bytes < 0 )
+   {
+      p_nb_bytes = std::max<OPJ_OFF_T>( p_nb_bytes, -(OPJ_OFF_T)mem->m_pos );
+   }
+   else
+   {
+      p_nb_bytes = std::min<OPJ_OFF_T>( p_nb_bytes, (OPJ_OFF_T)( mem->m_size - mem->m_pos ) );
+   }
+   mem->m_pos += p_nb_bytes;
+   return p_nb_bytes;
+}
+
+static OPJ_BOOL ossim_opj_memory_seek( OPJ_OFF_T p_nb_bytes, void* p_user_data )
+{
+   ossimOpjMemoryStream* mem = static_cast<ossimOpjMemoryStream*>(p_user_data);
+   if ( ( p_nb_bytes < 0 ) || ( p_nb_bytes > (OPJ_OFF_T)mem->m_size ) )
+   {
+      return OPJ_FALSE;
+   }
+   mem->m_pos = (OPJ_SIZE_T)p_nb_bytes;
+   return OPJ_TRUE;
+}
+
+/**
+ * Copies the overlap of a decoded codestream tile, whose first sample is at
+ * x0,y0, with area to tile.
+ */
+template <class T>
+static void copyOpjTile( T /* dummy */,
+                         const opj_image_t* image,
+                         ossim_int64 x0,
+                         ossim_int64 y0,
+                         const ossimIrect& area,
+                         ossimImageData* tile )
+{
+   const ossim_int64 W  = image->comps[0].w;
+   const ossim_int64 H  = image->comps[0].h;
+   const ossim_int64 SX = std::max<ossim_int64>( x0, area.ul().x );
+   const ossim_int64 EX = std::min<ossim_int64>( x0 + W - 1, area.lr().x );
+   const ossim_int64 SY = std::max<ossim_int64>( y0, area.ul().y );
+   const ossim_int64 EY = std::min<ossim_int64>( y0 + H - 1, area.lr().y );
+   if ( ( SX > EX ) || ( SY > EY ) )
+   {
+      return;
+   }
+
+   const ossim_int64 TILE_W = tile->getWidth();
+   const ossim_uint32 BANDS = tile->getNumberOfBands();
+   for ( ossim_uint32 band = 0; band < BANDS; ++band )
+   {
+      const OPJ_INT32* src = image->comps[band].data;
+      T* dst = (T*)tile->getBuf( band );
+      for ( ossim_int64 y = SY; y <= EY; ++y )
+      {
+         const OPJ_INT32* s = src + ( y - y0 ) * W + ( SX - x0 );
+         T* d = dst + ( y - area.ul().y ) * TILE_W + ( SX - area.ul().x );
+         for ( ossim_int64 x = SX; x <= EX; ++x )
+         {
+            *d++ = (T)( *s++ );
+         }
+      }
+   }
+}
+
+ossimOpjDecoder::ossimOpjDecoder()
+   :
+   m_str(0),
+   m_end(0),
+   m_mainHeader(),
+   m_tileParts(),
+   m_readMutex(),
+   m_Xsiz(0),
+   m_Ysiz(0),
+   m_XOsiz(0),
+   m_YOsiz(0),
+   m_XTsiz(0),
+   m_YTsiz(0),
+   m_XTOsiz(0),
+   m_YTOsiz(0),
+   m_Csiz(0),
+   m_tilesX(0),
+   m_tilesY(0),
+   m_threads(1),
+   m_pool(),
+   m_poolMutex(),
+   m_wake(),
+   m_finished(),
+   m_batch(0),
+   m_stop(false)
+{
+}
+
+ossimOpjDecoder::~ossimOpjDecoder()
+{
+   stopPool();
+   close();
+}
+
+bool ossimOpjDecoder::open( std::istream* str, std::streamoff offset )
+{
+   static const char MODULE[] = "ossimOpjDecoder::open";
+
+   close();
+
+   bool status = false;
+
+   if ( str )
+   {
+      m_str = str;
+
+      m_str->clear();
+      m_str->seekg( 0, std::ios_base::end );
+      m_end = m_str->tellg();
+
+      std::streamoff start = 0;
+      std::streamoff firstSot = 0;
+      std::vector<ossim_uint32> tlm;
+
+      if ( findCodestream( offset, start ) &&
+           readMainHeader( start, firstSot, tlm ) )
+      {
+         // TLM markers give the layout for free; scan if missing or wrong.
+         status = ( tlm.size() && indexFromTlm( tlm, firstSot ) ) ||
+                  indexFromScan( firstSot );
+      }
+
+      m_str->clear();
+      m_str->seekg( offset, std::ios_base::beg );
+
+      if ( traceDebug() )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << MODULE << " DEBUG:"
+            << "\ncodestream offset: " << start
+            << "\nmain header size:  " << m_mainHeader.size()
+            << "\ntiles:             " << m_tilesX << " x " << m_tilesY
+            << "\ntlm entries:       " << tlm.size() / 2
+            << "\nstatus:            " << (status ? "true" : "false")
+            << std::endl;
+      }
+   }
+
+   if ( !status )
+   {
+      close();
+   }
+
+   return status;
+}
+
+void ossimOpjDecoder::close()
+{
+   m_str = 0;
+   m_end = 0;
+   m_mainHeader.clear();
+   m_tileParts.clear();
+   m_tilesX = 0;
+   m_tilesY = 0;
+}
+
+bool ossimOpjDecoder::isOpen() const
+{
+   return ( m_str != 0 );
+}
+
+ossim_uint32 ossimOpjDecoder::getNumberOfTiles() const
+{
+   return m_tilesX * m_tilesY;
+}
+
+void ossimOpjDecoder::setThreads( ossim_uint32 threads )
+{
+   if ( threads != m_threads )
+   {
+      stopPool(); // Restarted at the new size on demand.
+      m_threads = threads;
+   }
+}
+
+ossim_uint32 ossimOpjDecoder::getThreads() const
+{
+   ossim_uint32 threads = m_threads;
+   if ( threads == 0 )
+   {
+      threads = std::thread::hardware_concurrency();
+   }
+   return std::max<ossim_uint32>( 1, threads );
+}
+
+bool ossimOpjDecoder::findCodestream( std::streamoff offset, std::streamoff& start )
+{
+   ossim_uint8 buf[16];
+   if ( !read( offset, buf, 2 ) )
+   {
+      return false;
+   }
+
+   if ( getUint16( buf ) == SOC_MARKER )
+   {
+      start = offset; // Raw codestream.
+      return true;
+   }
+
+   // Walk the top level jp2 boxes to the codestream.
+   std::streamoff pos = offset;
+   while ( pos + 8 <= m_end )
+   {
+      if ( !read( pos, buf, 8 ) )
+      {
+         return false;
+      }
+
+      ossim_uint64 length = getUint32( buf );
+      const ossim_uint32 TYPE = getUint32( buf + 4 );
+      std::streamoff header = 8;
+      if ( length == 1 )
+      {
+         if ( !read( pos + 8, buf + 8, 8 ) )
+         {
+            return false;
+         }
+         length = ( (ossim_uint64)getUint32( buf + 8 ) << 32 ) | getUint32( buf + 12 );
+         header = 16;
+      }
+      else if ( length == 0 )
+      {
+         length = m_end - pos; // Last box.
+      }
+      if ( length < (ossim_uint64)header )
+      {
+         return false;
+      }
+      const std::streamoff END = pos + (std::streamoff)length;
+
+      if ( TYPE == JP2H_BOX )
+      {
+         // Palette, channel definitions and color are applied by the jp2
+         // decoder which we bypass.
+         std::streamoff child = pos + header;
+         while ( child + 8 <= END )
+         {
+            if ( !read( child, buf, 8 ) )
+            {
+               return false;
+            }
+            const ossim_uint32 CHILD_LENGTH = getUint32( buf );
+            const ossim_uint32 CHILD_TYPE   = getUint32( buf + 4 );
+            if ( ( CHILD_TYPE == PCLR_BOX ) || ( CHILD_TYPE == CDEF_BOX ) )
+            {
+               return false;
+            }
+            if ( CHILD_TYPE == COLR_BOX )
+            {
+               // METH 1 is an enumerated space; allow sRGB(16) and gray(17).
+               if ( !read( child + 8, buf, 7 ) || ( buf[0] != 1 ) )
+               {
+                  return false;
+               }
+               const ossim_uint32 ENUM_CS = getUint32( buf + 3 );
+               if ( ( ENUM_CS != 16 ) && ( ENUM_CS != 17 ) )
+               {
+                  return false;
+               }
+            }
+            if ( CHILD_LENGTH < 8 )
+            {
+               break;
+            }
+            child += CHILD_LENGTH;
+         }
+      }
+      else if ( TYPE == JP2C_BOX )
+      {
+         start = pos + header;
+         m_end = END;
+         return read( start, buf, 2 ) && ( getUint16( buf ) == SOC_MARKER );
+      }
+
+      pos = END;
+   }
+
+   return false;
+}
+
+bool ossimOpjDecoder::readMainHeader( std::streamoff start,
+                                      std::streamoff& firstSot,
+                                      std::vector<ossim_uint32>& tlm )
+{
+   ossim_uint8 buf[4];
+
+   m_mainHeader.clear();
+   m_mainHeader.push_back( 0xff );
+   m_mainHeader.push_back( 0x4f );
+
+   bool haveSiz = false;
+   ossim_uint32 tlmCount = 0; // Tile-parts listed without a tile index.
+   std::vector<ossim_uint8> segment;
+   std::streamoff pos = start + 2;
+
+   while ( true )
+   {
+      if ( ( pos - start > MAX_MAIN_HEADER ) || !read( pos, buf, 4 ) )
+      {
+         return false;
+      }
+
+      const ossim_uint32 MARKER = getUint16( buf );
+      const ossim_uint32 LENGTH = getUint16( buf + 2 );
+
+      if ( MARKER == SOT_MARKER )
+      {
+         firstSot = pos;
+         break;
+      }
+      if ( ( ( MARKER >> 8 ) != 0xff ) || ( LENGTH < 2 ) )
+      {
+         return false;
+      }
+
+      segment.resize( LENGTH - 2 );
+      if ( segment.size() && !read( pos + 4, &segment.front(), segment.size() ) )
+      {
+         return false;
+      }
+
+      if ( MARKER == SIZ_MARKER )
+      {
+         if ( segment.size() < 36 )
+         {
+            return false;
+         }
+         const ossim_uint8* s = &segment.front();
+         m_Xsiz   = getUint32( s + 2 );
+         m_Ysiz   = getUint32( s + 6 );
+         m_XOsiz  = getUint32( s + 10 );
+         m_YOsiz  = getUint32( s + 14 );
+         m_XTsiz  = getUint32( s + 18 );
+         m_YTsiz  = getUint32( s + 22 );
+         m_XTOsiz = getUint32( s + 26 );
+         m_YTOsiz = getUint32( s + 30 );
+         m_Csiz   = getUint16( s + 34 );
+         if ( !m_Csiz || ( segment.size() < 36 + 3 * m_Csiz ) ||
+              !m_XTsiz || !m_YTsiz ||
+              ( m_Xsiz <= m_XTOsiz ) || ( m_Ysiz <= m_YTOsiz ) )
+         {
+            return false;
+         }
+         for ( ossim_uint32 i = 0; i < m_Csiz; ++i )
+         {
+            // Subsampled components don't line up with the tile.
+            if ( ( s[37 + 3 * i] != 1 ) || ( s[38 + 3 * i] != 1 ) )
+            {
+               return false;
+            }
+         }
+         m_tilesX = ( m_Xsiz - m_XTOsiz + m_XTsiz - 1 ) / m_XTsiz;
+         m_tilesY = ( m_Ysiz - m_YTOsiz + m_YTsiz - 1 ) / m_YTsiz;
+         haveSiz = true;
+      }
+      else if ( MARKER == PPM_MARKER )
+      {
+         // Packet headers for all tiles live in the main header.
+         return false;
+      }
+
+      if ( MARKER == TLM_MARKER )
+      {
+         // Ztlm, Stlm, then Ttlm (0, 1 or 2 bytes) and Ptlm (2 or 4 bytes).
+         if ( segment.size() >= 2 )
+         {
+            const ossim_uint32 ST = ( segment[1] >> 4 ) & 3;
+            const ossim_uint32 SP = ( segment[1] >> 6 ) & 1;
+            const ossim_uint32 ENTRY = ST + ( SP ? 4 : 2 );
+            if ( ST == 3 )
+            {
+               tlm.clear();
+            }
+            else
+            {
+               for ( size_t i = 2; i + ENTRY <= segment.size(); i += ENTRY )
+               {
+                  const ossim_uint8* e = &segment[i];
+                  const ossim_uint32 TILE =
+                     ( ST == 0 ) ? tlmCount : ( ( ST == 1 ) ? e[0] : getUint16( e ) );
+                  const ossim_uint32 PART_LENGTH =
+                     SP ? getUint32( e + ST ) : getUint16( e + ST );
+                  tlm.push_back( TILE );
+                  tlm.push_back( PART_LENGTH );
+                  ++tlmCount;
+               }
+            }
+         }
+      }
+      else if ( MARKER != PLM_MARKER )
+      {
+         //---
+         // TLM and PLM describe the whole codestream so are dropped from the
+         // per tile copy.
+         //---
+         m_mainHeader.insert( m_mainHeader.end(), buf, buf + 4 );
+         m_mainHeader.insert( m_mainHeader.end(), segment.begin(), segment.end() );
+      }
+
+      pos += 2 + LENGTH;
+   }
+
+   return haveSiz;
+}
+
+bool ossimOpjDecoder::indexFromTlm( const std::vector<ossim_uint32>& tlm,
+                                    std::streamoff firstSot )
+{
+   const ossim_uint32 TILES = getNumberOfTiles();
+   m_tileParts.assign( TILES, std::vector<TilePart>() );
+
+   std::streamoff pos = firstSot;
+   for ( size_t i = 0; i + 1 < tlm.size(); i += 2 )
+   {
+      TilePart part;
+      part.m_offset = pos;
+      part.m_length = tlm[i + 1];
+      if ( ( tlm[i] >= TILES ) || ( part.m_length < SOT_SIZE + 2 ) ||
+           ( pos + part.m_length > m_end ) )
+      {
+         m_tileParts.clear();
+         return false;
+      }
+      m_tileParts[ tlm[i] ].push_back( part );
+      pos += part.m_length;
+   }
+
+   // Spot check the first and last tile-parts land on SOT markers.
+   if ( !checkSot( firstSot, tlm[0] ) ||
+        !checkSot( pos - tlm[ tlm.size() - 1 ], tlm[ tlm.size() - 2 ] ) )
+   {
+      if ( traceDebug() )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimOpjDecoder::indexFromTlm DEBUG: TLM does not match "
+            << "the codestream, scanning." << std::endl;
+      }
+      m_tileParts.clear();
+      return false;
+   }
+
+   return true;
+}
+
+bool ossimOpjDecoder::indexFromScan( std::streamoff firstSot )
+{
+   const ossim_uint32 TILES = getNumberOfTiles();
+   m_tileParts.assign( TILES, std::vector<TilePart>() );
+
+   ossim_uint8 buf[SOT_SIZE];
+   std::streamoff pos = firstSot;
+   bool haveParts = false;
+
+   while ( ( pos + (std::streamoff)SOT_SIZE <= m_end ) && read( pos, buf, SOT_SIZE ) )
+   {
+      if ( getUint16( buf ) != SOT_MARKER )
+      {
+         break; // EOC or trailing data.
+      }
+
+      const ossim_uint32 ISOT = getUint16( buf + 4 );
+      const ossim_uint32 PSOT = getUint32( buf + 6 );
+
+      TilePart part;
+      part.m_offset = pos;
+      if ( PSOT )
+      {
+         part.m_length = PSOT;
+      }
+      else
+      {
+         // Last tile-part runs to the EOC marker.
+         std::streamoff end = m_end;
+         ossim_uint8 eoc[2];
+         if ( read( m_end - 2, eoc, 2 ) && ( getUint16( eoc ) == EOC_MARKER ) )
+         {
+            end -= 2;
+         }
+         part.m_length = (ossim_uint32)( end - pos );
+      }
+
+      if ( ( ISOT >= TILES ) || ( part.m_length < SOT_SIZE + 2 ) ||
+           ( pos + part.m_length > m_end ) )
+      {
+         m_tileParts.clear();
+         return false;
+      }
+
+      m_tileParts[ISOT].push_back( part );
+      haveParts = true;
+      pos += part.m_length;
+
+      if ( !PSOT )
+      {
+         break;
+      }
+   }
+
+   if ( !haveParts )
+   {
+      m_tileParts.clear();
+   }
+   return haveParts;
+}
+
+bool ossimOpjDecoder::checkSot( std::streamoff offset, ossim_uint32 tileIndex )
+{
+   ossim_uint8 buf[6];
+   return read( offset, buf, 6 ) &&
+          ( getUint16( buf ) == SOT_MARKER ) &&
+          ( getUint16( buf + 4 ) == tileIndex );
+}
+
+void ossimOpjDecoder::getTileBounds( ossim_uint32 tileIndex, ossim_uint32 resLevel,
+                                     ossim_int64& x0, ossim_int64& y0,
+                                     ossim_int64& x1, ossim_int64& y1 ) const
+{
+   const ossim_int64 TX = tileIndex % m_tilesX;
+   const ossim_int64 TY = tileIndex / m_tilesX;
+
+   x0 = std::max<ossim_int64>( m_XTOsiz + TX * m_XTsiz, m_XOsiz );
+   y0 = std::max<ossim_int64>( m_YTOsiz + TY * m_YTsiz, m_YOsiz );
+   x1 = std::min<ossim_int64>( m_XTOsiz + ( TX + 1 ) * m_XTsiz, m_Xsiz );
+   y1 = std::min<ossim_int64>( m_YTOsiz + ( TY + 1 ) * m_YTsiz, m_Ysiz );
+
+   x0 = ceilDivPow2( x0, resLevel );
+   y0 = ceilDivPow2( y0, resLevel );
+   x1 = ceilDivPow2( x1, resLevel );
+   y1 = ceilDivPow2( y1, resLevel );
+}
+
+bool ossimOpjDecoder::decode( const ossimIrect& rect,
+                              ossim_uint32 resLevel,
+                              ossimImageData* tile )
+{
+   if ( !isOpen() || !tile || rect.hasNans() || ( resLevel > 31 ) ||
+        ( tile->getNumberOfBands() != m_Csiz ) ||
+        ( tile->getWidth() != rect.width() ) ||
+        ( tile->getHeight() != rect.height() ) )
+   {
+      return false;
+   }
+
+   // Same scalars as ossim::copyOpjImage.
+   const ossimScalarType SCALAR = tile->getScalarType();
+   if ( ( SCALAR != OSSIM_UINT8 ) &&
+        ( SCALAR != OSSIM_UINT9 ) && ( SCALAR != OSSIM_UINT10 ) &&
+        ( SCALAR != OSSIM_UINT11 ) && ( SCALAR != OSSIM_UINT12 ) &&
+        ( SCALAR != OSSIM_UINT13 ) && ( SCALAR != OSSIM_UINT14 ) &&
+        ( SCALAR != OSSIM_UINT15 ) && ( SCALAR != OSSIM_UINT16 ) )
+   {
+      return false;
+   }
+
+   // Request in reference grid coordinates at resLevel.
+   const ossim_int64 OX = ceilDivPow2( m_XOsiz, resLevel );
+   const ossim_int64 OY = ceilDivPow2( m_YOsiz, resLevel );
+   const ossimIrect AREA( rect.ul().x + (ossim_int32)OX,
+                          rect.ul().y + (ossim_int32)OY,
+                          rect.lr().x + (ossim_int32)OX,
+                          rect.lr().y + (ossim_int32)OY );
+
+   // Large codestream tiles: leave it to the windowed decode.
+   const ossim_int64 TILE_W = ceilDivPow2( m_XTsiz, resLevel );
+   const ossim_int64 TILE_H = ceilDivPow2( m_YTsiz, resLevel );
+   if ( TILE_W * TILE_H >
+        MAX_TILE_TO_REQUEST_RATIO * (ossim_int64)rect.width() * (ossim_int64)rect.height() )
+   {
+      return false;
+   }
+
+   // Clip to the image in reference grid coordinates at resLevel.
+   const ossim_int64 SX = std::max<ossim_int64>( AREA.ul().x, OX );
+   const ossim_int64 SY = std::max<ossim_int64>( AREA.ul().y, OY );
+   const ossim_int64 EX = std::min<ossim_int64>( AREA.lr().x, ceilDivPow2( m_Xsiz, resLevel ) - 1 );
+   const ossim_int64 EY = std::min<ossim_int64>( AREA.lr().y, ceilDivPow2( m_Ysiz, resLevel ) - 1 );
+
+   // Edge requests: only the image part gets written.
+   bool blank = ( SX != AREA.ul().x ) || ( SY != AREA.ul().y ) ||
+                ( EX != AREA.lr().x ) || ( EY != AREA.lr().y );
+
+   std::vector<ossim_uint32> tiles;
+   if ( ( SX <= EX ) && ( SY <= EY ) )
+   {
+      //---
+      // Reduced sample x falls in the tile holding full resolution x << r,
+      // so the tile range comes straight from the tile grid.
+      //---
+      const ossim_int64 TX0 = ( ( SX << resLevel ) - m_XTOsiz ) / m_XTsiz;
+      const ossim_int64 TY0 = ( ( SY << resLevel ) - m_YTOsiz ) / m_YTsiz;
+      const ossim_int64 TX1 = std::min<ossim_int64>(
+         ( ( EX << resLevel ) - m_XTOsiz ) / m_XTsiz, m_tilesX - 1 );
+      const ossim_int64 TY1 = std::min<ossim_int64>(
+         ( ( EY << resLevel ) - m_YTOsiz ) / m_YTsiz, m_tilesY - 1 );
+
+      for ( ossim_int64 ty = TY0; ty <= TY1; ++ty )
+      {
+         for ( ossim_int64 tx = TX0; tx <= TX1; ++tx )
+         {
+            const ossim_uint32 INDEX = (ossim_uint32)( ty * m_tilesX + tx );
+            ossim_int64 x0, y0, x1, y1;
+            getTileBounds( INDEX, resLevel, x0, y0, x1, y1 );
+            if ( ( x0 < x1 ) && ( y0 < y1 ) )
+            {
+               tiles.push_back( INDEX );
+
+               // Tile missing from the codestream leaves a hole.
+               if ( m_tileParts[INDEX].empty() )
+               {
+                  blank = true;
+               }
+            }
+         }
+      }
+   }
+
+   if ( blank )
+   {
+      tile->makeBlank();
+   }
+
+   //---
+   // One thread per codestream tile up to the thread count; whatever is
+   // left over is split among the codecs.
+   //---
+   const ossim_uint32 THREADS = getThreads();
+   const ossim_uint32 WORKERS =
+      std::max<ossim_uint32>( 1, std::min<ossim_uint32>( THREADS, (ossim_uint32)tiles.size() ) );
+   const ossim_uint32 CODEC_THREADS = THREADS / WORKERS;
+
+   bool status = true;
+   if ( WORKERS == 1 )
+   {
+      for ( size_t i = 0; ( i < tiles.size() ) && status; ++i )
+      {
+         status = decodeTile( tiles[i], resLevel, AREA, tile, CODEC_THREADS );
+      }
+   }
+   else
+   {
+      std::unique_lock<std::mutex> lock( m_poolMutex );
+
+      // The calling thread works too.
+      m_stop = false;
+      while ( m_pool.size() < THREADS - 1 )
+      {
+         m_pool.push_back( std::thread( &ossimOpjDecoder::work, this ) );
+      }
+
+      // Codestream tiles don't overlap so each thread writes its own pixels.
+      Batch batch;
+      batch.m_tiles        = &tiles;
+      batch.m_resLevel     = resLevel;
+      batch.m_area         = &AREA;
+      batch.m_tile         = tile;
+      batch.m_codecThreads = CODEC_THREADS;
+      batch.m_next         = 0;
+      batch.m_done         = 0;
+      batch.m_status       = true;
+
+      m_batch = &batch;
+      m_wake.notify_all();
+      while ( decodeNext( lock ) )
+      {
+      }
+      while ( batch.m_done < tiles.size() )
+      {
+         m_finished.wait( lock );
+      }
+      m_batch = 0;
+      status = batch.m_status;
+   }
+
+   return status;
+}
+
+bool ossimOpjDecoder::decodeNext( std::unique_lock<std::mutex>& lock )
+{
+   Batch* batch = m_batch;
+   if ( !batch || ( batch->m_next >= batch->m_tiles->size() ) )
+   {
+      return false;
+   }
+
+   const ossim_uint32 INDEX = (*batch->m_tiles)[ batch->m_next++ ];
+   bool status = batch->m_status;
+
+   // Skip the decode once a tile has failed; the request fails anyway.
+   if ( status )
+   {
+      lock.unlock();
+      status = decodeTile( INDEX, batch->m_resLevel, *batch->m_area,
+                           batch->m_tile, batch->m_codecThreads );
+      lock.lock();
+   }
+
+   if ( !status )
+   {
+      batch->m_status = false;
+   }
+   if ( ++batch->m_done == batch->m_tiles->size() )
+   {
+      m_finished.notify_all();
+   }
+   return true;
+}
+
+void ossimOpjDecoder::work()
+{
+   std::unique_lock<std::mutex> lock( m_poolMutex );
+   while ( !m_stop )
+   {
+      if ( !decodeNext( lock ) )
+      {
+         m_wake.wait( lock );
+      }
+   }
+}
+
+void ossimOpjDecoder::stopPool()
+{
+   {
+      std::lock_guard<std::mutex> lock( m_poolMutex );
+      m_stop = true;
+   }
+   m_wake.notify_all();
+   for ( size_t i = 0; i < m_pool.size(); ++i )
+   {
+      m_pool[i].join();
+   }
+   m_pool.clear();
+}
+
+bool ossimOpjDecoder::decodeTile( ossim_uint32 tileIndex,
+                                  ossim_uint32 resLevel,
+                                  const ossimIrect& area,
+                                  ossimImageData* tile,
+                                  ossim_uint32 codecThreads )
+{
+   static const char MODULE[] = "ossimOpjDecoder::decodeTile";
+
+   const std::vector<TilePart>& PARTS = m_tileParts[tileIndex];
+   if ( PARTS.empty() )
+   {
+      return true; // Tile missing from the codestream; decode() blanked it.
+   }
+
+   //---
+   // Main header, this tile's parts and an EOC.  Psot is filled in since
+   // the last tile-part of a codestream may have it zero.
+   //---
+   std::vector<ossim_uint8> codestream( m_mainHeader.begin(), m_mainHeader.end() );
+   for ( size_t i = 0; i < PARTS.size(); ++i )
+   {
+      const size_t AT = codestream.size();
+      codestream.resize( AT + PARTS[i].m_length );
+      ossim_uint8* p = &codestream[AT];
+      if ( !read( PARTS[i].m_offset, p, PARTS[i].m_length ) ||
+           ( getUint16( p ) != SOT_MARKER ) || ( getUint16( p + 4 ) != tileIndex ) )
+      {
+         if ( traceDebug() )
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG)
+               << MODULE << " DEBUG: bad tile-part for tile " << tileIndex
+               << " at " << PARTS[i].m_offset << std::endl;
+         }
+         return false;
+      }
+      putUint32( p + 6, PARTS[i].m_length );
+   }
+   codestream.push_back( (ossim_uint8)( EOC_MARKER >> 8 ) );
+   codestream.push_back( (ossim_uint8)( EOC_MARKER & 0xff ) );
+
+   ossimOpjMemoryStream mem;
+   mem.m_data = &codestream.front();
+   mem.m_size = codestream.size();
+   mem.m_pos  = 0;
+
+   opj_stream_t* stream = opj_stream_default_create( OPJ_TRUE );
+   if ( !stream )
+   {
+      return false;
+   }
+   opj_stream_set_read_function( stream, ossim_opj_memory_read );
+   opj_stream_set_skip_function( stream, ossim_opj_memory_skip );
+   opj_stream_set_seek_function( stream, ossim_opj_memory_seek );
+   opj_stream_set_user_data( stream, &mem, NULL );
+   opj_stream_set_user_data_length( stream, mem.m_size );
+
+   opj_dparameters_t param;
+   opj_set_default_decoder_parameters( &param );
+   param.decod_format = OPJ_CODEC_J2K;
+   param.cp_layer = 0;
+   param.cp_reduce = resLevel;
+
+   opj_codec_t* codec = opj_create_decompress( OPJ_CODEC_J2K );
+   opj_image_t* image = 0;
+
+   opj_set_info_handler   ( codec, NULL, 00 );
+   opj_set_warning_handler( codec, ossim::opj_warning_callback, 00 );
+   opj_set_error_handler  ( codec, ossim::opj_error_callback, 00 );
+
+   bool status = opj_setup_decoder( codec, &param );
+   if ( status )
+   {
+      ossim::setCodecThreads( codec, codecThreads );
+   }
+   status = status &&
+      opj_read_header( stream, codec, &image ) &&
+      opj_set_decoded_resolution_factor( codec, resLevel ) &&
+      opj_get_decoded_tile( codec, stream, image, tileIndex );
+
+   if ( status )
+   {
+      ossim_int64 x0, y0, x1, y1;
+      getTileBounds( tileIndex, resLevel, x0, y0, x1, y1 );
+
+      // Sanity check openjpeg agrees on the tile size.
+      status = ( image->numcomps == m_Csiz );
+      for ( ossim_uint32 band = 0; status && ( band < m_Csiz ); ++band )
+      {
+         status = image->comps[band].data &&
+            ( (ossim_int64)image->comps[band].w == x1 - x0 ) &&
+            ( (ossim_int64)image->comps[band].h == y1 - y0 );
+      }
+
+      if ( status )
+      {
+         if ( tile->getScalarType() == OSSIM_UINT8 )
+         {
+            copyOpjTile( ossim_uint8(0), image, x0, y0, area, tile );
+         }
+         else
+         {
+            copyOpjTile( ossim_uint16(0), image, x0, y0, area, tile );
+         }
+      }
+      else if ( traceDebug() )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << MODULE << " DEBUG: unexpected decoded size for tile "
+            << tileIndex << std::endl;
+      }
+   }
+
+   opj_stream_destroy( stream );
+   opj_destroy_codec( codec );
+   if ( image )
+   {
+      opj_image_destroy( image );
+   }
+
+   return status;
+}
+
+bool ossimOpjDecoder::read( std::streamoff offset, ossim_uint8* buf, std::streamsize size )
+{
+   std::lock_guard<std::mutex> lock( m_readMutex );
+   m_str->clear();
+   m_str->seekg( offset, std::ios_base::beg );
+   m_str->read( (char*)buf, size );
+   const bool STATUS = ( m_str->gcount() == size );
+   m_str->clear();
+   return STATUS;
+}
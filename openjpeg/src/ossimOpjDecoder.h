@@ -0,0 +1,203 @@
+//----------------------------------------------------------------------------
+//
+// License:  See top level LICENSE.txt file
+//
+// Description: Persistent tile by tile decoder for one jp2/j2k codestream
+// using the openjpeg library.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#ifndef ossimOpjDecoder_HEADER
+#define ossimOpjDecoder_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+#include <condition_variable>
+#include <iosfwd>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ossimImageData;
+class ossimIrect;
+
+/**
+ * @class ossimOpjDecoder
+ *
+ * open() walks the jp2 boxes and reads the codestream main header once, then
+ * indexes every tile-part from the TLM markers or, when there are none, from
+ * a single pass over the SOT markers.  decode() picks the codestream tiles
+ * covering a request, seeks straight to their tile-parts and hands openjpeg
+ * a small codestream made of the cached main header and just those parts.
+ *
+ * With more than one thread, the codestream tiles of a request are decoded
+ * concurrently on a pool owned by the decoder, and threads left over go to
+ * openjpeg's codec internal threading.
+ *
+ * Codestreams this can't handle (subsampled components, PPM packed headers,
+ * palettes, channel definitions, color spaces other than gray or sRGB) fail
+ * open() and the caller should use ossim::opj_decode instead.  So do
+ * requests much smaller than a codestream tile, e.g. on single tile images,
+ * since whole tiles are decoded.
+ */
+class ossimOpjDecoder
+{
+public:
+
+   /** default constructor */
+   ossimOpjDecoder();
+
+   /** destructor */
+   ~ossimOpjDecoder();
+
+   /**
+    * @brief Reads the headers and builds the tile-part index.
+    * @param str Stream to read.  Not owned and must stay open while this is.
+    * @param offset Offset to the jp2 signature box or the j2k SOC marker.
+    * @return true if tile by tile decoding is possible.
+    */
+   bool open( std::istream* str, std::streamoff offset );
+
+   /** Releases the index.  Does not close the stream. */
+   void close();
+
+   /** @return true if open() succeeded. */
+   bool isOpen() const;
+
+   /**
+    * @brief Decodes a region.
+    * @param rect Region at resLevel relative to the image origin
+    * (XOsiz,YOsiz).  Must be the size of tile.
+    * @param resLevel Reduced resolution level, 0 being full resolution.
+    * @param tile Tile to fill.  Parts of rect outside the image or over
+    * tiles missing from the codestream are blanked.
+    * @return true on success, false on error or if the codestream tiles
+    * are too large, compared to rect, for whole tile decoding to pay off.
+    * On false the caller should use ossim::opj_decode.
+    */
+   bool decode( const ossimIrect& rect,
+                ossim_uint32 resLevel,
+                ossimImageData* tile );
+
+   /** @return Number of codestream tiles. */
+   ossim_uint32 getNumberOfTiles() const;
+
+   /**
+    * @brief Sets the number of decode threads.
+    * @param threads 0 = hardware threads.  Default = 1.
+    */
+   void setThreads( ossim_uint32 threads );
+
+   /** @return Number of decode threads, 0 resolved to hardware threads. */
+   ossim_uint32 getThreads() const;
+
+private:
+
+   /** Codestream tiles of one decode() call, shared with the pool. */
+   struct Batch
+   {
+      const std::vector<ossim_uint32>* m_tiles;
+      ossim_uint32                     m_resLevel;
+      const ossimIrect*                m_area;
+      ossimImageData*                  m_tile;
+      ossim_uint32                     m_codecThreads;
+      size_t                           m_next; // Next tile to hand out.
+      size_t                           m_done;
+      bool                             m_status;
+   };
+
+   /** Location of one tile-part, SOT marker included. */
+   struct TilePart
+   {
+      std::streamoff m_offset;
+      ossim_uint32   m_length;
+   };
+
+   /**
+    * @brief Finds the codestream, checking the jp2 header boxes are ones the
+    * raw codestream decode gives the same answer for.
+    */
+   bool findCodestream( std::streamoff offset, std::streamoff& start );
+
+   /**
+    * @brief Caches the main header, minus TLM/PLM, and parses SIZ.
+    * @param start Offset to the SOC marker.
+    * @param firstSot Initialized to the offset of the first SOT marker.
+    * @param tlm Initialized to (tile index, length) pairs from TLM markers.
+    */
+   bool readMainHeader( std::streamoff start,
+                        std::streamoff& firstSot,
+                        std::vector<ossim_uint32>& tlm );
+
+   bool indexFromTlm( const std::vector<ossim_uint32>& tlm,
+                      std::streamoff firstSot );
+
+   bool indexFromScan( std::streamoff firstSot );
+
+   /** @return true if a SOT for tileIndex starts at offset. */
+   bool checkSot( std::streamoff offset, ossim_uint32 tileIndex );
+
+   /**
+    * @brief Bounds of a codestream tile at resLevel in reference grid
+    * coordinates, end exclusive.  Empty tiles have x0 >= x1 or y0 >= y1.
+    */
+   void getTileBounds( ossim_uint32 tileIndex, ossim_uint32 resLevel,
+                       ossim_int64& x0, ossim_int64& y0,
+                       ossim_int64& x1, ossim_int64& y1 ) const;
+
+   /**
+    * @brief Decodes one codestream tile and copies its overlap with area.
+    * @param area Request in reference grid coordinates at resLevel.
+    */
+   bool decodeTile( ossim_uint32 tileIndex,
+                    ossim_uint32 resLevel,
+                    const ossimIrect& area,
+                    ossimImageData* tile,
+                    ossim_uint32 codecThreads );
+
+   /**
+    * @brief Decodes the next tile of m_batch, if any.
+    * @param lock Lock on m_poolMutex, released while decoding.
+    * @return false if there was nothing left to hand out.
+    */
+   bool decodeNext( std::unique_lock<std::mutex>& lock );
+
+   /** Pool thread loop. */
+   void work();
+
+   /** Stops and joins the pool threads. */
+   void stopPool();
+
+   /** Reads size bytes at offset.  Safe to call from pool threads. */
+   bool read( std::streamoff offset, ossim_uint8* buf, std::streamsize size );
+
+   std::istream*                        m_str;
+   std::streamoff                       m_end;
+   std::vector<ossim_uint8>             m_mainHeader;
+   std::vector< std::vector<TilePart> > m_tileParts;
+   std::mutex                           m_readMutex;
+
+   // From the SIZ marker.
+   ossim_uint32 m_Xsiz;
+   ossim_uint32 m_Ysiz;
+   ossim_uint32 m_XOsiz;
+   ossim_uint32 m_YOsiz;
+   ossim_uint32 m_XTsiz;
+   ossim_uint32 m_YTsiz;
+   ossim_uint32 m_XTOsiz;
+   ossim_uint32 m_YTOsiz;
+   ossim_uint32 m_Csiz;
+   ossim_uint32 m_tilesX;
+   ossim_uint32 m_tilesY;
+
+   // Decode pool; started on the first request spanning several tiles.
+   ossim_uint32             m_threads;
+   std::vector<std::thread> m_pool;
+   std::mutex               m_poolMutex;
+   std::condition_variable  m_wake;     // Work available or stopping.
+   std::condition_variable  m_finished; // Last tile of m_batch done.
+   Batch*                   m_batch;
+   bool                     m_stop;
+};
+
+#endif /* matches: #ifndef ossimOpjDecoder_HEADER */
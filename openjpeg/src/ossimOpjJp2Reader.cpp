@@ -11,6 +11,8 @@
 
 #include <ossimOpjJp2Reader.h>
 #include <ossimOpjCommon.h>
+#include <ossimOpjDecoder.h>
+#include <ossimOpjKeywords.h>
 
 #include <ossim/base/ossimCommon.h>
 #include <ossim/base/ossimConstants.h>
@@ -23,6 +25,7 @@
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimKeywordNames.h>
 #include <ossim/base/ossimNotifyContext.h>
+#include <ossim/base/ossimNumericProperty.h>
 #include <ossim/base/ossimTrace.h>
 #include <ossim/base/ossimUnitConversionTool.h>
 
@@ -64,7 +67,9 @@ ossimOpjJp2Reader::ossimOpjJp2Reader()
    m_sizRecord(),
    m_tile(0),
    m_str(0),
-   m_minDwtLevels(0)
+   m_minDwtLevels(0),
+   m_decoder(0),
+   m_threads(1)
 {
    // Uncomment to enable trace for debug:
    // traceDebug.setTraceFlag(true); 
@@ -89,6 +94,12 @@ void ossimOpjJp2Reader::destroy()
 {
    m_tile      = 0;  // ossimRefPtr
    m_cacheTile = 0;  // ossimRefPtr   
+
+   if ( m_decoder )
+   {
+      delete m_decoder;
+      m_decoder = 0;
+   }
    
    if ( m_str )
    {
@@ -136,6 +147,18 @@ bool ossimOpjJp2Reader::open()
                   // Number of built in reduced res sets.
                   m_minDwtLevels = codRecord.m_numberOfDecompositionLevels;
 
+                  //---
+                  // Index the codestream tiles once so getTile doesn't
+                  // re-parse the headers on every call.
+                  //---
+                  m_decoder = new ossimOpjDecoder();
+                  m_decoder->setThreads( m_threads );
+                  if ( !m_decoder->open( m_str, 0 ) )
+                  {
+                     delete m_decoder;
+                     m_decoder = 0;
+                  }
+
                   // Put the stream back:
                   m_str->seekg(0, ios_base::beg);
 
@@ -266,12 +289,20 @@ bool ossimOpjJp2Reader::getOverviewTile(ossim_uint32 resLevel,
          
          try
          {
-            status = ossim::opj_decode( m_str,
-                                        shiftedRect,
-                                        resLevel,
-                                        m_format,
-                                        0,
-                                        m_cacheTile.get() );
+            if ( m_decoder )
+            {
+               status = m_decoder->decode( clipRect, resLevel, m_cacheTile.get() );
+            }
+            if ( !status )
+            {
+               status = ossim::opj_decode( m_str,
+                                           shiftedRect,
+                                           resLevel,
+                                           m_format,
+                                           0,
+                                           m_cacheTile.get(),
+                                           m_threads );
+            }
 
             if ( status )
             {
@@ -351,12 +382,23 @@ ossimOpjJp2Reader::getImageRectangle(ossim_uint32 reduced_res_level) const
 bool ossimOpjJp2Reader::saveState(ossimKeywordlist& kwl,
                                   const char* prefix) const
 {
+   kwl.add( prefix,
+            THREADS_KW,
+            ossimString::toString(m_threads),
+            true );
+   
    return ossimImageHandler::saveState(kwl, prefix);
 }
 
 bool ossimOpjJp2Reader::loadState(const ossimKeywordlist& kwl,
                                   const char* prefix)
 {
+   const char* value = kwl.find(prefix, THREADS_KW);
+   if(value)
+   {
+      m_threads = ossimString(value).toUInt32();
+   }
+   
    if (ossimImageHandler::loadState(kwl, prefix))
    {
       return open();
@@ -365,6 +407,47 @@ bool ossimOpjJp2Reader::loadState(const ossimKeywordlist& kwl,
    return false;
 }
 
+void ossimOpjJp2Reader::setProperty(ossimRefPtr<ossimProperty> property)
+{
+   if ( property.valid() )
+   {
+      if ( property->getName() == THREADS_KW )
+      {
+         m_threads = property->valueToString().toUInt32();
+         if ( m_decoder )
+         {
+            m_decoder->setThreads( m_threads );
+         }
+      }
+      else
+      {
+         ossimImageHandler::setProperty(property);
+      }
+   }
+}
+
+ossimRefPtr<ossimProperty> ossimOpjJp2Reader::getProperty(
+   const ossimString& name)const
+{
+   ossimRefPtr<ossimProperty> prop = 0;
+   if ( name == THREADS_KW )
+   {
+      prop = new ossimNumericProperty(name, ossimString::toString(m_threads));
+   }
+   else
+   {
+      prop = ossimImageHandler::getProperty(name);
+   }
+   return prop;
+}
+
+void ossimOpjJp2Reader::getPropertyNames(
+   std::vector<ossimString>& propertyNames)const
+{
+   propertyNames.push_back(THREADS_KW);
+   ossimImageHandler::getPropertyNames(propertyNames);
+}
+
 ossim_uint32 ossimOpjJp2Reader::getNumberOfDecimationLevels()const
 {
    ossim_uint32 result = 1; // Add r0
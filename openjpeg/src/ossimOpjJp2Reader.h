@@ -21,6 +21,7 @@
 // Forward class declarations.
 class ossimImageData;
 class ossimJ2kCodRecord;
+class ossimOpjDecoder;
 
 class ossimOpjJp2Reader : public ossimImageHandler
 {
@@ -117,6 +118,18 @@ public:
    virtual bool loadState(const ossimKeywordlist& kwl,
                           const char* prefix=0);
 
+   /**
+    * @brief Sets a property.  Handles "threads", the number of decode
+    * threads; 0 = hardware threads, default 1.
+    */
+   virtual void setProperty(ossimRefPtr<ossimProperty> property);
+
+   /** @return The property, or a null ref if not found. */
+   virtual ossimRefPtr<ossimProperty> getProperty(const ossimString& name)const;
+
+   /** Adds this class's properties to the list. */
+   virtual void getPropertyNames(std::vector<ossimString>& propertyNames)const;
+
    /**
     * Returns the output pixel type of the tile source.
     */
@@ -225,6 +238,12 @@ private:
    std::ifstream*               m_str;
    ossim_uint32                 m_minDwtLevels;
    ossim_int32                  m_format; // OPJ_CODEC_FORMAT
+
+   /** Tile by tile decoder; null if the codestream needs ossim::opj_decode. */
+   ossimOpjDecoder*             m_decoder;
+
+   /** Decode threads; 0 = hardware threads. */
+   ossim_uint32                 m_threads;
    
 TYPE_DATA
 };
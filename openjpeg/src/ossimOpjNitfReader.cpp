@@ -14,8 +14,12 @@
 
 #include <ossimOpjNitfReader.h>
 #include <ossimOpjCommon.h>
+#include <ossimOpjDecoder.h>
+#include <ossimOpjKeywords.h>
 #include <ossim/base/ossimCommon.h>
 #include <ossim/base/ossimException.h>
+#include <ossim/base/ossimKeywordlist.h>
+#include <ossim/base/ossimNumericProperty.h>
 #include <ossim/base/ossimTrace.h>
 #include <ossim/support_data/ossimNitfImageHeader.h>
 
@@ -39,7 +43,10 @@ RTTI_DEF1_INST(ossimOpjNitfReader,
 
 
 ossimOpjNitfReader::ossimOpjNitfReader()
-   : ossimNitfTileSource()
+   : ossimNitfTileSource(),
+     m_decoder(0),
+     m_decoderOffset(0),
+     m_threads(1)
 {
 }
 
@@ -48,6 +55,80 @@ ossimOpjNitfReader::~ossimOpjNitfReader()
    close();
 }
 
+void ossimOpjNitfReader::close()
+{
+   if ( m_decoder )
+   {
+      delete m_decoder;
+      m_decoder = 0;
+   }
+   ossimNitfTileSource::close();
+}
+
+void ossimOpjNitfReader::setProperty(ossimRefPtr<ossimProperty> property)
+{
+   if ( property.valid() )
+   {
+      if ( property->getName() == THREADS_KW )
+      {
+         m_threads = property->valueToString().toUInt32();
+         if ( m_decoder )
+         {
+            m_decoder->setThreads( m_threads );
+         }
+      }
+      else
+      {
+         ossimNitfTileSource::setProperty(property);
+      }
+   }
+}
+
+ossimRefPtr<ossimProperty> ossimOpjNitfReader::getProperty(
+   const ossimString& name)const
+{
+   ossimRefPtr<ossimProperty> prop = 0;
+   if ( name == THREADS_KW )
+   {
+      prop = new ossimNumericProperty(name, ossimString::toString(m_threads));
+   }
+   else
+   {
+      prop = ossimNitfTileSource::getProperty(name);
+   }
+   return prop;
+}
+
+void ossimOpjNitfReader::getPropertyNames(
+   std::vector<ossimString>& propertyNames)const
+{
+   propertyNames.push_back(THREADS_KW);
+   ossimNitfTileSource::getPropertyNames(propertyNames);
+}
+
+bool ossimOpjNitfReader::saveState(ossimKeywordlist& kwl,
+                                   const char* prefix)const
+{
+   kwl.add( prefix,
+            THREADS_KW,
+            ossimString::toString(m_threads),
+            true );
+
+   return ossimNitfTileSource::saveState(kwl, prefix);
+}
+
+bool ossimOpjNitfReader::loadState(const ossimKeywordlist& kwl,
+                                   const char* prefix)
+{
+   const char* value = kwl.find(prefix, THREADS_KW);
+   if(value)
+   {
+      m_threads = ossimString(value).toUInt32();
+   }
+
+   return ossimNitfTileSource::loadState(kwl, prefix);
+}
+
 bool ossimOpjNitfReader::canUncompress(
    const ossimNitfImageHeader* hdr) const
 {
@@ -142,6 +223,23 @@ bool ossimOpjNitfReader::uncompressJpegBlock(ossim_uint32 x,
                    ossimIpt((blockX + 1) * numX - 1, (blockY + 1) * numY - 1));
 
    std::streamoff offset = hdr->getDataLocation();
+
+   // Index the entry's codestream once; then decode just the tiles needed.
+   if ( !m_decoder || ( m_decoderOffset != offset ) )
+   {
+      if ( !m_decoder )
+      {
+         m_decoder = new ossimOpjDecoder();
+         m_decoder->setThreads( m_threads );
+      }
+      m_decoder->open( theFileStr.get(), offset );
+      m_decoderOffset = offset;
+   }
+   if ( m_decoder->isOpen() && m_decoder->decode( rect, 0, theCacheTile.get() ) )
+   {
+      return true;
+   }
+
    theFileStr->seekg(offset, ios::beg);
    ossim_int32 format = ossim::getCodecFormat(theFileStr.get());
    if (format == OPJ_CODEC_UNKNOWN)
@@ -152,7 +250,7 @@ bool ossimOpjNitfReader::uncompressJpegBlock(ossim_uint32 x,
       return false;
    }
 
-   if (ossim::opj_decode(theFileStr.get(), rect, 0, format, offset, theCacheTile.get()) == false)
+   if (ossim::opj_decode(theFileStr.get(), rect, 0, format, offset, theCacheTile.get(), m_threads) == false)
    {
        return false;
    }
@@ -16,6 +16,9 @@
 #include <ossim/imaging/ossimNitfTileSource.h>
 // #include <ossimJ2kSizRecord.h>
 // #include <ossimJ2kSotRecord.h>
+#include <iosfwd>
+
+class ossimOpjDecoder;
 
 class OSSIM_PLUGINS_DLL ossimOpjNitfReader : public ossimNitfTileSource
 {
@@ -27,6 +30,27 @@ public:
    /** virtural destructor */
    virtual ~ossimOpjNitfReader();
 
+   /** Deletes the codestream decoder then calls base close. */
+   virtual void close();
+
+   /**
+    * @brief Sets a property.  Handles "threads", the number of decode
+    * threads; 0 = hardware threads, default 1.
+    */
+   virtual void setProperty(ossimRefPtr<ossimProperty> property);
+
+   /** @return The property, or a null ref if not found. */
+   virtual ossimRefPtr<ossimProperty> getProperty(const ossimString& name)const;
+
+   /** Adds this class's properties to the list. */
+   virtual void getPropertyNames(std::vector<ossimString>& propertyNames)const;
+
+   /** Saves the thread count then calls base saveState. */
+   virtual bool saveState(ossimKeywordlist& kwl, const char* prefix=0)const;
+
+   /** Loads the thread count then calls base loadState. */
+   virtual bool loadState(const ossimKeywordlist& kwl, const char* prefix=0);
+
 protected:
 
    /**
@@ -66,6 +90,15 @@ protected:
 
 private:
 
+   /** Tile by tile decoder for the current entry's codestream. */
+   ossimOpjDecoder* m_decoder;
+
+   /** Codestream offset m_decoder was opened on. */
+   std::streamoff   m_decoderOffset;
+
+   /** Decode threads; 0 = hardware threads. */
+   ossim_uint32     m_threads;
+
 TYPE_DATA   
 };
 
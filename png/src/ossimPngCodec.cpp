@@ -1,9 +1,28 @@
 #include "ossimPngCodec.h"
+#include <ossim/base/ossimBooleanProperty.h>
 #include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimIrect.h>
+#include <ossim/base/ossimKeywordlist.h>
+#include <ossim/base/ossimNumericProperty.h>
+#include <ossim/base/ossimStringProperty.h>
+#include <ossim/imaging/ossimImageData.h>
 #include <png.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
 static const char ADD_ALPHA_CHANNEL_KW[] = "add_alpha_channel";
+static const char COMPRESSION_LEVEL_KW[] = "compression_level";
+static const char FILTER_KW[]            = "filter";
+
+static const ossim_int32 DEFAULT_COMPRESSION_LEVEL = 1;
+
+// Largest width or height decodeDirect takes; bigger goes to libpng.
+static const ossim_uint32 MAX_DIRECT_DIMENSION = 8192;
+
+static const char* FILTER_STRINGS[] = { "none", "sub", "up", "avg", "paeth", "adaptive" };
 
 static void user_read_data (png_structp png_ptr, png_bytep data, png_size_t length)
 {
@@ -13,20 +32,436 @@ static void user_read_data (png_structp png_ptr, png_bytep data, png_size_t leng
    (*input_pointer) += length;
 }
 
-static void PngWriteCallback(png_structp  png_ptr, png_bytep data, png_size_t length) 
+static ossim_uint32 getUint32( const ossim_uint8* p )
+{
+   // Big endian.
+   return ( (ossim_uint32)p[0] << 24 ) | ( (ossim_uint32)p[1] << 16 ) |
+          ( (ossim_uint32)p[2] << 8 )  |   (ossim_uint32)p[3];
+}
+
+static void putUint32( ossim_uint8* p, ossim_uint32 v )
+{
+   // Big endian.
+   p[0] = (ossim_uint8)( ( v >> 24 ) & 0xff );
+   p[1] = (ossim_uint8)( ( v >> 16 ) & 0xff );
+   p[2] = (ossim_uint8)( ( v >> 8 ) & 0xff );
+   p[3] = (ossim_uint8)( v & 0xff );
+}
+
+// Writes the chunk crc after "length" bytes of data at p (p is the length field).
+static void putChunkCrc( ossim_uint8* p, ossim_uint32 length )
+{
+   uLong crc = crc32( 0L, Z_NULL, 0 );
+   crc = crc32( crc, p + 4, length + 4 );
+   putUint32( p + 8 + length, (ossim_uint32)crc );
+}
+
+static int paethPredictor( int a, int b, int c )
+{
+   int pa = std::abs( b - c );
+   int pb = std::abs( a - c );
+   int pc = std::abs( a + b - c - c );
+   return ( ( pa <= pb ) && ( pa <= pc ) ) ? a : ( ( pb <= pc ) ? b : c );
+}
+
+// Filters one row with a fixed filter.  out[0] is the filter type.
+static void filterRow( ossim_uint32 filter,
+                       const ossim_uint8* row,
+                       const ossim_uint8* prior,
+                       ossim_uint32 rowBytes,
+                       ossim_uint32 bpp,
+                       ossim_uint8* out )
+{
+   out[0] = (ossim_uint8)filter;
+   ++out;
+
+   ossim_uint32 i = 0;
+   switch ( filter )
+   {
+      case ossimPngCodec::FILTER_SUB:
+      {
+         for ( ; i < bpp; ++i )
+         {
+            out[i] = row[i];
+         }
+         for ( ; i < rowBytes; ++i )
+         {
+            out[i] = (ossim_uint8)( row[i] - row[i-bpp] );
+         }
+         break;
+      }
+      case ossimPngCodec::FILTER_UP:
+      {
+         for ( ; i < rowBytes; ++i )
+         {
+            out[i] = (ossim_uint8)( row[i] - prior[i] );
+         }
+         break;
+      }
+      case ossimPngCodec::FILTER_AVG:
+      {
+         for ( ; i < bpp; ++i )
+         {
+            out[i] = (ossim_uint8)( row[i] - ( prior[i] >> 1 ) );
+         }
+         for ( ; i < rowBytes; ++i )
+         {
+            out[i] = (ossim_uint8)( row[i] - ( ( row[i-bpp] + prior[i] ) >> 1 ) );
+         }
+         break;
+      }
+      case ossimPngCodec::FILTER_PAETH:
+      {
+         for ( ; i < bpp; ++i )
+         {
+            out[i] = (ossim_uint8)( row[i] - prior[i] );
+         }
+         for ( ; i < rowBytes; ++i )
+         {
+            out[i] = (ossim_uint8)( row[i] - paethPredictor( row[i-bpp], prior[i], prior[i-bpp] ) );
+         }
+         break;
+      }
+      case ossimPngCodec::FILTER_NONE:
+      default:
+      {
+         memcpy( out, row, rowBytes );
+         break;
+      }
+   }
+}
+
+//---
+// Sum of the residuals as signed bytes.  Smaller usually deflates better.
+// Stops once the sum reaches limit since the row has lost by then.
+//---
+static ossim_uint64 filterCost( const ossim_uint8* filtered,
+                                ossim_uint32 rowBytes,
+                                ossim_uint64 limit )
+{
+   ossim_uint64 sum = 0;
+   ossim_uint32 i = 0;
+   while ( i < rowBytes )
+   {
+      ossim_uint32 end = std::min<ossim_uint32>( i + 256, rowBytes );
+      for ( ; i < end; ++i )
+      {
+         sum += ( filtered[i] < 128 ) ? filtered[i] : ( 256 - filtered[i] );
+      }
+      if ( sum >= limit )
+      {
+         break;
+      }
+   }
+   return sum;
+}
+
+// Unfilters one row in place.  prior is the unfiltered row above.
+static bool unfilterRow( ossim_uint8 filter,
+                         ossim_uint8* row,
+                         const ossim_uint8* prior,
+                         ossim_uint32 rowBytes,
+                         ossim_uint32 bpp )
+{
+   ossim_uint32 i = 0;
+   switch ( filter )
+   {
+      case ossimPngCodec::FILTER_NONE:
+      {
+         break;
+      }
+      case ossimPngCodec::FILTER_SUB:
+      {
+         for ( i = bpp; i < rowBytes; ++i )
+         {
+            row[i] = (ossim_uint8)( row[i] + row[i-bpp] );
+         }
+         break;
+      }
+      case ossimPngCodec::FILTER_UP:
+      {
+         for ( ; i < rowBytes; ++i )
+         {
+            row[i] = (ossim_uint8)( row[i] + prior[i] );
+         }
+         break;
+      }
+      case ossimPngCodec::FILTER_AVG:
+      {
+         for ( ; i < bpp; ++i )
+         {
+            row[i] = (ossim_uint8)( row[i] + ( prior[i] >> 1 ) );
+         }
+         for ( ; i < rowBytes; ++i )
+         {
+            row[i] = (ossim_uint8)( row[i] + ( ( row[i-bpp] + prior[i] ) >> 1 ) );
+         }
+         break;
+      }
+      case ossimPngCodec::FILTER_PAETH:
+      {
+         for ( ; i < bpp; ++i )
+         {
+            row[i] = (ossim_uint8)( row[i] + prior[i] );
+         }
+         for ( ; i < rowBytes; ++i )
+         {
+            row[i] = (ossim_uint8)( row[i] + paethPredictor( row[i-bpp], prior[i], prior[i-bpp] ) );
+         }
+         break;
+      }
+      default:
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Copies band interleaved, decoded pixels to "out", dropping any alpha.
+static bool loadDecodedTile( const ossim_uint8* dataPtr,
+                             ossim_uint32 width,
+                             ossim_uint32 height,
+                             ossim_uint32 input_bands,
+                             ossimScalarType scalar_type,
+                             ossimRefPtr<ossimImageData>& out )
 {
-   std::vector<ossim_uint8> *p = (std::vector<ossim_uint8>*)png_get_io_ptr(png_ptr);
-   p->insert(p->end(), data, data + length);
+   bool result = true;
+
+   ossim_uint32 output_bands = input_bands;
+   if( (output_bands == 2) || (output_bands==4) )
+   {
+      output_bands = output_bands - 1;
+   }
+
+   ossim_uint32 bytes_per_pixel = (scalar_type == OSSIM_UINT8) ? 1 : 2;
+   ossim_uint32 bytes = height*width*input_bands*bytes_per_pixel;
+
+   // now allocate the ossimImageData object if not already allocated
+   if(!out.valid())
+   {
+      out = new ossimImageData(0, scalar_type, output_bands, width, height);
+      out->initialize();
+   }
+   else
+   {
+      out->setNumberOfDataComponents(output_bands);
+      out->setImageRectangleAndBands(ossimIrect(0,0,width-1,height-1), output_bands);
+      out->initialize();
+   }
+
+   if(input_bands == 1)
+   {
+      memcpy(out->getBuf(0), dataPtr, bytes);
+      out->validate();
+      // once we support alpha channel properly we will need to add alpha settings here
+   }
+   else if(input_bands == 2)
+   {
+      ossim_uint32 size = width*height;
+      ossim_uint32 idx = 0;
+      if(scalar_type == OSSIM_UINT16)
+      {
+         const ossim_uint16* tempDataPtr = reinterpret_cast<const ossim_uint16*> (dataPtr);
+         ossim_uint16* buf = static_cast<ossim_uint16*>(out->getBuf(0));
+
+         for(idx = 0; idx < size;++idx)
+         {
+            *buf = tempDataPtr[0];
+
+            tempDataPtr+=2;++buf;
+         }
+         out->validate();
+      }
+      else if(scalar_type == OSSIM_UINT8)
+      {
+         const ossim_uint8* tempDataPtr = dataPtr;
+         ossim_uint8* buf = static_cast<ossim_uint8*>(out->getBuf(0));
+
+         for(idx = 0; idx < size;++idx)
+         {
+            *buf = *tempDataPtr;
+
+            tempDataPtr+=2;++buf;
+         }
+         out->validate();
+      }
+      else
+      {
+         result = false;
+      }
+   }
+   else if(input_bands == 4)
+   {
+      ossim_uint32 size = width*height;
+      ossim_uint32 idx = 0;
+      if(scalar_type == OSSIM_UINT16)
+      {
+         const ossim_uint16* tempDataPtr = reinterpret_cast<const ossim_uint16*> (dataPtr);
+         ossim_uint16* buf1 = static_cast<ossim_uint16*>(out->getBuf(0));
+         ossim_uint16* buf2 = static_cast<ossim_uint16*>(out->getBuf(1));
+         ossim_uint16* buf3 = static_cast<ossim_uint16*>(out->getBuf(2));
+
+         for(idx = 0; idx < size;++idx)
+         {
+            *buf1 = tempDataPtr[0];
+            *buf2 = tempDataPtr[1];
+            *buf3 = tempDataPtr[2];
+
+            tempDataPtr+=4;++buf1;++buf2;++buf3;
+         }
+         out->validate();
+      }
+      else if(scalar_type == OSSIM_UINT8)
+      {
+         const ossim_uint8* tempDataPtr = dataPtr;
+         ossim_uint8* buf1 = static_cast<ossim_uint8*>(out->getBuf(0));
+         ossim_uint8* buf2 = static_cast<ossim_uint8*>(out->getBuf(1));
+         ossim_uint8* buf3 = static_cast<ossim_uint8*>(out->getBuf(2));
+
+         for(idx = 0; idx < size;++idx)
+         {
+            *buf1 = tempDataPtr[0];
+            *buf2 = tempDataPtr[1];
+            *buf3 = tempDataPtr[2];
+
+            tempDataPtr+=4;++buf1;++buf2;++buf3;
+         }
+         out->validate();
+      }
+      else
+      {
+         result = false;
+      }
+   }
+   else
+   {
+      out->loadTile(dataPtr, out->getImageRectangle(), OSSIM_BIP);
+   }
+
+   return result;
 }
- 
-struct TPngDestructor {
-   png_struct *p;
-   TPngDestructor(png_struct *p) : p(p)  {}
-   ~TPngDestructor() { if (p) {  png_destroy_write_struct(&p, NULL); } }
+
+//---
+// Per thread state.  A z_stream costs a few hundred k of allocations to
+// set up, so it is reset between tiles instead.  The buffers only grow.
+//---
+class ossimPngCodec::Context
+{
+public:
+   Context();
+   ~Context();
+
+   /** @return Deflate stream reset for level and strategy or 0 on error. */
+   z_stream* getDeflate( ossim_int32 level, ossim_int32 strategy );
+
+   /** @return Inflate stream reset or 0 on error. */
+   z_stream* getInflate();
+
+   std::vector<ossim_uint8>  m_bip;      // Band interleaved pixels.
+   std::vector<ossim_uint8>  m_filtered; // Filter byte plus row, all rows.
+   std::vector<ossim_uint8>  m_scratch;  // Adaptive filter candidates.
+   std::vector<ossim_uint8>  m_zeros;    // Prior for the first row.
+   std::vector<ossim_uint8*> m_rows;     // libpng row pointers.
+
+private:
+   z_stream    m_deflate;
+   bool        m_deflateInit;
+   ossim_int32 m_level;
+   ossim_int32 m_strategy;
+   z_stream    m_inflate;
+   bool        m_inflateInit;
 };
 
+ossimPngCodec::Context::Context()
+   : m_bip(),
+     m_filtered(),
+     m_scratch(),
+     m_zeros(),
+     m_rows(),
+     m_deflate(),
+     m_deflateInit(false),
+     m_level(0),
+     m_strategy(0),
+     m_inflate(),
+     m_inflateInit(false)
+{
+}
+
+ossimPngCodec::Context::~Context()
+{
+   if ( m_deflateInit )
+   {
+      deflateEnd( &m_deflate );
+   }
+   if ( m_inflateInit )
+   {
+      inflateEnd( &m_inflate );
+   }
+}
+
+z_stream* ossimPngCodec::Context::getDeflate( ossim_int32 level, ossim_int32 strategy )
+{
+   if ( m_deflateInit && ( ( level != m_level ) || ( strategy != m_strategy ) ) )
+   {
+      deflateEnd( &m_deflate );
+      m_deflateInit = false;
+   }
+
+   if ( m_deflateInit )
+   {
+      if ( deflateReset( &m_deflate ) != Z_OK )
+      {
+         return 0;
+      }
+   }
+   else
+   {
+      memset( &m_deflate, 0, sizeof(z_stream) );
+      if ( deflateInit2( &m_deflate, level, Z_DEFLATED, 15, 8, strategy ) != Z_OK )
+      {
+         return 0;
+      }
+      m_deflateInit = true;
+      m_level       = level;
+      m_strategy    = strategy;
+   }
+
+   return &m_deflate;
+}
+
+z_stream* ossimPngCodec::Context::getInflate()
+{
+   if ( m_inflateInit )
+   {
+      if ( inflateReset( &m_inflate ) != Z_OK )
+      {
+         return 0;
+      }
+   }
+   else
+   {
+      memset( &m_inflate, 0, sizeof(z_stream) );
+      if ( inflateInit( &m_inflate ) != Z_OK )
+      {
+         return 0;
+      }
+      m_inflateInit = true;
+   }
+
+   return &m_inflate;
+}
+
+ossimPngCodec::Context& ossimPngCodec::getContext()
+{
+   static thread_local Context context;
+   return context;
+}
+
 ossimPngCodec::ossimPngCodec(bool addAlpha)
    :m_addAlphaChannel(addAlpha),
+    m_compressionLevel(DEFAULT_COMPRESSION_LEVEL),
+    m_filter(FILTER_ADAPTIVE),
     m_ext("png")
 {
 
@@ -42,14 +477,21 @@ const std::string& ossimPngCodec::getExtension() const
    return m_ext; // "png"
 }
 
-
 bool ossimPngCodec::encode(const ossimRefPtr<ossimImageData>& in,
                            std::vector<ossim_uint8>& out ) const
+{
+   return encode( in, out, m_compressionLevel, m_filter );
+}
+
+bool ossimPngCodec::encode( const ossimRefPtr<ossimImageData>& in,
+                            std::vector<ossim_uint8>& out,
+                            ossim_int32 level,
+                            FilterType filter ) const
 {
    out.clear();
    ossim_int32 colorType = -1;
    ossim_int32 bitDepth = 0;
-   if(!in->getBuf()) return false;
+   if(!in.valid() || !in->getBuf()) return false;
    if(in->getNumberOfBands() == 1)
    {
       if(m_addAlphaChannel)
@@ -93,152 +535,296 @@ bool ossimPngCodec::encode(const ossimRefPtr<ossimImageData>& in,
       }
    }
    if(bitDepth == 0) return false;
-   // std::cout << "bitDepth = " << bitDepth << ", BANDS = " << in->getNumberOfBands() << std::endl;
-   ossim_int32 w = in->getWidth();
-   ossim_int32 h = in->getHeight();
-   png_structp p = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-   TPngDestructor destroyPng(p);
-   png_infop info_ptr = png_create_info_struct(p);
-   setjmp(png_jmpbuf(p));
-
-   png_set_IHDR(p, info_ptr, w, h, bitDepth,
-                colorType,
-                PNG_INTERLACE_NONE,
-                PNG_COMPRESSION_TYPE_DEFAULT,
-                PNG_FILTER_TYPE_DEFAULT);
-   png_set_compression_level(p, 1);
-
-   switch(colorType)
+
+   if ( ( level < Z_DEFAULT_COMPRESSION ) || ( level > Z_BEST_COMPRESSION ) )
    {
-      case PNG_COLOR_TYPE_GRAY:
+      level = DEFAULT_COMPRESSION_LEVEL;
+   }
+
+   const ossim_uint32 W         = in->getWidth();
+   const ossim_uint32 H         = in->getHeight();
+   const ossim_uint32 CHANNELS  = in->getNumberOfBands() + ( m_addAlphaChannel ? 1 : 0 );
+   const ossim_uint32 BPP       = CHANNELS * ( bitDepth / 8 );
+   const ossim_uint32 ROW_BYTES = W * BPP;
+   const ossim_uint32 STRIDE    = ROW_BYTES + 1;
+
+   Context& ctx = getContext();
+
+   //---
+   // Band interleave.  Samples go out in memory order, which is what
+   // decode expects back.  One band needs no copy.
+   //---
+   const ossim_uint8* pixels = 0;
+   if ( CHANNELS == 1 )
+   {
+      pixels = (const ossim_uint8*)in->getBuf();
+   }
+   else
+   {
+      ctx.m_bip.resize( ROW_BYTES * H );
+      if ( m_addAlphaChannel )
+      {
+         in->unloadTileToBipAlpha( &ctx.m_bip.front(),
+                                   in->getImageRectangle(),
+                                   in->getImageRectangle() );
+      }
+      else
+      {
+         in->unloadTile( &ctx.m_bip.front(),
+                         in->getImageRectangle(),
+                         in->getImageRectangle(),
+                         OSSIM_BIP );
+      }
+      pixels = &ctx.m_bip.front();
+   }
+
+   // Filter.
+   ctx.m_filtered.resize( STRIDE * H );
+   ctx.m_zeros.assign( ROW_BYTES, 0 );
+   if ( filter == FILTER_ADAPTIVE )
+   {
+      ctx.m_scratch.resize( STRIDE * 5 );
+   }
+   for ( ossim_uint32 y = 0; y < H; ++y )
+   {
+      const ossim_uint8* row   = pixels + y * ROW_BYTES;
+      const ossim_uint8* prior = y ? row - ROW_BYTES : &ctx.m_zeros.front();
+      ossim_uint8* dst = &ctx.m_filtered[ y * STRIDE ];
+
+      if ( filter == FILTER_ADAPTIVE )
       {
-         if(bitDepth == 8)
+         //---
+         // libpng's heuristic: keep the filter with the smallest sum of
+         // absolute residuals.  A zero sum cannot be beaten so stop there.
+         //---
+         ossim_uint32 best = 0;
+         ossim_uint64 bestCost = 0;
+         for ( ossim_uint32 f = FILTER_NONE; f <= FILTER_PAETH; ++f )
          {
-            ossim_uint8* buf = (ossim_uint8*)in->getBuf();
-            std::vector<ossim_uint8*> rows(h);
-            for(ossim_int32 y=0; y<h;++y)
+            ossim_uint8* candidate = &ctx.m_scratch[ f * STRIDE ];
+            filterRow( f, row, prior, ROW_BYTES, BPP, candidate );
+            ossim_uint64 cost = filterCost( candidate + 1, ROW_BYTES,
+                                            ( f == FILTER_NONE ) ? ~(ossim_uint64)0 : bestCost );
+            if ( ( f == FILTER_NONE ) || ( cost < bestCost ) )
             {
-               rows[y] = (ossim_uint8*)(buf + y * w) ;    		
+               best = f;
+               bestCost = cost;
             }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
-         else if(bitDepth == 16)
-         {
-            ossim_uint16* buf = (ossim_uint16*)in->getBuf();
-            std::vector<ossim_uint8*> rows(h);
-            for(int y=0; y<h;++y)
+            if ( cost == 0 )
             {
-               rows[y] = (ossim_uint8*)(buf + y * w) ;    		
+               break;
             }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
          }
-         break;
+         memcpy( dst, &ctx.m_scratch[ best * STRIDE ], STRIDE );
       }
-      case PNG_COLOR_TYPE_GRAY_ALPHA:
+      else
       {
-         if(bitDepth == 8)
-         {
-            std::vector<ossim_uint8> buf(w*h*2);
-            std::vector<ossim_uint8*> rows(h);
-            ossim_uint8* bufPtr = &buf.front();
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            for(int y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*2)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+         filterRow( filter, row, prior, ROW_BYTES, BPP, dst );
+      }
+   }
 
-         }
-         else
-         {
-            std::vector<ossim_uint16> buf(w*h*2);
-            std::vector<ossim_uint8*> rows(h);
-            ossim_uint16* bufPtr = &buf.front();
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*2)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
+   // Same strategy choice libpng makes.
+   z_stream* strm = ctx.getDeflate( level,
+                                    ( filter == FILTER_NONE ) ? Z_DEFAULT_STRATEGY : Z_FILTERED );
+   if ( !strm )
+   {
+      return false;
+   }
 
+   //---
+   // Signature, IHDR, IDAT header, the deflated data, then IDAT crc and
+   // IEND.  Sized from deflateBound so the buffer is written in place.
+   //---
+   static const ossim_uint8 SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+   const size_t IHDR_POS = 8;
+   const size_t IDAT_POS = IHDR_POS + 25;
+   const size_t DATA_POS = IDAT_POS + 8;
+   const uLong  SIZE     = STRIDE * H;
+
+   size_t capacity = DATA_POS + deflateBound( strm, SIZE ) + 4 + 12;
+   out.resize( capacity );
+   ossim_uint8* p = &out.front();
+
+   memcpy( p, SIGNATURE, 8 );
+
+   putUint32( p + IHDR_POS, 13 );
+   memcpy( p + IHDR_POS + 4, "IHDR", 4 );
+   putUint32( p + IHDR_POS + 8, W );
+   putUint32( p + IHDR_POS + 12, H );
+   p[IHDR_POS + 16] = (ossim_uint8)bitDepth;
+   p[IHDR_POS + 17] = (ossim_uint8)colorType;
+   p[IHDR_POS + 18] = PNG_COMPRESSION_TYPE_BASE;
+   p[IHDR_POS + 19] = PNG_FILTER_TYPE_BASE;
+   p[IHDR_POS + 20] = PNG_INTERLACE_NONE;
+   putChunkCrc( p + IHDR_POS, 13 );
+
+   strm->next_in  = &ctx.m_filtered.front();
+   strm->avail_in = (uInt)SIZE;
+   size_t used = DATA_POS;
+   while ( true )
+   {
+      strm->next_out  = &out.front() + used;
+      strm->avail_out = (uInt)( out.size() - used - 16 );
+      int status = deflate( strm, Z_FINISH );
+      used = out.size() - 16 - strm->avail_out;
+      if ( status == Z_STREAM_END )
+      {
          break;
       }
-      case PNG_COLOR_TYPE_RGB:
+      if ( ( status != Z_OK ) && ( status != Z_BUF_ERROR ) )
       {
-         if(bitDepth == 8)
-         {
-            std::vector<ossim_uint8> buf(w*h*3);
-            std::vector<ossim_uint8*> rows(h);
-            in->unloadTile(&buf.front(), in->getImageRectangle(), in->getImageRectangle(), OSSIM_BIP);
-            ossim_uint8* bufPtr = &buf.front();
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*3)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
-         else
-         {
-            std::vector<ossim_uint16> buf(w*h*3);
-            std::vector<ossim_uint8*> rows(h);
-            ossim_uint16* bufPtr = &buf.front();
-            in->unloadTile(&buf.front(), in->getImageRectangle(), in->getImageRectangle(),OSSIM_BIP);
-            for(ossim_int32 y=0; y<h;++y)
-            {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*3)) ;    		
-            }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
-         break;
+         out.clear();
+         return false;
       }
+      out.resize( out.size() * 2 ); // Should not happen with deflateBound.
+   }
+
+   const ossim_uint32 IDAT_SIZE = (ossim_uint32)( used - DATA_POS );
+   p = &out.front();
+   putUint32( p + IDAT_POS, IDAT_SIZE );
+   memcpy( p + IDAT_POS + 4, "IDAT", 4 );
+   putChunkCrc( p + IDAT_POS, IDAT_SIZE );
+
+   ossim_uint8* iend = p + DATA_POS + IDAT_SIZE + 4;
+   putUint32( iend, 0 );
+   memcpy( iend + 4, "IEND", 4 );
+   putChunkCrc( iend, 0 );
+
+   out.resize( used + 4 + 12 );
+
+   return true;
+}
+
+bool ossimPngCodec::decodeDirect( const std::vector<ossim_uint8>& in,
+                                  ossimRefPtr<ossimImageData>& out ) const
+{
+   const ossim_uint8* p = &in.front();
+   const size_t SIZE    = in.size();
+
+   // Signature plus IHDR.
+   if ( ( SIZE < 33 ) || ( png_sig_cmp( p, 0, 8 ) != 0 ) ||
+        ( getUint32( p + 8 ) != 13 ) || ( memcmp( p + 12, "IHDR", 4 ) != 0 ) )
+   {
+      return false;
+   }
+
+   const ossim_uint32 W          = getUint32( p + 16 );
+   const ossim_uint32 H          = getUint32( p + 20 );
+   const ossim_uint8  BIT_DEPTH  = p[24];
+   const ossim_uint8  COLOR_TYPE = p[25];
+   if ( !W || !H || ( W > MAX_DIRECT_DIMENSION ) || ( H > MAX_DIRECT_DIMENSION ) ||
+        ( ( BIT_DEPTH != 8 ) && ( BIT_DEPTH != 16 ) ) ||
+        p[26] || p[27] || p[28] ) // compression, filter, interlace
+   {
+      return false;
+   }
+
+   ossim_uint32 channels = 0;
+   switch ( COLOR_TYPE )
+   {
+      case PNG_COLOR_TYPE_GRAY:
+         channels = 1;
+         break;
+      case PNG_COLOR_TYPE_GRAY_ALPHA:
+         channels = 2;
+         break;
+      case PNG_COLOR_TYPE_RGB:
+         channels = 3;
+         break;
       case PNG_COLOR_TYPE_RGB_ALPHA:
+         channels = 4;
+         break;
+      default:
+         return false; // Palette.
+   }
+
+   // W and H come from the file; do the sizes in size_t and check them.
+   const size_t BPP       = channels * ( BIT_DEPTH / 8 );
+   const size_t ROW_BYTES = size_t(W) * BPP;
+   const size_t STRIDE    = ROW_BYTES + 1;
+   if ( ( ROW_BYTES / BPP != W ) || ( STRIDE > SIZE_MAX / H ) )
+   {
+      return false;
+   }
+
+   Context& ctx = getContext();
+   z_stream* strm = ctx.getInflate();
+   if ( !strm )
+   {
+      return false;
+   }
+
+   ctx.m_filtered.resize( STRIDE * H );
+   strm->next_out  = &ctx.m_filtered.front();
+   strm->avail_out = (uInt)ctx.m_filtered.size();
+
+   //---
+   // Inflate the IDAT chunks straight out of the input.  Chunk crcs are not
+   // checked; the zlib adler-32 covers the image data.
+   //---
+   bool done = false;
+   size_t pos = 33;
+   while ( !done && ( pos + 12 <= SIZE ) )
+   {
+      const ossim_uint32 LENGTH = getUint32( p + pos );
+      const ossim_uint8* type   = p + pos + 4;
+      if ( LENGTH > SIZE - pos - 12 )
+      {
+         return false;
+      }
+
+      if ( memcmp( type, "IDAT", 4 ) == 0 )
       {
-         if(bitDepth == 8)
+         strm->next_in  = (Bytef*)( p + pos + 8 );
+         strm->avail_in = LENGTH;
+         while ( strm->avail_in && !done )
          {
-            std::vector<ossim_uint8> buf(w*h*4);
-            std::vector<ossim_uint8*> rows(h);
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            ossim_uint8* bufPtr = &buf.front();
-            for(int y=0; y<h;++y)
+            int status = inflate( strm, Z_NO_FLUSH );
+            if ( status == Z_STREAM_END )
             {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*4)) ;    		
+               done = true;
             }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
-         }
-         else
-         {
-            std::vector<ossim_uint16> buf(w*h*4);
-            std::vector<ossim_uint8*> rows(h);
-            in->unloadTileToBipAlpha(&buf.front(), in->getImageRectangle(), in->getImageRectangle());
-            ossim_uint16* bufPtr = &buf.front();
-            for(ossim_int32 y=0; y<h;++y)
+            else if ( status != Z_OK )
             {
-               rows[y] = (ossim_uint8*)(bufPtr + y * (w*4)) ;    		
+               return false;
             }
-            png_set_rows(p, info_ptr, &rows[0]);
-            png_set_write_fn(p, &out, PngWriteCallback, NULL);
-            png_write_png(p, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
          }
+      }
+      else if ( memcmp( type, "tRNS", 4 ) == 0 )
+      {
+         return false; // libpng expands this to alpha.
+      }
+      else if ( memcmp( type, "IEND", 4 ) == 0 )
+      {
          break;
       }
+
+      pos += LENGTH + 12;
    }
 
-   return true;
+   if ( !done || strm->avail_out )
+   {
+      return false;
+   }
+
+   // Unfilter into the band interleaved buffer.
+   ctx.m_bip.resize( ROW_BYTES * H );
+   ctx.m_zeros.assign( ROW_BYTES, 0 );
+   for ( size_t y = 0; y < H; ++y )
+   {
+      const ossim_uint8* src = &ctx.m_filtered[ y * STRIDE ];
+      ossim_uint8* row = &ctx.m_bip[ y * ROW_BYTES ];
+      memcpy( row, src + 1, ROW_BYTES );
+      const ossim_uint8* prior = y ? row - ROW_BYTES : &ctx.m_zeros.front();
+      if ( !unfilterRow( src[0], row, prior,
+                         (ossim_uint32)ROW_BYTES, (ossim_uint32)BPP ) )
+      {
+         return false;
+      }
+   }
+
+   return loadDecodedTile( &ctx.m_bip.front(), W, H, channels,
+                           ( BIT_DEPTH == 8 ) ? OSSIM_UINT8 : OSSIM_UINT16, out );
 }
 
 // #include <fstream>
@@ -265,6 +851,12 @@ bool ossimPngCodec::decode(const std::vector<ossim_uint8>& in,
       }
 #endif
 
+      // Plain pngs, which include everything encode writes.
+      if ( decodeDirect( in, out ) )
+      {
+         return true;
+      }
+
       png_structp  png_ptr = 0;
       png_infop   info_ptr = 0;
 
@@ -275,12 +867,12 @@ bool ossimPngCodec::decode(const std::vector<ossim_uint8>& in,
 
       // Setup Exception handling
       setjmp (png_jmpbuf(png_ptr));
-      
+
       const ossim_uint8* inputPointer = &in.front();//&pngData_arg[0];
       png_set_read_fn (png_ptr, reinterpret_cast<void*> (&inputPointer), user_read_data);
-      
+
       png_read_info (png_ptr, info_ptr);
-      
+
       ossim_uint32 width           = png_get_image_width(png_ptr,info_ptr);
       ossim_uint32 height          = png_get_image_height(png_ptr,info_ptr);
       ossim_uint8  bit_depth       = png_get_bit_depth(png_ptr,info_ptr);
@@ -293,17 +885,17 @@ bool ossimPngCodec::decode(const std::vector<ossim_uint8>& in,
       {
          png_set_palette_to_rgb(png_ptr);
       }
-      
+
       if(color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
       {
          png_set_expand_gray_1_2_4_to_8(png_ptr);
       }
-      
+
       if(png_get_valid(png_ptr, info_ptr,PNG_INFO_tRNS))
       {
          png_set_tRNS_to_alpha(png_ptr);
       }
-      
+
       if(bit_depth < 8)
       {
          png_set_packing(png_ptr);
@@ -314,14 +906,9 @@ bool ossimPngCodec::decode(const std::vector<ossim_uint8>& in,
 
       // Update the input/output bands after any tranformations...
       ossim_uint32 input_bands = png_get_channels(png_ptr, info_ptr);
-      ossim_uint32 output_bands = input_bands;
-      if( (output_bands == 2) || (output_bands==4) )
-      {
-         output_bands = output_bands - 1;
-      }
-      
+
       ossim_uint32 bytes = height*width*input_bands*bytes_per_pixel;
-      
+
 #if 0 /* Please leave for debug. drb */
       ossim_uint8  filter_method    = png_get_filter_type(png_ptr,info_ptr);
       ossim_uint8  compression_type = png_get_compression_type(png_ptr,info_ptr);
@@ -335,129 +922,23 @@ bool ossimPngCodec::decode(const std::vector<ossim_uint8>& in,
            << "\ninterlace_type:   " << (int)interlace_type
            << "\nchannels:         " << (int)channels
            << "\ninput_bands:      " << input_bands
-           << "\noutput_bands:     " << output_bands
            << "\nbytes_per_pixel:  " << bytes_per_pixel
            << "\nbytes:            " << bytes
            << "\n";
 #endif
-      std::vector<ossim_uint8> data(bytes);
-      std::vector<ossim_uint8*> rowPointers(height);
-      ossim_uint8* dataPtr = &data.front();
+      Context& ctx = getContext();
+      ctx.m_bip.resize(bytes);
+      ctx.m_rows.resize(height);
+      ossim_uint8* dataPtr = &ctx.m_bip.front();
       for (ossim_uint32 y = 0; y < height; ++y)
       {
-         rowPointers[y] = reinterpret_cast<ossim_uint8*>
+         ctx.m_rows[y] = reinterpret_cast<ossim_uint8*>
             (dataPtr + ( y*(width*bytes_per_pixel*input_bands)));
       }
 
-      png_read_image (png_ptr, &rowPointers.front());
-   
-      // now allocate the ossimImageData object if not already allocated
-      if(!out.valid())
-      {
-         out = new ossimImageData(0, scalar_type, output_bands, width, height);
-         out->initialize();
-      }
-      else
-      {
-         out->setNumberOfDataComponents(output_bands);
-         out->setImageRectangleAndBands(ossimIrect(0,0,width-1,height-1), output_bands);
-         out->initialize();
-      }
-
-      if(input_bands == 1)
-      {
-         // ossim_uint32 idx = 0;
-         memcpy(out->getBuf(0), dataPtr, bytes);
-         out->validate();
-         // once we support alpha channel properly we will need to add alpha settings here
-
-      }
-      else if(input_bands == 2)
-      {
-         //std::cout << "DECODING 2 channels\n";
-         ossim_uint32 size = width*height;
-         ossim_uint32 idx = 0;
-         if(scalar_type == OSSIM_UINT16)
-         {
-            ossim_uint16* tempDataPtr = reinterpret_cast<ossim_uint16*> (dataPtr);
-            ossim_uint16* buf = static_cast<ossim_uint16*>(out->getBuf(0));
-
-            for(idx = 0; idx < size;++idx)
-            {
-               *buf = tempDataPtr[0];
-
-               tempDataPtr+=2;++buf;
-            }
-            out->validate();
-         }
-         else if(scalar_type == OSSIM_UINT8)
-         {
-            ossim_uint8* tempDataPtr = dataPtr;
-            ossim_uint8* buf = static_cast<ossim_uint8*>(out->getBuf(0));
-
-            for(idx = 0; idx < size;++idx)
-            {
-               *buf = *tempDataPtr;
-
-               tempDataPtr+=2;++buf;
-            }
-            out->validate();
-         }
-         else
-         {
-            result = false;
-         }
-      }
-      else if(input_bands == 4)
-      {
-         // cout << "scalarType: " << scalarType << endl;
-      
-         //std::cout << "DECODING 4 channels\n";
-         ossim_uint32 size = width*height;
-         ossim_uint32 idx = 0;
-         if(scalar_type == OSSIM_UINT16)
-         {
-            ossim_uint16* tempDataPtr = reinterpret_cast<ossim_uint16*> (dataPtr);
-            ossim_uint16* buf1 = static_cast<ossim_uint16*>(out->getBuf(0));
-            ossim_uint16* buf2 = static_cast<ossim_uint16*>(out->getBuf(1));
-            ossim_uint16* buf3 = static_cast<ossim_uint16*>(out->getBuf(2));
-
-            for(idx = 0; idx < size;++idx)
-            {
-               *buf1 = tempDataPtr[0];
-               *buf2 = tempDataPtr[1];
-               *buf3 = tempDataPtr[2];
+      png_read_image (png_ptr, &ctx.m_rows.front());
 
-               tempDataPtr+=4;++buf1;++buf2;++buf3;
-            }
-            out->validate();
-         }
-         else if(scalar_type == OSSIM_UINT8)
-         {
-            ossim_uint8* tempDataPtr = dataPtr;
-            ossim_uint8* buf1 = static_cast<ossim_uint8*>(out->getBuf(0));
-            ossim_uint8* buf2 = static_cast<ossim_uint8*>(out->getBuf(1));
-            ossim_uint8* buf3 = static_cast<ossim_uint8*>(out->getBuf(2));
-
-            for(idx = 0; idx < size;++idx)
-            {
-               *buf1 = tempDataPtr[0];
-               *buf2 = tempDataPtr[1];
-               *buf3 = tempDataPtr[2];
-
-               tempDataPtr+=4;++buf1;++buf2;++buf3;
-            }
-            out->validate();
-         }
-         else
-         {
-            result = false;
-         }
-      }
-      else
-      {
-         out->loadTile(dataPtr, out->getImageRectangle(), OSSIM_BIP);
-      }
+      result = loadDecodedTile( dataPtr, width, height, input_bands, scalar_type, out );
 
       if (info_ptr)
       {
@@ -472,7 +953,7 @@ bool ossimPngCodec::decode(const std::vector<ossim_uint8>& in,
    {
       result = false;
    }
-   
+
    return result;
 }
 
@@ -482,6 +963,27 @@ void ossimPngCodec::setProperty(ossimRefPtr<ossimProperty> property)
    {
       m_addAlphaChannel = property->valueToString().toBool();
    }
+   else if(property->getName() == COMPRESSION_LEVEL_KW)
+   {
+      ossim_int32 level = property->valueToString().toInt32();
+      if ( ( level >= Z_DEFAULT_COMPRESSION ) && ( level <= Z_BEST_COMPRESSION ) )
+      {
+         m_compressionLevel = level;
+      }
+   }
+   else if(property->getName() == FILTER_KW)
+   {
+      ossimString value = property->valueToString();
+      value.downcase();
+      for ( ossim_uint32 i = FILTER_NONE; i <= FILTER_ADAPTIVE; ++i )
+      {
+         if ( value == FILTER_STRINGS[i] )
+         {
+            m_filter = (FilterType)i;
+            break;
+         }
+      }
+   }
    else
    {
       ossimCodecBase::setProperty(property);
@@ -495,6 +997,23 @@ ossimRefPtr<ossimProperty> ossimPngCodec::getProperty(const ossimString& name)co
    if(name == ADD_ALPHA_CHANNEL_KW)
    {
 
+   }
+   else if(name == COMPRESSION_LEVEL_KW)
+   {
+      result = new ossimNumericProperty(name,
+                                        ossimString::toString(m_compressionLevel),
+                                        Z_DEFAULT_COMPRESSION,
+                                        Z_BEST_COMPRESSION);
+   }
+   else if(name == FILTER_KW)
+   {
+      ossimStringProperty* stringProp =
+         new ossimStringProperty(name, FILTER_STRINGS[m_filter], false);
+      for ( ossim_uint32 i = FILTER_NONE; i <= FILTER_ADAPTIVE; ++i )
+      {
+         stringProp->addConstraint(ossimString(FILTER_STRINGS[i]));
+      }
+      result = stringProp;
    }
    else
    {
@@ -507,6 +1026,8 @@ ossimRefPtr<ossimProperty> ossimPngCodec::getProperty(const ossimString& name)co
 void ossimPngCodec::getPropertyNames(std::vector<ossimString>& propertyNames)const
 {
    propertyNames.push_back(ADD_ALPHA_CHANNEL_KW);
+   propertyNames.push_back(COMPRESSION_LEVEL_KW);
+   propertyNames.push_back(FILTER_KW);
 }
 
 bool ossimPngCodec::loadState(const ossimKeywordlist& kwl, const char* prefix)
@@ -518,12 +1039,38 @@ bool ossimPngCodec::loadState(const ossimKeywordlist& kwl, const char* prefix)
       m_addAlphaChannel = addAlphaChannel.toBool();
    }
 
+   ossimString value = kwl.find(prefix, COMPRESSION_LEVEL_KW);
+   if(!value.empty())
+   {
+      ossim_int32 level = value.toInt32();
+      if ( ( level >= Z_DEFAULT_COMPRESSION ) && ( level <= Z_BEST_COMPRESSION ) )
+      {
+         m_compressionLevel = level;
+      }
+   }
+
+   value = kwl.find(prefix, FILTER_KW);
+   if(!value.empty())
+   {
+      value.downcase();
+      for ( ossim_uint32 i = FILTER_NONE; i <= FILTER_ADAPTIVE; ++i )
+      {
+         if ( value == FILTER_STRINGS[i] )
+         {
+            m_filter = (FilterType)i;
+            break;
+         }
+      }
+   }
+
    return ossimCodecBase::loadState(kwl, prefix);
 }
 
 bool ossimPngCodec::saveState(ossimKeywordlist& kwl, const char* prefix)const
 {
    kwl.add(prefix, ADD_ALPHA_CHANNEL_KW, m_addAlphaChannel);
+   kwl.add(prefix, COMPRESSION_LEVEL_KW, m_compressionLevel);
+   kwl.add(prefix, FILTER_KW, FILTER_STRINGS[m_filter]);
 
    return ossimCodecBase::saveState(kwl, prefix);
 }
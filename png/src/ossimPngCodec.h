@@ -2,9 +2,34 @@
 #define ossimPngCodec_HEADER 1
 #include <ossim/imaging/ossimCodecBase.h>
 
+/**
+ * @class ossimPngCodec
+ *
+ * Encodes with zlib directly and decodes plain (non-palette, non-interlaced,
+ * 8 or 16 bit, no tRNS) pngs the same way.  Everything else decodes
+ * through libpng.  The z_streams and scratch buffers live in a per thread
+ * context and are reset, not reallocated, between calls.
+ *
+ * Properties:
+ * - "add_alpha_channel" default false.
+ * - "compression_level" zlib level, -1 to 9, default 1.
+ * - "filter" none, sub, up, avg, paeth or adaptive, default adaptive.
+ */
 class ossimPngCodec : public ossimCodecBase
 {
 public:
+
+   /** Row filters.  ADAPTIVE picks one per row. */
+   enum FilterType
+   {
+      FILTER_NONE     = 0,
+      FILTER_SUB      = 1,
+      FILTER_UP       = 2,
+      FILTER_AVG      = 3,
+      FILTER_PAETH    = 4,
+      FILTER_ADAPTIVE = 5
+   };
+
    ossimPngCodec(bool addAlpha=false);
    
    virtual ossimString getCodecType()const;
@@ -25,6 +50,23 @@ public:
    virtual bool encode( const ossimRefPtr<ossimImageData>& in,
                         std::vector<ossim_uint8>& out ) const;
 
+   /**
+    * @brief Encode png method with a level and filter for this call.
+    *
+    * The capacity of "out" is reused so callers encoding in a loop should
+    * keep passing the same vector.
+    *
+    * @param in Input data to encode.
+    * @param out Encoded output data.
+    * @param level zlib compression level, -1 to 9.
+    * @param filter Row filter.
+    * @return true on success, false on failure.
+    */
+   bool encode( const ossimRefPtr<ossimImageData>& in,
+                std::vector<ossim_uint8>& out,
+                ossim_int32 level,
+                FilterType filter ) const;
+
    /**
     * @brief Decode png method.
     *
@@ -87,7 +129,23 @@ public:
 
 
 protected:
-   bool m_addAlphaChannel;
+
+   /** Per thread z_streams and buffers.  Defined in the .cpp. */
+   class Context;
+
+   /** @return The calling thread's context. */
+   static Context& getContext();
+
+   /**
+    * @brief Decodes with zlib if the png is plain enough.
+    * @return true on success, false if libpng is needed.
+    */
+   bool decodeDirect( const std::vector<ossim_uint8>& in,
+                      ossimRefPtr<ossimImageData>& out ) const;
+
+   bool        m_addAlphaChannel;
+   ossim_int32 m_compressionLevel;
+   FilterType  m_filter;
    std::string m_ext;
 };
 
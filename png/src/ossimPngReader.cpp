@@ -13,6 +13,7 @@
 
 
 #include "ossimPngReader.h"
+#include "ossimPngRowKernels.h"
 #include <ossim/base/ossimBooleanProperty.h>
 #include <ossim/base/ossimConstants.h>
 #include <ossim/base/ossimEndian.h>
@@ -21,6 +22,7 @@
 #include <ossim/base/ossimIrect.h>
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimNotifyContext.h>
+#include <ossim/base/ossimNumericProperty.h>
 #include <ossim/base/ossimProperty.h>
 #include <ossim/base/ossimStreamFactoryRegistry.h>
 #include <ossim/base/ossimTrace.h>
@@ -28,15 +30,23 @@
 
 #include <zlib.h>
 
+#include <algorithm>
 #include <cstddef> /* for NULL */
 #include <cmath>   /* for pow */
+#include <cstdlib> /* for abs */
+#include <cstring> /* for memcpy */
 #include <fstream>
+#include <limits>
 
 using namespace std;
 
 // If true alpha channel is passed as a layer.
 static const std::string USE_ALPHA_KW = "use_alpha"; // boolean
 
+// Rows between random access checkpoints.
+static const std::string CHECKPOINT_INTERVAL_KW = "checkpoint_interval"; // unsigned
+static const ossim_uint32 DEFAULT_CHECKPOINT_INTERVAL = 512;
+
 RTTI_DEF1(ossimPngReader, "ossimPngReader", ossimImageHandler)
 
 #ifdef OSSIM_ID_ENABLED
@@ -45,6 +55,390 @@ RTTI_DEF1(ossimPngReader, "ossimPngReader", ossimImageHandler)
    
 static ossimTrace traceDebug("ossimPngReader:degug");  
 
+//---
+// Random access row decoder.
+//
+// Inflates the concatenated IDAT data and unfilters rows itself.  Before
+// every "interval" rows, a copy of the inflate state (which holds the
+// 32k window), the compressed offset of the next unread byte, and the
+// prior unfiltered row are saved.  A seek restores the nearest checkpoint
+// at or before the requested row, so backing up costs at most "interval"
+// rows instead of a decode from row 0.
+//---
+class ossimPngReader::RowDecoder
+{
+public:
+   RowDecoder( ossim::istream* str,
+               ossim_uint32 rowBytes,
+               ossim_uint32 bytesPerPixel,
+               ossim_uint32 interval );
+   ~RowDecoder();
+
+   /**
+    * @brief Indexes the IDAT chunks and starts inflate at row 0.
+    * @return true on success, false on error.
+    */
+   bool init();
+
+   /**
+    * @brief Decodes the next row into buf (rowBytes long).
+    * @return true on success, false on error.
+    */
+   bool readRow( ossim_uint8* buf );
+
+   /**
+    * @brief Restores the nearest checkpoint for row if it is behind the
+    * current row or ahead of it.
+    * @return Row the next readRow will return.
+    */
+   ossim_uint32 seek( ossim_uint32 row );
+
+private:
+   struct Chunk
+   {
+      std::streamoff m_offset; // File offset of the chunk data.
+      ossim_uint64   m_start;  // Offset in the concatenated IDAT data.
+      ossim_uint32   m_length;
+   };
+
+   struct Checkpoint
+   {
+      z_stream                 m_strm;
+      ossim_uint64             m_nextIn;
+      std::vector<ossim_uint8> m_prior;
+   };
+
+   bool fillInput();
+   void addCheckpoint();
+   bool restore( ossim_uint32 index );
+   bool unfilter();
+
+   ossim::istream*          m_str;
+   ossim_uint32             m_rowBytes;
+   ossim_uint32             m_bpp;
+   ossim_uint32             m_interval;
+   ossim_uint32             m_row;
+   bool                     m_inflateInit;
+   z_stream                 m_strm;
+   ossim_uint64             m_nextIn;   // Next compressed byte to read.
+   ossim_uint64             m_idatSize;
+   std::vector<Chunk>       m_chunks;
+   std::vector<Checkpoint*> m_checkpoints;
+   std::vector<ossim_uint8> m_inBuf;
+   std::vector<ossim_uint8> m_raw;      // Filter byte plus row.
+   std::vector<ossim_uint8> m_prior;    // Previous unfiltered row.
+};
+
+ossimPngReader::RowDecoder::RowDecoder( ossim::istream* str,
+                                        ossim_uint32 rowBytes,
+                                        ossim_uint32 bytesPerPixel,
+                                        ossim_uint32 interval )
+   :
+   m_str(str),
+   m_rowBytes(rowBytes),
+   m_bpp(bytesPerPixel),
+   m_interval(interval),
+   m_row(0),
+   m_inflateInit(false),
+   m_strm(),
+   m_nextIn(0),
+   m_idatSize(0),
+   m_chunks(),
+   m_checkpoints(),
+   m_inBuf(65536),
+   m_raw(rowBytes+1),
+   m_prior(rowBytes, 0)
+{
+}
+
+ossimPngReader::RowDecoder::~RowDecoder()
+{
+   for ( ossim_uint32 i = 0; i < m_checkpoints.size(); ++i )
+   {
+      inflateEnd( &(m_checkpoints[i]->m_strm) );
+      delete m_checkpoints[i];
+   }
+   m_checkpoints.clear();
+
+   if ( m_inflateInit )
+   {
+      inflateEnd( &m_strm );
+   }
+}
+
+bool ossimPngReader::RowDecoder::init()
+{
+   if ( !m_str || !m_rowBytes || !m_bpp || !m_interval )
+   {
+      return false;
+   }
+
+   // Walk the chunks after the 8 byte signature.
+   m_str->clear();
+   std::streamoff pos = 8;
+   while ( true )
+   {
+      ossim_uint8 hdr[8];
+      m_str->seekg( pos, std::ios_base::beg );
+      m_str->read( (char*)hdr, 8 );
+      if ( m_str->gcount() != 8 )
+      {
+         break;
+      }
+
+      // Big endian length then type.
+      ossim_uint32 length = ( (ossim_uint32)hdr[0] << 24 ) | ( (ossim_uint32)hdr[1] << 16 ) |
+                            ( (ossim_uint32)hdr[2] << 8 )  |   (ossim_uint32)hdr[3];
+      if ( memcmp( hdr+4, "IDAT", 4 ) == 0 )
+      {
+         Chunk chunk;
+         chunk.m_offset = pos + 8;
+         chunk.m_start  = m_idatSize;
+         chunk.m_length = length;
+         m_chunks.push_back( chunk );
+         m_idatSize += length;
+      }
+      else if ( memcmp( hdr+4, "IEND", 4 ) == 0 )
+      {
+         break;
+      }
+
+      pos += (std::streamoff)length + 12; // header + data + crc
+   }
+   m_str->clear();
+
+   if ( m_chunks.empty() )
+   {
+      return false;
+   }
+
+   memset( &m_strm, 0, sizeof(z_stream) );
+   if ( inflateInit( &m_strm ) != Z_OK )
+   {
+      return false;
+   }
+   m_inflateInit = true;
+
+   return true;
+}
+
+bool ossimPngReader::RowDecoder::fillInput()
+{
+   if ( m_nextIn >= m_idatSize )
+   {
+      return false;
+   }
+
+   // Find the chunk holding m_nextIn.
+   ossim_uint32 i = 0;
+   ossim_uint32 n = (ossim_uint32)m_chunks.size();
+   while ( n > 1 )
+   {
+      ossim_uint32 half = n / 2;
+      if ( m_chunks[i+half].m_start <= m_nextIn )
+      {
+         i += half;
+         n -= half;
+      }
+      else
+      {
+         n = half;
+      }
+   }
+
+   const Chunk& chunk = m_chunks[i];
+   ossim_uint64 skip = m_nextIn - chunk.m_start;
+   ossim_uint64 size = std::min<ossim_uint64>( chunk.m_length - skip, m_inBuf.size() );
+
+   m_str->clear();
+   m_str->seekg( chunk.m_offset + (std::streamoff)skip, std::ios_base::beg );
+   m_str->read( (char*)&m_inBuf.front(), (std::streamsize)size );
+   if ( (ossim_uint64)m_str->gcount() != size )
+   {
+      m_str->clear();
+      return false;
+   }
+
+   m_strm.next_in  = &m_inBuf.front();
+   m_strm.avail_in = (uInt)size;
+   m_nextIn += size;
+
+   return true;
+}
+
+bool ossimPngReader::RowDecoder::readRow( ossim_uint8* buf )
+{
+   if ( !m_inflateInit )
+   {
+      return false;
+   }
+
+   if ( ( m_row % m_interval == 0 ) &&
+        ( m_row / m_interval == m_checkpoints.size() ) )
+   {
+      addCheckpoint();
+   }
+
+   m_strm.next_out  = &m_raw.front();
+   m_strm.avail_out = (uInt)m_raw.size();
+   while ( m_strm.avail_out )
+   {
+      if ( !m_strm.avail_in && !fillInput() )
+      {
+         return false;
+      }
+      int status = inflate( &m_strm, Z_NO_FLUSH );
+      if ( status == Z_STREAM_END )
+      {
+         if ( m_strm.avail_out )
+         {
+            return false; // Short image data.
+         }
+      }
+      else if ( ( status != Z_OK ) && ( status != Z_BUF_ERROR ) )
+      {
+         return false;
+      }
+   }
+
+   if ( !unfilter() )
+   {
+      return false;
+   }
+   memcpy( buf, &m_prior.front(), m_rowBytes );
+   ++m_row;
+
+   return true;
+}
+
+ossim_uint32 ossimPngReader::RowDecoder::seek( ossim_uint32 row )
+{
+   if ( m_inflateInit && m_checkpoints.size() )
+   {
+      ossim_uint32 index = std::min<ossim_uint32>( row / m_interval,
+                                                   (ossim_uint32)m_checkpoints.size() - 1 );
+      if ( ( row < m_row ) || ( index * m_interval > m_row ) )
+      {
+         restore( index );
+      }
+   }
+   return m_row;
+}
+
+void ossimPngReader::RowDecoder::addCheckpoint()
+{
+   Checkpoint* cp = new Checkpoint();
+   memset( &(cp->m_strm), 0, sizeof(z_stream) );
+   if ( inflateCopy( &(cp->m_strm), &m_strm ) == Z_OK )
+   {
+      // Bytes still sitting in the input buffer have not been consumed.
+      cp->m_nextIn = m_nextIn - m_strm.avail_in;
+      cp->m_prior  = m_prior;
+      m_checkpoints.push_back( cp );
+   }
+   else
+   {
+      delete cp;
+   }
+}
+
+bool ossimPngReader::RowDecoder::restore( ossim_uint32 index )
+{
+   Checkpoint* cp = m_checkpoints[index];
+
+   //---
+   // zlib ties the state to the z_stream address so copy straight into
+   // m_strm rather than assigning a copy.
+   //---
+   inflateEnd( &m_strm );
+   memset( &m_strm, 0, sizeof(z_stream) );
+   if ( inflateCopy( &m_strm, &(cp->m_strm) ) != Z_OK )
+   {
+      m_inflateInit = false;
+      return false;
+   }
+
+   m_strm.next_in  = Z_NULL;
+   m_strm.avail_in = 0;
+   m_nextIn = cp->m_nextIn;
+   m_prior  = cp->m_prior;
+   m_row    = index * m_interval;
+
+   return true;
+}
+
+bool ossimPngReader::RowDecoder::unfilter()
+{
+   // Unfilter in place, m_prior is the row above (zeros for row 0).
+   ossim_uint8* cur = &m_raw.front() + 1;
+   const ossim_uint8* up = &m_prior.front();
+   const ossim_uint32 BPP = m_bpp;
+   ossim_uint32 i = 0;
+
+   switch ( m_raw[0] )
+   {
+      case 0: // None
+      {
+         break;
+      }
+      case 1: // Sub
+      {
+         for ( i = BPP; i < m_rowBytes; ++i )
+         {
+            cur[i] = (ossim_uint8)( cur[i] + cur[i-BPP] );
+         }
+         break;
+      }
+      case 2: // Up
+      {
+         for ( ; i < m_rowBytes; ++i )
+         {
+            cur[i] = (ossim_uint8)( cur[i] + up[i] );
+         }
+         break;
+      }
+      case 3: // Average
+      {
+         for ( ; i < BPP; ++i )
+         {
+            cur[i] = (ossim_uint8)( cur[i] + ( up[i] >> 1 ) );
+         }
+         for ( ; i < m_rowBytes; ++i )
+         {
+            cur[i] = (ossim_uint8)( cur[i] + ( ( cur[i-BPP] + up[i] ) >> 1 ) );
+         }
+         break;
+      }
+      case 4: // Paeth
+      {
+         for ( ; i < BPP; ++i )
+         {
+            cur[i] = (ossim_uint8)( cur[i] + up[i] );
+         }
+         for ( ; i < m_rowBytes; ++i )
+         {
+            int a  = cur[i-BPP];
+            int b  = up[i];
+            int c  = up[i-BPP];
+            int pa = std::abs( b - c );
+            int pb = std::abs( a - c );
+            int pc = std::abs( a + b - c - c );
+            int p  = ( ( pa <= pb ) && ( pa <= pc ) ) ? a : ( ( pb <= pc ) ? b : c );
+            cur[i] = (ossim_uint8)( cur[i] + p );
+         }
+         break;
+      }
+      default:
+      {
+         return false; // Bad filter type.
+      }
+   }
+
+   memcpy( &m_prior.front(), cur, m_rowBytes );
+
+   return true;
+}
+
 ossimPngReader::ossimPngReader()
    :
    ossimImageHandler(),
@@ -70,7 +464,9 @@ ossimPngReader::ossimPngReader()
    m_readMode(ossimPngReadUnknown),
    m_maxPixelValue(),
    m_swapFlag(false),
-   m_useAlphaChannelFlag(false)
+   m_useAlphaChannelFlag(false),
+   m_rowDecoder(0),
+   m_checkpointInterval(DEFAULT_CHECKPOINT_INTERVAL)
 {
    if (traceDebug())
    {
@@ -112,6 +508,12 @@ void ossimPngReader::destroy()
       m_lineBuffer = 0;
    }
 
+   if (m_rowDecoder)
+   {
+      delete m_rowDecoder;
+      m_rowDecoder = 0;
+   }
+
    if (m_pngReadPtr)
    {
       png_destroy_read_struct(&m_pngReadPtr, &m_pngReadInfoPtr, NULL);
@@ -151,6 +553,8 @@ void ossimPngReader::allocate()
    }
    m_lineBuffer = new ossim_uint8[m_lineBufferSizeInBytes];
 
+   initRowDecoder();
+
    if (traceDebug())
    {
       ossimNotify(ossimNotifyLevel_DEBUG)
@@ -162,6 +566,7 @@ void ossimPngReader::allocate()
          << "\nimage height:              " << m_imageRect.height()
          << "\nnumber of bands:           " << m_numberOfOutputBands
          << "\nline buffer size:          " << m_lineBufferSizeInBytes
+         << "\nrandom access:             " << (m_rowDecoder?"true":"false")
          << endl;
    }
 }
@@ -309,7 +714,12 @@ void ossimPngReader::fillTile(const ossimIrect& clip_rect,
             m_cacheTile->makeBlank();
          }
 
-         if (startLine < m_currentRow)
+         if ( m_rowDecoder )
+         {
+            // Resume from the nearest checkpoint if backing up or skipping.
+            m_currentRow = m_rowDecoder->seek(startLine);
+         }
+         else if (startLine < m_currentRow)
          {
             // Must restart the compression process again.
             restart();
@@ -318,8 +728,7 @@ void ossimPngReader::fillTile(const ossimIrect& clip_rect,
          // Gobble any not needed lines.
          while(m_currentRow < startLine)
          {
-            png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
-            ++m_currentRow;
+            readPngRow();
          }
             
          switch (m_readMode)
@@ -399,6 +808,8 @@ bool ossimPngReader::saveState(ossimKeywordlist& kwl,
    std::string p = ( prefix ? prefix : "" );
    std::string v = ossimString::toString(m_useAlphaChannelFlag).string();
    kwl.addPair( p, USE_ALPHA_KW, v, true );
+   v = ossimString::toString(m_checkpointInterval).string();
+   kwl.addPair( p, CHECKPOINT_INTERVAL_KW, v, true );
    return ossimImageHandler::saveState(kwl, prefix);
 }
 
@@ -418,6 +829,11 @@ bool ossimPngReader::loadState(const ossimKeywordlist& kwl,
          ossimString s = value;
          m_useAlphaChannelFlag = s.toBool();
       }
+      value = kwl.findKey( ossimString(prefix).c_str(), CHECKPOINT_INTERVAL_KW );
+      if ( value.size() )
+      {
+         m_checkpointInterval = ossimString(value).toUInt32();
+      }
       result = open();
   }
    return result;
@@ -433,6 +849,12 @@ void ossimPngReader::setProperty(ossimRefPtr<ossimProperty> property)
          property->valueToString(s);
          m_useAlphaChannelFlag = s.toBool();
       }
+      else if ( property->getName().string() == CHECKPOINT_INTERVAL_KW )
+      {
+         ossimString s;
+         property->valueToString(s);
+         m_checkpointInterval = s.toUInt32();
+      }
       else
       {
          ossimImageHandler::setProperty(property);
@@ -447,6 +869,10 @@ ossimRefPtr<ossimProperty> ossimPngReader::getProperty(const ossimString& name)c
    {
       prop = new ossimBooleanProperty(name, m_useAlphaChannelFlag);
    }
+   else if ( name.string() == CHECKPOINT_INTERVAL_KW )
+   {
+      prop = new ossimNumericProperty(name, ossimString::toString(m_checkpointInterval));
+   }
    else
    {
       prop = ossimImageHandler::getProperty(name);
@@ -457,6 +883,7 @@ ossimRefPtr<ossimProperty> ossimPngReader::getProperty(const ossimString& name)c
 void ossimPngReader::getPropertyNames(std::vector<ossimString>& propertyNames)const
 {
    propertyNames.push_back( ossimString(USE_ALPHA_KW) );
+   propertyNames.push_back( ossimString(CHECKPOINT_INTERVAL_KW) );
    ossimImageHandler::getPropertyNames(propertyNames);
 }
 
@@ -767,6 +1194,65 @@ void ossimPngReader::restart()
    }
 }
 
+void ossimPngReader::initRowDecoder()
+{
+   if (m_rowDecoder)
+   {
+      delete m_rowDecoder;
+      m_rowDecoder = 0;
+   }
+
+   if ( m_str && m_checkpointInterval && (m_interlacePasses == 1) &&
+        ( (m_bitDepth == 8) || (m_bitDepth == 16) ) &&
+        (m_pngColorType != PNG_COLOR_TYPE_PALETTE) &&
+        !png_get_valid(m_pngReadPtr, m_pngReadInfoPtr, PNG_INFO_tRNS) )
+   {
+      //---
+      // Rows are read from the reader's own position in the stream.  libpng
+      // has only read the header at this point and is not used again.
+      //---
+      m_rowDecoder = new RowDecoder( m_str.get(),
+                                     m_lineBufferSizeInBytes,
+                                     m_numberOfInputBands*m_bytesPerPixelPerBand,
+                                     m_checkpointInterval );
+      if ( m_rowDecoder->init() )
+      {
+         if (traceDebug())
+         {
+            ossimNotify(ossimNotifyLevel_DEBUG)
+               << "ossimPngReader::initRowDecoder DEBUG:"
+               << "\nRandom access on, checkpoint interval: "
+               << m_checkpointInterval << std::endl;
+         }
+      }
+      else
+      {
+         delete m_rowDecoder;
+         m_rowDecoder = 0;
+      }
+   }
+}
+
+void ossimPngReader::readPngRow()
+{
+   if ( m_rowDecoder )
+   {
+      if ( !m_rowDecoder->readRow(m_lineBuffer) )
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "ossimPngReader::readPngRow WARNING:\n"
+            << "Error reading row " << m_currentRow << ".  File corrupted?  "
+            << theImageFile << std::endl;
+         memset(m_lineBuffer, 0, m_lineBufferSizeInBytes);
+      }
+   }
+   else
+   {
+      png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
+   }
+   ++m_currentRow;
+}
+
 bool ossimPngReader::checkSignature( std::istream& str )
 {
    bool result = false;
@@ -1151,66 +1637,62 @@ template <class T>  void ossimPngReader::copyLines(
    T /*dummy*/,  ossim_uint32 stopLine)
 {
    const ossim_uint32 SAMPLES = m_imageRect.width();
+   const ossim::PngRowKernels& KERNELS = ossim::getPngRowKernels();
 
    T* src = (T*)m_lineBuffer;
    std::vector<T*> dst(m_numberOfOutputBands);
-
-   ossim_uint32 band = 0;
-   for (band = 0; band < m_numberOfOutputBands; ++band)
-   {
-      dst[band] = (T*) m_cacheTile->getBuf(band);
-   }
    
-   ossim_int32 bufIdx = 0;
+   ossim_uint32 band = 0;
+   ossim_uint32 bufIdx = 0;
    
    while (m_currentRow <= stopLine)
    {
-      // Read a line from the jpeg file.
-      png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
-      ++m_currentRow;
+      // Read a line from the png file.
+      readPngRow();
 
       if(m_swapFlag)
       {
-         ossimEndian endian;
-         endian.swap(src, SAMPLES*m_numberOfInputBands);
+         KERNELS.swap((ossim_uint16*)m_lineBuffer,
+                      SAMPLES*m_numberOfInputBands);
       }
 
       //---
       // Copy the line which is band interleaved by pixel the the band
-      // separate buffers.
+      // separate buffers.  An alpha channel in the input is skipped.
       //---
-      ossim_uint32 index = 0;
-      for (ossim_uint32 sample = 0; sample < SAMPLES; ++sample)
+      for (band = 0; band < m_numberOfOutputBands; ++band)
       {
-         for (band = 0; band < m_numberOfOutputBands; ++band)
-         {
-            dst[band][bufIdx] = src[index];
-            ++index;
-         }
-         ++bufIdx;
+         dst[band] = (T*)m_cacheTile->getBuf(band) + bufIdx;
       }
+      KERNELS.deinterleave(src, m_numberOfInputBands,
+                           &dst.front(), m_numberOfOutputBands, SAMPLES);
+      bufIdx += SAMPLES;
    }
 }
 
 template <class T> void ossimPngReader::copyLinesWithAlpha(
    T, ossim_uint32 stopLine)
 {
-   ossim_float64 denominator;
-   if (m_outputScalarType == OSSIM_UINT8)
-   {
-      denominator = m_maxPixelValue[m_numberOfInputBands-1];
-   }
-   else
-   {
-      denominator = m_maxPixelValue[m_numberOfInputBands-1];
-   }
+   const ossim_float64 DENOMINATOR = m_maxPixelValue[m_numberOfInputBands-1];
 
    const ossim_uint32 SAMPLES = m_imageRect.width();
+   const ossim::PngRowKernels& KERNELS = ossim::getPngRowKernels();
    
    T* src = (T*) m_lineBuffer;
 
-   std::vector<T*> dst(m_numberOfOutputBands);
-   std::vector<T> p(m_numberOfOutputBands);
+   // Output bands followed by the alpha line.
+   std::vector<T*> dst(m_numberOfInputBands);
+   std::vector<T> alphaLine(SAMPLES);
+
+   //---
+   // Rows that are all opaque are left as copied.  Only usable if the
+   // alpha max is a value of T.
+   //---
+   const bool HAVE_OPAQUE =
+      (DENOMINATOR >= 0.0) &&
+      (DENOMINATOR <= static_cast<ossim_float64>(std::numeric_limits<T>::max())) &&
+      (static_cast<ossim_float64>(static_cast<T>(DENOMINATOR)) == DENOMINATOR);
+   const T OPAQUE = HAVE_OPAQUE ? static_cast<T>(DENOMINATOR) : 0;
    
    ossim_float64 alpha;
 
@@ -1219,78 +1701,75 @@ template <class T> void ossimPngReader::copyLinesWithAlpha(
    const ossim_float64 NULL_PIX = m_cacheTile->getNullPix(0);
  
    ossim_uint32 band = 0;
-   for (band = 0; band < m_numberOfOutputBands; ++band)
-   {
-      dst[band] = (T*)m_cacheTile->getBuf(band);
-   }
-
-   ossim_int32 dstIdx = 0;
+   ossim_uint32 dstIdx = 0;
    
    while (m_currentRow <= stopLine)
    {
-      // Read a line from the jpeg file.
-      png_read_row(m_pngReadPtr, m_lineBuffer, NULL);
-      ++m_currentRow;
+      // Read a line from the png file.
+      readPngRow();
 
       if(m_swapFlag)
       {
-         ossimEndian endian;
-         endian.swap(src, SAMPLES*m_numberOfInputBands);
+         KERNELS.swap((ossim_uint16*)m_lineBuffer,
+                      SAMPLES*m_numberOfInputBands);
       }
       
       //---
       // Copy the line which is band interleaved by pixel the the band
-      // separate buffers.
+      // separate buffers and the alpha line.
       //---
-      ossim_uint32 srcIdx = 0;
-      for (ossim_uint32 sample = 0; sample < SAMPLES; ++sample)
+      for (band = 0; band < m_numberOfOutputBands; ++band)
+      {
+         dst[band] = (T*)m_cacheTile->getBuf(band) + dstIdx;
+      }
+      dst[m_numberOfOutputBands] = &alphaLine.front();
+      KERNELS.deinterleave(src, m_numberOfInputBands,
+                           &dst.front(), m_numberOfInputBands, SAMPLES);
+
+      if ( !HAVE_OPAQUE || !KERNELS.allEqual(&alphaLine.front(), SAMPLES, OPAQUE) )
       {
-         // Copy the pixels.
-         for (band = 0; band < m_numberOfOutputBands; ++band)
+         // Burn the alpha into the copied pixels.
+         for (ossim_uint32 sample = 0; sample < SAMPLES; ++sample)
          {
-            p[band] = src[srcIdx++];
-         }
-         
-         // Get the alpha channel.
-         alpha = src[srcIdx++];
-         alpha = alpha / denominator;
+            // Get the alpha channel.
+            alpha = alphaLine[sample];
+            alpha = alpha / DENOMINATOR;
          
-         if (alpha == 1.0)
-         {
-            for (band = 0; band < m_numberOfOutputBands; ++band)
+            if (alpha == 1.0)
             {
-               dst[band][dstIdx] = p[band];
+               continue; // Copied as is.
             }
-         }
-         else if (alpha == 0.0)
-         {
-            for (band = 0; band < m_numberOfOutputBands; ++band)
-            {
-               dst[band][dstIdx] = static_cast<T>(NULL_PIX);
-            }
-         }
-         else
-         {
-            for (band = 0; band < m_numberOfOutputBands; ++band)
+            else if (alpha == 0.0)
             {
-               ossim_float64 f = p[band];
-               f = f * alpha;
-               if (f != NULL_PIX)
+               for (band = 0; band < m_numberOfOutputBands; ++band)
                {
-                  dst[band][dstIdx] =
-                     static_cast<T>( (f>=MIN_PIX) ?
-                                     ( (f<=MAX_PIX) ? f : MAX_PIX ) :
-                                     MIN_PIX );
+                  dst[band][sample] = static_cast<T>(NULL_PIX);
                }
-               else
+            }
+            else
+            {
+               for (band = 0; band < m_numberOfOutputBands; ++band)
                {
-                  dst[band][dstIdx] = static_cast<T>(NULL_PIX);
+                  ossim_float64 f = dst[band][sample];
+                  f = f * alpha;
+                  if (f != NULL_PIX)
+                  {
+                     dst[band][sample] =
+                        static_cast<T>( (f>=MIN_PIX) ?
+                                        ( (f<=MAX_PIX) ? f : MAX_PIX ) :
+                                        MIN_PIX );
+                  }
+                  else
+                  {
+                     dst[band][sample] = static_cast<T>(NULL_PIX);
+                  }
                }
             }
-         }
-         ++dstIdx; // next sample...
             
-      } // End of sample loop.
+         } // End of sample loop.
+      }
+
+      dstIdx += SAMPLES; // next line...
       
    } // End of line loop.
 }
@@ -123,6 +123,9 @@ public:
     * Current property name handled:
     * "scale" One double value representing the scale in meters per pixel. It is
     * assumed the scale is same for x and y direction.
+    *
+    * "checkpoint_interval" Rows between random access checkpoints.  0 turns
+    * random access off.  Takes effect on the first tile request.
     * 
     * @param property to set.
     */
@@ -267,6 +270,21 @@ protected:
     */
    void restart();
 
+   /**
+    * @brief Sets up the random access row decoder if the image allows it.
+    *
+    * Non-interlaced, 8 or 16 bit, non-palette images without a tRNS chunk
+    * decode rows straight to m_lineBuffer with no libpng transforms, so
+    * these are inflated here and checkpointed every m_checkpointInterval
+    * rows.  Everything else stays on the libpng/restart() path.
+    */
+   void initRowDecoder();
+
+   /**
+    * @brief Reads the next row into m_lineBuffer and bumps m_currentRow.
+    */
+   void readPngRow();
+
    /**
     * @note this method assumes that setImageRectangle has been called on
     * theTile.
@@ -317,6 +335,14 @@ protected:
 
    // If true the alpha channel will be passed on as a band.
    bool m_useAlphaChannelFlag;
+
+   /**
+    * Inflates IDAT data directly and keeps zlib checkpoints so a backward
+    * seek resumes from the nearest checkpoint instead of row 0.
+    */
+   class RowDecoder;
+   RowDecoder*  m_rowDecoder;
+   ossim_uint32 m_checkpointInterval;
    
 TYPE_DATA
 };
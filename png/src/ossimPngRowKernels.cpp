@@ -0,0 +1,617 @@
+//----------------------------------------------------------------------------
+//
+// License: MIT
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: Row conversion kernels for the png plugin.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#include "ossimPngRowKernels.h"
+
+#include <cstring> /* for memcpy */
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define OSSIM_PNG_X86 1
+#  include <immintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#  define OSSIM_PNG_NEON 1
+#  include <arm_neon.h>
+#endif
+
+//---
+// gcc and clang only emit SSSE3/AVX2 instructions in functions marked for
+// them.  msvc emits whatever intrinsics are used.  Either way the marked
+// functions are only called after the cpu check below.
+//---
+#if defined(__GNUC__) || defined(__clang__)
+#  define OSSIM_PNG_TARGET(isa) __attribute__((target(isa)))
+#else
+#  define OSSIM_PNG_TARGET(isa)
+#endif
+
+//---
+// Scalar kernels.  These are the loops ossimPngReader used before and
+// finish the tails of the vector kernels.
+//---
+
+template <class T>
+static void deinterleaveTail( const T* src, ossim_uint32 srcBands,
+                              T* const* dst, ossim_uint32 dstBands,
+                              ossim_uint32 start, ossim_uint32 samples )
+{
+   if ( (srcBands == 1) && (dstBands == 1) )
+   {
+      if ( samples > start )
+      {
+         memcpy( dst[0] + start, src + start, (samples - start) * sizeof(T) );
+      }
+      return;
+   }
+
+   src += start * srcBands;
+   for ( ossim_uint32 sample = start; sample < samples; ++sample )
+   {
+      for ( ossim_uint32 band = 0; band < dstBands; ++band )
+      {
+         dst[band][sample] = src[band];
+      }
+      src += srcBands;
+   }
+}
+
+template <class T>
+static void deinterleaveScalar( const T* src, ossim_uint32 srcBands,
+                                T* const* dst, ossim_uint32 dstBands,
+                                ossim_uint32 samples )
+{
+   deinterleaveTail( src, srcBands, dst, dstBands, 0, samples );
+}
+
+static void swap16Tail( ossim_uint16* buf, ossim_uint32 start, ossim_uint32 count )
+{
+   for ( ossim_uint32 i = start; i < count; ++i )
+   {
+      buf[i] = static_cast<ossim_uint16>( (buf[i] >> 8) | (buf[i] << 8) );
+   }
+}
+
+static void swap16Scalar( ossim_uint16* buf, ossim_uint32 count )
+{
+   swap16Tail( buf, 0, count );
+}
+
+template <class T>
+static bool allEqualTail( const T* buf, ossim_uint32 start, ossim_uint32 count, T value )
+{
+   for ( ossim_uint32 i = start; i < count; ++i )
+   {
+      if ( buf[i] != value )
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+template <class T>
+static bool allEqualScalar( const T* buf, ossim_uint32 count, T value )
+{
+   return allEqualTail( buf, 0, count, value );
+}
+
+static const ossim::PngRowKernels SCALAR_KERNELS =
+{
+   "scalar",
+   deinterleaveScalar<ossim_uint8>,
+   deinterleaveScalar<ossim_uint16>,
+   swap16Scalar,
+   allEqualScalar<ossim_uint8>,
+   allEqualScalar<ossim_uint16>
+};
+
+#if defined(OSSIM_PNG_X86)
+
+struct CpuFeatures
+{
+   bool m_sse2;
+   bool m_ssse3;
+   bool m_avx2;
+};
+
+static CpuFeatures getCpuFeatures()
+{
+   CpuFeatures cpu = { false, false, false };
+#if defined(_MSC_VER)
+   int info[4];
+   __cpuid( info, 0 );
+   const int MAX_LEAF = info[0];
+   if ( MAX_LEAF >= 1 )
+   {
+      __cpuid( info, 1 );
+      cpu.m_sse2  = ( info[3] & (1 << 26) ) != 0;
+      cpu.m_ssse3 = ( info[2] & (1 << 9) ) != 0;
+
+      // AVX2 also needs the os to save the ymm registers.
+      const bool OSXSAVE = ( info[2] & (1 << 27) ) != 0;
+      const bool AVX     = ( info[2] & (1 << 28) ) != 0;
+      if ( (MAX_LEAF >= 7) && OSXSAVE && AVX && ( (_xgetbv(0) & 6) == 6 ) )
+      {
+         __cpuidex( info, 7, 0 );
+         cpu.m_avx2 = ( info[1] & (1 << 5) ) != 0;
+      }
+   }
+#else
+   __builtin_cpu_init();
+   cpu.m_sse2  = __builtin_cpu_supports( "sse2" ) != 0;
+   cpu.m_ssse3 = __builtin_cpu_supports( "ssse3" ) != 0;
+   cpu.m_avx2  = __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+   return cpu;
+}
+
+//---
+// Shuffle masks that gather one band from a block of BANDS 16 byte
+// registers holding 16/sizeof(T) interleaved pixels.  mask[band][reg] picks
+// the bytes of "band" that live in register "reg"; 0x80 zeroes the rest so
+// the BANDS shuffles can be or'ed together.
+//---
+template <class T, ossim_uint32 BANDS>
+static void buildGatherMasks( ossim_uint8 mask[BANDS][BANDS][16] )
+{
+   const ossim_uint32 SIZE = sizeof(T);
+   for ( ossim_uint32 band = 0; band < BANDS; ++band )
+   {
+      for ( ossim_uint32 reg = 0; reg < BANDS; ++reg )
+      {
+         for ( ossim_uint32 i = 0; i < 16; ++i )
+         {
+            const ossim_uint32 SRC = ( BANDS * (i / SIZE) + band ) * SIZE + i % SIZE;
+            mask[band][reg][i] =
+               static_cast<ossim_uint8>( (SRC / 16 == reg) ? SRC % 16 : 0x80 );
+         }
+      }
+   }
+}
+
+OSSIM_PNG_TARGET("sse2")
+static void swap16Sse2( ossim_uint16* buf, ossim_uint32 count )
+{
+   ossim_uint32 i = 0;
+   for ( ; i + 8 <= count; i += 8 )
+   {
+      __m128i v = _mm_loadu_si128( (const __m128i*)(buf + i) );
+      v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+      _mm_storeu_si128( (__m128i*)(buf + i), v );
+   }
+   swap16Tail( buf, i, count );
+}
+
+OSSIM_PNG_TARGET("sse2")
+static bool allEqual8Sse2( const ossim_uint8* buf, ossim_uint32 count, ossim_uint8 value )
+{
+   const __m128i VALUE = _mm_set1_epi8( static_cast<char>(value) );
+   ossim_uint32 i = 0;
+   for ( ; i + 16 <= count; i += 16 )
+   {
+      const __m128i V = _mm_loadu_si128( (const __m128i*)(buf + i) );
+      if ( _mm_movemask_epi8( _mm_cmpeq_epi8( V, VALUE ) ) != 0xffff )
+      {
+         return false;
+      }
+   }
+   return allEqualTail( buf, i, count, value );
+}
+
+OSSIM_PNG_TARGET("sse2")
+static bool allEqual16Sse2( const ossim_uint16* buf, ossim_uint32 count, ossim_uint16 value )
+{
+   const __m128i VALUE = _mm_set1_epi16( static_cast<short>(value) );
+   ossim_uint32 i = 0;
+   for ( ; i + 8 <= count; i += 8 )
+   {
+      const __m128i V = _mm_loadu_si128( (const __m128i*)(buf + i) );
+      if ( _mm_movemask_epi8( _mm_cmpeq_epi16( V, VALUE ) ) != 0xffff )
+      {
+         return false;
+      }
+   }
+   return allEqualTail( buf, i, count, value );
+}
+
+/** @return Number of pixels done. */
+template <class T, ossim_uint32 BANDS>
+OSSIM_PNG_TARGET("ssse3")
+static ossim_uint32 gatherSsse3( const T* src, T* const* dst, ossim_uint32 dstBands,
+                                 ossim_uint32 start, ossim_uint32 samples )
+{
+   const ossim_uint32 PIXELS = 16 / sizeof(T);
+
+   ossim_uint8 bytes[BANDS][BANDS][16];
+   buildGatherMasks<T, BANDS>( bytes );
+   __m128i mask[BANDS][BANDS];
+   for ( ossim_uint32 band = 0; band < BANDS; ++band )
+   {
+      for ( ossim_uint32 reg = 0; reg < BANDS; ++reg )
+      {
+         mask[band][reg] = _mm_loadu_si128( (const __m128i*)bytes[band][reg] );
+      }
+   }
+
+   ossim_uint32 sample = start;
+   for ( ; sample + PIXELS <= samples; sample += PIXELS )
+   {
+      const ossim_uint8* s = (const ossim_uint8*)( src + sample * BANDS );
+      __m128i v[BANDS];
+      for ( ossim_uint32 reg = 0; reg < BANDS; ++reg )
+      {
+         v[reg] = _mm_loadu_si128( (const __m128i*)( s + 16 * reg ) );
+      }
+      for ( ossim_uint32 band = 0; band < dstBands; ++band )
+      {
+         __m128i r = _mm_shuffle_epi8( v[0], mask[band][0] );
+         for ( ossim_uint32 reg = 1; reg < BANDS; ++reg )
+         {
+            r = _mm_or_si128( r, _mm_shuffle_epi8( v[reg], mask[band][reg] ) );
+         }
+         _mm_storeu_si128( (__m128i*)( dst[band] + sample ), r );
+      }
+   }
+   return sample;
+}
+
+template <class T>
+OSSIM_PNG_TARGET("ssse3")
+static void deinterleaveSsse3( const T* src, ossim_uint32 srcBands,
+                               T* const* dst, ossim_uint32 dstBands,
+                               ossim_uint32 samples )
+{
+   ossim_uint32 done = 0;
+   if ( dstBands <= srcBands )
+   {
+      switch ( srcBands )
+      {
+         case 2:
+            done = gatherSsse3<T, 2>( src, dst, dstBands, 0, samples );
+            break;
+         case 3:
+            done = gatherSsse3<T, 3>( src, dst, dstBands, 0, samples );
+            break;
+         case 4:
+            done = gatherSsse3<T, 4>( src, dst, dstBands, 0, samples );
+            break;
+         default:
+            break;
+      }
+   }
+   deinterleaveTail( src, srcBands, dst, dstBands, done, samples );
+}
+
+//---
+// AVX2 shuffles only within 128 bit lanes, so each ymm register holds the
+// same register of two consecutive blocks (low lane first block, high lane
+// second).  The gathered band then comes out as two blocks in order.
+//---
+template <class T, ossim_uint32 BANDS>
+OSSIM_PNG_TARGET("avx2")
+static ossim_uint32 gatherAvx2( const T* src, T* const* dst, ossim_uint32 dstBands,
+                                ossim_uint32 samples )
+{
+   const ossim_uint32 PIXELS = 32 / sizeof(T);
+
+   ossim_uint8 bytes[BANDS][BANDS][16];
+   buildGatherMasks<T, BANDS>( bytes );
+   __m256i mask[BANDS][BANDS];
+   for ( ossim_uint32 band = 0; band < BANDS; ++band )
+   {
+      for ( ossim_uint32 reg = 0; reg < BANDS; ++reg )
+      {
+         const __m128i M = _mm_loadu_si128( (const __m128i*)bytes[band][reg] );
+         mask[band][reg] = _mm256_inserti128_si256( _mm256_castsi128_si256( M ), M, 1 );
+      }
+   }
+
+   ossim_uint32 sample = 0;
+   for ( ; sample + PIXELS <= samples; sample += PIXELS )
+   {
+      const ossim_uint8* s = (const ossim_uint8*)( src + sample * BANDS );
+      __m256i v[BANDS];
+      for ( ossim_uint32 reg = 0; reg < BANDS; ++reg )
+      {
+         const __m128i LO = _mm_loadu_si128( (const __m128i*)( s + 16 * reg ) );
+         const __m128i HI = _mm_loadu_si128( (const __m128i*)( s + 16 * (BANDS + reg) ) );
+         v[reg] = _mm256_inserti128_si256( _mm256_castsi128_si256( LO ), HI, 1 );
+      }
+      for ( ossim_uint32 band = 0; band < dstBands; ++band )
+      {
+         __m256i r = _mm256_shuffle_epi8( v[0], mask[band][0] );
+         for ( ossim_uint32 reg = 1; reg < BANDS; ++reg )
+         {
+            r = _mm256_or_si256( r, _mm256_shuffle_epi8( v[reg], mask[band][reg] ) );
+         }
+         _mm256_storeu_si256( (__m256i*)( dst[band] + sample ), r );
+      }
+   }
+
+   // A half block may be left.
+   return gatherSsse3<T, BANDS>( src, dst, dstBands, sample, samples );
+}
+
+template <class T>
+OSSIM_PNG_TARGET("avx2")
+static void deinterleaveAvx2( const T* src, ossim_uint32 srcBands,
+                              T* const* dst, ossim_uint32 dstBands,
+                              ossim_uint32 samples )
+{
+   ossim_uint32 done = 0;
+   if ( dstBands <= srcBands )
+   {
+      switch ( srcBands )
+      {
+         case 2:
+            done = gatherAvx2<T, 2>( src, dst, dstBands, samples );
+            break;
+         case 3:
+            done = gatherAvx2<T, 3>( src, dst, dstBands, samples );
+            break;
+         case 4:
+            done = gatherAvx2<T, 4>( src, dst, dstBands, samples );
+            break;
+         default:
+            break;
+      }
+   }
+   deinterleaveTail( src, srcBands, dst, dstBands, done, samples );
+}
+
+OSSIM_PNG_TARGET("avx2")
+static void swap16Avx2( ossim_uint16* buf, ossim_uint32 count )
+{
+   ossim_uint32 i = 0;
+   for ( ; i + 16 <= count; i += 16 )
+   {
+      __m256i v = _mm256_loadu_si256( (const __m256i*)(buf + i) );
+      v = _mm256_or_si256( _mm256_slli_epi16( v, 8 ), _mm256_srli_epi16( v, 8 ) );
+      _mm256_storeu_si256( (__m256i*)(buf + i), v );
+   }
+   swap16Tail( buf, i, count );
+}
+
+OSSIM_PNG_TARGET("avx2")
+static bool allEqual8Avx2( const ossim_uint8* buf, ossim_uint32 count, ossim_uint8 value )
+{
+   const __m256i VALUE = _mm256_set1_epi8( static_cast<char>(value) );
+   ossim_uint32 i = 0;
+   for ( ; i + 32 <= count; i += 32 )
+   {
+      const __m256i V = _mm256_loadu_si256( (const __m256i*)(buf + i) );
+      if ( _mm256_movemask_epi8( _mm256_cmpeq_epi8( V, VALUE ) ) != -1 )
+      {
+         return false;
+      }
+   }
+   return allEqualTail( buf, i, count, value );
+}
+
+OSSIM_PNG_TARGET("avx2")
+static bool allEqual16Avx2( const ossim_uint16* buf, ossim_uint32 count, ossim_uint16 value )
+{
+   const __m256i VALUE = _mm256_set1_epi16( static_cast<short>(value) );
+   ossim_uint32 i = 0;
+   for ( ; i + 16 <= count; i += 16 )
+   {
+      const __m256i V = _mm256_loadu_si256( (const __m256i*)(buf + i) );
+      if ( _mm256_movemask_epi8( _mm256_cmpeq_epi16( V, VALUE ) ) != -1 )
+      {
+         return false;
+      }
+   }
+   return allEqualTail( buf, i, count, value );
+}
+
+#endif /* #if defined(OSSIM_PNG_X86) */
+
+#if defined(OSSIM_PNG_NEON)
+
+// NEON is part of the aarch64 base so no run time check is needed.
+
+static void deinterleave8Neon( const ossim_uint8* src, ossim_uint32 srcBands,
+                               ossim_uint8* const* dst, ossim_uint32 dstBands,
+                               ossim_uint32 samples )
+{
+   ossim_uint32 sample = 0;
+   if ( dstBands <= srcBands )
+   {
+      switch ( srcBands )
+      {
+         case 2:
+         {
+            for ( ; sample + 16 <= samples; sample += 16 )
+            {
+               const uint8x16x2_t V = vld2q_u8( src + sample * 2 );
+               for ( ossim_uint32 band = 0; band < dstBands; ++band )
+               {
+                  vst1q_u8( dst[band] + sample, V.val[band] );
+               }
+            }
+            break;
+         }
+         case 3:
+         {
+            for ( ; sample + 16 <= samples; sample += 16 )
+            {
+               const uint8x16x3_t V = vld3q_u8( src + sample * 3 );
+               for ( ossim_uint32 band = 0; band < dstBands; ++band )
+               {
+                  vst1q_u8( dst[band] + sample, V.val[band] );
+               }
+            }
+            break;
+         }
+         case 4:
+         {
+            for ( ; sample + 16 <= samples; sample += 16 )
+            {
+               const uint8x16x4_t V = vld4q_u8( src + sample * 4 );
+               for ( ossim_uint32 band = 0; band < dstBands; ++band )
+               {
+                  vst1q_u8( dst[band] + sample, V.val[band] );
+               }
+            }
+            break;
+         }
+         default:
+            break;
+      }
+   }
+   deinterleaveTail( src, srcBands, dst, dstBands, sample, samples );
+}
+
+static void deinterleave16Neon( const ossim_uint16* src, ossim_uint32 srcBands,
+                                ossim_uint16* const* dst, ossim_uint32 dstBands,
+                                ossim_uint32 samples )
+{
+   ossim_uint32 sample = 0;
+   if ( dstBands <= srcBands )
+   {
+      switch ( srcBands )
+      {
+         case 2:
+         {
+            for ( ; sample + 8 <= samples; sample += 8 )
+            {
+               const uint16x8x2_t V = vld2q_u16( src + sample * 2 );
+               for ( ossim_uint32 band = 0; band < dstBands; ++band )
+               {
+                  vst1q_u16( dst[band] + sample, V.val[band] );
+               }
+            }
+            break;
+         }
+         case 3:
+         {
+            for ( ; sample + 8 <= samples; sample += 8 )
+            {
+               const uint16x8x3_t V = vld3q_u16( src + sample * 3 );
+               for ( ossim_uint32 band = 0; band < dstBands; ++band )
+               {
+                  vst1q_u16( dst[band] + sample, V.val[band] );
+               }
+            }
+            break;
+         }
+         case 4:
+         {
+            for ( ; sample + 8 <= samples; sample += 8 )
+            {
+               const uint16x8x4_t V = vld4q_u16( src + sample * 4 );
+               for ( ossim_uint32 band = 0; band < dstBands; ++band )
+               {
+                  vst1q_u16( dst[band] + sample, V.val[band] );
+               }
+            }
+            break;
+         }
+         default:
+            break;
+      }
+   }
+   deinterleaveTail( src, srcBands, dst, dstBands, sample, samples );
+}
+
+static void swap16Neon( ossim_uint16* buf, ossim_uint32 count )
+{
+   ossim_uint32 i = 0;
+   for ( ; i + 8 <= count; i += 8 )
+   {
+      ossim_uint8* p = (ossim_uint8*)( buf + i );
+      vst1q_u8( p, vrev16q_u8( vld1q_u8( p ) ) );
+   }
+   swap16Tail( buf, i, count );
+}
+
+static bool allEqual8Neon( const ossim_uint8* buf, ossim_uint32 count, ossim_uint8 value )
+{
+   const uint8x16_t VALUE = vdupq_n_u8( value );
+   ossim_uint32 i = 0;
+   for ( ; i + 16 <= count; i += 16 )
+   {
+      if ( vminvq_u8( vceqq_u8( vld1q_u8( buf + i ), VALUE ) ) == 0 )
+      {
+         return false;
+      }
+   }
+   return allEqualTail( buf, i, count, value );
+}
+
+static bool allEqual16Neon( const ossim_uint16* buf, ossim_uint32 count, ossim_uint16 value )
+{
+   const uint16x8_t VALUE = vdupq_n_u16( value );
+   ossim_uint32 i = 0;
+   for ( ; i + 8 <= count; i += 8 )
+   {
+      if ( vminvq_u16( vceqq_u16( vld1q_u16( buf + i ), VALUE ) ) == 0 )
+      {
+         return false;
+      }
+   }
+   return allEqualTail( buf, i, count, value );
+}
+
+#endif /* #if defined(OSSIM_PNG_NEON) */
+
+static ossim::PngRowKernels selectPngRowKernels()
+{
+   ossim::PngRowKernels kernels = SCALAR_KERNELS;
+
+#if defined(OSSIM_PNG_X86)
+   const CpuFeatures CPU = getCpuFeatures();
+   if ( CPU.m_sse2 )
+   {
+      kernels.m_name       = "sse2";
+      kernels.m_swap16     = swap16Sse2;
+      kernels.m_allEqual8  = allEqual8Sse2;
+      kernels.m_allEqual16 = allEqual16Sse2;
+   }
+   if ( CPU.m_sse2 && CPU.m_ssse3 )
+   {
+      kernels.m_name           = "ssse3";
+      kernels.m_deinterleave8  = deinterleaveSsse3<ossim_uint8>;
+      kernels.m_deinterleave16 = deinterleaveSsse3<ossim_uint16>;
+   }
+   if ( CPU.m_ssse3 && CPU.m_avx2 )
+   {
+      kernels.m_name           = "avx2";
+      kernels.m_deinterleave8  = deinterleaveAvx2<ossim_uint8>;
+      kernels.m_deinterleave16 = deinterleaveAvx2<ossim_uint16>;
+      kernels.m_swap16         = swap16Avx2;
+      kernels.m_allEqual8      = allEqual8Avx2;
+      kernels.m_allEqual16     = allEqual16Avx2;
+   }
+#elif defined(OSSIM_PNG_NEON)
+   kernels.m_name           = "neon";
+   kernels.m_deinterleave8  = deinterleave8Neon;
+   kernels.m_deinterleave16 = deinterleave16Neon;
+   kernels.m_swap16         = swap16Neon;
+   kernels.m_allEqual8      = allEqual8Neon;
+   kernels.m_allEqual16     = allEqual16Neon;
+#endif
+
+   return kernels;
+}
+
+const ossim::PngRowKernels& ossim::getPngRowKernels()
+{
+   static const ossim::PngRowKernels KERNELS = selectPngRowKernels();
+   return KERNELS;
+}
+
+const ossim::PngRowKernels& ossim::getPngScalarRowKernels()
+{
+   return SCALAR_KERNELS;
+}
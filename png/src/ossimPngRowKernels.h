@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------
+//
+// License: MIT
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: Row conversion kernels for the png plugin.
+//
+// Decoded png rows are band interleaved by pixel while tiles are band
+// separate.  These kernels do the deinterleave, the alpha test and the 16 bit
+// byte swap with SSE2, SSSE3, AVX2 or NEON when the running cpu has them and
+// with plain loops otherwise.  The set is picked once, on first use.
+//
+// This code is namespaced with "ossim".
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#ifndef ossimPngRowKernels_HEADER
+#define ossimPngRowKernels_HEADER 1
+
+#include <ossim/base/ossimConstants.h>
+
+namespace ossim
+{
+   /**
+    * @brief Table of row kernels for one instruction set.
+    */
+   struct PngRowKernels
+   {
+      /**
+       * Copies "samples" pixels of "srcBands" interleaved values to
+       * "dstBands" separate buffers.  dstBands may be less than srcBands in
+       * which case the trailing source bands (alpha) are dropped.
+       */
+      typedef void (*Deinterleave8Fn)( const ossim_uint8* src,
+                                       ossim_uint32 srcBands,
+                                       ossim_uint8* const* dst,
+                                       ossim_uint32 dstBands,
+                                       ossim_uint32 samples );
+      typedef void (*Deinterleave16Fn)( const ossim_uint16* src,
+                                        ossim_uint32 srcBands,
+                                        ossim_uint16* const* dst,
+                                        ossim_uint32 dstBands,
+                                        ossim_uint32 samples );
+
+      /** Swaps the bytes of "count" 16 bit values in place. */
+      typedef void (*Swap16Fn)( ossim_uint16* buf, ossim_uint32 count );
+
+      /** @return true if all "count" values equal "value". */
+      typedef bool (*AllEqual8Fn)( const ossim_uint8* buf,
+                                   ossim_uint32 count,
+                                   ossim_uint8 value );
+      typedef bool (*AllEqual16Fn)( const ossim_uint16* buf,
+                                    ossim_uint32 count,
+                                    ossim_uint16 value );
+
+      void deinterleave( const ossim_uint8* src, ossim_uint32 srcBands,
+                         ossim_uint8* const* dst, ossim_uint32 dstBands,
+                         ossim_uint32 samples ) const
+      {
+         m_deinterleave8( src, srcBands, dst, dstBands, samples );
+      }
+
+      void deinterleave( const ossim_uint16* src, ossim_uint32 srcBands,
+                         ossim_uint16* const* dst, ossim_uint32 dstBands,
+                         ossim_uint32 samples ) const
+      {
+         m_deinterleave16( src, srcBands, dst, dstBands, samples );
+      }
+
+      void swap( ossim_uint16* buf, ossim_uint32 count ) const
+      {
+         m_swap16( buf, count );
+      }
+
+      bool allEqual( const ossim_uint8* buf, ossim_uint32 count,
+                     ossim_uint8 value ) const
+      {
+         return m_allEqual8( buf, count, value );
+      }
+
+      bool allEqual( const ossim_uint16* buf, ossim_uint32 count,
+                     ossim_uint16 value ) const
+      {
+         return m_allEqual16( buf, count, value );
+      }
+
+      /** Instruction set, e.g. "avx2".  Mixed sets list the best one. */
+      const char*      m_name;
+      Deinterleave8Fn  m_deinterleave8;
+      Deinterleave16Fn m_deinterleave16;
+      Swap16Fn         m_swap16;
+      AllEqual8Fn      m_allEqual8;
+      AllEqual16Fn     m_allEqual16;
+   };
+
+   /** @return Fastest kernels the running cpu supports. */
+   const PngRowKernels& getPngRowKernels();
+
+   /** @return Plain c++ kernels.  The reference for tests and benchmarks. */
+   const PngRowKernels& getPngScalarRowKernels();
+}
+
+#endif /* #ifndef ossimPngRowKernels_HEADER */
@@ -25,8 +25,14 @@
 #include <ossim/imaging/ossimImageSource.h>
 #include <ossim/imaging/ossimScalarRemapper.h>
 #include <zlib.h>
+#include <algorithm>
+#include <condition_variable>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
@@ -36,6 +42,7 @@ RTTI_DEF1(ossimPngWriter,
 
 static const char COMPRESSION_LEVEL_KW[] = "compression_level";
 static const char ADD_ALPHA_CHANNEL_KW[] = "add_alpha_channel";
+static const char THREADS_KW[]           = "threads";
 
 //---
 // For trace debugging (to enable at runtime do:
@@ -51,6 +58,502 @@ static ossimTrace traceDebug("ossimPngWriter:debug");
 static const char OSSIM_ID[] = "$Id: ossimPngWriter.cpp 22466 2013-10-24 18:23:51Z dburken $";
 #endif
 
+// Target uncompressed bytes per parallel deflate job.
+static const ossim_uint32 PARALLEL_JOB_BYTES = 512*1024;
+
+// Deflate window size.  Each job is primed with this much prior data.
+static const ossim_uint32 DICTIONARY_BYTES = 32768;
+
+class ossimPngWriter::ParallelDeflater
+{
+public:
+   /**
+    * @param str Stream positioned after the last pre IDAT chunk.
+    * @param rowBytes Bytes in a raw row, no filter byte.
+    * @param bytesPerPixel Bytes in a pixel, for the filters.
+    * @param level zlib compression level.
+    * @param strategy zlib strategy.
+    * @param filterRows If false rows go out with the "none" filter.
+    * @param threads Number of deflate threads.
+    */
+   ParallelDeflater( std::ostream* str,
+                     ossim_uint32 rowBytes,
+                     ossim_uint32 bytesPerPixel,
+                     ossim_int32 level,
+                     ossim_int32 strategy,
+                     bool filterRows,
+                     ossim_uint32 threads );
+
+   /** Stops and joins the threads. */
+   ~ParallelDeflater();
+
+   /** @brief Adds the next raw row. */
+   void addRow( const ossim_uint8* row );
+
+   /**
+    * @brief Deflates the remaining rows, then writes the zlib trailer and
+    * the IEND chunk.
+    * @return true on success, false on error.
+    */
+   bool finish();
+
+private:
+
+   struct Job
+   {
+      std::vector<ossim_uint8> m_raw;         // Context rows then job rows.
+      ossim_uint32             m_contextRows; // Rows from prior jobs.
+      ossim_uint32             m_rows;
+      bool                     m_first;
+      bool                     m_last;
+      std::vector<ossim_uint8> m_out;
+      uLong                    m_adler;
+      uLong                    m_length;
+      bool                     m_done;
+      bool                     m_ok;
+   };
+
+   Job* newJob();
+   void submit( bool last );
+   void work();
+   void deflateJob( Job* job ) const;
+   void filterRow( const ossim_uint8* row,
+                   const ossim_uint8* prior,
+                   ossim_uint8* out,
+                   std::vector<ossim_uint8>& scratch ) const;
+   void writeJob( Job* job );
+   void writeChunk( const char* type,
+                    const ossim_uint8* data,
+                    ossim_uint32 length );
+
+   std::ostream*            m_str;
+   ossim_uint32             m_rowBytes;
+   ossim_uint32             m_bpp;
+   ossim_int32              m_level;
+   ossim_int32              m_strategy;
+   bool                     m_filterRows;
+   ossim_uint32             m_contextRows;
+   ossim_uint32             m_rowsPerJob;
+   ossim_uint32             m_maxJobs;
+   Job*                     m_current;
+   bool                     m_firstJob;
+   uLong                    m_adler;
+   bool                     m_ok;
+
+   std::deque<Job*>         m_pending;  // Waiting for a thread.
+   std::deque<Job*>         m_inFlight; // Submitted, in output order.
+   std::mutex               m_mutex;
+   std::condition_variable  m_workCond;
+   std::condition_variable  m_doneCond;
+   bool                     m_stop;
+   std::vector<std::thread> m_threads;
+};
+
+ossimPngWriter::ParallelDeflater::ParallelDeflater( std::ostream* str,
+                                                    ossim_uint32 rowBytes,
+                                                    ossim_uint32 bytesPerPixel,
+                                                    ossim_int32 level,
+                                                    ossim_int32 strategy,
+                                                    bool filterRows,
+                                                    ossim_uint32 threads )
+   : m_str( str ),
+     m_rowBytes( rowBytes ),
+     m_bpp( bytesPerPixel ),
+     m_level( level ),
+     m_strategy( strategy ),
+     m_filterRows( filterRows ),
+     m_contextRows( ( DICTIONARY_BYTES + rowBytes ) / ( rowBytes + 1 ) + 1 ),
+     m_rowsPerJob( std::max<ossim_uint32>( 1, PARALLEL_JOB_BYTES / ( rowBytes + 1 ) ) ),
+     m_maxJobs( threads * 2 ),
+     m_current( 0 ),
+     m_firstJob( true ),
+     m_adler( adler32( 0L, Z_NULL, 0 ) ),
+     m_ok( true ),
+     m_pending(),
+     m_inFlight(),
+     m_mutex(),
+     m_workCond(),
+     m_doneCond(),
+     m_stop( false ),
+     m_threads()
+{
+   m_current = newJob();
+
+   for ( ossim_uint32 i = 0; i < threads; ++i )
+   {
+      m_threads.push_back( std::thread( &ParallelDeflater::work, this ) );
+   }
+}
+
+ossimPngWriter::ParallelDeflater::~ParallelDeflater()
+{
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_stop = true;
+   }
+   m_workCond.notify_all();
+
+   for ( ossim_uint32 i = 0; i < m_threads.size(); ++i )
+   {
+      m_threads[i].join();
+   }
+
+   while ( m_inFlight.size() )
+   {
+      delete m_inFlight.front();
+      m_inFlight.pop_front();
+   }
+   delete m_current;
+}
+
+ossimPngWriter::ParallelDeflater::Job* ossimPngWriter::ParallelDeflater::newJob()
+{
+   Job* job = new Job();
+   job->m_contextRows = 0;
+   job->m_rows        = 0;
+   job->m_first       = false;
+   job->m_last        = false;
+   job->m_adler       = 0;
+   job->m_length      = 0;
+   job->m_done        = false;
+   job->m_ok          = false;
+   job->m_raw.reserve( ( m_contextRows + m_rowsPerJob ) * m_rowBytes );
+   return job;
+}
+
+void ossimPngWriter::ParallelDeflater::addRow( const ossim_uint8* row )
+{
+   m_current->m_raw.insert( m_current->m_raw.end(), row, row + m_rowBytes );
+   ++m_current->m_rows;
+
+   if ( m_current->m_rows == m_rowsPerJob )
+   {
+      submit( false );
+   }
+}
+
+void ossimPngWriter::ParallelDeflater::submit( bool last )
+{
+   Job* job = m_current;
+   job->m_first = m_firstJob;
+   job->m_last  = last;
+   m_firstJob = false;
+
+   if ( !last )
+   {
+      // Seed the next job with the rows it needs to rebuild its dictionary.
+      m_current = newJob();
+      ossim_uint32 rows = job->m_contextRows + job->m_rows;
+      ossim_uint32 context = std::min( rows, m_contextRows );
+      m_current->m_raw.assign( job->m_raw.end() - context * m_rowBytes,
+                               job->m_raw.end() );
+      m_current->m_contextRows = context;
+   }
+   else
+   {
+      m_current = 0;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_pending.push_back( job );
+      m_inFlight.push_back( job );
+   }
+   m_workCond.notify_one();
+
+   //---
+   // Write finished jobs in order.  Block on the oldest when too many are
+   // out so memory stays bounded.
+   //---
+   while ( m_inFlight.size() )
+   {
+      Job* front = m_inFlight.front();
+      {
+         std::unique_lock<std::mutex> lock( m_mutex );
+         if ( !front->m_done )
+         {
+            if ( !last && ( m_inFlight.size() < m_maxJobs ) )
+            {
+               break;
+            }
+            m_doneCond.wait( lock, [front]{ return front->m_done; } );
+         }
+      }
+      writeJob( front );
+      m_inFlight.pop_front();
+      delete front;
+   }
+}
+
+void ossimPngWriter::ParallelDeflater::work()
+{
+   while ( true )
+   {
+      Job* job = 0;
+      {
+         std::unique_lock<std::mutex> lock( m_mutex );
+         m_workCond.wait( lock, [this]{ return m_stop || m_pending.size(); } );
+         if ( m_pending.empty() )
+         {
+            return; // Stopped.
+         }
+         job = m_pending.front();
+         m_pending.pop_front();
+      }
+
+      deflateJob( job );
+
+      {
+         std::lock_guard<std::mutex> lock( m_mutex );
+         job->m_done = true;
+      }
+      m_doneCond.notify_all();
+   }
+}
+
+void ossimPngWriter::ParallelDeflater::deflateJob( Job* job ) const
+{
+   const ossim_uint32 STRIDE = m_rowBytes + 1;
+   const ossim_uint32 ROWS   = job->m_contextRows + job->m_rows;
+
+   //---
+   // The first context row is only the prior for the next one.  Filtering is
+   // deterministic so the context rows filter to the same bytes the prior
+   // job wrote, which makes them the dictionary.
+   //---
+   const ossim_uint32 START = job->m_contextRows ? 1 : 0;
+   std::vector<ossim_uint8> filtered( ( ROWS - START ) * STRIDE );
+   std::vector<ossim_uint8> zeros( START ? 0 : m_rowBytes, 0 );
+   std::vector<ossim_uint8> scratch;
+   for ( ossim_uint32 row = START; row < ROWS; ++row )
+   {
+      const ossim_uint8* prior = row ? &job->m_raw[ ( row - 1 ) * m_rowBytes ] : &zeros.front();
+      filterRow( &job->m_raw[ row * m_rowBytes ], prior,
+                 &filtered[ ( row - START ) * STRIDE ], scratch );
+   }
+
+   const ossim_uint32 DICT_SIZE = ( job->m_contextRows - START ) * STRIDE;
+   const ossim_uint32 SIZE      = job->m_rows * STRIDE;
+   Bytef* in = filtered.size() ? &filtered.front() + DICT_SIZE : Z_NULL;
+
+   job->m_adler  = adler32( adler32( 0L, Z_NULL, 0 ), in, SIZE );
+   job->m_length = SIZE;
+
+   z_stream strm;
+   memset( &strm, 0, sizeof(z_stream) );
+   if ( deflateInit2( &strm, m_level, Z_DEFLATED, -15, 8, m_strategy ) != Z_OK )
+   {
+      return;
+   }
+
+   if ( DICT_SIZE )
+   {
+      ossim_uint32 dictSize = std::min( DICT_SIZE, DICTIONARY_BYTES );
+      deflateSetDictionary( &strm, in - dictSize, dictSize );
+   }
+
+   std::vector<ossim_uint8>& out = job->m_out;
+   out.clear();
+   if ( job->m_first )
+   {
+      // zlib header, deflate with a 32k window and the level hint.
+      ossim_uint32 flevel = 2;
+      if ( ( m_level >= 0 ) && ( m_level <= 1 ) )
+      {
+         flevel = 0;
+      }
+      else if ( ( m_level >= 2 ) && ( m_level <= 5 ) )
+      {
+         flevel = 1;
+      }
+      else if ( m_level >= 7 )
+      {
+         flevel = 3;
+      }
+      ossim_uint32 header = ( 0x78 << 8 ) | ( flevel << 6 );
+      header += 31 - ( header % 31 );
+      out.push_back( (ossim_uint8)( header >> 8 ) );
+      out.push_back( (ossim_uint8)( header & 0xff ) );
+   }
+
+   //---
+   // Interior jobs end on a sync flush so the next piece starts byte
+   // aligned.  Only the last job sets the final block bit.
+   //---
+   const int FLUSH = job->m_last ? Z_FINISH : Z_SYNC_FLUSH;
+   size_t used = out.size();
+   out.resize( used + deflateBound( &strm, SIZE ) + 16 );
+   strm.next_in  = in;
+   strm.avail_in = SIZE;
+   bool ok = false;
+   while ( true )
+   {
+      strm.next_out  = &out.front() + used;
+      strm.avail_out = (uInt)( out.size() - used );
+      int status = deflate( &strm, FLUSH );
+      used = out.size() - strm.avail_out;
+
+      if ( ( status != Z_OK ) && ( status != Z_STREAM_END ) && ( status != Z_BUF_ERROR ) )
+      {
+         break;
+      }
+      if ( job->m_last ? ( status == Z_STREAM_END ) : ( strm.avail_out != 0 ) )
+      {
+         ok = true;
+         break;
+      }
+      out.resize( out.size() * 2 );
+   }
+   out.resize( used );
+   deflateEnd( &strm );
+
+   job->m_ok = ok;
+}
+
+void ossimPngWriter::ParallelDeflater::filterRow( const ossim_uint8* row,
+                                                  const ossim_uint8* prior,
+                                                  ossim_uint8* out,
+                                                  std::vector<ossim_uint8>& scratch ) const
+{
+   if ( !m_filterRows )
+   {
+      out[0] = PNG_FILTER_VALUE_NONE;
+      memcpy( out + 1, row, m_rowBytes );
+      return;
+   }
+
+   //---
+   // Same heuristic as libpng's default: try all five filters and keep
+   // the one with the smallest sum of absolute (signed) residuals.
+   //---
+   const ossim_uint32 STRIDE = m_rowBytes + 1;
+   const ossim_uint32 BPP    = m_bpp;
+   scratch.resize( STRIDE * 5 );
+
+   ossim_uint32 best = 0;
+   ossim_uint64 bestSum = 0;
+   for ( ossim_uint32 filter = 0; filter < 5; ++filter )
+   {
+      ossim_uint8* f = &scratch[ filter * STRIDE ];
+      f[0] = (ossim_uint8)filter;
+      ++f;
+
+      for ( ossim_uint32 i = 0; i < m_rowBytes; ++i )
+      {
+         int a = ( i >= BPP ) ? row[i-BPP]   : 0;
+         int b = prior[i];
+         int c = ( i >= BPP ) ? prior[i-BPP] : 0;
+         int p = 0;
+         switch ( filter )
+         {
+            case PNG_FILTER_VALUE_SUB:
+               p = a;
+               break;
+            case PNG_FILTER_VALUE_UP:
+               p = b;
+               break;
+            case PNG_FILTER_VALUE_AVG:
+               p = ( a + b ) >> 1;
+               break;
+            case PNG_FILTER_VALUE_PAETH:
+            {
+               int pa = std::abs( b - c );
+               int pb = std::abs( a - c );
+               int pc = std::abs( a + b - c - c );
+               p = ( ( pa <= pb ) && ( pa <= pc ) ) ? a : ( ( pb <= pc ) ? b : c );
+               break;
+            }
+            default:
+               break;
+         }
+         f[i] = (ossim_uint8)( row[i] - p );
+      }
+
+      ossim_uint64 sum = 0;
+      for ( ossim_uint32 i = 0; i < m_rowBytes; ++i )
+      {
+         sum += ( f[i] < 128 ) ? f[i] : ( 256 - f[i] );
+      }
+      if ( ( filter == 0 ) || ( sum < bestSum ) )
+      {
+         best = filter;
+         bestSum = sum;
+      }
+   }
+
+   memcpy( out, &scratch[ best * STRIDE ], STRIDE );
+}
+
+bool ossimPngWriter::ParallelDeflater::finish()
+{
+   if ( m_current )
+   {
+      submit( true );
+   }
+
+   if ( m_ok )
+   {
+      writeChunk( "IEND", 0, 0 );
+   }
+
+   return m_ok && m_str->good();
+}
+
+void ossimPngWriter::ParallelDeflater::writeJob( Job* job )
+{
+   if ( !job->m_ok )
+   {
+      m_ok = false;
+   }
+   if ( !m_ok )
+   {
+      return;
+   }
+
+   m_adler = adler32_combine( m_adler, job->m_adler, (z_off_t)job->m_length );
+
+   if ( job->m_last )
+   {
+      job->m_out.push_back( (ossim_uint8)( ( m_adler >> 24 ) & 0xff ) );
+      job->m_out.push_back( (ossim_uint8)( ( m_adler >> 16 ) & 0xff ) );
+      job->m_out.push_back( (ossim_uint8)( ( m_adler >> 8 ) & 0xff ) );
+      job->m_out.push_back( (ossim_uint8)( m_adler & 0xff ) );
+   }
+
+   if ( job->m_out.size() )
+   {
+      writeChunk( "IDAT", &job->m_out.front(), (ossim_uint32)job->m_out.size() );
+   }
+}
+
+void ossimPngWriter::ParallelDeflater::writeChunk( const char* type,
+                                                   const ossim_uint8* data,
+                                                   ossim_uint32 length )
+{
+   // Length and crc are big endian.  The crc covers the type and data.
+   ossim_uint8 buf[8];
+   buf[0] = (ossim_uint8)( ( length >> 24 ) & 0xff );
+   buf[1] = (ossim_uint8)( ( length >> 16 ) & 0xff );
+   buf[2] = (ossim_uint8)( ( length >> 8 ) & 0xff );
+   buf[3] = (ossim_uint8)( length & 0xff );
+   memcpy( buf + 4, type, 4 );
+   m_str->write( (const char*)buf, 8 );
+
+   uLong crc = crc32( 0L, Z_NULL, 0 );
+   crc = crc32( crc, buf + 4, 4 );
+   if ( length )
+   {
+      m_str->write( (const char*)data, length );
+      crc = crc32( crc, data, length );
+   }
+
+   buf[0] = (ossim_uint8)( ( crc >> 24 ) & 0xff );
+   buf[1] = (ossim_uint8)( ( crc >> 16 ) & 0xff );
+   buf[2] = (ossim_uint8)( ( crc >> 8 ) & 0xff );
+   buf[3] = (ossim_uint8)( crc & 0xff );
+   m_str->write( (const char*)buf, 4 );
+}
+
 ossimPngWriter::ossimPngWriter()
    : ossimImageFileWriter(),
      theOutputStream(0),
@@ -59,6 +562,7 @@ ossimPngWriter::ossimPngWriter()
      theInterlaceSupport(PNG_INTERLACE_NONE),
      theCompressionStratagy(Z_FILTERED),
      thePngFilter(PNG_FILTER_NONE),
+     theNumberOfThreads(1),
      theGammaFlag(false),
      theGamma(0.0),
      theTimeFlag(true),
@@ -338,6 +842,7 @@ bool ossimPngWriter::writeStream()
             << "\nimageHeight:         " << imageHeight
             << "\ngitDepth:            " << getBitDepth(outputScalar)
             << "\ngetColorType(bands): " << colorType
+            << "\nthreads:             " << getNumberOfThreads()
             << endl;
       }
 
@@ -373,6 +878,24 @@ bool ossimPngWriter::writeStream()
          theInputConnection->setToStartOfSequence();
          ossim_uint32 maxY = theInputConnection->getNumberOfTilesVertical();
 
+         //---
+         // With more than one thread the rows bypass png_write_row and go
+         // out as IDAT chunks deflated in parallel.
+         //---
+         ossim_uint32 threads = getNumberOfThreads();
+         ParallelDeflater* deflater = 0;
+         if ( threads > 1 )
+         {
+            png_write_flush(pp);
+            deflater = new ParallelDeflater( theOutputStream,
+                                             bytesPerRow,
+                                             bands*bytesPerPixel,
+                                             theCompressionLevel,
+                                             isLutEnabled() ? Z_DEFAULT_STRATEGY : Z_FILTERED,
+                                             !isLutEnabled(),
+                                             threads );
+         }
+
          //---
          // Loop through and grab a row of tiles and copy to the buffer.
          // Then write the buffer to the png file.
@@ -432,7 +955,14 @@ bool ossimPngWriter::writeStream()
                   for (ossim_int32 line=0; line<lines_to_copy; ++line)
                   {
                      png_bytep rowp = (png_bytep)&buf[buf_offset];
-                     png_write_row(pp, rowp);
+                     if ( deflater )
+                     {
+                        deflater->addRow(rowp);
+                     }
+                     else
+                     {
+                        png_write_row(pp, rowp);
+                     }
                      buf_offset += bytesPerRow;
                   }
 
@@ -445,9 +975,31 @@ bool ossimPngWriter::writeStream()
 
          } // End of loop through tiles in the y direction.
 
+         if ( deflater )
+         {
+            // Writes the last IDAT and the IEND chunk.
+            bool status = deflater->finish();
+            delete deflater;
+            deflater = 0;
+
+            if ( !status )
+            {
+               ossimNotify(ossimNotifyLevel_WARN)
+                  << MODULE << " ERROR:"
+                  << "\nParallel deflate failed writing image:  "
+                  << theFilename.c_str() << std::endl;
+               png_destroy_write_struct(&pp, &info);
+               close();
+               return false;
+            }
+         }
+         else
+         {
+            png_write_end(pp, 0);
+         }
+
       } // Not interlace write block.
 
-      png_write_end(pp, 0);
       png_destroy_write_struct(&pp, &info);
 
       close();
@@ -494,6 +1046,11 @@ bool ossimPngWriter::saveState(ossimKeywordlist& kwl,
             ossimString::toString( theAlphaChannelFlag ),
             true );
 
+   kwl.add( prefix,
+            THREADS_KW,
+            theNumberOfThreads,
+            true );
+
    return ossimImageFileWriter::saveState(kwl, prefix);
 }
 
@@ -508,6 +1065,12 @@ bool ossimPngWriter::loadState(const ossimKeywordlist& kwl,
       setAlphaChannelFlag( ossimString(value).toBool() );
    }
 
+   value = kwl.find(prefix, THREADS_KW);
+   if(value)
+   {
+      setNumberOfThreads( ossimString(value).toUInt32() );
+   }
+
    theOutputImageType = "png";
 
    return ossimImageFileWriter::loadState(kwl, prefix);
@@ -599,6 +1162,11 @@ void ossimPngWriter::setProperty(ossimRefPtr<ossimProperty> property)
       setAlphaChannelFlag( property->valueToString().toBool() );
    }
    else
+   if (property->getName() == THREADS_KW)
+   {
+      setNumberOfThreads( property->valueToString().toUInt32() );
+   }
+   else
    {
       ossimImageFileWriter::setProperty(property);
    }
@@ -623,6 +1191,11 @@ ossimRefPtr<ossimProperty> ossimPngWriter::getProperty(const ossimString& name)c
       return new ossimBooleanProperty(ADD_ALPHA_CHANNEL_KW,
                                       theAlphaChannelFlag);
    }
+   else if (name == THREADS_KW)
+   {
+      return new ossimNumericProperty(THREADS_KW,
+                                      ossimString::toString(theNumberOfThreads));
+   }
    return ossimImageFileWriter::getProperty(name);
 }
 
@@ -630,6 +1203,7 @@ void ossimPngWriter::getPropertyNames(std::vector<ossimString>& propertyNames)co
 {
    propertyNames.push_back(ossimString(COMPRESSION_LEVEL_KW));
    propertyNames.push_back(ossimString(ADD_ALPHA_CHANNEL_KW));
+   propertyNames.push_back(ossimString(THREADS_KW));
    ossimImageFileWriter::getPropertyNames(propertyNames);
 }
 
@@ -995,6 +1569,21 @@ bool ossimPngWriter::setCompressionLevel(const ossimString& level)
    return status;
 }
 
+ossim_uint32 ossimPngWriter::getNumberOfThreads() const
+{
+   ossim_uint32 threads = theNumberOfThreads;
+   if ( threads == 0 )
+   {
+      threads = std::thread::hardware_concurrency();
+   }
+   return std::max<ossim_uint32>( 1, threads );
+}
+
+void ossimPngWriter::setNumberOfThreads( ossim_uint32 threads )
+{
+   theNumberOfThreads = threads;
+}
+
 bool ossimPngWriter::getAlphaChannelFlag( void ) const
 {
    return theAlphaChannelFlag;
@@ -129,6 +129,20 @@ public:
     */
    bool setCompressionLevel(const ossimString& level);
 
+   /** @return Number of threads used to deflate image data. */
+   ossim_uint32 getNumberOfThreads() const;
+
+   /**
+    * Set the number of threads used to deflate image data.
+    *
+    * 1 (the default) writes rows through libpng.  Greater than 1 filters
+    * and deflates row bands in parallel and writes the IDAT chunks
+    * directly.  0 uses the number of hardware threads.
+    *
+    * @param threads Number of threads.
+    */
+   void setNumberOfThreads( ossim_uint32 threads );
+
    /**
     * Retrieve the writer's setting for whether or not to add an 
     * alpha channel to the output png image.
@@ -307,6 +321,13 @@ private:
    ossim_int32 getColorType(ossim_int32 bands) const;
    
    ossim_int32 getBitDepth(ossimScalarType outputScalar) const;
+
+   /**
+    * Filters and deflates rows on a thread pool, pigz style.  Each job is
+    * primed with the 32k of filtered data before it so the pieces stitch
+    * into one zlib stream with a combined Adler-32.  Defined in the .cpp.
+    */
+   class ParallelDeflater;
    
    std::ostream* theOutputStream;
    bool          theOwnsStreamFlag;
@@ -356,6 +377,13 @@ private:
     */
    ossim_int32 thePngFilter;
 
+   /**
+    * Threads used to deflate image data.  1 writes through libpng.
+    *
+    * Defaulted to 1.
+    */
+   ossim_uint32 theNumberOfThreads;
+
    /**
     * For gamma support.
     * gamma multiplied by 100,000 and rounded to the nearest integer.
@@ -0,0 +1,172 @@
+//---
+//
+// License: MIT
+//
+// File: png-codec-bench.cpp
+//
+// Description: Tiles per second for ossimPngCodec encode and decode.
+//
+// Usage: png-codec-bench [--size <n>] [--bands <1|3>] [--alpha]
+//                        [--level <-1..9>] [--filter <name>]
+//                        [--tiles <n>] [--threads <n>]
+//
+// Each thread encodes then decodes its share of the tiles with its own
+// codec so the per thread contexts get exercised.
+//
+// $Id$
+//---
+
+#include <ossim/base/ossimArgumentParser.h>
+#include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimNotify.h>
+#include <ossim/base/ossimString.h>
+#include <ossim/imaging/ossimImageData.h>
+#include <ossim/init/ossimInit.h>
+#include <png/src/ossimPngCodec.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static ossimRefPtr<ossimImageData> makeTile( ossim_uint32 size, ossim_uint32 bands )
+{
+   ossimRefPtr<ossimImageData> tile =
+      new ossimImageData( 0, OSSIM_UINT8, bands, size, size );
+   tile->initialize();
+
+   // Smooth ramps with a null corner, roughly like imagery at a tile edge.
+   for ( ossim_uint32 band = 0; band < bands; ++band )
+   {
+      ossim_uint8* buf = tile->getUcharBuf( band );
+      for ( ossim_uint32 y = 0; y < size; ++y )
+      {
+         for ( ossim_uint32 x = 0; x < size; ++x )
+         {
+            buf[ y*size + x ] = ( ( x < size/4 ) && ( y < size/4 ) ) ? 0 :
+               (ossim_uint8)( ( x + y*( band + 1 ) + ( ( x*y ) >> 6 ) ) & 0xff );
+         }
+      }
+   }
+   tile->validate();
+   return tile;
+}
+
+int main(int argc, char *argv[])
+{
+   ossimArgumentParser ap(&argc, argv);
+   ossimInit::instance()->addOptions(ap);
+   ossimInit::instance()->initialize(ap);
+
+   ossim_uint32 size    = 256;
+   ossim_uint32 bands   = 3;
+   ossim_int32  level   = 1;
+   ossim_uint32 tiles   = 2000;
+   ossim_uint32 threads = 1;
+   bool         alpha   = false;
+   ossimString  filter  = "adaptive";
+
+   std::string s;
+   ossimArgumentParser::ossimParameter sp(s);
+   if ( ap.read("--size", sp) )    size    = ossimString(s).toUInt32();
+   if ( ap.read("--bands", sp) )   bands   = ossimString(s).toUInt32();
+   if ( ap.read("--level", sp) )   level   = ossimString(s).toInt32();
+   if ( ap.read("--filter", sp) )  filter  = s;
+   if ( ap.read("--tiles", sp) )   tiles   = ossimString(s).toUInt32();
+   if ( ap.read("--threads", sp) ) threads = std::max<ossim_uint32>( 1, ossimString(s).toUInt32() );
+   if ( ap.read("--alpha") )       alpha   = true;
+
+   if ( ( ( bands != 1 ) && ( bands != 3 ) ) || !size || !tiles )
+   {
+      cout << "\nUsage: " << argv[0]
+           << " [--size <n>] [--bands <1|3>] [--alpha] [--level <-1..9>]"
+           << "\n  [--filter <none|sub|up|avg|paeth|adaptive>] [--tiles <n>]"
+           << " [--threads <n>]\n" << endl;
+      return 1;
+   }
+
+   ossimPngCodec::FilterType filterType = ossimPngCodec::FILTER_ADAPTIVE;
+   const char* FILTERS[] = { "none", "sub", "up", "avg", "paeth", "adaptive" };
+   for ( ossim_uint32 i = 0; i < 6; ++i )
+   {
+      if ( filter == FILTERS[i] )
+      {
+         filterType = (ossimPngCodec::FilterType)i;
+      }
+   }
+
+   ossimRefPtr<ossimImageData> tile = makeTile( size, bands );
+
+   std::vector<double>       encodeSeconds( threads, 0.0 );
+   std::vector<double>       decodeSeconds( threads, 0.0 );
+   std::vector<ossim_uint64> bytes( threads, 0 );
+   std::vector<int>          ok( threads, 1 );
+
+   auto bench = [&]( ossim_uint32 id )
+   {
+      ossimPngCodec codec( alpha );
+      std::vector<ossim_uint8> encoded;
+      ossimRefPtr<ossimImageData> decoded;
+      const ossim_uint32 COUNT = tiles / threads + ( id < tiles % threads ? 1 : 0 );
+
+      std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+      for ( ossim_uint32 i = 0; i < COUNT; ++i )
+      {
+         if ( !codec.encode( tile, encoded, level, filterType ) )
+         {
+            ok[id] = 0;
+         }
+      }
+      std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+      for ( ossim_uint32 i = 0; i < COUNT; ++i )
+      {
+         if ( !codec.decode( encoded, decoded ) )
+         {
+            ok[id] = 0;
+         }
+      }
+      std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+      encodeSeconds[id] = std::chrono::duration<double>( t1 - t0 ).count();
+      decodeSeconds[id] = std::chrono::duration<double>( t2 - t1 ).count();
+      bytes[id] = encoded.size();
+   };
+
+   std::vector<std::thread> workers;
+   for ( ossim_uint32 i = 0; i < threads; ++i )
+   {
+      workers.push_back( std::thread( bench, i ) );
+   }
+   for ( ossim_uint32 i = 0; i < threads; ++i )
+   {
+      workers[i].join();
+   }
+
+   // Threads run side by side so the slowest one sets the wall time.
+   double encodeWall = 0.0;
+   double decodeWall = 0.0;
+   bool status = true;
+   for ( ossim_uint32 i = 0; i < threads; ++i )
+   {
+      encodeWall = std::max( encodeWall, encodeSeconds[i] );
+      decodeWall = std::max( decodeWall, decodeSeconds[i] );
+      status = status && ( ok[i] != 0 );
+   }
+
+   cout << "tile:          " << size << "x" << size << "x" << bands
+        << ( alpha ? " +alpha" : "" )
+        << "\nlevel:         " << level
+        << "\nfilter:        " << FILTERS[filterType]
+        << "\nthreads:       " << threads
+        << "\ntiles:         " << tiles
+        << "\nencoded bytes: " << bytes[0]
+        << "\nencode:        " << ( encodeWall > 0.0 ? tiles / encodeWall : 0.0 ) << " tiles/s"
+        << "\ndecode:        " << ( decodeWall > 0.0 ? tiles / decodeWall : 0.0 ) << " tiles/s"
+        << "\nstatus:        " << ( status ? "ok" : "failed" )
+        << endl;
+
+   return status ? 0 : 1;
+}
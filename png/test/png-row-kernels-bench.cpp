@@ -0,0 +1,191 @@
+//---
+//
+// License: MIT
+//
+// File: png-row-kernels-bench.cpp
+//
+// Description: Times the ossimPngReader row kernels (deinterleave, alpha
+// test, 16 bit swap) against the per pixel loops the reader used before,
+// checking the outputs match.
+//
+// Usage: png-row-kernels-bench [--width <n>] [--rows <n>]
+//
+// $Id$
+//---
+
+#include <ossim/base/ossimArgumentParser.h>
+#include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimString.h>
+#include <ossim/init/ossimInit.h>
+#include <png/src/ossimPngRowKernels.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// The reader's loops before the kernels.
+template <class T>
+static void loopRow( T* src, ossim_uint32 srcBands, bool swap, bool alpha,
+                     std::vector<T*>& dst, ossim_uint32 dstBands,
+                     ossim_uint32 samples, T opaque )
+{
+   if ( swap )
+   {
+      ossim_uint16* p = (ossim_uint16*)src;
+      for ( ossim_uint32 i = 0; i < samples*srcBands; ++i )
+      {
+         p[i] = static_cast<ossim_uint16>( (p[i] >> 8) | (p[i] << 8) );
+      }
+   }
+
+   ossim_uint32 index = 0;
+   for ( ossim_uint32 sample = 0; sample < samples; ++sample )
+   {
+      for ( ossim_uint32 band = 0; band < dstBands; ++band )
+      {
+         dst[band][sample] = src[index++];
+      }
+      if ( alpha )
+      {
+         // Stand in for the opaque test done per pixel.
+         if ( src[index++] != opaque )
+         {
+            dst[0][sample] = 0;
+         }
+      }
+   }
+}
+
+template <class T>
+static void kernelRow( const ossim::PngRowKernels& kernels,
+                       T* src, ossim_uint32 srcBands, bool swap, bool alpha,
+                       std::vector<T*>& dst, ossim_uint32 dstBands,
+                       ossim_uint32 samples, T opaque, std::vector<T>& alphaLine )
+{
+   if ( swap )
+   {
+      kernels.swap( (ossim_uint16*)src, samples*srcBands );
+   }
+
+   if ( alpha )
+   {
+      std::vector<T*> planes( dst );
+      planes.push_back( &alphaLine.front() );
+      kernels.deinterleave( src, srcBands, &planes.front(), srcBands, samples );
+      if ( !kernels.allEqual( &alphaLine.front(), samples, opaque ) )
+      {
+         for ( ossim_uint32 sample = 0; sample < samples; ++sample )
+         {
+            if ( alphaLine[sample] != opaque )
+            {
+               dst[0][sample] = 0;
+            }
+         }
+      }
+   }
+   else
+   {
+      kernels.deinterleave( src, srcBands, &dst.front(), dstBands, samples );
+   }
+}
+
+template <class T>
+static bool bench( const ossim::PngRowKernels& kernels, ossim_uint32 srcBands,
+                   bool alpha, ossim_uint32 width, ossim_uint32 rows )
+{
+   const bool SWAP = ( sizeof(T) == 2 );
+   const ossim_uint32 DST_BANDS = alpha ? srcBands - 1 : srcBands;
+   const T OPAQUE = static_cast<T>( ~T(0) );
+
+   // Input rows; alpha is opaque so the common path is timed.
+   std::vector<T> line( width * srcBands );
+   for ( ossim_uint32 i = 0; i < line.size(); ++i )
+   {
+      line[i] = static_cast<T>( rand() );
+      if ( alpha && ( (i % srcBands) == srcBands - 1 ) )
+      {
+         line[i] = OPAQUE;
+      }
+   }
+
+   std::vector<T> work( line );
+   std::vector< std::vector<T> > a( DST_BANDS, std::vector<T>( width ) );
+   std::vector< std::vector<T> > b( DST_BANDS, std::vector<T>( width ) );
+   std::vector<T*> pa( DST_BANDS );
+   std::vector<T*> pb( DST_BANDS );
+   for ( ossim_uint32 band = 0; band < DST_BANDS; ++band )
+   {
+      pa[band] = &a[band].front();
+      pb[band] = &b[band].front();
+   }
+   std::vector<T> alphaLine( width );
+
+   std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+   for ( ossim_uint32 row = 0; row < rows; ++row )
+   {
+      loopRow( &work.front(), srcBands, SWAP, alpha, pa, DST_BANDS, width, OPAQUE );
+   }
+   std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+   // Rows are swapped in place so both runs start from the same line.
+   work = line;
+
+   std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+   for ( ossim_uint32 row = 0; row < rows; ++row )
+   {
+      kernelRow( kernels, &work.front(), srcBands, SWAP, alpha, pb, DST_BANDS,
+                 width, OPAQUE, alphaLine );
+   }
+   std::chrono::steady_clock::time_point t3 = std::chrono::steady_clock::now();
+
+   const bool OK = ( a == b );
+   const double MB = double(width) * rows * srcBands * sizeof(T) / 1.0e6;
+   const double LOOP = std::chrono::duration<double>( t1 - t0 ).count();
+   const double KERNEL = std::chrono::duration<double>( t3 - t2 ).count();
+
+   cout << setw(3) << sizeof(T)*8 << " bit  " << srcBands << " bands"
+        << ( alpha ? " (alpha)" : "        " )
+        << "  loop: " << setw(8) << fixed << setprecision(1) << MB / LOOP << " MB/s"
+        << "  " << kernels.m_name << ": " << setw(8) << MB / KERNEL << " MB/s"
+        << "  x" << setprecision(2) << ( KERNEL > 0.0 ? LOOP / KERNEL : 0.0 )
+        << ( OK ? "" : "  MISMATCH" ) << endl;
+
+   return OK;
+}
+
+int main(int argc, char *argv[])
+{
+   ossimArgumentParser ap(&argc, argv);
+   ossimInit::instance()->addOptions(ap);
+   ossimInit::instance()->initialize(ap);
+
+   ossim_uint32 width = 4096;
+   ossim_uint32 rows  = 4096;
+
+   std::string s;
+   ossimArgumentParser::ossimParameter sp(s);
+   if ( ap.read("--width", sp) ) width = ossimString(s).toUInt32();
+   if ( ap.read("--rows", sp) )  rows  = ossimString(s).toUInt32();
+
+   if ( !width || !rows )
+   {
+      cout << "\nUsage: " << argv[0] << " [--width <n>] [--rows <n>]\n" << endl;
+      return 1;
+   }
+
+   const ossim::PngRowKernels& KERNELS = ossim::getPngRowKernels();
+
+   bool status = true;
+   for ( ossim_uint32 bands = 1; bands <= 4; ++bands )
+   {
+      const bool ALPHA = ( (bands == 2) || (bands == 4) );
+      status = bench<ossim_uint8>( KERNELS, bands, ALPHA, width, rows ) && status;
+      status = bench<ossim_uint16>( KERNELS, bands, ALPHA, width, rows ) && status;
+   }
+
+   return status ? 0 : 1;
+}
@@ -28,13 +28,16 @@
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimNotify.h>
 #include <ossim/base/ossimProperty.h>
+#include <ossim/base/ossimStringProperty.h>
 #include <ossim/base/ossimStreamFactoryRegistry.h>
 #include <ossim/base/ossimTrace.h>
 
 #include <ossim/imaging/ossimCodecFactoryRegistry.h>
+#include <ossim/imaging/ossimImageData.h>
 #include <ossim/imaging/ossimImageDataFactory.h>
 #include <ossim/imaging/ossimImageGeometryRegistry.h>
 #include <ossim/imaging/ossimImageHandlerRegistry.h>
+#include <ossim/imaging/ossimJpegMemSrc.h>
 #include <ossim/imaging/ossimStreamReaderInterface.h>
 
 #include <ossim/projection/ossimMapProjection.h>
@@ -42,8 +45,17 @@
 
 #include <sqlite3.h>
 
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <sstream>
+#include <thread>
 
 RTTI_DEF1(ossimGpkgReader, "ossimGpkgReader", ossimImageHandler)
 
@@ -54,19 +66,245 @@ static const char OSSIM_ID[] = "$Id$";
 static ossimTrace traceDebug("ossimGpkgReader:debug");
 static ossimTrace traceValidate("ossimGpkgReader:validate");
 
+static const std::string CONNECTION_POOL_KW  = "connection_pool";
+static const std::string TILE_CACHE_SIZE_KW  = "tile_cache_size";
+static const std::string TILE_PREFETCH_KW    = "tile_prefetch";
+
+// Default decoded tile cache size in MiB; off unless asked for.
+static const ossim_uint64 DEFAULT_TILE_CACHE_SIZE = 0;
+
+//---
+// Byte budgeted, least recently used cache of decoded tiles keyed by
+// entry, res level, column and row.  Missing tiles are cached as null.
+//---
+class ossimGpkgReader::DecodedTileCache
+{
+public:
+   struct Key
+   {
+      ossim_uint32 m_entry;
+      ossim_uint32 m_resLevel;
+      ossim_int32  m_col;
+      ossim_int32  m_row;
+      
+      bool operator<( const Key& rhs ) const
+      {
+         if ( m_entry != rhs.m_entry ) return m_entry < rhs.m_entry;
+         if ( m_resLevel != rhs.m_resLevel ) return m_resLevel < rhs.m_resLevel;
+         if ( m_row != rhs.m_row ) return m_row < rhs.m_row;
+         return m_col < rhs.m_col;
+      }
+   };
+
+   explicit DecodedTileCache( ossim_uint64 maxBytes )
+      : m_mutex(), m_lru(), m_tiles(), m_bytes(0), m_maxBytes(maxBytes)
+   {}
+
+   /** @return true if found.  Moves key to the front. */
+   bool get( const Key& key, ossimRefPtr<ossimImageData>& tile )
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      std::map<Key, Entry>::iterator i = m_tiles.find( key );
+      if ( i != m_tiles.end() )
+      {
+         m_lru.splice( m_lru.begin(), m_lru, i->second.m_lru );
+         tile = i->second.m_tile;
+         return true;
+      }
+      return false;
+   }
+
+   bool contains( const Key& key )
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      return ( m_tiles.find( key ) != m_tiles.end() );
+   }
+
+   void add( const Key& key, ossimRefPtr<ossimImageData> tile )
+   {
+      // Null tiles still cost their entry.
+      const ossim_uint64 BYTES = 64 + ( tile.valid() ? tile->getSizeInBytes() : 0 );
+      
+      std::lock_guard<std::mutex> lock( m_mutex );
+      if ( m_tiles.find( key ) == m_tiles.end() )
+      {
+         m_lru.push_front( key );
+         Entry& entry = m_tiles[key];
+         entry.m_tile  = tile;
+         entry.m_bytes = BYTES;
+         entry.m_lru   = m_lru.begin();
+         m_bytes += BYTES;
+         trim();
+      }
+   }
+
+   void clear()
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_tiles.clear();
+      m_lru.clear();
+      m_bytes = 0;
+   }
+
+   void setMaxBytes( ossim_uint64 maxBytes )
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_maxBytes = maxBytes;
+      trim();
+   }
+
+   ossim_uint64 getMaxBytes()
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      return m_maxBytes;
+   }
+
+private:
+   struct Entry
+   {
+      ossimRefPtr<ossimImageData> m_tile;
+      ossim_uint64                m_bytes;
+      std::list<Key>::iterator    m_lru;
+   };
+
+   // Drops least recently used tiles until under budget.  Locked by caller.
+   void trim()
+   {
+      while ( ( m_bytes > m_maxBytes ) && m_lru.size() )
+      {
+         std::map<Key, Entry>::iterator i = m_tiles.find( m_lru.back() );
+         m_bytes -= i->second.m_bytes;
+         m_tiles.erase( i );
+         m_lru.pop_back();
+      }
+   }
+
+   std::mutex           m_mutex;
+   std::list<Key>       m_lru;
+   std::map<Key, Entry> m_tiles;
+   ossim_uint64         m_bytes;
+   ossim_uint64         m_maxBytes;
+};
+
+//---
+// Background thread that reads and decodes queued tiles into the decoded
+// tile cache on its own connection.
+//---
+class ossimGpkgReader::TilePrefetcher
+{
+public:
+   explicit TilePrefetcher( ossimGpkgReader* reader )
+      : m_reader( reader ),
+        m_connection(),
+        m_thread(),
+        m_mutex(),
+        m_cond(),
+        m_queue(),
+        m_stop( false )
+   {
+      if ( m_reader->openConnection( m_connection ) )
+      {
+         m_thread = std::thread( &TilePrefetcher::run, this );
+      }
+   }
+
+   ~TilePrefetcher()
+   {
+      {
+         std::lock_guard<std::mutex> lock( m_mutex );
+         m_stop = true;
+         m_cond.notify_all();
+      }
+      if ( m_thread.joinable() )
+      {
+         m_thread.join();
+      }
+      m_reader->finalizeTileStatements( m_connection );
+      sqlite3_close( m_connection.m_db );
+   }
+
+   void request( ossim_uint32 resLevel, const ossimIpt& index )
+   {
+      // Old requests are stale once the view has moved on.
+      static const std::size_t MAX_QUEUED = 64;
+      
+      std::lock_guard<std::mutex> lock( m_mutex );
+      if ( m_thread.joinable() )
+      {
+         m_queue.push_back( std::make_pair( resLevel, index ) );
+         if ( m_queue.size() > MAX_QUEUED )
+         {
+            m_queue.pop_front();
+         }
+         m_cond.notify_one();
+      }
+   }
+
+private:
+   void run()
+   {
+      while ( true )
+      {
+         std::pair<ossim_uint32, ossimIpt> request;
+         {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_cond.wait( lock, [this]{ return m_stop || m_queue.size(); } );
+            if ( m_stop )
+            {
+               break;
+            }
+            request = m_queue.front();
+            m_queue.pop_front();
+         }
+         m_reader->getDecodedTile( m_connection, request.first, request.second );
+      }
+   }
+
+   ossimGpkgReader* m_reader;
+   Connection       m_connection;
+   std::thread      m_thread;
+   std::mutex       m_mutex;
+   std::condition_variable m_cond;
+   std::deque< std::pair<ossim_uint32, ossimIpt> > m_queue;
+   bool             m_stop;
+};
+
+namespace
+{
+   // libjpeg error manager that returns to decodeJpegTile instead of exiting.
+   struct GpkgJpegErrorMgr
+   {
+      jpeg_error_mgr pub;
+      jmp_buf setjmp_buffer;
+   };
+
+   void gpkgJpegErrorExit( j_common_ptr cinfo )
+   {
+      GpkgJpegErrorMgr* err = (GpkgJpegErrorMgr*)cinfo->err;
+      longjmp( err->setjmp_buffer, 1 );
+   }
+}
+
 ossimGpkgReader::ossimGpkgReader()
    :
    ossimImageHandler(),
    m_ih(0),
    m_tile(0),
-   m_cacheTile(0),
    m_db(0),
    m_currentEntry(0),
    m_bands(0),
    m_scalar(OSSIM_SCALAR_UNKNOWN),
    m_tileWidth(0),
    m_tileHeight(0),
-   m_entries(0)
+   m_entries(0),
+   m_connection(),
+   m_connectionPoolFlag(false),
+   m_pooledConnections(0),
+   m_idleConnections(0),
+   m_connectionMutex(),
+   m_decodedTileCache( new DecodedTileCache( DEFAULT_TILE_CACHE_SIZE * 1024 * 1024 ) ),
+   m_prefetcher(0),
+   m_prefetchFlag(false)
 {
    if (traceDebug())
    {
@@ -85,6 +323,9 @@ ossimGpkgReader::~ossimGpkgReader()
    {
       close();
    }
+   stopPrefetch();
+   delete m_decodedTileCache;
+   m_decodedTileCache = 0;
 }
 
 void ossimGpkgReader::allocate()
@@ -93,9 +334,38 @@ void ossimGpkgReader::allocate()
    m_tile->initialize();
 }
 
+ossimGpkgReader::Connection::Connection()
+   :
+   m_db(0),
+   m_tileStatements(),
+   m_cacheTile(0),
+   m_tileBuffer(),
+   m_jpegCodec(0),
+   m_pngCodec(0),
+   m_webpCodec(0)
+{
+}
+
 ossimRefPtr<ossimImageData> ossimGpkgReader::getTile(
    const ossimIrect& rect, ossim_uint32 resLevel)
 {
+   if ( m_connectionPoolFlag )
+   {
+      // Concurrent callers each get their own tile.
+      ossimRefPtr<ossimImageData> tile =
+         ossimImageDataFactory::instance()->create(this, this);
+      tile->initialize();
+      tile->setImageRectangle(rect);
+      if ( getTile( tile.get(), resLevel ) == false )
+      {
+         if (tile->getDataObjectStatus() != OSSIM_NULL)
+         {
+            tile->makeBlank();
+         }
+      }
+      return tile;
+   }
+   
    if ( !m_tile )
    {
       allocate();
@@ -134,24 +404,30 @@ bool ossimGpkgReader::getTile(ossimImageData* result,
 
       if ( resLevel < getNumberOfZoomLevels() )
       {
-         status = true;
-         
-         ossimIrect tileRect = result->getImageRectangle();
-         ossimIrect imageRect = getImageRectangle(resLevel);
-
-         //---
-         // Format allows for missing tiles so alway make blank in case tile
-         // is not filled completely.
-         //---
-         m_tile->makeBlank();
-         
-         if ( imageRect.intersects(tileRect) )
+         Connection* conn = acquireConnection();
+         if ( conn )
          {
-            // Make a clip rect.
-            ossimIrect clipRect = tileRect.clipToRect( imageRect );
+            status = true;
+            
+            ossimIrect tileRect = result->getImageRectangle();
+            ossimIrect imageRect = getImageRectangle(resLevel);
             
-            // This will validate the tile at the end.
-            fillTile(resLevel, tileRect, clipRect, result);
+            //---
+            // Format allows for missing tiles so alway make blank in case tile
+            // is not filled completely.
+            //---
+            result->makeBlank();
+            
+            if ( imageRect.intersects(tileRect) )
+            {
+               // Make a clip rect.
+               ossimIrect clipRect = tileRect.clipToRect( imageRect );
+               
+               // This will validate the tile at the end.
+               fillTile(*conn, resLevel, tileRect, clipRect, result);
+            }
+
+            releaseConnection( conn );
          }
       }
       else
@@ -165,7 +441,8 @@ bool ossimGpkgReader::getTile(ossimImageData* result,
    return status;
 }
 
-void ossimGpkgReader::fillTile( ossim_uint32 resLevel,
+void ossimGpkgReader::fillTile( Connection& conn,
+                                ossim_uint32 resLevel,
                                 const ossimIrect& tileRect,
                                 const ossimIrect& clipRect,
                                 ossimImageData* tile )
@@ -179,7 +456,7 @@ void ossimGpkgReader::fillTile( ossim_uint32 resLevel,
       std::vector<ossimIpt>::const_iterator i = tileIndexes.begin();
       while ( i != tileIndexes.end() )
       {
-         ossimRefPtr<ossimImageData> id = getTile( resLevel, (*i) );
+         ossimRefPtr<ossimImageData> id = getDecodedTile( conn, resLevel, (*i) );
          if ( id.valid() )
          {
             ossimIrect tileClipRect = clipRect.clipToRect( id->getImageRectangle() );
@@ -189,6 +466,11 @@ void ossimGpkgReader::fillTile( ossim_uint32 resLevel,
       }
       
       tile->validate();
+
+      if ( m_prefetchFlag && tileIndexes.size() )
+      {
+         prefetchNeighbors( resLevel, tileIndexes );
+      }
    }
 }
 
@@ -269,18 +551,57 @@ bool ossimGpkgReader::loadState(const ossimKeywordlist& kwl,
 
 void ossimGpkgReader::setProperty(ossimRefPtr<ossimProperty> property)
 {
-   ossimImageHandler::setProperty(property);
+   if ( property.valid() && ( property->getName() == CONNECTION_POOL_KW ) )
+   {
+      m_connectionPoolFlag = property->valueToString().toBool();
+   }
+   else if ( property.valid() && ( property->getName() == TILE_CACHE_SIZE_KW ) )
+   {
+      m_decodedTileCache->setMaxBytes(
+         property->valueToString().toUInt64() * 1024 * 1024 );
+   }
+   else if ( property.valid() && ( property->getName() == TILE_PREFETCH_KW ) )
+   {
+      m_prefetchFlag = property->valueToString().toBool();
+      if ( !m_prefetchFlag )
+      {
+         stopPrefetch();
+      }
+   }
+   else
+   {
+      ossimImageHandler::setProperty(property);
+   }
 }
 
 ossimRefPtr<ossimProperty> ossimGpkgReader::getProperty(const ossimString& name)const
 {
    ossimRefPtr<ossimProperty> prop = 0;
-   prop = ossimImageHandler::getProperty(name);
+   if ( name == CONNECTION_POOL_KW )
+   {
+      prop = new ossimBooleanProperty( name, m_connectionPoolFlag );
+   }
+   else if ( name == TILE_CACHE_SIZE_KW )
+   {
+      prop = new ossimStringProperty(
+         name, ossimString::toString( m_decodedTileCache->getMaxBytes() / (1024 * 1024) ) );
+   }
+   else if ( name == TILE_PREFETCH_KW )
+   {
+      prop = new ossimBooleanProperty( name, m_prefetchFlag );
+   }
+   else
+   {
+      prop = ossimImageHandler::getProperty(name);
+   }
    return prop;
 }
 
 void ossimGpkgReader::getPropertyNames(std::vector<ossimString>& propertyNames)const
 {
+   propertyNames.push_back( ossimString(CONNECTION_POOL_KW) );
+   propertyNames.push_back( ossimString(TILE_CACHE_SIZE_KW) );
+   propertyNames.push_back( ossimString(TILE_PREFETCH_KW) );
    ossimImageHandler::getPropertyNames(propertyNames);
 }
 
@@ -322,6 +643,7 @@ bool ossimGpkgReader::open()
       int rc = sqlite3_open_v2( theImageFile.c_str(), &m_db, SQLITE_OPEN_READONLY, 0);
       if ( rc == SQLITE_OK )
       {
+         m_connection.m_db = m_db;
          m_entries.clear();
          ossim_gpkg::getTileEntries( m_db, m_entries );
 
@@ -477,8 +799,14 @@ void ossimGpkgReader::close()
    {
       ossimImageHandler::close();
    }
+   stopPrefetch();
+   m_decodedTileCache->clear();
+   closeConnectionPool();
    if ( m_db )
    {
+      // Must be finalized before the close or the close fails.
+      finalizeTileStatements( m_connection );
+      m_connection.m_db = 0;
       sqlite3_close( m_db );
       m_db = 0;
    }
@@ -520,6 +848,9 @@ bool ossimGpkgReader::setCurrentEntry(ossim_uint32 entryIdx )
    {
       if ( entryIdx < getNumberOfEntries() )
       {
+         // Prefetch thread reads the current entry.
+         stopPrefetch();
+         
          m_currentEntry = entryIdx;
          
          if ( isOpen() )
@@ -550,6 +881,78 @@ bool ossimGpkgReader::setCurrentEntry(ossim_uint32 entryIdx )
    return result;
 }
 
+const ossimGpkgTileEntry* ossimGpkgReader::getTileEntry() const
+{
+   return ( m_currentEntry < m_entries.size() ) ? &m_entries[m_currentEntry] : 0;
+}
+
+bool ossimGpkgReader::getEncodedTile( ossim_int32 zoomLevel,
+                                      ossim_int32 col,
+                                      ossim_int32 row,
+                                      std::vector<ossim_uint8>& data,
+                                      std::string& mimeType )
+{
+   bool result = false;
+   data.clear();
+   mimeType.clear();
+
+   if ( isOpen() && ( m_currentEntry < m_entries.size() ) )
+   {
+      Connection* conn = acquireConnection();
+      if ( conn )
+      {
+         sqlite3_stmt* pStmt =
+            getTileStatement( *conn, m_entries[m_currentEntry].getTileMatrixSet().m_table_name );
+         if ( pStmt )
+         {
+            sqlite3_bind_int( pStmt, 1, zoomLevel );
+            sqlite3_bind_int( pStmt, 2, col );
+            sqlite3_bind_int( pStmt, 3, row );
+
+            if ( sqlite3_step( pStmt ) == SQLITE_ROW )
+            {
+               // Column 4 is tile_data.
+               const ossim_uint8* blob = (const ossim_uint8*)sqlite3_column_blob( pStmt, 4 );
+               int bytes = sqlite3_column_bytes( pStmt, 4 );
+               if ( blob && ( bytes > 0 ) )
+               {
+                  data.assign( blob, blob + bytes );
+
+                  switch ( ossimGpkgTileRecord::getTileType( &data.front(),
+                                                             (ossim_uint32)bytes ) )
+                  {
+                     case ossimGpkgTileRecord::OSSIM_GPKG_JPEG:
+                     {
+                        mimeType = "image/jpeg";
+                        break;
+                     }
+                     case ossimGpkgTileRecord::OSSIM_GPKG_PNG:
+                     {
+                        mimeType = "image/png";
+                        break;
+                     }
+                     case ossimGpkgTileRecord::OSSIM_GPKG_WEBP:
+                     {
+                        mimeType = "image/webp";
+                        break;
+                     }
+                     default:
+                     {
+                        break;
+                     }
+                  }
+                  result = true;
+               }
+            }
+            sqlite3_reset( pStmt );
+         }
+         releaseConnection( conn );
+      }
+   }
+
+   return result;
+}
+
 ossim_uint32 ossimGpkgReader::getNumberOfDecimationLevels() const
 {
    // Internal overviews.
@@ -738,7 +1141,7 @@ bool ossimGpkgReader::initImageParams()
             if ( (index.x > -1) && (index.y > -1) )
             {
                // Grab a tile:
-               ossimRefPtr<ossimImageData> tile = getTile( 0, index );
+               ossimRefPtr<ossimImageData> tile = getTile( m_connection, 0, index );
                if ( tile.valid() )
                {
                   // Set the bands:
@@ -776,7 +1179,8 @@ bool ossimGpkgReader::initImageParams()
    return result;
 }
 
-ossimRefPtr<ossimImageData> ossimGpkgReader::getTile( ossim_uint32 resLevel,
+ossimRefPtr<ossimImageData> ossimGpkgReader::getTile( Connection& conn,
+                                                      ossim_uint32 resLevel,
                                                       ossimIpt index)
 {
    static const char MODULE[] = "ossimGpkgReader::getTile(resLevel, index)";
@@ -789,7 +1193,7 @@ ossimRefPtr<ossimImageData> ossimGpkgReader::getTile( ossim_uint32 resLevel,
 
    ossimRefPtr<ossimImageData> result = 0;
    
-   if ( m_db )
+   if ( conn.m_db )
    {
       if ( m_currentEntry < m_entries.size() )
       {
@@ -799,126 +1203,145 @@ ossimRefPtr<ossimImageData> ossimGpkgReader::getTile( ossim_uint32 resLevel,
                m_entries[m_currentEntry].getTileMatrix()[resLevel].m_table_name;
             ossim_int32 zoomLevel =
                m_entries[m_currentEntry].getTileMatrix()[resLevel].m_zoom_level;
-            const char *zLeftover;   // Tail of unprocessed SQL
-            sqlite3_stmt *pStmt = 0; // The current SQL statement
-            std::ostringstream sql;
-            sql << "SELECT id, zoom_level, tile_column, tile_row, tile_data from "
-                << tableName
-                << " WHERE zoom_level=" << zoomLevel
-                << " AND tile_column=" << index.x
-                << " AND tile_row=" << index.y;
 
             if (traceDebug())
             {
                ossimNotify(ossimNotifyLevel_DEBUG)
-                  << MODULE << " sql:\n" << sql.str() << "\n";
+                  << MODULE << " table: " << tableName
+                  << " zoom_level: " << zoomLevel << "\n";
             }
-            
-            int rc = sqlite3_prepare_v2(
-               m_db,             // Database handle
-               sql.str().c_str(),// SQL statement, UTF-8 encoded
-               -1,               // Maximum length of zSql in bytes.
-               &pStmt,           // OUT: Statement handle
-               &zLeftover);      // OUT: Pointer to unused portion of zSql
-            if ( rc == SQLITE_OK )
+
+            // Cached statement, bound and reset per tile.
+            sqlite3_stmt *pStmt = getTileStatement( conn, tableName );
+            if ( pStmt )
             {
-               int nCol = sqlite3_column_count( pStmt );
-               if ( nCol )
+               int rc = sqlite3_bind_int( pStmt, 1, zoomLevel );
+               rc |= sqlite3_bind_int( pStmt, 2, index.x );
+               rc |= sqlite3_bind_int( pStmt, 3, index.y );
+               
+               // Read the row:
+               if ( rc == SQLITE_OK )
                {
-                  // Read the row:
                   rc = sqlite3_step(pStmt);
-                  if (rc == SQLITE_ROW) //  || (rc == SQLITE_DONE) )
+               }
+               if (rc == SQLITE_ROW) //  || (rc == SQLITE_DONE) )
+               {
+                  //---
+                  // Blob is not copied.  It is decoded from sqlite memory
+                  // which is good until the sqlite3_reset below.
+                  //---
+                  ossimGpkgTileRecord tile;
+                  tile.setCopyTileFlag(false);
+                  if (tile.init( pStmt ) )
                   {
-                     ossimGpkgTileRecord tile;
-                     tile.setCopyTileFlag(true);
-                     if (tile.init( pStmt ) )
+                     ossimIpt tileSize;
+                     m_entries[m_currentEntry].getTileMatrix()[resLevel].getTileSize(tileSize);
+
+                     ossim_uint32 tileBytes = 0;
+                     const ossim_uint8* tileData = tile.getTileData( tileBytes );
+                     
+                     ossimRefPtr<ossimCodecBase> codec;
+                     switch ( tile.getTileType() )
                      {
-                        ossimIpt tileSize;
-                        m_entries[m_currentEntry].getTileMatrix()[resLevel].getTileSize(tileSize);
-                        ossimRefPtr<ossimCodecBase> codec;
-                        switch ( tile.getTileType() )
+                        case ossimGpkgTileRecord::OSSIM_GPKG_JPEG:
                         {
-                           case ossimGpkgTileRecord::OSSIM_GPKG_JPEG:
+                           if ( decodeJpegTile( conn, tileData, tileBytes ) )
                            {
-                              // we need to cache this instead of allocating a new codec every tile
-                              // for now just getting it to compile with registry implementation
-                              //
-                              if( !m_jpegCodec.valid() )
-                              {
-                                 m_jpegCodec = ossimCodecFactoryRegistry::instance()->
-                                    createCodec(ossimString("jpeg"));
-                              }
-                              
-                              codec = m_jpegCodec.get();
+                              result = conn.m_cacheTile;
                               break;
                            }
-                           case ossimGpkgTileRecord::OSSIM_GPKG_PNG:
+                           
+                           // we need to cache this instead of allocating a new codec every tile
+                           // for now just getting it to compile with registry implementation
+                           //
+                           if( !conn.m_jpegCodec.valid() )
                            {
-                              if( !m_pngCodec.valid() )
-                              {
-                                 m_pngCodec = ossimCodecFactoryRegistry::instance()->
-                                    createCodec(ossimString("png"));
-                              }
-                              codec = m_pngCodec.get();
-                              break;
+                              conn.m_jpegCodec = ossimCodecFactoryRegistry::instance()->
+                                 createCodec(ossimString("jpeg"));
                            }
-                           default:
+                           
+                           codec = conn.m_jpegCodec.get();
+                           break;
+                        }
+                        case ossimGpkgTileRecord::OSSIM_GPKG_PNG:
+                        {
+                           if( !conn.m_pngCodec.valid() )
                            {
-                              if (traceDebug())
-                              {
-                                 ossimNotify(ossimNotifyLevel_WARN)
-                                    << "Unhandled type: " << tile.getTileType() << std::endl;;
-                              }
-                              result = 0;
-                              break;
+                              conn.m_pngCodec = ossimCodecFactoryRegistry::instance()->
+                                 createCodec(ossimString("png"));
                            }
+                           codec = conn.m_pngCodec.get();
+                           break;
                         }
-                        
-                        if ( codec.valid() )
+                        case ossimGpkgTileRecord::OSSIM_GPKG_WEBP:
                         {
-                           if ( codec->decode(tile.m_tile_data, m_cacheTile ) )
+                           // From the plugin's own codec factory, null if built without WebP.
+                           if( !conn.m_webpCodec.valid() )
                            {
-                              result = m_cacheTile;
+                              conn.m_webpCodec = ossimCodecFactoryRegistry::instance()->
+                                 createCodec(ossimString("webp"));
                            }
-                           else
+                           codec = conn.m_webpCodec.get();
+                           break;
+                        }
+                        default:
+                        {
+                           if (traceDebug())
                            {
                               ossimNotify(ossimNotifyLevel_WARN)
-                                 << "WARNING: decode failed...\n";
+                                 << "Unhandled type: " << tile.getTileType() << std::endl;;
                            }
+                           result = 0;
+                           break;
                         }
-                        
-                        if ( result.valid() )
+                     }
+                     
+                     if ( codec.valid() )
+                     {
+                        // Codec interface takes a vector; buffer is reused across tiles.
+                        conn.m_tileBuffer.assign( tileData, tileData + tileBytes );
+                        if ( codec->decode( conn.m_tileBuffer, conn.m_cacheTile ) )
                         {
-                           // Set the tile origin in image space.
-                           ossimIpt origin( index.x*tileSize.x,
-                                            index.y*tileSize.y );
-                           
-                           // Subtract the sub image offset if any:
-                           ossimIpt subImageOffset(0,0);
-                           m_entries[m_currentEntry].getSubImageOffset( resLevel, subImageOffset );
-                           origin -= subImageOffset;
-                           
-                           result->setOrigin( origin );
+                           result = conn.m_cacheTile;
                         }
-                        else if (traceDebug())
+                        else
                         {
                            ossimNotify(ossimNotifyLevel_WARN)
-                              << MODULE << " WARNING: result is null!\n";
+                              << "WARNING: decode failed...\n";
                         }
                      }
+                     
+                     if ( result.valid() )
+                     {
+                        // Set the tile origin in image space.
+                        ossimIpt origin( index.x*tileSize.x,
+                                         index.y*tileSize.y );
+                        
+                        // Subtract the sub image offset if any:
+                        ossimIpt subImageOffset(0,0);
+                        m_entries[m_currentEntry].getSubImageOffset( resLevel, subImageOffset );
+                        origin -= subImageOffset;
+                        
+                        result->setOrigin( origin );
+                     }
+                     else if (traceDebug())
+                     {
+                        ossimNotify(ossimNotifyLevel_WARN)
+                           << MODULE << " WARNING: result is null!\n";
+                     }
                   }
-                  
-               } // Matches: if ( nCol )
-               
-            } // Matches: if ( rc == SQLITE_OK )
+               }
 
-            sqlite3_finalize(pStmt);
+               sqlite3_reset(pStmt);
+               sqlite3_clear_bindings(pStmt);
+               
+            } // Matches: if ( pStmt )
             
          } // Matches: if(resLevel<m_entries[m_currentEntry].getTileMatrix().size())
          
       } // Matches: if ( m_currentEntry < m_entries.size() )
       
-   } // Matches: if ( m_db )
+   } // Matches: if ( conn.m_db )
 
    if (traceDebug())
    {
@@ -930,6 +1353,315 @@ ossimRefPtr<ossimImageData> ossimGpkgReader::getTile( ossim_uint32 resLevel,
    
 } // End: ossimGpkgReader::getTile( resLevel, index )
 
+sqlite3_stmt* ossimGpkgReader::getTileStatement( Connection& conn,
+                                                 const std::string& tableName )
+{
+   sqlite3_stmt* pStmt = 0;
+   
+   std::map<std::string, sqlite3_stmt*>::const_iterator i = conn.m_tileStatements.find( tableName );
+   if ( i != conn.m_tileStatements.end() )
+   {
+      pStmt = i->second;
+   }
+   else if ( conn.m_db )
+   {
+      std::ostringstream sql;
+      sql << "SELECT id, zoom_level, tile_column, tile_row, tile_data from "
+          << tableName
+          << " WHERE zoom_level=? AND tile_column=? AND tile_row=?";
+      
+      if (traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << "ossimGpkgReader::getTileStatement sql:\n" << sql.str() << "\n";
+      }
+
+      int rc = sqlite3_prepare_v2( conn.m_db,              // Database handle
+                                   sql.str().c_str(), // SQL statement, UTF-8 encoded
+                                   -1,                // Maximum length of zSql in bytes.
+                                   &pStmt,            // OUT: Statement handle
+                                   0 );
+      if ( rc == SQLITE_OK )
+      {
+         conn.m_tileStatements[tableName] = pStmt;
+      }
+      else
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "sqlite3_prepare_v2 error: " << sqlite3_errmsg(conn.m_db) << std::endl;
+         sqlite3_finalize( pStmt );
+         pStmt = 0;
+      }
+   }
+
+   return pStmt;
+}
+
+void ossimGpkgReader::finalizeTileStatements( Connection& conn )
+{
+   std::map<std::string, sqlite3_stmt*>::iterator i = conn.m_tileStatements.begin();
+   while ( i != conn.m_tileStatements.end() )
+   {
+      sqlite3_finalize( i->second );
+      ++i;
+   }
+   conn.m_tileStatements.clear();
+}
+
+bool ossimGpkgReader::decodeJpegTile( Connection& conn,
+                                      const ossim_uint8* data,
+                                      ossim_uint32 size )
+{
+   bool status = false;
+
+   if ( data && size )
+   {
+      jpeg_decompress_struct cinfo;
+      GpkgJpegErrorMgr jerr;
+      cinfo.err = jpeg_std_error( &jerr.pub );
+      jerr.pub.error_exit = gpkgJpegErrorExit;
+
+      // Establish the setjmp return context for gpkgJpegErrorExit to use.
+      if ( setjmp( jerr.setjmp_buffer ) )
+      {
+         jpeg_destroy_decompress( &cinfo );
+         return false;
+      }
+
+      jpeg_create_decompress( &cinfo );
+
+      // Read straight from the sqlite blob.
+      ossimJpegMemorySrc( &cinfo, data, static_cast<std::size_t>(size) );
+
+      jpeg_read_header( &cinfo, TRUE );
+
+      if ( ( cinfo.out_color_space == JCS_GRAYSCALE ) ||
+           ( cinfo.out_color_space == JCS_RGB ) )
+      {
+         jpeg_start_decompress( &cinfo );
+
+         const ossim_uint32 SAMPLES = cinfo.output_width;
+         const ossim_uint32 LINES   = cinfo.output_height;
+         const ossim_uint32 BANDS   = cinfo.output_components;
+
+         if ( !conn.m_cacheTile.valid() ||
+              ( conn.m_cacheTile->getScalarType() != OSSIM_UINT8 ) ||
+              ( conn.m_cacheTile->getNumberOfBands() != BANDS ) ||
+              ( conn.m_cacheTile->getWidth() != SAMPLES ) ||
+              ( conn.m_cacheTile->getHeight() != LINES ) )
+         {
+            conn.m_cacheTile = new ossimImageData( 0, OSSIM_UINT8, BANDS, SAMPLES, LINES );
+            conn.m_cacheTile->initialize();
+         }
+         
+         // Row buffer from the jpeg pool so a longjmp cannot leak it.
+         JSAMPARRAY rowBuffer = (*cinfo.mem->alloc_sarray)
+            ( (j_common_ptr)&cinfo, JPOOL_IMAGE, SAMPLES * BANDS, 1 );
+
+         ossim_uint8* buf[3]; // Gray or rgb.
+         for ( ossim_uint32 band = 0; band < BANDS; ++band )
+         {
+            buf[band] = conn.m_cacheTile->getUcharBuf( band );
+         }
+
+         // Pixel interleaved to band sequential:
+         while ( cinfo.output_scanline < LINES )
+         {
+            jpeg_read_scanlines( &cinfo, rowBuffer, 1 );
+            const ossim_uint8* in = rowBuffer[0];
+            for ( ossim_uint32 sample = 0; sample < SAMPLES; ++sample )
+            {
+               for ( ossim_uint32 band = 0; band < BANDS; ++band )
+               {
+                  *(buf[band]++) = *(in++);
+               }
+            }
+         }
+
+         jpeg_finish_decompress( &cinfo );
+
+         conn.m_cacheTile->validate();
+         status = true;
+      }
+
+      jpeg_destroy_decompress( &cinfo );
+   }
+
+   return status;
+   
+} // End: ossimGpkgReader::decodeJpegTile( ... )
+
+ossimRefPtr<ossimImageData> ossimGpkgReader::getDecodedTile( Connection& conn,
+                                                             ossim_uint32 resLevel,
+                                                             const ossimIpt& index )
+{
+   ossimRefPtr<ossimImageData> tile = 0;
+   
+   if ( m_decodedTileCache->getMaxBytes() )
+   {
+      DecodedTileCache::Key key = { m_currentEntry, resLevel, index.x, index.y };
+      if ( m_decodedTileCache->get( key, tile ) == false )
+      {
+         tile = getTile( conn, resLevel, index );
+         if ( tile.valid() )
+         {
+            // Keep the decoded tile; the next decode on conn allocates anew.
+            conn.m_cacheTile = 0;
+         }
+         m_decodedTileCache->add( key, tile );
+      }
+   }
+   else
+   {
+      tile = getTile( conn, resLevel, index );
+   }
+
+   return tile;
+}
+
+void ossimGpkgReader::prefetchNeighbors( ossim_uint32 resLevel,
+                                         const std::vector<ossimIpt>& tileIndexes )
+{
+   if ( ( m_currentEntry < m_entries.size() ) &&
+        ( resLevel < m_entries[m_currentEntry].getTileMatrix().size() ) &&
+        m_decodedTileCache->getMaxBytes() )
+   {
+      {
+         std::lock_guard<std::mutex> lock( m_connectionMutex );
+         if ( !m_prefetcher )
+         {
+            m_prefetcher = new TilePrefetcher( this );
+         }
+      }
+      
+      const ossimGpkgTileMatrixRecord& matrix =
+         m_entries[m_currentEntry].getTileMatrix()[resLevel];
+
+      // Bounds of the request:
+      ossimIpt ul = tileIndexes[0];
+      ossimIpt lr = tileIndexes[0];
+      for ( std::size_t i = 1; i < tileIndexes.size(); ++i )
+      {
+         ul.x = std::min( ul.x, tileIndexes[i].x );
+         ul.y = std::min( ul.y, tileIndexes[i].y );
+         lr.x = std::max( lr.x, tileIndexes[i].x );
+         lr.y = std::max( lr.y, tileIndexes[i].y );
+      }
+
+      // Ring of tiles around it, i.e. the 8-neighborhood for a single tile.
+      for ( ossim_int32 y = ul.y - 1; y <= lr.y + 1; ++y )
+      {
+         for ( ossim_int32 x = ul.x - 1; x <= lr.x + 1; ++x )
+         {
+            if ( ( y > ul.y - 1 ) && ( y < lr.y + 1 ) && ( x > ul.x - 1 ) && ( x < lr.x + 1 ) )
+            {
+               continue; // Inside the request.
+            }
+            if ( ( x < 0 ) || ( y < 0 ) ||
+                 ( x >= matrix.m_matrix_width ) || ( y >= matrix.m_matrix_height ) )
+            {
+               continue;
+            }
+            
+            DecodedTileCache::Key key = { m_currentEntry, resLevel, x, y };
+            if ( !m_decodedTileCache->contains( key ) )
+            {
+               m_prefetcher->request( resLevel, ossimIpt( x, y ) );
+            }
+         }
+      }
+   }
+}
+
+void ossimGpkgReader::stopPrefetch()
+{
+   std::lock_guard<std::mutex> lock( m_connectionMutex );
+   if ( m_prefetcher )
+   {
+      delete m_prefetcher;
+      m_prefetcher = 0;
+   }
+}
+
+ossimGpkgReader::Connection* ossimGpkgReader::acquireConnection()
+{
+   if ( !m_connectionPoolFlag )
+   {
+      return &m_connection;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock( m_connectionMutex );
+      if ( m_idleConnections.size() )
+      {
+         Connection* conn = m_idleConnections.back();
+         m_idleConnections.pop_back();
+         return conn;
+      }
+   }
+
+   // Pool grows to the number of concurrent readers.
+   Connection* conn = new Connection();
+   if ( openConnection( *conn ) )
+   {
+      std::lock_guard<std::mutex> lock( m_connectionMutex );
+      m_pooledConnections.push_back( conn );
+   }
+   else
+   {
+      delete conn;
+      conn = 0;
+   }
+   return conn;
+}
+
+void ossimGpkgReader::releaseConnection( Connection* conn )
+{
+   if ( conn && ( conn != &m_connection ) )
+   {
+      std::lock_guard<std::mutex> lock( m_connectionMutex );
+      m_idleConnections.push_back( conn );
+   }
+}
+
+bool ossimGpkgReader::openConnection( Connection& conn ) const
+{
+   // Memory map up to 256 MiB of the file; 16 MiB page cache per connection.
+   static const char PRAGMAS[] = "PRAGMA mmap_size=268435456; PRAGMA cache_size=-16384;";
+   
+   bool status = false;
+   int rc = sqlite3_open_v2( theImageFile.c_str(), &conn.m_db,
+                             SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX |
+                             SQLITE_OPEN_PRIVATECACHE, 0 );
+   if ( rc == SQLITE_OK )
+   {
+      sqlite3_exec( conn.m_db, PRAGMAS, 0, 0, 0 );
+      status = true;
+   }
+   else
+   {
+      ossimNotify(ossimNotifyLevel_WARN)
+         << "ossimGpkgReader::openConnection WARNING: sqlite3_open_v2 error: "
+         << ( conn.m_db ? sqlite3_errmsg(conn.m_db) : "out of memory" ) << std::endl;
+      sqlite3_close( conn.m_db );
+      conn.m_db = 0;
+   }
+   return status;
+}
+
+void ossimGpkgReader::closeConnectionPool()
+{
+   std::lock_guard<std::mutex> lock( m_connectionMutex );
+   for ( std::size_t i = 0; i < m_pooledConnections.size(); ++i )
+   {
+      finalizeTileStatements( *m_pooledConnections[i] );
+      sqlite3_close( m_pooledConnections[i]->m_db );
+      delete m_pooledConnections[i];
+   }
+   m_pooledConnections.clear();
+   m_idleConnections.clear();
+}
+
 ossimRefPtr<ossimImageData> ossimGpkgReader::uncompressPngTile( const ossimGpkgTileRecord& tile,
                                                                 const ossimIpt& tileSize )
 {
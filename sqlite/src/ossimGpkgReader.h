@@ -18,11 +18,15 @@
 #include "ossimGpkgTileEntry.h"
 #include <ossim/imaging/ossimCodecBase.h>
 
+#include <map>
+#include <mutex>
+#include <string>
 #include <vector>
 
 class ossimGpkgTileRecord;
 class ossimImageData;
 struct sqlite3;
+struct sqlite3_stmt;
 
 class ossimGpkgReader : public ossimImageHandler
 {
@@ -115,6 +119,21 @@ public:
     * Current property name handled:
     * "scale" One double value representing the scale in meters per pixel. It is
     * assumed the scale is same for x and y direction.
+    *
+    * "connection_pool" bool, default=false.  If true, tiles are read through
+    * a pool of read only connections, one per concurrent caller, each with
+    * its own codecs and decode buffers.  getTile may then be called from
+    * several threads at once for the internal zoom levels; each call to
+    * getTile(rect, resLevel) returns a new tile.  Changing the entry or
+    * closing must still be serialized with reads.
+    *
+    * "tile_cache_size" Decoded tile cache size in MiB, default=0 (off).
+    * Decoded tiles are shared by all readers and kept in least recently used
+    * order.
+    *
+    * "tile_prefetch" bool, default=false.  If true, the tiles around each
+    * request are read and decoded into the tile cache on a background
+    * thread.  Needs the tile cache.
     * 
     * @param property to set.
     */
@@ -200,6 +219,30 @@ public:
     */
    virtual bool setCurrentEntry(ossim_uint32 entryIdx);
 
+   /** @return The current tile entry or null if not open. */
+   const ossimGpkgTileEntry* getTileEntry() const;
+
+   /**
+    * @brief Gets a stored tile from the current entry as is, without
+    * decoding.
+    *
+    * For repackaging tiles, e.g. serving them over a tile protocol or copying
+    * them to another tile store with the same tiling.
+    *
+    * @param zoomLevel GeoPackage zoom_level.
+    * @param col tile_column.
+    * @param row tile_row.
+    * @param data Initialized by this with the encoded tile_data blob.
+    * @param mimeType Initialized by this to "image/jpeg", "image/png",
+    * "image/webp" or empty if the blob type is not known.
+    * @return true on success, false if tile is missing or error.
+    */
+   bool getEncodedTile( ossim_int32 zoomLevel,
+                        ossim_int32 col,
+                        ossim_int32 row,
+                        std::vector<ossim_uint8>& data,
+                        std::string& mimeType );
+
    /**
     * @brief Returns the number of decimation levels.
     * 
@@ -238,18 +281,102 @@ private:
    /** @brief Allocates m_tile.  Called on first getTile. */
    void allocate();
 
+   /**
+    * @brief Tile read state.  The reader's own uses m_db; in connection pool
+    * mode each concurrent reader gets one with its own connection.
+    */
+   struct Connection
+   {
+      Connection();
+      
+      sqlite3*                             m_db;
+      
+      /** Prepared tile select statements keyed by tile table name. */
+      std::map<std::string, sqlite3_stmt*> m_tileStatements;
+      
+      ossimRefPtr<ossimImageData>          m_cacheTile;
+
+      /** Reused input buffer for codecs. */
+      std::vector<ossim_uint8>             m_tileBuffer;
+      
+      ossimRefPtr<ossimCodecBase>          m_jpegCodec;
+      ossimRefPtr<ossimCodecBase>          m_pngCodec;
+      ossimRefPtr<ossimCodecBase>          m_webpCodec;
+   };
+
    /**
     * @note this method assumes that setImageRectangle has been called on
     * theTile.
     */
-   void fillTile( ossim_uint32 resLevel,
+   void fillTile( Connection& conn,
+                  ossim_uint32 resLevel,
                   const ossimIrect& tileRect,
                   const ossimIrect& clipRect,
                   ossimImageData* tile );
 
-   ossimRefPtr<ossimImageData> getTile( ossim_uint32 resLevel,
+   /** @return conn.m_cacheTile with the tile or null if missing or error. */
+   ossimRefPtr<ossimImageData> getTile( Connection& conn,
+                                        ossim_uint32 resLevel,
                                         ossimIpt index );
 
+   /**
+    * @brief Gets the tile select statement for table, preparing it on first
+    * use.  Parameters are zoom_level, tile_column and tile_row.  Caller must
+    * sqlite3_reset after use.
+    * @return Statement or 0 on error.
+    */
+   sqlite3_stmt* getTileStatement( Connection& conn, const std::string& tableName );
+
+   /** @brief Finalizes cached statements.  Must be called before closing conn.m_db. */
+   void finalizeTileStatements( Connection& conn );
+
+   /**
+    * @brief Decodes gray or rgb jpeg straight from memory to conn.m_cacheTile.
+    * @param data Blob, may be sqlite owned.
+    * @param size Bytes in data.
+    * @return true on success, false if not handled or error.
+    */
+   bool decodeJpegTile( Connection& conn, const ossim_uint8* data, ossim_uint32 size );
+
+   /**
+    * @brief Gets a connection for this thread's read.  Must be given back
+    * with releaseConnection.
+    * @return m_connection, or an idle or new pooled connection in
+    * connection pool mode.  Null on error.
+    */
+   Connection* acquireConnection();
+
+   void releaseConnection( Connection* conn );
+
+   /** @brief Opens a read only, no mutex, private cache connection. */
+   bool openConnection( Connection& conn ) const;
+
+   /** @brief Closes and deletes all pooled connections. */
+   void closeConnectionPool();
+
+   class DecodedTileCache;
+   class TilePrefetcher;
+
+   /**
+    * @brief Gets a tile from the decoded tile cache, reading and caching it
+    * on a miss.  Without the cache this is getTile(conn, resLevel, index).
+    * @return Tile or null if missing.  Cached tiles are shared and must not
+    * be modified.
+    */
+   ossimRefPtr<ossimImageData> getDecodedTile( Connection& conn,
+                                               ossim_uint32 resLevel,
+                                               const ossimIpt& index );
+
+   /**
+    * @brief Queues the ring of tiles around tileIndexes for the prefetch
+    * thread, starting it if needed.
+    */
+   void prefetchNeighbors( ossim_uint32 resLevel,
+                           const std::vector<ossimIpt>& tileIndexes );
+
+   /** @brief Stops and deletes the prefetch thread. */
+   void stopPrefetch();
+
    /**
     * @brief Uncompresses png tile to m_cacheTile.
     * @param tile Tile record.
@@ -272,7 +399,6 @@ private:
    ossimRefPtr<ossimImageHandler> m_ih;
    
    ossimRefPtr<ossimImageData> m_tile;
-   ossimRefPtr<ossimImageData> m_cacheTile;
    // std::ifstream               m_str;
    sqlite3*                    m_db;
    ossim_uint32                m_currentEntry;
@@ -283,8 +409,17 @@ private:
    
    std::vector<ossimGpkgTileEntry> m_entries;
 
-   mutable ossimRefPtr<ossimCodecBase> m_jpegCodec;
-   mutable ossimRefPtr<ossimCodecBase> m_pngCodec;
+   /** Tile read state used when not in connection pool mode. */
+   Connection                  m_connection;
+
+   bool                        m_connectionPoolFlag;
+   std::vector<Connection*>    m_pooledConnections;
+   std::vector<Connection*>    m_idleConnections;
+   std::mutex                  m_connectionMutex;
+
+   DecodedTileCache*           m_decodedTileCache;
+   TilePrefetcher*             m_prefetcher;
+   bool                        m_prefetchFlag;
 
 TYPE_DATA
 };
@@ -27,7 +27,9 @@ ossimGpkgTileRecord::ossimGpkgTileRecord()
    m_tile_column(0),
    m_tile_row(0),
    m_tile_data(0),
-   m_copy_tile_flag(true)
+   m_copy_tile_flag(true),
+   m_tile_blob(0),
+   m_tile_blob_size(0)
 {
 }
 
@@ -38,7 +40,9 @@ ossimGpkgTileRecord::ossimGpkgTileRecord(const ossimGpkgTileRecord& obj)
    m_tile_column(obj.m_tile_column),
    m_tile_row(obj.m_tile_row),
    m_tile_data(obj.m_tile_data),
-   m_copy_tile_flag(obj.m_copy_tile_flag)
+   m_copy_tile_flag(obj.m_copy_tile_flag),
+   m_tile_blob(obj.m_tile_blob),
+   m_tile_blob_size(obj.m_tile_blob_size)
 {
 }
 
@@ -53,6 +57,8 @@ const ossimGpkgTileRecord& ossimGpkgTileRecord::operator=(
       m_tile_row = obj.m_tile_row;
       m_tile_data = obj.m_tile_data;
       m_copy_tile_flag = obj.m_copy_tile_flag;
+      m_tile_blob = obj.m_tile_blob;
+      m_tile_blob_size = obj.m_tile_blob_size;
    }
    return *this;
 }
@@ -67,6 +73,9 @@ bool ossimGpkgTileRecord::init( sqlite3_stmt* pStmt )
    
    bool status = false;
 
+   m_tile_blob = 0;
+   m_tile_blob_size = 0;
+
    if ( pStmt )
    {
       const ossim_int32 EXPECTED_COLUMNS = 5;
@@ -131,6 +140,13 @@ bool ossimGpkgTileRecord::init( sqlite3_stmt* pStmt )
                                      sqlite3_column_blob( pStmt, i ), bytes );
                      }
                   }
+                  else
+                  {
+                     // Caller decodes straight from sqlite memory.
+                     m_tile_data.clear();
+                     m_tile_blob = (const ossim_uint8*)sqlite3_column_blob( pStmt, i );
+                     m_tile_blob_size = (ossim_uint32)sqlite3_column_bytes( pStmt, i );
+                  }
                }
                else
                {
@@ -219,6 +235,23 @@ void ossimGpkgTileRecord::setCopyTileFlag( bool flag )
    m_copy_tile_flag = flag;
 }
 
+const ossim_uint8* ossimGpkgTileRecord::getTileData( ossim_uint32& size ) const
+{
+   const ossim_uint8* data = 0;
+   size = 0;
+   if ( m_tile_data.size() )
+   {
+      data = &m_tile_data.front();
+      size = (ossim_uint32)m_tile_data.size();
+   }
+   else if ( m_tile_blob )
+   {
+      data = m_tile_blob;
+      size = m_tile_blob_size;
+   }
+   return data;
+}
+
 std::ostream& ossimGpkgTileRecord::print(std::ostream& out) const
 {
    out << "id: " << m_id
@@ -258,31 +291,47 @@ void ossimGpkgTileRecord::getTileIndex( ossimIpt& index ) const
 }
 
 ossimGpkgTileRecord::ossimGpkgTileType ossimGpkgTileRecord::getTileType() const
+{
+   ossim_uint32 size = 0;
+   const ossim_uint8* data = getTileData( size );
+   return getTileType( data, size );
+}
+
+ossimGpkgTileRecord::ossimGpkgTileType ossimGpkgTileRecord::getTileType(
+   const ossim_uint8* data, ossim_uint32 size )
 {
    ossimGpkgTileType result = ossimGpkgTileRecord::OSSIM_GPKG_UNKNOWN;
 
-   if ( m_tile_data.size() > 7 )
+   if ( data && ( size > 7 ) )
    {
-      if ( (m_tile_data[0] == 0xff) &&
-           (m_tile_data[1] == 0xd8) &&
-           (m_tile_data[2] == 0xff) )
+      if ( (data[0] == 0xff) &&
+           (data[1] == 0xd8) &&
+           (data[2] == 0xff) )
       {
-         if ( (m_tile_data[3] == 0xe0) || (m_tile_data[3] == 0xdb) )
+         if ( (data[3] == 0xe0) || (data[3] == 0xdb) )
          {
             result = ossimGpkgTileRecord::OSSIM_GPKG_JPEG;
          }
       }
-      else if ( ( m_tile_data[0] == 0x89 ) &&
-                ( m_tile_data[1] == 0x50 ) &&
-                ( m_tile_data[2] == 0x4e ) &&
-                ( m_tile_data[3] == 0x47 ) &&
-                ( m_tile_data[4] == 0x0d ) &&
-                ( m_tile_data[5] == 0x0a ) &&
-                ( m_tile_data[6] == 0x1a ) &&
-                ( m_tile_data[7] == 0x0a ) )
+      else if ( ( data[0] == 0x89 ) &&
+                ( data[1] == 0x50 ) &&
+                ( data[2] == 0x4e ) &&
+                ( data[3] == 0x47 ) &&
+                ( data[4] == 0x0d ) &&
+                ( data[5] == 0x0a ) &&
+                ( data[6] == 0x1a ) &&
+                ( data[7] == 0x0a ) )
       {
          result = ossimGpkgTileRecord::OSSIM_GPKG_PNG;
       }
+      else if ( ( size > 11 ) &&
+                ( data[0] == 'R' ) && ( data[1] == 'I' ) &&
+                ( data[2] == 'F' ) && ( data[3] == 'F' ) &&
+                ( data[8] == 'W' ) && ( data[9] == 'E' ) &&
+                ( data[10] == 'B' ) && ( data[11] == 'P' ) )
+      {
+         result = ossimGpkgTileRecord::OSSIM_GPKG_WEBP;
+      }
 
 #if 0 /* Please keep for debug. (drb) */
       if ( result == ossimGpkgTileRecord::OSSIM_GPKG_UNKNOWN )
@@ -294,7 +343,7 @@ ossimGpkgTileRecord::ossimGpkgTileType ossimGpkgTileRecord::getTileType() const
             {
                for ( int i = 0; i < 8; ++i )
                {
-                  std::cout << std::hex << int(m_tile_data[i]) << " ";
+                  std::cout << std::hex << int(data[i]) << " ";
                }
                std::cout << std::dec << "\n";
                traced = true;
@@ -322,6 +371,11 @@ std::string ossimGpkgTileRecord::getTileMediaType() const
          result = "image/png";
          break;
       }
+      case ossimGpkgTileRecord::OSSIM_GPKG_WEBP:
+      {
+         result = "image/webp";
+         break;
+      }
       default:
       {
          result = "unknown";
@@ -30,7 +30,8 @@ public:
    {
       OSSIM_GPKG_UNKNOWN = 0,
       OSSIM_GPKG_JPEG    = 1,
-      OSSIM_GPKG_PNG     = 2
+      OSSIM_GPKG_PNG     = 2,
+      OSSIM_GPKG_WEBP    = 3
    };
 
    /** @brief default constructor */
@@ -60,8 +61,24 @@ public:
     */   
    static bool createTable( sqlite3* db, const std::string& tableName );  
 
+   /**
+    * @brief Sets the copy tile flag.
+    *
+    * If false init does not copy the tile blob.  It is then only reachable
+    * through getTileData which points into sqlite memory that goes away on
+    * the next sqlite3_step(), sqlite3_reset() or sqlite3_finalize().
+    *
+    * @param flag Default is true.
+    */
    void setCopyTileFlag( bool flag );
 
+   /**
+    * @brief Gets the tile blob, copied or not.
+    * @param size Initialized with the size in bytes.
+    * @return Pointer to the blob or 0 if none.
+    */
+   const ossim_uint8* getTileData( ossim_uint32& size ) const;
+
    /**
     * @brief Print method.
     *
@@ -89,6 +106,9 @@ public:
    /** @return Tile type from signature block. */
    ossimGpkgTileType getTileType() const;
 
+   /** @return Tile type from signature block of data. */
+   static ossimGpkgTileType getTileType( const ossim_uint8* data, ossim_uint32 size );
+
    /** @return Tile media type from signature block. e.g. "image/png" */
    std::string getTileMediaType() const;
 
@@ -98,6 +118,10 @@ public:
    ossim_int32 m_tile_row;
    std::vector<ossim_uint8> m_tile_data;
    bool m_copy_tile_flag;
+
+   /** Uncopied blob from last init, owned by sqlite. */
+   const ossim_uint8* m_tile_blob;
+   ossim_uint32 m_tile_blob_size;
 };
 
 #endif /* #ifndef ossimGpkgTileRecord_HEADER */
@@ -14,6 +14,7 @@
 #include "ossimGpkgWriter.h"
 #include "ossimGpkgContentsRecord.h"
 #include "ossimGpkgNsgTileMatrixExtentRecord.h"
+#include "ossimGpkgReader.h"
 #include "ossimGpkgSpatialRefSysRecord.h"
 #include "ossimGpkgTileEntry.h"
 #include "ossimGpkgTileRecord.h"
@@ -38,11 +39,14 @@
 #include <ossim/base/ossimTrace.h>
 #include <ossim/base/ossimViewInterface.h>
 #include <ossim/base/ossimVisitor.h>
+#include <ossim/base/ossimObjectFactoryRegistry.h>
 
 #include <ossim/imaging/ossimCacheTileSource.h>
 #include <ossim/imaging/ossimCodecFactoryRegistry.h>
 #include <ossim/imaging/ossimImageCombiner.h>
+#include <ossim/imaging/ossimImageChain.h>
 #include <ossim/imaging/ossimImageData.h>
+#include <ossim/imaging/ossimImageHandler.h>
 #include <ossim/imaging/ossimImageSource.h>
 #include <ossim/imaging/ossimJpegMemDest.h>
 #include <ossim/imaging/ossimRectangleCutFilter.h>
@@ -60,8 +64,16 @@
 #include <sqlite3.h>
 
 #include <algorithm> /* std::sort */
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 RTTI_DEF1(ossimGpkgWriter, "ossimGpkgWriter", ossimImageFileWriter)
 
@@ -71,25 +83,638 @@ static const std::string ADD_LEVELS_KW                 = "add_levels";
 static const std::string ALIGN_TO_GRID_KW              = "align_to_grid";
 static const std::string APPEND_KW                     = "append";
 static const std::string BATCH_SIZE_KW                 = "batch_size";
+static const std::string BULK_INGEST_KW                = "bulk_ingest";
+static const std::string CACHE_UNIFORM_TILES_KW        = "cache_uniform_tiles";
 static const std::string CLIP_EXTENTS_KW               = "clip_extents";
 static const std::string CLIP_EXTENTS_ALIGN_TO_GRID_KW = "clip_extents_align_to_grid";
 static const std::string COMPRESSION_LEVEL_KW          = "compression_level";
+static const std::string COPY_ENCODED_TILES_KW         = "copy_encoded_tiles";
 static const std::string DEFAULT_FILE_NAME             = "output.gpkg";
 static const std::string EPSG_KW                       = "epsg";
 static const std::string INCLUDE_BLANK_TILES_KW        = "include_blank_tiles";
+static const std::string REDUCE_LEVELS_KW              = "reduce_levels";
+static const std::string THREADS_KW                    = "threads";
 static const std::string TILE_SIZE_KW                  = "tile_size";
 static const std::string TILE_TABLE_NAME_KW            = "tile_table_name";
 static const std::string TRUE_KW                       = "true";
 static const std::string USE_PROJECTION_EXTENTS_KW     = "use_projection_extents";
+static const std::string WEBP_LOSSLESS_KW              = "webp_lossless";
 static const std::string WRITER_MODE_KW                = "writer_mode";
 static const std::string ZOOM_LEVELS_KW                = "zoom_levels";
 
+// Bulk ingest progress, one record per finished zoom level.
+static const std::string INGEST_PROGRESS_TABLE         = "ossim_gpkg_ingest";
+
+// Zoom level of the job record in INGEST_PROGRESS_TABLE.
+static const ossim_int32 INGEST_JOB_LEVEL = -1;
+
 //---
 // For trace debugging (to enable at runtime do:
 // your_app -T "ossimGpkgWriter:debug" your_app_args
 //---
 static ossimTrace traceDebug("ossimGpkgWriter:debug");
 
+//---
+// Encoded tile handed from an encoding thread to the sqlite writer.
+//---
+struct ossimGpkgWriter::EncodedTile
+{
+   ossim_int32              m_zoomLevel;
+   ossim_int64              m_row;
+   ossim_int64              m_col;
+   std::vector<ossim_uint8> m_data; // Empty if tile is not written.
+};
+
+//---
+// Bounded queue between the encoding threads and the sqlite writer.
+// push blocks while full so encoders cannot run ahead of the database.
+//---
+class ossimGpkgWriter::EncodedTileQueue
+{
+public:
+   EncodedTileQueue( std::size_t capacity, ossim_uint32 producers )
+      : m_mutex(),
+        m_notFull(),
+        m_notEmpty(),
+        m_tiles(),
+        m_capacity( capacity ),
+        m_producers( producers ),
+        m_closed( false )
+   {}
+
+   /** @return false if queue was closed. */
+   bool push( EncodedTile& tile )
+   {
+      std::unique_lock<std::mutex> lock( m_mutex );
+      m_notFull.wait( lock, [this]{ return m_closed || ( m_tiles.size() < m_capacity ); } );
+      if ( m_closed )
+      {
+         return false;
+      }
+      m_tiles.push_back( EncodedTile() );
+      m_tiles.back().m_zoomLevel = tile.m_zoomLevel;
+      m_tiles.back().m_row = tile.m_row;
+      m_tiles.back().m_col = tile.m_col;
+      m_tiles.back().m_data.swap( tile.m_data );
+      m_notEmpty.notify_one();
+      return true;
+   }
+
+   /** @return false when closed, or empty with all producers done. */
+   bool pop( EncodedTile& tile )
+   {
+      std::unique_lock<std::mutex> lock( m_mutex );
+      m_notEmpty.wait( lock, [this]{ return m_closed || m_tiles.size() || !m_producers; } );
+      if ( m_closed || m_tiles.empty() )
+      {
+         return false;
+      }
+      tile.m_zoomLevel = m_tiles.front().m_zoomLevel;
+      tile.m_row = m_tiles.front().m_row;
+      tile.m_col = m_tiles.front().m_col;
+      tile.m_data.swap( m_tiles.front().m_data );
+      m_tiles.pop_front();
+      m_notFull.notify_one();
+      return true;
+   }
+
+   void producerDone()
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      --m_producers;
+      m_notEmpty.notify_all();
+   }
+
+   /** Abort: wakes everyone; push and pop return false from here on. */
+   void close()
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_closed = true;
+      m_notFull.notify_all();
+      m_notEmpty.notify_all();
+   }
+
+   bool isClosed()
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      return m_closed;
+   }
+
+private:
+   std::mutex              m_mutex;
+   std::condition_variable m_notFull;
+   std::condition_variable m_notEmpty;
+   std::deque<EncodedTile> m_tiles;
+   std::size_t             m_capacity;
+   ossim_uint32            m_producers;
+   bool                    m_closed;
+};
+
+//---
+// Tile matrix of one zoom level when building reduced or copied levels.
+//---
+struct ossimGpkgWriter::PyramidLevel
+{
+   ossim_int32 m_zoomLevel;
+   ossimIrect  m_expandedAoi;
+   ossimIrect  m_clippedAoi;
+   ossimIpt    m_matrixSize;
+   ossimDpt    m_gsd;
+};
+
+//---
+// Encoded tiles keyed by the single value of each band, shared by all
+// encoding threads.  Entries are small and few, e.g. water, fill, cloud.
+//---
+class ossimGpkgWriter::UniformTileCache
+{
+public:
+   struct Key
+   {
+      ossimDataObjectStatus    m_status; // Picks full or partial codec.
+      ossimScalarType          m_scalar;
+      ossim_uint32             m_width;
+      ossim_uint32             m_height;
+      std::vector<ossim_uint8> m_value;  // One sample per band.
+
+      bool operator<( const Key& rhs ) const
+      {
+         if ( m_status != rhs.m_status ) return m_status < rhs.m_status;
+         if ( m_scalar != rhs.m_scalar ) return m_scalar < rhs.m_scalar;
+         if ( m_width != rhs.m_width ) return m_width < rhs.m_width;
+         if ( m_height != rhs.m_height ) return m_height < rhs.m_height;
+         return m_value < rhs.m_value;
+      }
+   };
+
+   UniformTileCache() : m_mutex(), m_tiles(), m_enabled( true ) {}
+
+   /** @brief Empties cache, i.e. on codec change. */
+   void reset( bool enabled )
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      m_tiles.clear();
+      m_enabled = enabled;
+   }
+
+   bool isEnabled() const { return m_enabled; }
+
+   bool get( const Key& key, std::vector<ossim_uint8>& codecTile )
+   {
+      std::lock_guard<std::mutex> lock( m_mutex );
+      std::map< Key, std::vector<ossim_uint8> >::const_iterator i = m_tiles.find( key );
+      if ( i != m_tiles.end() )
+      {
+         codecTile = i->second;
+         return true;
+      }
+      return false;
+   }
+
+   void add( const Key& key, const std::vector<ossim_uint8>& codecTile )
+   {
+      // Guard against noise, e.g. a 16 bit ramp of single value tiles.
+      static const std::size_t MAX_TILES = 1024;
+      
+      std::lock_guard<std::mutex> lock( m_mutex );
+      if ( m_tiles.size() < MAX_TILES )
+      {
+         m_tiles[key] = codecTile;
+      }
+   }
+
+private:
+   std::mutex m_mutex;
+   std::map< Key, std::vector<ossim_uint8> > m_tiles;
+   bool m_enabled;
+};
+
+//---
+// Reads and decodes tiles already stored in a tile table.
+//---
+class ossimGpkgWriter::StoredTileReader
+{
+public:
+   StoredTileReader( sqlite3* db, const std::string& tableName )
+      : m_pStmt( 0 ),
+        m_jpegCodec( ossimCodecFactoryRegistry::instance()->createCodec( ossimString("jpeg") ) ),
+        m_pngCodec( ossimCodecFactoryRegistry::instance()->createCodec( ossimString("png") ) ),
+        m_webpCodec( ossimCodecFactoryRegistry::instance()->createCodec( ossimString("webp") ) ),
+        m_data()
+   {
+      std::ostringstream sql;
+      sql << "SELECT tile_data FROM " << tableName
+          << " WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?";
+      if ( sqlite3_prepare_v2( db, sql.str().c_str(), -1, &m_pStmt, NULL ) != SQLITE_OK )
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << "sqlite3_prepare_v2 error: " << sqlite3_errmsg(db) << std::endl;
+      }
+   }
+
+   ~StoredTileReader()
+   {
+      sqlite3_finalize( m_pStmt );
+   }
+
+   /** @return New decoded tile or null if there is none. */
+   ossimRefPtr<ossimImageData> read( ossim_int32 zoomLevel, ossim_int32 col, ossim_int32 row )
+   {
+      ossimRefPtr<ossimImageData> tile = 0;
+      if ( m_pStmt )
+      {
+         sqlite3_bind_int( m_pStmt, 1, zoomLevel );
+         sqlite3_bind_int( m_pStmt, 2, col );
+         sqlite3_bind_int( m_pStmt, 3, row );
+         if ( sqlite3_step( m_pStmt ) == SQLITE_ROW )
+         {
+            const ossim_uint8* data = (const ossim_uint8*)sqlite3_column_blob( m_pStmt, 0 );
+            ossim_uint32 size = (ossim_uint32)sqlite3_column_bytes( m_pStmt, 0 );
+            
+            ossimCodecBase* codec = 0;
+            switch ( ossimGpkgTileRecord::getTileType( data, size ) )
+            {
+               case ossimGpkgTileRecord::OSSIM_GPKG_JPEG:
+                  codec = m_jpegCodec.get();
+                  break;
+               case ossimGpkgTileRecord::OSSIM_GPKG_PNG:
+                  codec = m_pngCodec.get();
+                  break;
+               case ossimGpkgTileRecord::OSSIM_GPKG_WEBP:
+                  codec = m_webpCodec.get();
+                  break;
+               default:
+                  break;
+            }
+            
+            if ( codec )
+            {
+               m_data.assign( data, data + size );
+               if ( !codec->decode( m_data, tile ) )
+               {
+                  tile = 0;
+               }
+            }
+         }
+         sqlite3_reset( m_pStmt );
+      }
+      return tile;
+   }
+
+private:
+   sqlite3_stmt*               m_pStmt;
+   ossimRefPtr<ossimCodecBase> m_jpegCodec;
+   ossimRefPtr<ossimCodecBase> m_pngCodec;
+   ossimRefPtr<ossimCodecBase> m_webpCodec;
+   std::vector<ossim_uint8>    m_data;
+};
+
+namespace
+{
+   //---
+   // True if each band of a full or empty tile is a single value, which is
+   // copied to value.  Partial tiles mix null and valid pixels so are never
+   // uniform.  Comparing a band against itself shifted by one sample is
+   // true only if every sample equals the first, and lets memcmp do the
+   // work with wide compares.
+   //---
+   bool isUniformTile( const ossimImageData* tile, std::vector<ossim_uint8>& value )
+   {
+      const ossimDataObjectStatus STATUS = tile->getDataObjectStatus();
+      if ( ( ( STATUS != OSSIM_FULL ) && ( STATUS != OSSIM_EMPTY ) ) || !tile->getBuf() )
+      {
+         return false;
+      }
+
+      const ossim_uint32 BANDS   = tile->getNumberOfBands();
+      const ossim_uint32 BYTES   = ossim::scalarSizeInBytes( tile->getScalarType() );
+      const ossim_uint32 SAMPLES = tile->getSizePerBand();
+      if ( !BANDS || !BYTES || !SAMPLES )
+      {
+         return false;
+      }
+
+      value.resize( BANDS * BYTES );
+      for ( ossim_uint32 band = 0; band < BANDS; ++band )
+      {
+         const ossim_uint8* buf = (const ossim_uint8*)tile->getBuf( band );
+         if ( std::memcmp( buf, buf + BYTES, ( SAMPLES - 1 ) * BYTES ) != 0 )
+         {
+            return false;
+         }
+         std::memcpy( &value[ band * BYTES ], buf, BYTES );
+      }
+      return true;
+   }
+
+   // Only write tiles that have data in them:
+   bool isTileWritable( const ossimImageData* tile, bool writeBlanks )
+   {
+      return ( tile &&
+               ( tile->getDataObjectStatus() != OSSIM_NULL ) &&
+               ( ( tile->getDataObjectStatus() != OSSIM_EMPTY ) || writeBlanks ) );
+   }
+
+   //---
+   // 2x2 box filter of four child tiles (ul, ur, ll, lr) into tile.  Null
+   // pixels are left out of the average; null if all four are null.
+   //---
+   template <class T>
+   void reduceQuads( T /* dummy */,
+                     const std::vector< ossimRefPtr<ossimImageData> >& quads,
+                     ossimImageData* tile )
+   {
+      const ossim_uint32 W     = tile->getWidth();
+      const ossim_uint32 HW    = W / 2;
+      const ossim_uint32 HH    = tile->getHeight() / 2;
+      const ossim_uint32 BANDS = tile->getNumberOfBands();
+      const bool ROUND = std::numeric_limits<T>::is_integer;
+      
+      for ( ossim_uint32 band = 0; band < BANDS; ++band )
+      {
+         const T NP = (T)tile->getNullPix( band );
+         T* out = (T*)tile->getBuf( band );
+         
+         for ( ossim_uint32 q = 0; q < 4; ++q )
+         {
+            const ossimImageData* quad = quads[q].get();
+            const T* in = 0;
+            T qnp = NP;
+            if ( quad && quad->getBuf() && ( quad->getDataObjectStatus() != OSSIM_EMPTY ) )
+            {
+               in  = (const T*)quad->getBuf( band );
+               qnp = (T)quad->getNullPix( band );
+            }
+            
+            for ( ossim_uint32 y = 0; y < HH; ++y )
+            {
+               T* o = out + ( y + (q / 2) * HH ) * W + (q % 2) * HW;
+               if ( !in )
+               {
+                  std::fill( o, o + HW, NP );
+                  continue;
+               }
+               
+               const T* r0 = in + 2 * y * W;
+               const T* r1 = r0 + W;
+               for ( ossim_uint32 x = 0; x < HW; ++x )
+               {
+                  const T p[4] = { r0[2*x], r0[2*x+1], r1[2*x], r1[2*x+1] };
+                  ossim_float64 sum = 0.0;
+                  ossim_uint32 count = 0;
+                  for ( ossim_uint32 i = 0; i < 4; ++i )
+                  {
+                     if ( p[i] != qnp )
+                     {
+                        sum += p[i];
+                        ++count;
+                     }
+                  }
+                  if ( count )
+                  {
+                     sum = sum / count;
+                     o[x] = (T)( ROUND ? std::floor( sum + 0.5 ) : sum );
+                  }
+                  else
+                  {
+                     o[x] = NP;
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   //---
+   // Makes the tile for rect from its four children.
+   // Returns null if none of the children have data.
+   //---
+   ossimRefPtr<ossimImageData> reduceTile(
+      const std::vector< ossimRefPtr<ossimImageData> >& quads, const ossimIrect& rect )
+   {
+      ossimRefPtr<ossimImageData> tile = 0;
+      
+      for ( ossim_uint32 q = 0; q < quads.size(); ++q )
+      {
+         if ( quads[q].valid() && quads[q]->getBuf() )
+         {
+            tile = (ossimImageData*)quads[q]->dup();
+            tile->setImageRectangle( rect );
+            break;
+         }
+      }
+
+      if ( tile.valid() )
+      {
+         switch ( tile->getScalarType() )
+         {
+            case OSSIM_UINT8:
+               reduceQuads( ossim_uint8(0), quads, tile.get() );
+               break;
+            case OSSIM_SINT8:
+               reduceQuads( ossim_sint8(0), quads, tile.get() );
+               break;
+            case OSSIM_USHORT11:
+            case OSSIM_UINT16:
+               reduceQuads( ossim_uint16(0), quads, tile.get() );
+               break;
+            case OSSIM_SINT16:
+               reduceQuads( ossim_sint16(0), quads, tile.get() );
+               break;
+            case OSSIM_UINT32:
+               reduceQuads( ossim_uint32(0), quads, tile.get() );
+               break;
+            case OSSIM_SINT32:
+               reduceQuads( ossim_sint32(0), quads, tile.get() );
+               break;
+            case OSSIM_FLOAT32:
+            case OSSIM_NORMALIZED_FLOAT:
+               reduceQuads( ossim_float32(0), quads, tile.get() );
+               break;
+            case OSSIM_FLOAT64:
+            case OSSIM_NORMALIZED_DOUBLE:
+               reduceQuads( ossim_float64(0), quads, tile.get() );
+               break;
+            default:
+               tile = 0;
+               break;
+         }
+         
+         if ( tile.valid() )
+         {
+            tile->validate();
+         }
+      }
+
+      return tile;
+   }
+
+   // Fills pixels of over that are null in every band from under.
+   template <class T>
+   void fillNulls( T /* dummy */, const ossimImageData* under, ossimImageData* over )
+   {
+      const ossim_uint32 BANDS = over->getNumberOfBands();
+      const ossim_uint32 SIZE  = over->getSizePerBand();
+      std::vector<const T*> in( BANDS );
+      std::vector<T*> out( BANDS );
+      std::vector<T> np( BANDS );
+      for ( ossim_uint32 band = 0; band < BANDS; ++band )
+      {
+         in[band]  = (const T*)under->getBuf( band );
+         out[band] = (T*)over->getBuf( band );
+         np[band]  = (T)over->getNullPix( band );
+      }
+      
+      for ( ossim_uint32 i = 0; i < SIZE; ++i )
+      {
+         ossim_uint32 band = 0;
+         while ( ( band < BANDS ) && ( out[band][i] == np[band] ) )
+         {
+            ++band;
+         }
+         if ( band == BANDS )
+         {
+            for ( band = 0; band < BANDS; ++band )
+            {
+               out[band][i] = in[band][i];
+            }
+         }
+      }
+   }
+
+   //---
+   // Composites over on top of under, i.e. a new tile over the stored one.
+   // False if the tiles are not alike, in which case over is untouched.
+   //---
+   bool compositeTile( const ossimImageData* under, ossimImageData* over )
+   {
+      if ( !under->getBuf() || !over->getBuf() ||
+           ( under->getNumberOfBands() != over->getNumberOfBands() ) ||
+           ( under->getScalarType() != over->getScalarType() ) ||
+           ( under->getSizePerBand() != over->getSizePerBand() ) )
+      {
+         return false;
+      }
+
+      switch ( over->getScalarType() )
+      {
+         case OSSIM_UINT8:
+            fillNulls( ossim_uint8(0), under, over );
+            break;
+         case OSSIM_SINT8:
+            fillNulls( ossim_sint8(0), under, over );
+            break;
+         case OSSIM_USHORT11:
+         case OSSIM_UINT16:
+            fillNulls( ossim_uint16(0), under, over );
+            break;
+         case OSSIM_SINT16:
+            fillNulls( ossim_sint16(0), under, over );
+            break;
+         case OSSIM_UINT32:
+            fillNulls( ossim_uint32(0), under, over );
+            break;
+         case OSSIM_SINT32:
+            fillNulls( ossim_sint32(0), under, over );
+            break;
+         case OSSIM_FLOAT32:
+         case OSSIM_NORMALIZED_FLOAT:
+            fillNulls( ossim_float32(0), under, over );
+            break;
+         case OSSIM_FLOAT64:
+         case OSSIM_NORMALIZED_DOUBLE:
+            fillNulls( ossim_float64(0), under, over );
+            break;
+         default:
+            return false;
+      }
+      
+      over->validate();
+      return true;
+   }
+
+   // Finest zoom level first.
+   bool isFinerLevel( const ossimGpkgTileMatrixRecord& a, const ossimGpkgTileMatrixRecord& b )
+   {
+      return ( a.m_zoom_level > b.m_zoom_level );
+   }
+
+   //---
+   // Recreates a source from its state; null if it is not a chain or image
+   // handler.  Other sources, e.g. memory sources, do not save all they hold.
+   //---
+   ossimRefPtr<ossimImageSource> cloneSource( ossimImageSource* source )
+   {
+      ossimRefPtr<ossimImageSource> clone = 0;
+      if ( source )
+      {
+         if ( dynamic_cast<ossimImageChain*>( source ) ||
+              dynamic_cast<ossimImageHandler*>( source ) )
+         {
+            ossimKeywordlist kwl;
+            if ( source->saveState( kwl ) )
+            {
+               ossimRefPtr<ossimObject> obj =
+                  ossimObjectFactoryRegistry::instance()->createObject( kwl );
+               clone = dynamic_cast<ossimImageSource*>( obj.get() );
+            }
+         }
+         else if ( dynamic_cast<ossimScalarRemapper*>( source ) &&
+                   ( source->getNumberOfInputs() == 1 ) )
+         {
+            // Eight bit remapper put in front of the sequencer by writeFile.
+            ossimRefPtr<ossimImageSource> input =
+               cloneSource( dynamic_cast<ossimImageSource*>( source->getInput(0) ) );
+            if ( input.valid() )
+            {
+               ossimRefPtr<ossimScalarRemapper> remapper = new ossimScalarRemapper();
+               remapper->setOutputScalarType( source->getOutputScalarType() );
+               remapper->connectMyInputTo( 0, input.get() );
+               clone = remapper.get();
+            }
+         }
+      }
+      return clone;
+   }
+
+   //---
+   // True if a png blob carries transparency: a gray+alpha or rgba color
+   // type in the IHDR chunk, or a tRNS chunk ahead of the image data.
+   //---
+   bool pngHasAlpha( const std::vector<ossim_uint8>& data )
+   {
+      // 8 byte signature, then IHDR: length, type, width, height, depth, color.
+      if ( ( data.size() < 26 ) || ( std::memcmp( &data[12], "IHDR", 4 ) != 0 ) )
+      {
+         return false;
+      }
+      const ossim_uint8 COLOR_TYPE = data[25];
+      if ( ( COLOR_TYPE == 4 ) || ( COLOR_TYPE == 6 ) )
+      {
+         return true;
+      }
+      std::vector<ossim_uint8>::size_type pos = 8;
+      while ( pos + 8 <= data.size() )
+      {
+         const ossim_uint32 LENGTH = ( ossim_uint32(data[pos])   << 24 ) |
+                                     ( ossim_uint32(data[pos+1]) << 16 ) |
+                                     ( ossim_uint32(data[pos+2]) << 8  ) |
+                                     ossim_uint32(data[pos+3]);
+         const ossim_uint8* TYPE = &data[pos+4];
+         if ( std::memcmp( TYPE, "tRNS", 4 ) == 0 )
+         {
+            return true;
+         }
+         if ( std::memcmp( TYPE, "IDAT", 4 ) == 0 )
+         {
+            break;
+         }
+         pos += ossim_uint64(LENGTH) + 12; // length, type and crc
+      }
+      return false;
+   }
+}
+
 // For the "ident" program:
 #if OSSIM_ID_ENABLED
 static const char OSSIM_ID[] = "$Id: ossimGpkgWriter.cpp 22466 2013-10-24 18:23:51Z dburken $";
@@ -116,7 +741,11 @@ ossimGpkgWriter::ossimGpkgWriter()
    m_zoomLevels(),
    m_zoomLevelMatrixSizes(),
    m_pStmt(0),
-   m_writeBlanks(false)
+   m_writeBlanks(false),
+   m_ingestTableName(),
+   m_resumeIngest(false),
+   m_ingestedLevels(),
+   m_uniformTileCache( new UniformTileCache() )
 {
    //---
    // Uncomment for debug mode:
@@ -152,6 +781,9 @@ ossimGpkgWriter::~ossimGpkgWriter()
 
    // Not a leak, ref ptr.
    m_kwl = 0;
+
+   delete m_uniformTileCache;
+   m_uniformTileCache = 0;
 }
 
 ossimString ossimGpkgWriter::getShortName() const
@@ -186,7 +818,8 @@ bool ossimGpkgWriter::open()
 
       if ( theFilename.exists() )
       {
-         if ( !append() )
+         // A killed bulk ingest is picked up where it left off.
+         if ( !append() && !( bulkIngest() && canResumeIngest() ) )
          {
             theFilename.remove();
             flags |= SQLITE_OPEN_CREATE;
@@ -539,6 +1172,10 @@ void ossimGpkgWriter::close()
 
    m_pStmt = 0;
    m_batchCount = 0;
+
+   m_ingestTableName.clear();
+   m_resumeIngest = false;
+   m_ingestedLevels.clear();
 }
 
 bool ossimGpkgWriter::writeFile()
@@ -562,6 +1199,20 @@ bool ossimGpkgWriter::writeFile()
    {
       if( theInputConnection.valid() && (getErrorStatus() == ossimErrorCodes::OSSIM_OK) )
       {
+         //---
+         // WebP has no gray mode so one band tiles would be stored as three
+         // band rgb, mixed in with one band jpeg/png tiles in the same table.
+         //---
+         if ( usesWebp() && ( theInputConnection->getNumberOfOutputBands() == 1 ) )
+         {
+            std::ostringstream errMsg;
+            errMsg << MODULE << " ERROR:\n"
+                   << "Writer mode " << getWriterModeString( getWriterMode() )
+                   << " requires a three band input.  Use a band selector or "
+                   << "a jpeg/png mode for one band input.\n";
+            throw ossimException( errMsg.str() );
+         }
+
          //---
          // To hold the original input to the image source sequencer. Only used
          // if we mess with the input chain, e.g. add a scalar remapper.
@@ -602,13 +1253,28 @@ bool ossimGpkgWriter::writeFile()
 
             if ( status )
             {
-               if ( keyIsTrue( ADD_LEVELS_KW ) )
+               ossimGpkgTileEntry entry;
+               if ( keyIsTrue( APPEND_KW ) && !keyIsTrue( ADD_LEVELS_KW ) &&
+                    ossim_gpkg::getTileEntry( m_db, m_tileTableName, entry ) )
                {
-                  status = addLevels();
+                  // Updates go straight to the tile table; no staging.
+                  status = updateEntry( entry );
                }
                else
                {
-                  status = writeEntry();
+                  //---
+                  // Staging tables are only merged and dropped by
+                  // writeZoomLevels, which the update path never reaches.
+                  //---
+                  if ( bulkIngest() )
+                  {
+                     status = beginIngest( m_db );
+                  }
+
+                  if ( status )
+                  {
+                     status = keyIsTrue( ADD_LEVELS_KW ) ? addLevels() : writeEntry();
+                  }
                }
             }
             
@@ -1069,6 +1735,14 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
    if ( db && proj )
    {
       initializeCodec(); // Throws exception on error.
+
+      //---
+      // Tiles are copied as is from a GeoPackage input with the same tiling.
+      // Else coarser levels are reduced from the full res level when the
+      // levels nest.  Otherwise each level is read from the input below.
+      //---
+      bool reduced = ( copyEncodedZoomLevels( db, proj, zoomLevels ) ||
+                       writeReducedZoomLevels( db, proj, zoomLevels ) );
       
       ossimDpt gsd;
       getGsd( proj, gsd );
@@ -1077,7 +1751,8 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
       ossim_float64 tilesWritten = 0.0;
       ossim_float64 totalTiles   = 0.0;
 
-      std::vector<ossim_int32>::const_iterator zoomLevel = zoomLevels.begin();
+      std::vector<ossim_int32>::const_iterator zoomLevel =
+         reduced ? zoomLevels.end() : zoomLevels.begin();
       while ( zoomLevel != zoomLevels.end() )
       {
          // Get the area of interest.
@@ -1149,7 +1824,19 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
             if ( writeGpkgNsgTileMatrixExtentTable( db, (*zoomLevel),
                                                     expandedAoi, clippedAoi ) )
             {
-               writeTiles( db, expandedAoi, (*zoomLevel), totalTiles, tilesWritten );
+               if ( isLevelIngested( *zoomLevel ) )
+               {
+                  // Finished by a killed bulk ingest.
+                  tilesWritten += ossim_float64(matrixSize.x) * ossim_float64(matrixSize.y);
+               }
+               else
+               {
+                  writeTiles( db, expandedAoi, (*zoomLevel), totalTiles, tilesWritten );
+                  if ( m_ingestTableName.size() && !needsAborting() )
+                  {
+                     checkpointIngest( db, (*zoomLevel) );
+                  }
+               }
                // writeZoomLevel( db, expandedAoi, (*zoomLevel), totalTiles, tilesWritten );
             }
             else
@@ -1191,6 +1878,11 @@ void ossimGpkgWriter::writeZoomLevels( sqlite3* db,
       char * sErrMsg = 0;
       sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &sErrMsg);
    }
+
+   if ( m_ingestTableName.size() && !needsAborting() )
+   {
+      finishIngest( db );
+   }
    
    if (traceDebug())
    {
@@ -1218,7 +1910,7 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
       char * sErrMsg = 0;
       sqlite3_stmt* pStmt = 0; // The current SQL statement
       std::ostringstream sql;
-      sql << "INSERT INTO " << m_tileTableName << "( zoom_level, tile_column, tile_row, tile_data ) VALUES ( "
+      sql << "INSERT INTO " << getInsertTableName() << "( zoom_level, tile_column, tile_row, tile_data ) VALUES ( "
           << "?, " // 1: zoom level
           << "?, " // 2: col
           << "?, " // 3: row
@@ -1239,7 +1931,21 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
 
       bool writeBlanks = keyIsTrue( INCLUDE_BLANK_TILES_KW );
 
-      if(rc == SQLITE_OK)
+      // Encoding threads need their own copy of the input chain.
+      std::vector< ossimRefPtr<ossimImageSource> > sources;
+      ossim_uint32 threads = getNumberOfThreads();
+      if ( ( rc == SQLITE_OK ) && ( threads > 1 ) && ( ROWS * COLS > 1 ) )
+      {
+         cloneInputChains( threads, sources );
+      }
+
+      if( ( rc == SQLITE_OK ) && ( sources.size() > 1 ) )
+      {
+         writeTilesThreaded( db, pStmt, aoi, zoomLevel, ROWS, COLS, writeBlanks,
+                             sources, totalTiles, tilesWritten );
+         sqlite3_finalize(pStmt);
+      }
+      else if(rc == SQLITE_OK)
       {
          for ( ossim_int64 row = 0; row < ROWS; ++row )
          {
@@ -1259,117 +1965,1920 @@ void ossimGpkgWriter::writeTiles( sqlite3* db,
                            sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &sErrMsg);
                         }
 
-                        writeTile( pStmt, db, tile, zoomLevel, row, col);//, quality );
-                        ++m_batchCount;
+                        writeTile( pStmt, db, tile, zoomLevel, row, col);//, quality );
+                        ++m_batchCount;
+
+                        if(m_batchCount == m_batchSize)
+                        {
+                           sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &sErrMsg);
+                           m_batchCount = 0;
+                        }
+                     }
+                  }
+               }
+               else
+               {
+                  std::ostringstream errMsg;
+                  errMsg << "ossimGpkgWriter::writeTiles ERROR: "
+                         << "Sequencer returned null tile pointer for ("
+                         << col << ", " << row << ")";
+                  
+                  throw ossimException( errMsg.str() );
+               }
+
+               // Always increment the tiles written thing.
+               ++tilesWritten;
+
+               if ( needsAborting() ) break;
+               
+            } // End: col loop
+
+            setPercentComplete( (tilesWritten / totalTiles) * 100.0 );
+
+            if ( needsAborting() )
+            {
+               setPercentComplete( 100 );
+               break;
+            }
+             
+         } // End: row loop
+
+         sqlite3_finalize(pStmt);
+      }
+      else
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+              << "sqlite3_prepare_v2 error: " << sqlite3_errmsg(db) << std::endl;
+      }
+     
+   } // if ( db )
+
+} // End: ossimGpkgWriter::writeTiles( ... )
+
+void ossimGpkgWriter::writeTile( sqlite3_stmt* pStmt,
+                                 sqlite3* db,
+                                 ossimRefPtr<ossimImageData>& tile,
+                                 ossim_int32 zoomLevel,
+                                 ossim_int64 row,
+                                 ossim_int64 col )
+{
+   if ( db && tile.valid() )
+   {
+      std::vector<ossim_uint8> codecTile; // To hold the jpeg encoded tile.
+      bool encodeStatus = encodeTile( tile,
+                                      m_fullTileCodec.get(),
+                                      m_partialTileCodec.get(),
+                                      codecTile );
+      
+      if ( encodeStatus )
+      {
+         // Insert into the database file(gpkg):
+         int rc = sqlite3_bind_int (pStmt, 1, zoomLevel);
+         rc |= sqlite3_bind_int (pStmt, 2, col);
+         rc |= sqlite3_bind_int (pStmt, 3, row);
+         rc |= sqlite3_bind_blob (pStmt,
+                                  4,
+                                  (void*)&codecTile.front(),
+                                  codecTile.size(),
+                                  SQLITE_TRANSIENT);
+         if (  rc == SQLITE_OK )
+         {
+            rc = sqlite3_step(pStmt);
+            if (  rc == SQLITE_OK )
+            {
+               ossimNotify(ossimNotifyLevel_WARN)
+                  << "sqlite3_step error: " << sqlite3_errmsg(db) << std::endl;
+            }
+            
+         }
+         else
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << "sqlite3_bind_blob error: " << sqlite3_errmsg(db) << std::endl;
+         }
+         
+         sqlite3_clear_bindings(pStmt);
+         sqlite3_reset(pStmt);
+      }
+      
+   } // Matches:  if ( db && tile.valid() )
+}
+
+bool ossimGpkgWriter::encodeTile( ossimRefPtr<ossimImageData>& tile,
+                                  ossimCodecBase* fullTileCodec,
+                                  ossimCodecBase* partialTileCodec,
+                                  std::vector<ossim_uint8>& codecTile ) const
+{
+   bool encodeStatus;
+
+   UniformTileCache::Key key;
+   bool uniform = ( m_uniformTileCache->isEnabled() &&
+                    isUniformTile( tile.get(), key.m_value ) );
+   if ( uniform )
+   {
+      key.m_status = tile->getDataObjectStatus();
+      key.m_scalar = tile->getScalarType();
+      key.m_width  = tile->getWidth();
+      key.m_height = tile->getHeight();
+      if ( m_uniformTileCache->get( key, codecTile ) )
+      {
+         return true;
+      }
+   }
+   
+   if ( tile->getDataObjectStatus() == OSSIM_FULL )
+   {
+      if ( m_fullTileCodecAlpha )
+      {
+         tile->computeAlphaChannel();
+      }
+      encodeStatus = fullTileCodec->encode(tile, codecTile);
+   }
+   else
+   {
+      if ( m_partialTileCodecAlpha )
+      {
+         tile->computeAlphaChannel();
+      }
+      encodeStatus = partialTileCodec->encode(tile, codecTile);
+   }
+
+   if ( uniform && encodeStatus )
+   {
+      m_uniformTileCache->add( key, codecTile );
+   }
+
+   return encodeStatus;
+}
+
+void ossimGpkgWriter::writeTilesThreaded(
+   sqlite3* db,
+   sqlite3_stmt* pStmt,
+   const ossimIrect& aoi,
+   ossim_int32 zoomLevel,
+   ossim_int64 rows,
+   ossim_int64 cols,
+   bool writeBlanks,
+   std::vector< ossimRefPtr<ossimImageSource> >& sources,
+   const ossim_float64& totalTiles,
+   ossim_float64& tilesWritten )
+{
+   const ossim_uint32 THREADS  = (ossim_uint32)sources.size();
+   const ossim_int64  TILES    = rows * cols;
+   const ossim_int32  TW       = (ossim_int32)theInputConnection->getTileWidth();
+   const ossim_int32  TH       = (ossim_int32)theInputConnection->getTileHeight();
+
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimGpkgWriter::writeTilesThreaded DEBUG:"
+         << "\nlevel:   " << zoomLevel
+         << "\nthreads: " << THREADS << "\n";
+   }
+
+   // Queue depth of a few tiles per thread keeps everyone busy.
+   EncodedTileQueue queue( THREADS * 4, THREADS );
+   std::atomic<ossim_int64> nextTile( 0 );
+   std::mutex errorMutex;
+   std::string errorMessage;
+
+   // Encoder: pulls the next tile index, reads, encodes and queues it.
+   auto encoder = [&]( ossim_uint32 threadIndex )
+   {
+      try
+      {
+         ossimRefPtr<ossimCodecBase> fullTileCodec;
+         ossimRefPtr<ossimCodecBase> partialTileCodec;
+         if ( !createCodecs( fullTileCodec, partialTileCodec ) )
+         {
+            throw ossimException( std::string("Could not create codecs!") );
+         }
+         ossimImageSource* source = sources[threadIndex].get();
+
+         while ( true )
+         {
+            ossim_int64 index = nextTile++;
+            if ( index >= TILES )
+            {
+               break;
+            }
+
+            EncodedTile encoded;
+            encoded.m_zoomLevel = zoomLevel;
+            encoded.m_row = index / cols;
+            encoded.m_col = index % cols;
+
+            ossimIpt origin( aoi.ul().x + (ossim_int32)encoded.m_col * TW,
+                             aoi.ul().y + (ossim_int32)encoded.m_row * TH );
+            ossimRefPtr<ossimImageData> tile =
+               source->getTile( ossimIrect( origin.x, origin.y,
+                                            origin.x + TW - 1, origin.y + TH - 1 ) );
+            if ( !tile.valid() )
+            {
+               std::ostringstream errMsg;
+               errMsg << "ossimGpkgWriter::writeTiles ERROR: "
+                      << "Input returned null tile pointer for ("
+                      << encoded.m_col << ", " << encoded.m_row << ")";
+               throw ossimException( errMsg.str() );
+            }
+
+            if ( isTileWritable( tile.get(), writeBlanks ) )
+            {
+               if ( !encodeTile( tile, fullTileCodec.get(), partialTileCodec.get(),
+                                 encoded.m_data ) )
+               {
+                  encoded.m_data.clear();
+               }
+            }
+
+            if ( !queue.push( encoded ) )
+            {
+               break; // Aborted.
+            }
+         }
+      }
+      catch ( const std::exception& e )
+      {
+         std::lock_guard<std::mutex> lock( errorMutex );
+         if ( errorMessage.empty() )
+         {
+            errorMessage = e.what();
+         }
+         queue.close();
+      }
+      queue.producerDone();
+   };
+
+   std::vector<std::thread> workers;
+   for ( ossim_uint32 i = 0; i < THREADS; ++i )
+   {
+      workers.push_back( std::thread( encoder, i ) );
+   }
+
+   // This thread is the only sqlite writer.
+   drainEncodedTiles( db, pStmt, queue, cols, totalTiles, tilesWritten );
+
+   for ( ossim_uint32 i = 0; i < workers.size(); ++i )
+   {
+      workers[i].join();
+   }
+
+   if ( errorMessage.size() )
+   {
+      throw ossimException( errorMessage );
+   }
+}
+
+void ossimGpkgWriter::insertEncodedTile( sqlite3* db,
+                                         sqlite3_stmt* pStmt,
+                                         EncodedTile& tile )
+{
+   if ( tile.m_data.size() )
+   {
+      char* sErrMsg = 0;
+      if(m_batchCount == 0)
+      {
+         sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &sErrMsg);
+      }
+      
+      writeCodecTile( pStmt, db, &tile.m_data.front(),
+                      (ossim_int32)tile.m_data.size(),
+                      tile.m_zoomLevel, tile.m_row, tile.m_col );
+      ++m_batchCount;
+      
+      if(m_batchCount == m_batchSize)
+      {
+         sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &sErrMsg);
+         m_batchCount = 0;
+      }
+   }
+}
+
+void ossimGpkgWriter::drainEncodedTiles( sqlite3* db,
+                                         sqlite3_stmt* pStmt,
+                                         EncodedTileQueue& queue,
+                                         ossim_int64 progressInterval,
+                                         const ossim_float64& totalTiles,
+                                         ossim_float64& tilesWritten )
+{
+   ossim_int64 tilesDone = 0;
+   EncodedTile encoded;
+   while ( queue.pop( encoded ) )
+   {
+      insertEncodedTile( db, pStmt, encoded );
+
+      // Always increment the tiles written thing.
+      ++tilesWritten;
+      ++tilesDone;
+      if ( ( tilesDone % progressInterval ) == 0 )
+      {
+         setPercentComplete( (tilesWritten / totalTiles) * 100.0 );
+      }
+
+      if ( needsAborting() )
+      {
+         queue.close();
+         setPercentComplete( 100 );
+         break;
+      }
+   }
+}
+
+bool ossimGpkgWriter::writeReducedZoomLevels( sqlite3* db,
+                                              ossimMapProjection* proj,
+                                              const std::vector<ossim_int32>& zoomLevels )
+{
+   static const char MODULE[] = "ossimGpkgWriter::writeReducedZoomLevels";
+
+   const ossim_uint32 LEVELS = (ossim_uint32)zoomLevels.size();
+   if ( !reduceLevels() || ( LEVELS < 2 ) || ( m_tileSize.x % 2 ) || ( m_tileSize.y % 2 ) )
+   {
+      return false;
+   }
+
+   // Pyramid is one bulk ingest checkpoint so a level by level one is resumed by level.
+   ossim_uint32 ingested = 0;
+   for ( ossim_uint32 i = 0; i < LEVELS; ++i )
+   {
+      if ( isLevelIngested( zoomLevels[i] ) )
+      {
+         ++ingested;
+      }
+   }
+   if ( ingested && ( ingested < LEVELS ) )
+   {
+      return false;
+   }
+
+   //---
+   // Lay the levels out on a copy of the projection so nothing is touched if
+   // they do not nest, i.e. each level must be exactly twice the one above.
+   //---
+   ossimRefPtr<ossimMapProjection> levelProj =
+      dynamic_cast<ossimMapProjection*>( proj->dup() );
+   if ( !levelProj.valid() )
+   {
+      return false;
+   }
+   
+   std::vector<PyramidLevel> levels( LEVELS );
+   for ( ossim_uint32 i = 0; i < LEVELS; ++i )
+   {
+      if ( i )
+      {
+         ossimDpt scale( 0.5, 0.5 );
+         levelProj->applyScale( scale, true );
+         levelProj->update();
+      }
+      
+      PyramidLevel& level = levels[i];
+      level.m_zoomLevel = zoomLevels[i];
+      getGsd( levelProj.get(), level.m_gsd );
+      
+      ossimIrect aoi;
+      getAoiFromRect( levelProj.get(), m_outputRect, aoi );
+      getAoiFromRect( levelProj.get(), m_clipRect, level.m_clippedAoi );
+      getExpandedAoi( aoi, level.m_expandedAoi );
+      getMatrixSize( level.m_expandedAoi, level.m_matrixSize );
+
+      if ( i )
+      {
+         const PyramidLevel& parent = levels[i-1];
+         if ( ( level.m_zoomLevel != parent.m_zoomLevel + 1 ) ||
+              ( level.m_expandedAoi.ul().x != parent.m_expandedAoi.ul().x * 2 ) ||
+              ( level.m_expandedAoi.ul().y != parent.m_expandedAoi.ul().y * 2 ) ||
+              ( level.m_matrixSize.x != parent.m_matrixSize.x * 2 ) ||
+              ( level.m_matrixSize.y != parent.m_matrixSize.y * 2 ) )
+         {
+            if (traceDebug())
+            {
+               ossimNotify(ossimNotifyLevel_DEBUG)
+                  << MODULE << " DEBUG: level " << level.m_zoomLevel
+                  << " does not nest, writing levels from input.\n";
+            }
+            return false;
+         }
+      }
+   }
+
+   ossim_float64 totalTiles   = 0.0;
+   ossim_float64 tilesWritten = 0.0;
+   for ( ossim_uint32 i = 0; i < LEVELS; ++i )
+   {
+      const PyramidLevel& level = levels[i];
+      totalTiles += ossim_float64(level.m_matrixSize.x) * ossim_float64(level.m_matrixSize.y);
+
+      if ( traceDebug() )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << MODULE << " DEBUG:"
+            << "\nlevel:       " << level.m_zoomLevel
+            << "\ngsd:         " << level.m_gsd
+            << "\nclippedAoi:  " << level.m_clippedAoi
+            << "\nexpandedAoi: " << level.m_expandedAoi
+            << "\nmatrixSize:  " << level.m_matrixSize
+            << "\n";
+      }
+      
+      if ( writeGpkgTileMatrixTable( db, level.m_zoomLevel, level.m_matrixSize, level.m_gsd ) )
+      {
+         if ( !writeGpkgNsgTileMatrixExtentTable( db, level.m_zoomLevel,
+                                                  level.m_expandedAoi, level.m_clippedAoi ) )
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << MODULE
+               << " WARNING:\nwriteGpkgNsgTileMatrixExtentTable call failed!" << std::endl;
+         }
+      }
+      else
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << MODULE
+            << " WARNING:\nwriteGpkgTileMatrixTable call failed!" << std::endl;
+      }
+   }
+
+   // Only the full res level is read from the input.
+   for ( ossim_uint32 i = 1; i < LEVELS; ++i )
+   {
+      ossimDpt scale( 0.5, 0.5 );
+      proj->applyScale( scale, true );
+      proj->update();
+   }
+   
+   // Propagate projection to chains and update aoi's of cutters.
+   setView( proj );
+
+   if ( ingested == LEVELS )
+   {
+      // Finished by a killed bulk ingest.
+      setPercentComplete( 100 );
+      return true;
+   }
+   
+   std::vector< ossimRefPtr<ossimImageSource> > sources;
+   ossim_uint32 threads = getNumberOfThreads();
+   if ( threads > 1 )
+   {
+      cloneInputChains( threads, sources );
+   }
+   if ( sources.empty() )
+   {
+      sources.push_back( theInputConnection.get() );
+   }
+   const ossim_uint32 THREADS = (ossim_uint32)sources.size();
+
+   //---
+   // Subtrees are handed out from the first level with a few tiles per
+   // thread.  Tiles at that level are kept so the levels above it can be
+   // reduced from them at the end.
+   //---
+   ossim_uint32 split = 0;
+   while ( ( split < LEVELS - 1 ) &&
+           ( ossim_int64(levels[split].m_matrixSize.x) * levels[split].m_matrixSize.y <
+             ossim_int64(THREADS) * 4 ) )
+   {
+      ++split;
+   }
+   const ossim_int64 SPLIT_COLS  = levels[split].m_matrixSize.x;
+   const ossim_int64 SPLIT_TILES = SPLIT_COLS * levels[split].m_matrixSize.y;
+   std::vector< ossimRefPtr<ossimImageData> > reduced( split ? SPLIT_TILES : 0 );
+
+   bool writeBlanks = keyIsTrue( INCLUDE_BLANK_TILES_KW );
+
+   sqlite3_stmt* pStmt = 0;
+   std::ostringstream sql;
+   sql << "INSERT INTO " << getInsertTableName() << "( zoom_level, tile_column, tile_row, tile_data ) VALUES ( "
+       << "?, " // 1: zoom level
+       << "?, " // 2: col
+       << "?, " // 3: row
+       << "?"   // 4: blob
+       << " )";
+   int rc = sqlite3_prepare_v2( db, sql.str().c_str(), -1, &pStmt, NULL );
+   if ( rc != SQLITE_OK )
+   {
+      ossimNotify(ossimNotifyLevel_WARN)
+         << "sqlite3_prepare_v2 error: " << sqlite3_errmsg(db) << std::endl;
+      return true;
+   }
+
+   EncodedTileQueue queue( THREADS * 4, THREADS );
+   std::atomic<ossim_int64> nextTile( 0 );
+   std::mutex errorMutex;
+   std::string errorMessage;
+
+   auto builder = [&]( ossim_uint32 threadIndex )
+   {
+      try
+      {
+         ossimRefPtr<ossimCodecBase> fullTileCodec;
+         ossimRefPtr<ossimCodecBase> partialTileCodec;
+         if ( !createCodecs( fullTileCodec, partialTileCodec ) )
+         {
+            throw ossimException( std::string("Could not create codecs!") );
+         }
+
+         while ( true )
+         {
+            ossim_int64 index = nextTile++;
+            if ( index >= SPLIT_TILES )
+            {
+               break;
+            }
+            
+            ossimRefPtr<ossimImageData> tile =
+               buildPyramidTile( levels, split, index / SPLIT_COLS, index % SPLIT_COLS,
+                                 sources[threadIndex].get(), fullTileCodec.get(),
+                                 partialTileCodec.get(), writeBlanks, queue );
+            if ( queue.isClosed() )
+            {
+               break; // Aborted.
+            }
+            if ( split )
+            {
+               reduced[index] = tile;
+            }
+         }
+      }
+      catch ( const std::exception& e )
+      {
+         std::lock_guard<std::mutex> lock( errorMutex );
+         if ( errorMessage.empty() )
+         {
+            errorMessage = e.what();
+         }
+         queue.close();
+      }
+      queue.producerDone();
+   };
+
+   std::vector<std::thread> workers;
+   for ( ossim_uint32 i = 0; i < THREADS; ++i )
+   {
+      workers.push_back( std::thread( builder, i ) );
+   }
+   
+   // This thread is the only sqlite writer.
+   drainEncodedTiles( db, pStmt, queue, levels[LEVELS-1].m_matrixSize.x,
+                      totalTiles, tilesWritten );
+
+   for ( ossim_uint32 i = 0; i < workers.size(); ++i )
+   {
+      workers[i].join();
+   }
+
+   if ( errorMessage.empty() && !needsAborting() )
+   {
+      // Levels above the split, reduced from the kept tiles.
+      const ossim_int32 TW = m_tileSize.x;
+      const ossim_int32 TH = m_tileSize.y;
+      ossim_int32 i = (ossim_int32)split - 1;
+      while ( i >= 0 )
+      {
+         const PyramidLevel& level = levels[i];
+         const ossim_int64 ROWS = level.m_matrixSize.y;
+         const ossim_int64 COLS = level.m_matrixSize.x;
+         const ossim_int64 CHILD_COLS = COLS * 2;
+         std::vector< ossimRefPtr<ossimImageData> > parents( ROWS * COLS );
+         std::vector< ossimRefPtr<ossimImageData> > quads( 4 );
+         
+         for ( ossim_int64 row = 0; row < ROWS; ++row )
+         {
+            for ( ossim_int64 col = 0; col < COLS; ++col )
+            {
+               for ( ossim_uint32 q = 0; q < 4; ++q )
+               {
+                  quads[q] = reduced[ ( row * 2 + q / 2 ) * CHILD_COLS + col * 2 + q % 2 ];
+               }
+               
+               ossimIpt origin( level.m_expandedAoi.ul().x + (ossim_int32)col * TW,
+                                level.m_expandedAoi.ul().y + (ossim_int32)row * TH );
+               ossimRefPtr<ossimImageData> tile =
+                  reduceTile( quads, ossimIrect( origin.x, origin.y,
+                                                 origin.x + TW - 1, origin.y + TH - 1 ) );
+               
+               EncodedTile encoded;
+               encoded.m_zoomLevel = level.m_zoomLevel;
+               encoded.m_row = row;
+               encoded.m_col = col;
+               if ( isTileWritable( tile.get(), writeBlanks ) )
+               {
+                  if ( !encodeTile( tile, m_fullTileCodec.get(), m_partialTileCodec.get(),
+                                    encoded.m_data ) )
+                  {
+                     encoded.m_data.clear();
+                  }
+               }
+               insertEncodedTile( db, pStmt, encoded );
+               ++tilesWritten;
+               
+               parents[ row * COLS + col ] = tile;
+            }
+         }
+         
+         reduced.swap( parents );
+         --i;
+      }
+
+      if ( m_ingestTableName.size() )
+      {
+         for ( ossim_uint32 level = 0; level < LEVELS; ++level )
+         {
+            checkpointIngest( db, levels[level].m_zoomLevel );
+         }
+      }
+      
+      setPercentComplete( 100 );
+   }
+
+   sqlite3_finalize( pStmt );
+   
+   if ( errorMessage.size() )
+   {
+      throw ossimException( errorMessage );
+   }
+
+   return true;
+   
+} // End: ossimGpkgWriter::writeReducedZoomLevels( ... )
+
+ossimRefPtr<ossimImageData> ossimGpkgWriter::buildPyramidTile(
+   const std::vector<PyramidLevel>& levels,
+   ossim_uint32 levelIndex,
+   ossim_int64 row,
+   ossim_int64 col,
+   ossimImageSource* source,
+   ossimCodecBase* fullTileCodec,
+   ossimCodecBase* partialTileCodec,
+   bool writeBlanks,
+   EncodedTileQueue& queue ) const
+{
+   const PyramidLevel& level = levels[levelIndex];
+   ossimIpt origin( level.m_expandedAoi.ul().x + (ossim_int32)col * m_tileSize.x,
+                    level.m_expandedAoi.ul().y + (ossim_int32)row * m_tileSize.y );
+   ossimIrect rect( origin.x, origin.y,
+                    origin.x + m_tileSize.x - 1, origin.y + m_tileSize.y - 1 );
+   
+   ossimRefPtr<ossimImageData> result = 0;
+   
+   if ( levelIndex + 1 == levels.size() )
+   {
+      // Full res level, from the input.
+      ossimRefPtr<ossimImageData> tile = source->getTile( rect );
+      if ( !tile.valid() )
+      {
+         std::ostringstream errMsg;
+         errMsg << "ossimGpkgWriter::writeTiles ERROR: "
+                << "Input returned null tile pointer for ("
+                << col << ", " << row << ")";
+         throw ossimException( errMsg.str() );
+      }
+      if ( tile->getDataObjectStatus() != OSSIM_NULL )
+      {
+         // Copy as the source reuses its tile on the next getTile.
+         result = (ossimImageData*)tile->dup();
+      }
+   }
+   else
+   {
+      // Depth first so only four tiles per level are held at a time.
+      std::vector< ossimRefPtr<ossimImageData> > quads( 4 );
+      for ( ossim_uint32 q = 0; q < 4; ++q )
+      {
+         quads[q] = buildPyramidTile( levels, levelIndex + 1,
+                                      row * 2 + q / 2, col * 2 + q % 2,
+                                      source, fullTileCodec, partialTileCodec,
+                                      writeBlanks, queue );
+         if ( queue.isClosed() )
+         {
+            return 0;
+         }
+      }
+      result = reduceTile( quads, rect );
+   }
+
+   EncodedTile encoded;
+   encoded.m_zoomLevel = level.m_zoomLevel;
+   encoded.m_row = row;
+   encoded.m_col = col;
+   if ( isTileWritable( result.get(), writeBlanks ) )
+   {
+      if ( !encodeTile( result, fullTileCodec, partialTileCodec, encoded.m_data ) )
+      {
+         encoded.m_data.clear();
+      }
+   }
+   queue.push( encoded );
+
+   return result;
+}
+
+bool ossimGpkgWriter::copyEncodedZoomLevels( sqlite3* db,
+                                             ossimMapProjection* proj,
+                                             const std::vector<ossim_int32>& zoomLevels )
+{
+   static const char MODULE[] = "ossimGpkgWriter::copyEncodedZoomLevels";
+
+   const ossim_uint32 LEVELS = (ossim_uint32)zoomLevels.size();
+   if ( !copyEncodedTiles() || !LEVELS )
+   {
+      return false;
+   }
+
+   ossimGpkgReader* source = getEncodedTileSource();
+   const ossimGpkgTileEntry* entry = source ? source->getTileEntry() : 0;
+   if ( !entry ||
+        ( entry->getSrs().m_organization_coordsys_id != (ossim_int32)proj->getPcsCode() ) )
+   {
+      return false;
+   }
+
+   // Lay the levels out on a copy of the projection, coarsest first.
+   ossimRefPtr<ossimMapProjection> levelProj =
+      dynamic_cast<ossimMapProjection*>( proj->dup() );
+   if ( !levelProj.valid() )
+   {
+      return false;
+   }
+
+   std::vector<PyramidLevel> levels( LEVELS );
+   for ( ossim_uint32 i = 0; i < LEVELS; ++i )
+   {
+      if ( i )
+      {
+         ossimDpt scale( 0.5, 0.5 );
+         levelProj->applyScale( scale, true );
+         levelProj->update();
+      }
+      
+      PyramidLevel& level = levels[i];
+      level.m_zoomLevel = zoomLevels[i];
+      getGsd( levelProj.get(), level.m_gsd );
+      
+      ossimIrect aoi;
+      getAoiFromRect( levelProj.get(), m_outputRect, aoi );
+      getAoiFromRect( levelProj.get(), m_clipRect, level.m_clippedAoi );
+      getExpandedAoi( aoi, level.m_expandedAoi );
+      getMatrixSize( level.m_expandedAoi, level.m_matrixSize );
+   }
+
+   //---
+   // Source tile indexes must be ours, i.e. same tile matrix set to within
+   // half a full res pixel and the same matrix at every level.
+   //---
+   ossimDrect sourceRect;
+   entry->getTileMatrixSet().getRect( sourceRect );
+   const ossimDpt TOLERANCE = levels[LEVELS-1].m_gsd * 0.5;
+   bool compatible =
+      ( std::fabs( sourceRect.ul().x - m_outputRect.ul().x ) < TOLERANCE.x ) &&
+      ( std::fabs( sourceRect.ul().y - m_outputRect.ul().y ) < TOLERANCE.y ) &&
+      ( std::fabs( sourceRect.lr().x - m_outputRect.lr().x ) < TOLERANCE.x ) &&
+      ( std::fabs( sourceRect.lr().y - m_outputRect.lr().y ) < TOLERANCE.y );
+   
+   const std::vector<ossimGpkgTileMatrixRecord>& matrix = entry->getTileMatrix();
+   for ( ossim_uint32 i = 0; compatible && ( i < LEVELS ); ++i )
+   {
+      const PyramidLevel& level = levels[i];
+      compatible = false;
+      for ( std::size_t j = 0; j < matrix.size(); ++j )
+      {
+         const ossimGpkgTileMatrixRecord& record = matrix[j];
+         if ( record.m_zoom_level == level.m_zoomLevel )
+         {
+            compatible =
+               ( record.m_matrix_width  == level.m_matrixSize.x ) &&
+               ( record.m_matrix_height == level.m_matrixSize.y ) &&
+               ( record.m_tile_width    == m_tileSize.x ) &&
+               ( record.m_tile_height   == m_tileSize.y ) &&
+               ( std::fabs( record.m_pixel_x_size - level.m_gsd.x ) < level.m_gsd.x * 1.0e-6 ) &&
+               ( std::fabs( record.m_pixel_y_size - level.m_gsd.y ) < level.m_gsd.y * 1.0e-6 ) &&
+               ( level.m_expandedAoi.ul() == ossimIpt( 0, 0 ) );
+            break;
+         }
+      }
+   }
+
+   if ( !compatible )
+   {
+      if (traceDebug())
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << MODULE << " DEBUG: tiling of "
+            << entry->getTileMatrixSet().m_table_name
+            << " does not match, writing levels from input.\n";
+      }
+      return false;
+   }
+
+   sqlite3_stmt* pStmt = 0;
+   std::ostringstream sql;
+   sql << "INSERT INTO " << getInsertTableName() << "( zoom_level, tile_column, tile_row, tile_data ) VALUES ( "
+       << "?, " // 1: zoom level
+       << "?, " // 2: col
+       << "?, " // 3: row
+       << "?"   // 4: blob
+       << " )";
+   if ( sqlite3_prepare_v2( db, sql.str().c_str(), -1, &pStmt, NULL ) != SQLITE_OK )
+   {
+      ossimNotify(ossimNotifyLevel_WARN)
+         << "sqlite3_prepare_v2 error: " << sqlite3_errmsg(db) << std::endl;
+      sqlite3_finalize( pStmt );
+      return false;
+   }
+
+   //---
+   // Blobs not in an encoding the writer mode produces are transcoded.  Png
+   // mode writes no alpha; pnga and mixed partials always have it.
+   //---
+   ossim::WriterMode mode = getWriterMode();
+   const bool COPY_JPEG = ( mode == ossim::JPEG ) || ( mode == ossim::MIXED ) ||
+                          ( mode == ossim::JPEGWEBP );
+   const bool COPY_PNG  = ( mode == ossim::PNG );
+   const bool COPY_PNGA = ( mode == ossim::PNGA ) || ( mode == ossim::MIXED );
+   const bool COPY_WEBP = usesWebp();
+   ossimRefPtr<ossimCodecBase> jpegCodec =
+      ossimCodecFactoryRegistry::instance()->createCodec( ossimString("jpeg") );
+   ossimRefPtr<ossimCodecBase> pngCodec =
+      ossimCodecFactoryRegistry::instance()->createCodec( ossimString("png") );
+   ossimRefPtr<ossimCodecBase> webpCodec =
+      ossimCodecFactoryRegistry::instance()->createCodec( ossimString("webp") );
+
+   bool writeBlanks = keyIsTrue( INCLUDE_BLANK_TILES_KW );
+
+   ossim_float64 totalTiles   = 0.0;
+   ossim_float64 tilesWritten = 0.0;
+   for ( ossim_uint32 i = 0; i < LEVELS; ++i )
+   {
+      totalTiles += ossim_float64(levels[i].m_matrixSize.x) * ossim_float64(levels[i].m_matrixSize.y);
+   }
+   
+   ossim_int64 copied     = 0;
+   ossim_int64 transcoded = 0;
+   ossim_int64 fromInput  = 0;
+   
+   std::vector<ossim_uint8> data;
+   std::string mimeType;
+   
+   for ( ossim_uint32 i = 0; i < LEVELS; ++i )
+   {
+      const PyramidLevel& level = levels[i];
+
+      if ( i )
+      {
+         ossimDpt scale( 0.5, 0.5 );
+         proj->applyScale( scale, true );
+         proj->update();
+      }
+      
+      // Propagate projection to chains and update aoi's of cutters.
+      setView( proj );
+      
+      if ( traceDebug() )
+      {
+         ossimNotify(ossimNotifyLevel_DEBUG)
+            << MODULE << " DEBUG:"
+            << "\nlevel:       " << level.m_zoomLevel
+            << "\ngsd:         " << level.m_gsd
+            << "\nclippedAoi:  " << level.m_clippedAoi
+            << "\nexpandedAoi: " << level.m_expandedAoi
+            << "\nmatrixSize:  " << level.m_matrixSize
+            << "\n";
+      }
+      
+      if ( writeGpkgTileMatrixTable( db, level.m_zoomLevel, level.m_matrixSize, level.m_gsd ) )
+      {
+         if ( !writeGpkgNsgTileMatrixExtentTable( db, level.m_zoomLevel,
+                                                  level.m_expandedAoi, level.m_clippedAoi ) )
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << MODULE
+               << " WARNING:\nwriteGpkgNsgTileMatrixExtentTable call failed!" << std::endl;
+         }
+      }
+      else
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << MODULE
+            << " WARNING:\nwriteGpkgTileMatrixTable call failed!" << std::endl;
+      }
+      
+      if ( isLevelIngested( level.m_zoomLevel ) )
+      {
+         // Finished by a killed bulk ingest.
+         tilesWritten += ossim_float64(level.m_matrixSize.x) * ossim_float64(level.m_matrixSize.y);
+         continue;
+      }
+      
+      for ( ossim_int32 row = 0; row < level.m_matrixSize.y; ++row )
+      {
+         for ( ossim_int32 col = 0; col < level.m_matrixSize.x; ++col )
+         {
+            ossimIrect tileRect( col * m_tileSize.x,
+                                 row * m_tileSize.y,
+                                 col * m_tileSize.x + m_tileSize.x - 1,
+                                 row * m_tileSize.y + m_tileSize.y - 1 );
+            
+            EncodedTile encoded;
+            encoded.m_zoomLevel = level.m_zoomLevel;
+            encoded.m_row = row;
+            encoded.m_col = col;
+
+            // Tiles the clip rect cuts through are cut by the input chain.
+            if ( tileRect.completely_within( level.m_clippedAoi ) &&
+                 source->getEncodedTile( level.m_zoomLevel, col, row, data, mimeType ) )
+            {
+               bool copy = false;
+               ossimCodecBase* codec = 0;
+               if ( mimeType == "image/jpeg" )
+               {
+                  copy  = COPY_JPEG;
+                  codec = jpegCodec.get();
+               }
+               else if ( mimeType == "image/png" )
+               {
+                  copy  = pngHasAlpha( data ) ? COPY_PNGA : COPY_PNG;
+                  codec = pngCodec.get();
+               }
+               else if ( mimeType == "image/webp" )
+               {
+                  copy  = COPY_WEBP;
+                  codec = webpCodec.get();
+               }
+               
+               if ( copy )
+               {
+                  encoded.m_data.swap( data );
+                  ++copied;
+               }
+               else if ( codec )
+               {
+                  ossimRefPtr<ossimImageData> tile = 0;
+                  if ( codec->decode( data, tile ) && tile.valid() )
+                  {
+                     tile->validate();
+                     if ( encodeTile( tile, m_fullTileCodec.get(),
+                                      m_partialTileCodec.get(), encoded.m_data ) )
+                     {
+                        ++transcoded;
+                     }
+                  }
+               }
+            }
+            
+            if ( encoded.m_data.empty() )
+            {
+               // Missing from the source, on the clip edge or not decodable.
+               ossimRefPtr<ossimImageData> tile = theInputConnection->getTile( tileRect );
+               if ( tile.valid() &&
+                    ( tile->getDataObjectStatus() != OSSIM_NULL ) &&
+                    ( ( tile->getDataObjectStatus() != OSSIM_EMPTY ) || writeBlanks ) )
+               {
+                  if ( encodeTile( tile, m_fullTileCodec.get(),
+                                   m_partialTileCodec.get(), encoded.m_data ) )
+                  {
+                     ++fromInput;
+                  }
+               }
+            }
+            
+            insertEncodedTile( db, pStmt, encoded );
+            
+            // Always increment the tiles written thing.
+            ++tilesWritten;
+            
+            if ( needsAborting() ) break;
+         }
+         
+         setPercentComplete( (tilesWritten / totalTiles) * 100.0 );
+         
+         if ( needsAborting() ) break;
+      }
+      
+      if ( needsAborting() )
+      {
+         setPercentComplete( 100 );
+         break;
+      }
+      
+      if ( m_ingestTableName.size() )
+      {
+         checkpointIngest( db, level.m_zoomLevel );
+      }
+   }
+   
+   sqlite3_finalize( pStmt );
+   
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << MODULE << " DEBUG:"
+         << "\ntiles copied:     " << copied
+         << "\ntiles transcoded: " << transcoded
+         << "\ntiles from input: " << fromInput
+         << "\n";
+   }
+   
+   return true;
+   
+} // End: ossimGpkgWriter::copyEncodedZoomLevels( ... )
+
+ossimGpkgReader* ossimGpkgWriter::getEncodedTileSource() const
+{
+   ossimGpkgReader* result = 0;
+   
+   if ( theInputConnection.valid() )
+   {
+      ossimTypeNameVisitor visitor( ossimString("ossimImageSource"),
+                                    false, // firstofTypeFlag
+                                    (ossimVisitor::VISIT_INPUTS|
+                                     ossimVisitor::VISIT_CHILDREN) );
+      theInputConnection->accept( visitor );
+      
+      for( ossim_uint32 i = 0; i < visitor.getObjects().size(); ++i )
+      {
+         ossimImageSource* source = visitor.getObjectAs<ossimImageSource>( i );
+         if ( !source )
+         {
+            continue;
+         }
+         
+         ossimGpkgReader* reader = dynamic_cast<ossimGpkgReader*>( source );
+         if ( reader )
+         {
+            if ( result && ( result != reader ) )
+            {
+               return 0; // Mosaic.
+            }
+            result = reader;
+            continue;
+         }
+         
+         //---
+         // Everything else must pass pixels through.  The renderer does when
+         // the output tiling matches the reader's, which is checked by the
+         // caller.
+         //---
+         std::string className = source->getClassName().string();
+         if ( ( className == "ossimImageSourceSequencer" ) ||
+              ( className == "ossimImageChain" ) ||
+              ( className == "ossimCacheTileSource" ) ||
+              ( className == "ossimImageRenderer" ) ||
+              ( className == "ossimRectangleCutFilter" ) )
+         {
+            continue;
+         }
+         
+         if ( dynamic_cast<ossimScalarRemapper*>( source ) &&
+              ( source->getOutputScalarType() == OSSIM_UINT8 ) &&
+              source->getInput(0) )
+         {
+            ossimImageSource* input = dynamic_cast<ossimImageSource*>( source->getInput(0) );
+            if ( input && ( input->getOutputScalarType() == OSSIM_UINT8 ) )
+            {
+               continue;
+            }
+         }
+         
+         return 0;
+      }
+   }
+   
+   return result;
+}
+
+bool ossimGpkgWriter::updateEntry( const ossimGpkgTileEntry& entry )
+{
+   static const char MODULE[] = "ossimGpkgWriter::updateEntry";
+
+   bool status = false;
+   
+   // Get the image geometry from the input.   
+   ossimRefPtr<ossimImageGeometry> geom = theInputConnection->getImageGeometry();
+   
+   // Input projection:
+   ossimRefPtr<ossimMapProjection> sourceProj =
+      geom.valid() ? geom->getAsMapProjection() : 0;
+   
+   // Raw area of interest:
+   ossimIrect sourceAoi = getAreaOfInterest();
+
+   // Existing levels, finest first:
+   std::vector<ossimGpkgTileMatrixRecord> levels = entry.getTileMatrix();
+   std::sort( levels.begin(), levels.end(), isFinerLevel );
+   
+   if ( geom.valid() && sourceProj.valid() && (sourceAoi.hasNans() == false) &&
+        levels.size() )
+   {
+      ossimRefPtr<ossimMapProjection> productProjection =
+         getNewOutputProjection( geom.get() );
+      
+      // productProjection must match what's already in there.
+      if ( productProjection.valid() &&
+           ( entry.getSrs().m_organization_coordsys_id ==
+             (ossim_int32)productProjection->getPcsCode() ) )
+      {
+         initializeRect( sourceProj.get(), sourceAoi, m_sceneBoundingRect );
+         entry.getTileMatrixSet().getRect( m_outputRect );
+         
+         status = true;
+         
+         if ( m_sceneBoundingRect.intersects( m_outputRect ) )
+         {
+            m_clipRect = m_sceneBoundingRect.clipToRect( m_outputRect );
+            
+            // Tile size of the existing entry.
+            levels[0].getTileSize( m_tileSize );
+            theInputConnection->setTileSize( m_tileSize );
+            
+            if (traceDebug())
+            {
+               ossimNotify(ossimNotifyLevel_DEBUG)
+                  << MODULE << " DEBUG:"
+                  << "\nscene rect:   " << m_sceneBoundingRect
+                  << "\nclip rect:    " << m_clipRect
+                  << "\noutput rect:  " << m_outputRect
+                  << "\ntile size:    " << m_tileSize
+                  << "\n";
+            }
+            
+            initializeCodec(); // Throws exception on error.
+            
+            bool writeBlanks = keyIsTrue( INCLUDE_BLANK_TILES_KW );
+            
+            // Replaces stored tiles.
+            sqlite3_stmt* pStmt = 0;
+            std::ostringstream sql;
+            sql << "INSERT OR REPLACE INTO " << m_tileTableName
+                << "( zoom_level, tile_column, tile_row, tile_data ) VALUES ( "
+                << "?, " // 1: zoom level
+                << "?, " // 2: col
+                << "?, " // 3: row
+                << "?"   // 4: blob
+                << " )";
+            if ( sqlite3_prepare_v2( m_db, sql.str().c_str(), -1, &pStmt, NULL ) == SQLITE_OK )
+            {
+               StoredTileReader stored( m_db, m_tileTableName );
+               
+               // Tiles written at the previous(finer) level.
+               TileSet changed;
+               
+               for ( std::size_t i = 0; i < levels.size(); ++i )
+               {
+                  const ossimGpkgTileMatrixRecord& level = levels[i];
+                  
+                  bool nested = false;
+                  if ( i )
+                  {
+                     const ossimGpkgTileMatrixRecord& child = levels[i-1];
+                     nested = ( ( level.m_zoom_level == child.m_zoom_level - 1 ) &&
+                                ( child.m_matrix_width  == level.m_matrix_width * 2 ) &&
+                                ( child.m_matrix_height == level.m_matrix_height * 2 ) &&
+                                ( child.m_tile_width  == level.m_tile_width ) &&
+                                ( child.m_tile_height == level.m_tile_height ) );
+                  }
+                  
+                  if ( nested )
+                  {
+                     TileSet parents;
+                     for ( TileSet::const_iterator t = changed.begin(); t != changed.end(); ++t )
+                     {
+                        parents.insert( std::make_pair( t->first / 2, t->second / 2 ) );
+                     }
+                     updateParentTiles( m_db, pStmt, stored, levels[i-1], level,
+                                        writeBlanks, parents );
+                     changed.swap( parents );
+                  }
+                  else
+                  {
+                     changed.clear();
+                     updateTilesFromInput( m_db, pStmt, stored, productProjection.get(),
+                                           level, writeBlanks, changed );
+                  }
+                  
+                  if (traceDebug())
+                  {
+                     ossimNotify(ossimNotifyLevel_DEBUG)
+                        << MODULE << " DEBUG: level " << level.m_zoom_level
+                        << ( nested ? " reduced" : " read" )
+                        << ", tiles written: " << changed.size() << "\n";
+                  }
+                  
+                  setPercentComplete( ( ( i + 1 ) * 100.0 ) / levels.size() );
+                  
+                  if ( needsAborting() ) break;
+               }
+            }
+            else
+            {
+               ossimNotify(ossimNotifyLevel_WARN)
+                  << "sqlite3_prepare_v2 error: " << sqlite3_errmsg(m_db) << std::endl;
+               status = false;
+            }
+            
+            sqlite3_finalize( pStmt );
+            
+            if ( m_batchCount )
+            {
+               char* sErrMsg = 0;
+               sqlite3_exec(m_db, "END TRANSACTION", NULL, NULL, &sErrMsg);
+               m_batchCount = 0;
+            }
+         }
+      }
+      else
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << MODULE << " WARNING: Input projection does not match "
+            << m_tileTableName << std::endl;
+      }
+   }
+   
+   return status;
+   
+} // End: ossimGpkgWriter::updateEntry( ... )
+
+void ossimGpkgWriter::updateTilesFromInput( sqlite3* db,
+                                            sqlite3_stmt* pStmt,
+                                            StoredTileReader& stored,
+                                            ossimMapProjection* proj,
+                                            const ossimGpkgTileMatrixRecord& level,
+                                            bool writeBlanks,
+                                            TileSet& changed )
+{
+   // Image space of the level, (0,0) at the tile matrix origin.
+   ossimDpt gsd;
+   level.getGsd( gsd );
+   ossimDpt halfGsd = gsd/2.0;
+   if ( proj->isGeographic() )
+   {
+      proj->setDecimalDegreesPerPixel( gsd );
+      proj->setUlTiePoints( ossimGpt( m_outputRect.ul().y - halfGsd.y,
+                                      m_outputRect.ul().x + halfGsd.x, 0.0 ) );
+   }
+   else
+   {
+      proj->setMetersPerPixel( gsd );
+      proj->setUlTiePoints( ossimDpt( m_outputRect.ul().x + halfGsd.x,
+                                      m_outputRect.ul().y - halfGsd.y ) );
+   }
+   proj->update();
+   
+   // Propagate projection to chains and update aoi's of cutters.
+   setView( proj );
+   
+   // Tiles touched by the input:
+   ossimIrect clippedAoi;
+   getAoiFromRect( proj, m_clipRect, clippedAoi );
+   
+   const ossim_int32 TW = m_tileSize.x;
+   const ossim_int32 TH = m_tileSize.y;
+   const ossim_int32 COL0 = std::max<ossim_int32>( 0, clippedAoi.ul().x / TW );
+   const ossim_int32 ROW0 = std::max<ossim_int32>( 0, clippedAoi.ul().y / TH );
+   const ossim_int32 COL1 = std::min<ossim_int32>( level.m_matrix_width - 1,
+                                                   clippedAoi.lr().x / TW );
+   const ossim_int32 ROW1 = std::min<ossim_int32>( level.m_matrix_height - 1,
+                                                   clippedAoi.lr().y / TH );
+   if ( ( COL0 > COL1 ) || ( ROW0 > ROW1 ) )
+   {
+      return;
+   }
+   
+   // Initialize the sequencer:
+   theInputConnection->setAreaOfInterest(
+      ossimIrect( COL0 * TW, ROW0 * TH, ( COL1 + 1 ) * TW - 1, ( ROW1 + 1 ) * TH - 1 ) );
+   theInputConnection->setToStartOfSequence();
+   
+   for ( ossim_int32 row = ROW0; row <= ROW1; ++row )
+   {
+      for ( ossim_int32 col = COL0; col <= COL1; ++col )
+      {
+         // Grab the tile.
+         ossimRefPtr<ossimImageData> tile = theInputConnection->getNextTile();
+         if ( !tile.valid() )
+         {
+            std::ostringstream errMsg;
+            errMsg << "ossimGpkgWriter::updateTilesFromInput ERROR: "
+                   << "Sequencer returned null tile pointer for ("
+                   << col << ", " << row << ")";
+            
+            throw ossimException( errMsg.str() );
+         }
+         
+         // Stored tile stays as is where the input has nothing.
+         if ( ( tile->getDataObjectStatus() == OSSIM_NULL ) ||
+              ( tile->getDataObjectStatus() == OSSIM_EMPTY ) )
+         {
+            continue;
+         }
+         
+         if ( tile->getDataObjectStatus() == OSSIM_PARTIAL )
+         {
+            ossimRefPtr<ossimImageData> under = stored.read( level.m_zoom_level, col, row );
+            if ( under.valid() )
+            {
+               // Sequencer tile may be cached by the input; work on a copy.
+               tile = (ossimImageData*)tile->dup();
+               compositeTile( under.get(), tile.get() );
+            }
+         }
+         
+         EncodedTile encoded;
+         encoded.m_zoomLevel = level.m_zoom_level;
+         encoded.m_row = row;
+         encoded.m_col = col;
+         if ( isTileWritable( tile.get(), writeBlanks ) &&
+              encodeTile( tile, m_fullTileCodec.get(), m_partialTileCodec.get(),
+                          encoded.m_data ) )
+         {
+            insertEncodedTile( db, pStmt, encoded );
+            changed.insert( std::make_pair( col, row ) );
+         }
+         
+         if ( needsAborting() ) return;
+      }
+   }
+}
+
+void ossimGpkgWriter::updateParentTiles( sqlite3* db,
+                                         sqlite3_stmt* pStmt,
+                                         StoredTileReader& stored,
+                                         const ossimGpkgTileMatrixRecord& childLevel,
+                                         const ossimGpkgTileMatrixRecord& level,
+                                         bool writeBlanks,
+                                         const TileSet& parents )
+{
+   const ossim_int32 TW = m_tileSize.x;
+   const ossim_int32 TH = m_tileSize.y;
+   std::vector< ossimRefPtr<ossimImageData> > quads( 4 );
+   
+   for ( TileSet::const_iterator p = parents.begin(); p != parents.end(); ++p )
+   {
+      // Children ul, ur, ll, lr, already rewritten at the child level.
+      const ossimImageData* first = 0;
+      for ( ossim_uint32 q = 0; q < 4; ++q )
+      {
+         quads[q] = stored.read( childLevel.m_zoom_level,
+                                 p->first * 2 + q % 2, p->second * 2 + q / 2 );
+         if ( quads[q].valid() )
+         {
+            if ( !first )
+            {
+               first = quads[q].get();
+            }
+            else if ( ( quads[q]->getNumberOfBands() != first->getNumberOfBands() ) ||
+                      ( quads[q]->getScalarType() != first->getScalarType() ) ||
+                      ( quads[q]->getSizePerBand() != first->getSizePerBand() ) )
+            {
+               quads[q] = 0; // Cannot be reduced with the others.
+            }
+         }
+      }
+      
+      ossimIpt origin( p->first * TW, p->second * TH );
+      ossimRefPtr<ossimImageData> tile =
+         reduceTile( quads, ossimIrect( origin.x, origin.y,
+                                        origin.x + TW - 1, origin.y + TH - 1 ) );
+      
+      EncodedTile encoded;
+      encoded.m_zoomLevel = level.m_zoom_level;
+      encoded.m_row = p->second;
+      encoded.m_col = p->first;
+      if ( isTileWritable( tile.get(), writeBlanks ) &&
+           encodeTile( tile, m_fullTileCodec.get(), m_partialTileCodec.get(),
+                       encoded.m_data ) )
+      {
+         insertEncodedTile( db, pStmt, encoded );
+      }
+      
+      if ( needsAborting() ) break;
+   }
+}
+
+bool ossimGpkgWriter::cacheUniformTiles() const
+{
+   // Default is on.
+   bool result = true;
+   std::string value = m_kwl->findKey( CACHE_UNIFORM_TILES_KW );
+   if ( value.size() )
+   {
+      result = ossimString(value).toBool();
+   }
+   return result;
+}
+
+bool ossimGpkgWriter::copyEncodedTiles() const
+{
+   // Default is on.
+   bool result = true;
+   std::string value = m_kwl->findKey( COPY_ENCODED_TILES_KW );
+   if ( value.size() )
+   {
+      result = ossimString(value).toBool();
+   }
+   return result;
+}
+
+bool ossimGpkgWriter::reduceLevels() const
+{
+   // Default is on.
+   bool result = true;
+   std::string value = m_kwl->findKey( REDUCE_LEVELS_KW );
+   if ( value.size() )
+   {
+      result = ossimString(value).toBool();
+   }
+   return result;
+}
+
+void ossimGpkgWriter::cloneInputChains(
+   ossim_uint32 count, std::vector< ossimRefPtr<ossimImageSource> >& clones ) const
+{
+   clones.clear();
+   if ( theInputConnection.valid() )
+   {
+      ossimImageSource* input =
+         dynamic_cast<ossimImageSource*>( theInputConnection->getInput(0) );
+      for ( ossim_uint32 i = 0; i < count; ++i )
+      {
+         ossimRefPtr<ossimImageSource> clone = cloneSource( input );
+         if ( clone.valid() )
+         {
+            clone->initialize();
+         }
+
+         // A clone that does not look like the input would write wrong tiles.
+         if ( !clone.valid() ||
+              ( clone->getBoundingRect() != input->getBoundingRect() ) ||
+              ( clone->getNumberOfOutputBands() != input->getNumberOfOutputBands() ) ||
+              ( clone->getOutputScalarType() != input->getOutputScalarType() ) )
+         {
+            clones.clear();
+            break;
+         }
+         clones.push_back( clone );
+      }
+   }
+
+   if (traceDebug())
+   {
+      ossimNotify(ossimNotifyLevel_DEBUG)
+         << "ossimGpkgWriter::cloneInputChains DEBUG: cloned input chains: "
+         << clones.size() << std::endl;
+   }
+}
+
+ossim_uint32 ossimGpkgWriter::getNumberOfThreads() const
+{
+   ossim_uint32 threads = 1;
+   std::string value = m_kwl->findKey( THREADS_KW );
+   if ( value.size() )
+   {
+      threads = ossimString(value).toUInt32();
+      if ( threads == 0 )
+      {
+         threads = std::thread::hardware_concurrency();
+      }
+   }
+   return std::max<ossim_uint32>( 1, threads );
+}
+
+bool ossimGpkgWriter::bulkIngest() const
+{
+   return keyIsTrue( BULK_INGEST_KW );
+}
+
+void ossimGpkgWriter::getIngestTableName( std::string& ingestTableName ) const
+{
+   getTileTableName( ingestTableName );
+   ingestTableName += "_ingest";
+}
+
+bool ossimGpkgWriter::canResumeIngest() const
+{
+   bool status = false;
+   sqlite3* db = 0;
+   if ( sqlite3_open_v2( theFilename.c_str(), &db, SQLITE_OPEN_READONLY, 0 ) == SQLITE_OK )
+   {
+      std::string ingestTableName;
+      getIngestTableName( ingestTableName );
+      if ( ossim_sqlite::tableExists( db, ingestTableName ) )
+      {
+         // No journal while ingesting, so a kill during a commit can corrupt the file.
+         sqlite3_stmt* pStmt = 0;
+         if ( sqlite3_prepare_v2( db, "PRAGMA quick_check", -1, &pStmt, NULL ) == SQLITE_OK )
+         {
+            if ( sqlite3_step( pStmt ) == SQLITE_ROW )
+            {
+               const char* result = (const char*)sqlite3_column_text( pStmt, 0 );
+               status = ( result && ( std::string(result) == "ok" ) );
+            }
+         }
+         sqlite3_finalize( pStmt );
+
+         if ( !status )
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << "ossimGpkgWriter::canResumeIngest WARNING: "
+               << theFilename << " failed integrity check, starting over." << std::endl;
+         }
+         else
+         {
+            std::string tileTableName;
+            std::string fingerprint;
+            std::string storedFingerprint;
+            getTileTableName( tileTableName );
+            getIngestFingerprint( fingerprint );
+            status = getStoredIngestFingerprint( db, tileTableName, storedFingerprint ) &&
+                     ( storedFingerprint == fingerprint );
+            if ( !status )
+            {
+               ossimNotify(ossimNotifyLevel_WARN)
+                  << "ossimGpkgWriter::canResumeIngest WARNING: "
+                  << ingestTableName << " in " << theFilename
+                  << " was left by a different job, starting over." << std::endl;
+            }
+         }
+      }
+   }
+   sqlite3_close( db );
+   return status;
+}
+
+bool ossimGpkgWriter::beginIngest( sqlite3* db )
+{
+   bool status = false;
+   m_ingestedLevels.clear();
+   
+   if ( db )
+   {
+      getIngestTableName( m_ingestTableName );
+      m_resumeIngest = ossim_sqlite::tableExists( db, m_ingestTableName );
 
-                        if(m_batchCount == m_batchSize)
-                        {
-                           sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &sErrMsg);
-                           m_batchCount = 0;
-                        }
-                     }
-                  }
-               }
-               else
-               {
-                  std::ostringstream errMsg;
-                  errMsg << "ossimGpkgWriter::writeTiles ERROR: "
-                         << "Sequencer returned null tile pointer for ("
-                         << col << ", " << row << ")";
-                  
-                  throw ossimException( errMsg.str() );
-               }
+      std::string fingerprint;
+      getIngestFingerprint( fingerprint );
 
-               // Always increment the tiles written thing.
-               ++tilesWritten;
+      std::ostringstream sql;
+      if ( m_resumeIngest )
+      {
+         // A staging table from another job must not be merged into this entry.
+         std::string storedFingerprint;
+         if ( !getStoredIngestFingerprint( db, m_tileTableName, storedFingerprint ) ||
+              ( storedFingerprint != fingerprint ) )
+         {
+            ossimNotify(ossimNotifyLevel_WARN)
+               << "ossimGpkgWriter::beginIngest WARNING: " << m_ingestTableName
+               << " was left by a different job, starting over." << std::endl;
 
-               if ( needsAborting() ) break;
-               
-            } // End: col loop
+            ossim_sqlite::exec( db, std::string("DROP TABLE ") + m_ingestTableName );
+            if ( ossim_sqlite::tableExists( db, INGEST_PROGRESS_TABLE ) )
+            {
+               sql << "DELETE FROM " << INGEST_PROGRESS_TABLE
+                   << " WHERE table_name = '" << m_tileTableName << "'";
+               ossim_sqlite::exec( db, sql.str() );
+            }
+            m_resumeIngest = false;
+         }
+      }
 
-            setPercentComplete( (tilesWritten / totalTiles) * 100.0 );
+      // 256 MiB page cache.  Journal and sync are already off, see open().
+      ossim_sqlite::exec( db, std::string("PRAGMA cache_size = -262144") );
 
-            if ( needsAborting() )
+      // No constraints, key index is built at the end.
+      sql.str("");
+      sql << "CREATE TABLE IF NOT EXISTS " << m_ingestTableName << " ( "
+          << "zoom_level INTEGER NOT NULL, "
+          << "tile_column INTEGER NOT NULL, "
+          << "tile_row INTEGER NOT NULL, "
+          << "tile_data BLOB NOT NULL "
+          << ")";
+      status = ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE );
+
+      if ( status )
+      {
+         sql.str("");
+         sql << "CREATE TABLE IF NOT EXISTS " << INGEST_PROGRESS_TABLE << " ( "
+             << "table_name TEXT NOT NULL, "
+             << "zoom_level INTEGER NOT NULL, "
+             << "fingerprint TEXT, "
+             << "PRIMARY KEY (table_name, zoom_level) "
+             << ")";
+         status = ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE );
+      }
+
+      if ( status && !m_resumeIngest )
+      {
+         // Job record, checked by a later run before resuming.
+         sql.str("");
+         sql << "INSERT OR REPLACE INTO " << INGEST_PROGRESS_TABLE
+             << " ( table_name, zoom_level, fingerprint ) VALUES ( ?, "
+             << INGEST_JOB_LEVEL << ", ? )";
+         sqlite3_stmt* pStmt = 0;
+         status = ( sqlite3_prepare_v2( db, sql.str().c_str(), -1, &pStmt, NULL ) == SQLITE_OK );
+         if ( status )
+         {
+            sqlite3_bind_text( pStmt, 1, m_tileTableName.c_str(), -1, SQLITE_TRANSIENT );
+            sqlite3_bind_text( pStmt, 2, fingerprint.c_str(), -1, SQLITE_TRANSIENT );
+            status = ( sqlite3_step( pStmt ) == SQLITE_DONE );
+         }
+         sqlite3_finalize( pStmt );
+      }
+      
+      if ( status && m_resumeIngest )
+      {
+         sql.str("");
+         sql << "SELECT zoom_level FROM " << INGEST_PROGRESS_TABLE
+             << " WHERE table_name = '" << m_tileTableName << "'"
+             << " AND zoom_level != " << INGEST_JOB_LEVEL;
+         sqlite3_stmt* pStmt = 0;
+         if ( sqlite3_prepare_v2( db, sql.str().c_str(), -1, &pStmt, NULL ) == SQLITE_OK )
+         {
+            while ( sqlite3_step( pStmt ) == SQLITE_ROW )
             {
-               setPercentComplete( 100 );
-               break;
+               m_ingestedLevels.push_back( sqlite3_column_int( pStmt, 0 ) );
             }
-             
-         } // End: row loop
-
-         sqlite3_finalize(pStmt);
+         }
+         sqlite3_finalize( pStmt );
+
+         // Drop what was written of unfinished levels.
+         sql.str("");
+         sql << "DELETE FROM " << m_ingestTableName << " WHERE zoom_level NOT IN "
+             << "( SELECT zoom_level FROM " << INGEST_PROGRESS_TABLE
+             << " WHERE table_name = '" << m_tileTableName << "'"
+             << " AND zoom_level != " << INGEST_JOB_LEVEL << " )";
+         status = ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE );
+
+         ossimNotify(ossimNotifyLevel_INFO)
+            << "ossimGpkgWriter::beginIngest: resuming " << theFilename
+            << ", finished zoom levels: " << m_ingestedLevels.size() << std::endl;
       }
-      else
+
+      if ( !status )
       {
-         ossimNotify(ossimNotifyLevel_WARN)
-              << "sqlite3_prepare_v2 error: " << sqlite3_errmsg(db) << std::endl;
+         m_ingestTableName.clear();
       }
-     
-   } // if ( db )
+   }
+   
+   return status;
+}
 
-} // End: ossimGpkgWriter::writeTiles( ... )
+void ossimGpkgWriter::checkpointIngest( sqlite3* db, ossim_int32 zoomLevel )
+{
+   if ( m_batchCount )
+   {
+      char* sErrMsg = 0;
+      sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &sErrMsg);
+      m_batchCount = 0;
+   }
+   
+   std::ostringstream sql;
+   sql << "INSERT OR REPLACE INTO " << INGEST_PROGRESS_TABLE
+       << " ( table_name, zoom_level ) VALUES ( '"
+       << m_tileTableName << "', " << zoomLevel << " )";
+   if ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE )
+   {
+      m_ingestedLevels.push_back( zoomLevel );
+   }
+}
 
-void ossimGpkgWriter::writeTile( sqlite3_stmt* pStmt,
-                                 sqlite3* db,
-                                 ossimRefPtr<ossimImageData>& tile,
-                                 ossim_int32 zoomLevel,
-                                 ossim_int64 row,
-                                 ossim_int64 col )
+bool ossimGpkgWriter::isLevelIngested( ossim_int32 zoomLevel ) const
 {
-   if ( db && tile.valid() )
+   return ( std::find( m_ingestedLevels.begin(), m_ingestedLevels.end(), zoomLevel ) !=
+            m_ingestedLevels.end() );
+}
+
+void ossimGpkgWriter::getIngestFingerprint( std::string& fingerprint ) const
+{
+   // Everything that changes which tiles get written, or how.
+   static const std::string KEYS[] =
    {
-      std::vector<ossim_uint8> codecTile; // To hold the jpeg encoded tile.
-      bool encodeStatus;
+      ADD_ALPHA_CHANNEL_KW,
+      ALIGN_TO_GRID_KW,
+      CLIP_EXTENTS_KW,
+      CLIP_EXTENTS_ALIGN_TO_GRID_KW,
+      COMPRESSION_LEVEL_KW,
+      EPSG_KW,
+      INCLUDE_BLANK_TILES_KW,
+      REDUCE_LEVELS_KW,
+      TILE_SIZE_KW,
+      USE_PROJECTION_EXTENTS_KW,
+      WEBP_LOSSLESS_KW,
+      ZOOM_LEVELS_KW
+   };
+
+   std::ostringstream os;
+   os << "aoi: " << theAreaOfInterest
+      << "\n" << WRITER_MODE_KW << ": " << getWriterModeString( getWriterMode() )
+      << "\n" << ossimKeywordNames::COMPRESSION_QUALITY_KW << ": "
+      << getCompressionQuality();
+   for ( std::size_t i = 0; i < sizeof(KEYS) / sizeof(KEYS[0]); ++i )
+   {
+      os << "\n" << KEYS[i] << ": " << m_kwl->findKey( KEYS[i] );
+   }
+
+   if ( theInputConnection.valid() )
+   {
+      os << "\nbands: " << theInputConnection->getNumberOfOutputBands()
+         << "\nscalar_type: " << theInputConnection->getOutputScalarType();
 
-      if ( tile->getDataObjectStatus() == OSSIM_FULL )
+      ossimTypeNameVisitor visitor( ossimString("ossimImageHandler"),
+                                    false, // firstofTypeFlag
+                                    (ossimVisitor::VISIT_INPUTS|
+                                     ossimVisitor::VISIT_CHILDREN) );
+      theInputConnection->accept( visitor );
+      for( ossim_uint32 i = 0; i < visitor.getObjects().size(); ++i )
       {
-         if ( m_fullTileCodecAlpha )
+         ossimImageHandler* handler = visitor.getObjectAs<ossimImageHandler>( i );
+         if ( handler )
          {
-            tile->computeAlphaChannel();
+            os << "\nimage: " << handler->getFilename()
+               << " entry: " << handler->getCurrentEntry();
          }
-         encodeStatus = m_fullTileCodec->encode(tile, codecTile);
       }
-      else
+   }
+
+   fingerprint = os.str();
+}
+
+bool ossimGpkgWriter::getStoredIngestFingerprint( sqlite3* db,
+                                                  const std::string& tileTableName,
+                                                  std::string& fingerprint ) const
+{
+   bool status = false;
+   if ( db && ossim_sqlite::tableExists( db, INGEST_PROGRESS_TABLE ) )
+   {
+      std::ostringstream sql;
+      sql << "SELECT fingerprint FROM " << INGEST_PROGRESS_TABLE
+          << " WHERE table_name = ? AND zoom_level = " << INGEST_JOB_LEVEL;
+      sqlite3_stmt* pStmt = 0;
+      if ( sqlite3_prepare_v2( db, sql.str().c_str(), -1, &pStmt, NULL ) == SQLITE_OK )
       {
-         if ( m_partialTileCodecAlpha )
+         sqlite3_bind_text( pStmt, 1, tileTableName.c_str(), -1, SQLITE_TRANSIENT );
+         if ( sqlite3_step( pStmt ) == SQLITE_ROW )
          {
-            tile->computeAlphaChannel();
+            const char* text = (const char*)sqlite3_column_text( pStmt, 0 );
+            if ( text )
+            {
+               fingerprint = text;
+               status = true;
+            }
          }
-         encodeStatus = m_partialTileCodec->encode(tile, codecTile);
       }
+      sqlite3_finalize( pStmt );
+   }
+   return status;
+}
+
+bool ossimGpkgWriter::finishIngest( sqlite3* db )
+{
+   static const char MODULE[] = "ossimGpkgWriter::finishIngest";
+   
+   bool status = false;
+   
+   if ( db && m_ingestTableName.size() )
+   {
+      // Journal the move so a kill here leaves a file that can be resumed.
+      ossim_sqlite::exec( db, std::string("PRAGMA journal_mode = DELETE") );
       
-      if ( encodeStatus )
+      // Built once from a sort of the keys.
+      std::ostringstream sql;
+      sql << "CREATE INDEX IF NOT EXISTS " << m_ingestTableName << "_key ON "
+          << m_ingestTableName << " ( zoom_level, tile_column, tile_row )";
+      if ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE )
       {
-         // Insert into the database file(gpkg):
-         int rc = sqlite3_bind_int (pStmt, 1, zoomLevel);
-         rc |= sqlite3_bind_int (pStmt, 2, col);
-         rc |= sqlite3_bind_int (pStmt, 3, row);
-         rc |= sqlite3_bind_blob (pStmt,
-                                  4,
-                                  (void*)&codecTile.front(),
-                                  codecTile.size(),
-                                  SQLITE_TRANSIENT);
-         if (  rc == SQLITE_OK )
+         // Columns left to move.
+         std::vector< std::pair<ossim_int32, ossim_int32> > columns;
+         sqlite3_stmt* pStmt = 0;
+         sql.str("");
+         sql << "SELECT DISTINCT zoom_level, tile_column FROM " << m_ingestTableName
+             << " ORDER BY zoom_level, tile_column";
+         if ( sqlite3_prepare_v2( db, sql.str().c_str(), -1, &pStmt, NULL ) == SQLITE_OK )
          {
-            rc = sqlite3_step(pStmt);
-            if (  rc == SQLITE_OK )
+            while ( sqlite3_step( pStmt ) == SQLITE_ROW )
             {
-               ossimNotify(ossimNotifyLevel_WARN)
-                  << "sqlite3_step error: " << sqlite3_errmsg(db) << std::endl;
+               columns.push_back( std::make_pair( sqlite3_column_int( pStmt, 0 ),
+                                                  sqlite3_column_int( pStmt, 1 ) ) );
             }
-            
          }
-         else
+         sqlite3_finalize( pStmt );
+
+         //---
+         // Tiles go in in key order so the tile table unique index is only
+         // appended to.  Deleting each column after its copy frees pages
+         // for the next one instead of doubling the file size.
+         //---
+         sqlite3_stmt* copyStmt   = 0;
+         sqlite3_stmt* deleteStmt = 0;
+         sql.str("");
+         sql << "INSERT INTO " << m_tileTableName
+             << "( zoom_level, tile_column, tile_row, tile_data ) "
+             << "SELECT zoom_level, tile_column, tile_row, tile_data FROM "
+             << m_ingestTableName << " WHERE zoom_level = ? AND tile_column = ? "
+             << "ORDER BY tile_row";
+         int rc = sqlite3_prepare_v2( db, sql.str().c_str(), -1, &copyStmt, NULL );
+         sql.str("");
+         sql << "DELETE FROM " << m_ingestTableName << " WHERE zoom_level = ? AND tile_column = ?";
+         rc |= sqlite3_prepare_v2( db, sql.str().c_str(), -1, &deleteStmt, NULL );
+         status = ( rc == SQLITE_OK );
+
+         char* sErrMsg = 0;
+         for ( std::size_t i = 0; status && ( i < columns.size() ); ++i )
          {
-            ossimNotify(ossimNotifyLevel_WARN)
-               << "sqlite3_bind_blob error: " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &sErrMsg);
+            
+            sqlite3_bind_int( copyStmt, 1, columns[i].first );
+            sqlite3_bind_int( copyStmt, 2, columns[i].second );
+            status = ( sqlite3_step( copyStmt ) == SQLITE_DONE );
+            sqlite3_reset( copyStmt );
+            
+            if ( status )
+            {
+               sqlite3_bind_int( deleteStmt, 1, columns[i].first );
+               sqlite3_bind_int( deleteStmt, 2, columns[i].second );
+               status = ( sqlite3_step( deleteStmt ) == SQLITE_DONE );
+               sqlite3_reset( deleteStmt );
+            }
+            
+            sqlite3_exec(db, status ? "END TRANSACTION" : "ROLLBACK", NULL, NULL, &sErrMsg);
+            
+            if ( needsAborting() )
+            {
+               status = false;
+            }
          }
          
-         sqlite3_clear_bindings(pStmt);
-         sqlite3_reset(pStmt);
+         sqlite3_finalize( copyStmt );
+         sqlite3_finalize( deleteStmt );
+
+         if ( status )
+         {
+            sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &sErrMsg);
+            
+            sql.str("");
+            sql << "DROP TABLE " << m_ingestTableName;
+            status = ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE );
+            
+            sql.str("");
+            sql << "DELETE FROM " << INGEST_PROGRESS_TABLE
+                << " WHERE table_name = '" << m_tileTableName << "'";
+            status = status && ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE );
+            
+            sqlite3_exec(db, status ? "END TRANSACTION" : "ROLLBACK", NULL, NULL, &sErrMsg);
+         }
+
+         if ( status )
+         {
+            // Leave no trace unless another table is mid ingest.
+            sql.str("");
+            sql << "SELECT COUNT(*) FROM " << INGEST_PROGRESS_TABLE;
+            if ( sqlite3_prepare_v2( db, sql.str().c_str(), -1, &pStmt, NULL ) == SQLITE_OK )
+            {
+               if ( ( sqlite3_step( pStmt ) == SQLITE_ROW ) &&
+                    ( sqlite3_column_int64( pStmt, 0 ) == 0 ) )
+               {
+                  sqlite3_finalize( pStmt );
+                  pStmt = 0;
+                  ossim_sqlite::exec( db, std::string("DROP TABLE ") + INGEST_PROGRESS_TABLE );
+               }
+            }
+            sqlite3_finalize( pStmt );
+            
+            m_ingestTableName.clear();
+            m_resumeIngest = false;
+         }
       }
-      
-   } // Matches:  if ( db && tile.valid() )
+
+      ossim_sqlite::exec( db, std::string("PRAGMA journal_mode = OFF") );
+
+      if ( !status )
+      {
+         ossimNotify(ossimNotifyLevel_WARN)
+            << MODULE << " WARNING: Tiles were left in " << m_ingestTableName
+            << ". Run again with \"bulk_ingest\" on to finish." << std::endl;
+      }
+   }
+   
+   return status;
+}
+
+void ossimGpkgWriter::removeIngestRecord( sqlite3* db,
+                                          const std::string& table,
+                                          ossim_int32 zoomLevel ) const
+{
+   if ( m_resumeIngest )
+   {
+      std::ostringstream sql;
+      sql << "DELETE FROM " << table << " WHERE table_name = '" << m_tileTableName << "'";
+      if ( zoomLevel > -1 )
+      {
+         sql << " AND zoom_level = " << zoomLevel;
+      }
+      ossim_sqlite::exec( db, sql.str() );
+   }
+}
+
+const std::string& ossimGpkgWriter::getInsertTableName() const
+{
+   return m_ingestTableName.size() ? m_ingestTableName : m_tileTableName;
 }
 
 void ossimGpkgWriter::writeCodecTile( sqlite3_stmt* pStmt,
@@ -1535,6 +4044,10 @@ bool ossimGpkgWriter::createTables( sqlite3* db )
                {
                   getTileTableName(m_tileTableName);
                   status = ossimGpkgTileRecord::createTable( db, m_tileTableName );
+                  if ( status && usesWebp() )
+                  {
+                     status = writeGpkgExtensionsTable( db );
+                  }
                }
             }
          }
@@ -1543,6 +4056,41 @@ bool ossimGpkgWriter::createTables( sqlite3* db )
    return status;
 }
 
+bool ossimGpkgWriter::writeGpkgExtensionsTable( sqlite3* db )
+{
+   bool status = false;
+   if ( db )
+   {
+      std::ostringstream sql;
+      sql << "CREATE TABLE IF NOT EXISTS gpkg_extensions ( "
+          << "table_name TEXT, "
+          << "column_name TEXT, "
+          << "extension_name TEXT NOT NULL, "
+          << "definition TEXT NOT NULL, "
+          << "scope TEXT NOT NULL, "
+          << "CONSTRAINT ge_tce UNIQUE (table_name, column_name, extension_name)"
+          << " )";
+      
+      if ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE )
+      {
+         sql.str("");
+         sql << "INSERT OR IGNORE INTO gpkg_extensions VALUES ( "
+             << "'" << m_tileTableName << "', "
+             << "'tile_data', "
+             << "'gpkg_webp', "
+             << "'http://www.geopackage.org/spec/#extension_tiles_webp', "
+             << "'read-write' )";
+         
+         if ( ossim_sqlite::exec( db, sql.str() ) == SQLITE_DONE )
+         {
+            status = true;
+         }
+      }
+   }
+   return status;
+   
+} // End: ossimGpkgWriter::writeGpkgExtensionsTable( ... )
+
 ossim_int32 ossimGpkgWriter::writeGpkgSpatialRefSysTable(
    sqlite3* db, const ossimMapProjection* proj )
 {
@@ -1589,6 +4137,7 @@ bool ossimGpkgWriter::writeGpkgContentsTable( sqlite3* db, const ossimDrect& rec
 
       if ( record.init( m_tileTableName, m_srs_id, minPt, maxPt ) )
       {
+         removeIngestRecord( db, std::string("gpkg_contents"), -1 );
          status = record.insert( db );
       }  
    }
@@ -1606,6 +4155,7 @@ bool ossimGpkgWriter::writeGpkgTileMatrixSetTable( sqlite3* db, const ossimDrect
       
       if ( record.init( m_tileTableName, m_srs_id, minPt, maxPt ) )
       {
+         removeIngestRecord( db, std::string("gpkg_tile_matrix_set"), -1 );
          status = record.insert( db );
       }  
    }
@@ -1624,6 +4174,7 @@ bool ossimGpkgWriter::writeGpkgTileMatrixTable( sqlite3* db,
       ossimGpkgTileMatrixRecord record;
       if ( record.init( m_tileTableName, zoom_level, matrixSize, m_tileSize, gsd ) )
       {
+         removeIngestRecord( db, std::string("gpkg_tile_matrix"), zoom_level );
          status = record.insert( db );
       }  
    }
@@ -1648,6 +4199,7 @@ bool ossimGpkgWriter::writeGpkgNsgTileMatrixExtentTable( sqlite3* db,
       ossimGpkgNsgTileMatrixExtentRecord record;
       if ( record.init( m_tileTableName, zoom_level, imageRect, m_clipRect ) )
       {
+         removeIngestRecord( db, std::string("nsg_tile_matrix_extent"), zoom_level );
          status = record.insert( db );
       } 
    }
@@ -1720,12 +4272,18 @@ void ossimGpkgWriter::setProperty(ossimRefPtr<ossimProperty> property)
            ( key == ALIGN_TO_GRID_KW ) ||
            ( key == APPEND_KW ) ||           
            ( key == BATCH_SIZE_KW ) ||
+           ( key == BULK_INGEST_KW ) ||
+           ( key == CACHE_UNIFORM_TILES_KW ) ||
            ( key == COMPRESSION_LEVEL_KW ) ||
+           ( key == COPY_ENCODED_TILES_KW ) ||
            ( key == ossimKeywordNames::COMPRESSION_QUALITY_KW ) ||
            ( key == EPSG_KW ) ||
            ( key == INCLUDE_BLANK_TILES_KW ) ||
+           ( key == REDUCE_LEVELS_KW ) ||
+           ( key == THREADS_KW ) ||
            ( key == TILE_SIZE_KW ) ||
            ( key == TILE_TABLE_NAME_KW ) ||           
+           ( key == WEBP_LOSSLESS_KW ) ||
            ( key == WRITER_MODE_KW ) ||
            ( key == ZOOM_LEVELS_KW ) )
       {
@@ -1755,12 +4313,18 @@ void ossimGpkgWriter::getPropertyNames(std::vector<ossimString>& propertyNames)c
    propertyNames.push_back(ossimString(ALIGN_TO_GRID_KW));
    propertyNames.push_back(ossimString(APPEND_KW));   
    propertyNames.push_back(ossimString(BATCH_SIZE_KW));
+   propertyNames.push_back(ossimString(BULK_INGEST_KW));
+   propertyNames.push_back(ossimString(CACHE_UNIFORM_TILES_KW));
    propertyNames.push_back(ossimString(COMPRESSION_LEVEL_KW));
+   propertyNames.push_back(ossimString(COPY_ENCODED_TILES_KW));
    propertyNames.push_back(ossimString(ossimKeywordNames::COMPRESSION_QUALITY_KW));
    propertyNames.push_back(ossimString(EPSG_KW));
    propertyNames.push_back(ossimString(INCLUDE_BLANK_TILES_KW));
+   propertyNames.push_back(ossimString(REDUCE_LEVELS_KW));
+   propertyNames.push_back(ossimString(THREADS_KW));
    propertyNames.push_back(ossimString(TILE_SIZE_KW));
    propertyNames.push_back(ossimString(TILE_TABLE_NAME_KW));
+   propertyNames.push_back(ossimString(WEBP_LOSSLESS_KW));
    propertyNames.push_back(ossimString(WRITER_MODE_KW));
    propertyNames.push_back(ossimString(ZOOM_LEVELS_KW));
 
@@ -2648,6 +5212,14 @@ ossim::WriterMode ossimGpkgWriter::getWriterMode() const
       {
          mode = ossim::PNGA;
       }
+      else if ( os == "webp" )
+      {
+         mode = ossim::WEBP;
+      }
+      else if ( os == "jpegwebp" )
+      {
+         mode = ossim::JPEGWEBP;
+      }
    }
    return mode;
 }
@@ -2677,6 +5249,16 @@ std::string ossimGpkgWriter::getWriterModeString( ossim::WriterMode mode ) const
          result = "pnga";
          break;
       }
+      case ossim::WEBP:
+      {
+         result = "webp";
+         break;
+      }
+      case ossim::JPEGWEBP:
+      {
+         result = "jpegwebp";
+         break;
+      }
       case ossim::UNKNOWN:
       default:
       {
@@ -2687,11 +5269,18 @@ std::string ossimGpkgWriter::getWriterModeString( ossim::WriterMode mode ) const
    return result;
 }
 
+bool ossimGpkgWriter::usesWebp() const
+{
+   ossim::WriterMode mode = getWriterMode();
+   return ( ( mode == ossim::WEBP ) || ( mode == ossim::JPEGWEBP ) );
+}
+
 bool ossimGpkgWriter::requiresEightBit() const
 {
    bool result = false;
    ossim::WriterMode mode = getWriterMode();
-   if ( ( mode == ossim::JPEG ) || ( mode == ossim::MIXED ) )
+   if ( ( mode == ossim::JPEG ) || ( mode == ossim::MIXED ) ||
+        ( mode == ossim::WEBP ) || ( mode == ossim::JPEGWEBP ) )
    {
       result = true;
    }
@@ -2954,43 +5543,69 @@ bool ossimGpkgWriter::getFilename( ossimFilename& file ) const
 }
 
 void ossimGpkgWriter::initializeCodec()
+{
+   ossim::WriterMode mode = getWriterMode();
+
+   // Alpha channel needed by codec:
+   m_fullTileCodecAlpha    = ( mode == ossim::PNGA );
+   m_partialTileCodecAlpha = ( ( mode == ossim::PNGA ) || ( mode == ossim::MIXED ) );
+
+   if ( createCodecs( m_fullTileCodec, m_partialTileCodec ) == false )
+   {
+      std::ostringstream errMsg;
+      errMsg << "ossimGpkgWriter::initializeCodec ERROR:\n"
+             << "Unsupported writer mode: " << getWriterModeString( mode )
+             << "\nCheck for ossim png plugin or sqlite plugin built with webp..."
+             << "\n";
+      throw ossimException( errMsg.str() );
+   }
+
+   // Encoded tiles are only good for these codecs.
+   m_uniformTileCache->reset( cacheUniformTiles() );
+}
+
+bool ossimGpkgWriter::createCodecs( ossimRefPtr<ossimCodecBase>& fullTileCodec,
+                                    ossimRefPtr<ossimCodecBase>& partialTileCodec ) const
 {
    ossim::WriterMode mode = getWriterMode();
    if ( mode == ossim::JPEG )
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
-      m_partialTileCodec = m_fullTileCodec.get();
-      m_fullTileCodecAlpha = false;
-      m_partialTileCodecAlpha = false;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
+      partialTileCodec = fullTileCodec.get();
    }
    else if(mode == ossim::PNG)
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("png"));
-      m_partialTileCodec = m_fullTileCodec.get();
-      m_fullTileCodecAlpha = false;
-      m_partialTileCodecAlpha = false;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("png"));
+      partialTileCodec = fullTileCodec.get();
    }
    else if( mode == ossim::PNGA )
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
-      m_partialTileCodec = m_fullTileCodec.get();
-      m_fullTileCodecAlpha = true;
-      m_partialTileCodecAlpha = true;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
+      partialTileCodec = fullTileCodec.get();
    }
    else if( mode == ossim::MIXED )
    {
-      m_fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
-      m_partialTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
-      m_fullTileCodecAlpha = false;
-      m_partialTileCodecAlpha = true;
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
+      partialTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("pnga"));
+   }
+   else if( mode == ossim::WEBP )
+   {
+      // Full tiles need no alpha channel.
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("webp"));
+      partialTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("webpa"));
+   }
+   else if( mode == ossim::JPEGWEBP )
+   {
+      fullTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("jpeg"));
+      partialTileCodec = ossimCodecFactoryRegistry::instance()->createCodec(ossimString("webpa"));
    }
    else
    {
-      m_fullTileCodec = 0;
-      m_partialTileCodec = 0;
+      fullTileCodec = 0;
+      partialTileCodec = 0;
    }
 
-   if ( m_fullTileCodec.valid() &&  m_partialTileCodec.valid() )
+   if ( fullTileCodec.valid() &&  partialTileCodec.valid() )
    {
       // Note: This will only take for jpeg.  Png uses compression_level and need to add.      
       ossim_uint32 quality = getCompressionQuality();
@@ -2998,18 +5613,19 @@ void ossimGpkgWriter::initializeCodec()
       {
          quality = (ossim_uint32)ossimGpkgWriter::DEFAULT_JPEG_QUALITY;
       }
-      m_fullTileCodec->setProperty("quality", ossimString::toString(quality));
-      m_partialTileCodec->setProperty("quality", ossimString::toString(quality));
-   }
-   else
-   {
-      std::ostringstream errMsg;
-      errMsg << "ossimGpkgWriter::initializeCodec ERROR:\n"
-             << "Unsupported writer mode: " << getWriterModeString( mode )
-             << "\nCheck for ossim png plugin..."
-             << "\n";
-      throw ossimException( errMsg.str() );
+      fullTileCodec->setProperty("quality", ossimString::toString(quality));
+      partialTileCodec->setProperty("quality", ossimString::toString(quality));
+
+      if ( usesWebp() && keyIsTrue( WEBP_LOSSLESS_KW ) )
+      {
+         // Only the webp codecs know "lossless".
+         fullTileCodec->setProperty("lossless", TRUE_KW);
+         partialTileCodec->setProperty("lossless", TRUE_KW);
+      }
+      return true;
    }
+
+   return false;
 }
 
 bool ossimGpkgWriter::getWmsCutBox( ossimDrect& rect ) const
@@ -20,11 +20,17 @@
 #include <ossim/base/ossimKeywordlist.h>
 #include <ossim/base/ossimRefPtr.h>
 #include <ossim/imaging/ossimCodecBase.h>
+#include <set>
+#include <utility>
 #include <vector>
 
 // Forward class declarations.
 class ossimDpt;
+class ossimGpkgReader;
+class ossimGpkgTileEntry;
+class ossimGpkgTileMatrixRecord;
 class ossimImageData;
+class ossimImageSource;
 class ossimIrect;
 struct jpeg_compress_struct;
 struct sqlite3;
@@ -166,7 +172,8 @@ public:
     * epsg: 4326, 3857
     * filename: output_file.gpkg
     * tile_table_name: default="tiles"
-    * writer_mode: mixed(default), jpeg, png, pnga
+    * writer_mode: mixed(default), jpeg, png, pnga, webp, jpegwebp
+    * webp_lossless: bool, default=false.  Lossless webp tiles.
     * 
     * 
     * @param options.  Keyword list containing all options.
@@ -184,6 +191,11 @@ public:
     * jpeg
     * png
     * pnga
+    * webp     (partial tiles with alpha)
+    * jpegwebp (full tiles jpeg, partial tiles webp with alpha)
+    * 
+    * The webp modes need the sqlite plugin built with libwebp and a three
+    * band input.
     * 
     * @return Writer mode.  Default mode = jpeg.
     */
@@ -280,6 +292,13 @@ private:
    
    bool createTables( sqlite3* db );
 
+   /**
+    * @brief Registers the GeoPackage WebP extension ("gpkg_webp") for the
+    * tile table in gpkg_extensions, creating the table if needed.
+    * @return true on success, false on error.
+    */
+   bool writeGpkgExtensionsTable( sqlite3* db );
+
    /**
     * @return the "srs_id" number pointing to the
     * gpkg_spatial_ref_sys record for our projection.
@@ -336,6 +355,278 @@ private:
                    ossim_int32 zoomLevel,
                    ossim_int64 row,
                    ossim_int64 col);
+
+   /**
+    * @brief Threaded version of the writeTiles loop.
+    *
+    * Each source in sources is read and encoded on its own thread.  Encoded
+    * tiles go through a bounded queue to the calling thread which is the
+    * only one to touch db; it does the batched inserts.
+    *
+    * Throws ossimException on error.
+    *
+    * @param sources Independent input chains, one per encoding thread.
+    */
+   void writeTilesThreaded( sqlite3* db,
+                            sqlite3_stmt* pStmt,
+                            const ossimIrect& aoi,
+                            ossim_int32 zoomLevel,
+                            ossim_int64 rows,
+                            ossim_int64 cols,
+                            bool writeBlanks,
+                            std::vector< ossimRefPtr<ossimImageSource> >& sources,
+                            const ossim_float64& totalTiles,
+                            ossim_float64& tilesWritten );
+
+   /**
+    * @brief Encodes tile with the full or partial codec depending on the
+    * tile status, computing the alpha channel first if needed.
+    *
+    * Tiles that are a single value in each band are encoded once and then
+    * copied from the uniform tile cache.  Option key "cache_uniform_tiles"
+    * (default=true) turns this off.
+    * 
+    * @return true on success.
+    */
+   bool encodeTile( ossimRefPtr<ossimImageData>& tile,
+                    ossimCodecBase* fullTileCodec,
+                    ossimCodecBase* partialTileCodec,
+                    std::vector<ossim_uint8>& codecTile ) const;
+
+   /**
+    * @brief Makes independent copies of the sequencer input for encoding
+    * threads.
+    *
+    * Only chains, image handlers, or either of those behind the scalar
+    * remapper added by writeFile are recreated from their state, and only
+    * if the copies match the input's bounds, band count and scalar type.
+    *
+    * @param count Number of copies wanted.
+    * @param clones Initialized by this.  Left empty if the input cannot be
+    * copied.
+    */
+   void cloneInputChains( ossim_uint32 count,
+                          std::vector< ossimRefPtr<ossimImageSource> >& clones ) const;
+
+   struct EncodedTile;
+   class EncodedTileQueue;
+   struct PyramidLevel;
+   class UniformTileCache;
+   class StoredTileReader;
+
+   /** Tile column, row pairs. */
+   typedef std::set< std::pair<ossim_int32, ossim_int32> > TileSet;
+
+   /**
+    * @brief Inserts an encoded tile using the batched transactions.  Tiles
+    * without data are skipped.
+    */
+   void insertEncodedTile( sqlite3* db,
+                           sqlite3_stmt* pStmt,
+                           EncodedTile& tile );
+
+   /**
+    * @brief Inserts tiles from queue until all producers are done.  Closes
+    * queue if the process is aborted.
+    * @param progressInterval Number of tiles between percent complete
+    * updates.
+    */
+   void drainEncodedTiles( sqlite3* db,
+                           sqlite3_stmt* pStmt,
+                           EncodedTileQueue& queue,
+                           ossim_int64 progressInterval,
+                           const ossim_float64& totalTiles,
+                           ossim_float64& tilesWritten );
+
+   /**
+    * @brief Writes all zoom levels reading only the full res level from the
+    * input.  Each coarser tile is a 2x2 box reduction of the four tiles
+    * under it, built depth first so only a few tiles per level are held.
+    *
+    * Only done if the levels are consecutive and each tile matrix is
+    * exactly twice the size of the one above it.  Option key
+    * "reduce_levels" (default=true) turns this off.
+    *
+    * Throws ossimException on error.
+    *
+    * @return true if levels were written, false if levels do not nest, in
+    * which case nothing was written and proj is untouched.
+    */
+   bool writeReducedZoomLevels( sqlite3* db,
+                                ossimMapProjection* proj,
+                                const std::vector<ossim_int32>& zoomLevels );
+
+   /**
+    * @brief Builds, encodes and queues the tile at levels[levelIndex]
+    * row/col and everything under it.
+    * @return The tile or null if no data.  Null if queue was closed.
+    */
+   ossimRefPtr<ossimImageData> buildPyramidTile( const std::vector<PyramidLevel>& levels,
+                                                 ossim_uint32 levelIndex,
+                                                 ossim_int64 row,
+                                                 ossim_int64 col,
+                                                 ossimImageSource* source,
+                                                 ossimCodecBase* fullTileCodec,
+                                                 ossimCodecBase* partialTileCodec,
+                                                 bool writeBlanks,
+                                                 EncodedTileQueue& queue ) const;
+
+   /**
+    * @brief Writes all zoom levels by copying the encoded tiles of a
+    * GeoPackage input as is, without decoding and encoding them.
+    *
+    * Only done if the input is a single ossimGpkgReader through pass through
+    * filters and its current entry has the same srs, tile matrix set, tile
+    * size and, for each level, zoom level, matrix size and gsd as the
+    * output.  Tiles the clip rect cuts through and tiles missing from the
+    * source are read from the input as usual.  Blobs not in an encoding
+    * "writer_mode" produces, e.g. png with alpha in png mode, are
+    * transcoded.  Option key "copy_encoded_tiles" (default=true) turns this
+    * off.
+    *
+    * @return true if levels were written, false if the input is not
+    * compatible, in which case nothing was written and proj is untouched.
+    */
+   bool copyEncodedZoomLevels( sqlite3* db,
+                               ossimMapProjection* proj,
+                               const std::vector<ossim_int32>& zoomLevels );
+
+   /**
+    * @return The GeoPackage reader feeding the input if nothing between it
+    * and this writer changes pixels, else null.
+    */
+   ossimGpkgReader* getEncodedTileSource() const;
+
+   /**
+    * @brief Updates an existing entry with the input in place.  Used for
+    * option key "append" when the tile table already has an entry.
+    *
+    * Only tiles touched by the input are read, composited and rewritten;
+    * new pixels go over the stored tile where they are not null.  Coarser
+    * levels only rewrite parents of changed tiles, reduced from their four
+    * stored children when the levels nest, else read from the input like
+    * the finest level.  Input outside the tile matrix set is clipped.
+    *
+    * Throws ossimException on error.
+    *
+    * @return true on success.
+    */
+   bool updateEntry( const ossimGpkgTileEntry& entry );
+
+   /**
+    * @brief Reads the input over the tiles of level it touches, composites
+    * them over the stored tiles and writes them.
+    * @param proj Output projection.  Gsd and tie are set to the level.
+    * @param changed Initialized with the tiles written.
+    */
+   void updateTilesFromInput( sqlite3* db,
+                              sqlite3_stmt* pStmt,
+                              StoredTileReader& stored,
+                              ossimMapProjection* proj,
+                              const ossimGpkgTileMatrixRecord& level,
+                              bool writeBlanks,
+                              TileSet& changed );
+
+   /**
+    * @brief Rewrites parents, tiles of level, reduced from their four
+    * children in childLevel.
+    */
+   void updateParentTiles( sqlite3* db,
+                           sqlite3_stmt* pStmt,
+                           StoredTileReader& stored,
+                           const ossimGpkgTileMatrixRecord& childLevel,
+                           const ossimGpkgTileMatrixRecord& level,
+                           bool writeBlanks,
+                           const TileSet& parents );
+
+   /** @return Option key "reduce_levels", default=true. */
+   bool reduceLevels() const;
+
+   /** @return Option key "cache_uniform_tiles", default=true. */
+   bool cacheUniformTiles() const;
+
+   /** @return Option key "copy_encoded_tiles", default=true. */
+   bool copyEncodedTiles() const;
+
+   /**
+    * @brief Gets the number of encoding threads from option key "threads".
+    * 0 = number of cores.  default = 1, which disables threaded writing.
+    */
+   ossim_uint32 getNumberOfThreads() const;
+
+   /**
+    * @return Option key "bulk_ingest", default=false.
+    *
+    * In bulk ingest mode tiles go to an unindexed staging table,
+    * "<tile_table_name>_ingest", with a large page cache.  Each zoom level
+    * that is finished is recorded in the "ossim_gpkg_ingest" table.  When
+    * all levels are done the staging table gets its key index and is moved
+    * into the tile table in key order.
+    *
+    * If a bulk ingest is killed, running it again on the same file picks
+    * up from the last finished level instead of starting over.  With
+    * reduced levels the whole pyramid counts as one level.
+    */
+   bool bulkIngest() const;
+
+   /** @brief Gets the bulk ingest staging table name. */
+   void getIngestTableName( std::string& ingestTableName ) const;
+
+   /**
+    * @return true if theFilename has a bulk ingest staging table for the
+    * tile table, passes an integrity check and was left by the same job,
+    * i.e. it can be resumed.
+    */
+   bool canResumeIngest() const;
+
+   /**
+    * @brief Sets up the staging and progress tables, and on resume loads
+    * the finished levels and deletes staging rows of unfinished levels.
+    * A staging table left by a different job is dropped and the ingest
+    * starts over.
+    * @return true on success.
+    */
+   bool beginIngest( sqlite3* db );
+
+   /**
+    * @brief Gets the text identifying this bulk ingest job: area of
+    * interest, tiling and codec options, and input images.
+    */
+   void getIngestFingerprint( std::string& fingerprint ) const;
+
+   /**
+    * @brief Gets the job fingerprint stored for tileTableName.
+    * @return true if there is one.
+    */
+   bool getStoredIngestFingerprint( sqlite3* db,
+                                    const std::string& tileTableName,
+                                    std::string& fingerprint ) const;
+
+   /** @brief Commits the open batch and records zoomLevel as finished. */
+   void checkpointIngest( sqlite3* db, ossim_int32 zoomLevel );
+
+   /** @return true if zoomLevel was finished by a previous bulk ingest. */
+   bool isLevelIngested( ossim_int32 zoomLevel ) const;
+
+   /**
+    * @brief Indexes the staging table and moves it into the tile table one
+    * column at a time so freed pages get reused.  Each column is its own
+    * journaled transaction so this can also be resumed.
+    * @return true on success.
+    */
+   bool finishIngest( sqlite3* db );
+
+   /**
+    * @brief On resume, removes the record a killed ingest already wrote to
+    * a gpkg metadata table so it can be written again.
+    * @param zoomLevel Zoom level of record or -1 if table has no zoom level.
+    */
+   void removeIngestRecord( sqlite3* db,
+                            const std::string& table,
+                            ossim_int32 zoomLevel ) const;
+
+   /** @return Table to insert tiles into, staging or tile table. */
+   const std::string& getInsertTableName() const;
    
 /*
    void writeJpegTiles( sqlite3* db,
@@ -533,6 +824,9 @@ private:
 
    bool requiresEightBit() const;
 
+   /** @return true if writer mode is webp or jpegwebp. */
+   bool usesWebp() const;
+
    ossim_uint32 getEpsgCode() const;
 
    /**
@@ -573,6 +867,14 @@ private:
     */
    void initializeCodec();
 
+   /**
+    * @brief Creates a full and partial tile codec for the writer mode.
+    * Used by initializeCodec and for each encoding thread.
+    * @return true if both codecs were created.
+    */
+   bool createCodecs( ossimRefPtr<ossimCodecBase>& fullTileCodec,
+                      ossimRefPtr<ossimCodecBase>& partialTileCodec ) const;
+
    /**
     * @brief Initializes the output gpkg file.  This method is used for
     * non-connected writing, e.g. openFile(...), writeTile(...)
@@ -715,6 +1017,18 @@ private:
    /** Controlled by option key: "include_blank_tiles" */
    bool m_writeBlanks;
 
+   /** Encoded uniform tiles shared by all encoding threads. */
+   UniformTileCache* m_uniformTileCache;
+
+   /** Bulk ingest staging table; empty if not bulk ingesting. */
+   std::string m_ingestTableName;
+
+   /** true if bulk ingest found a staging table from a killed run. */
+   bool m_resumeIngest;
+
+   /** Zoom levels finished by a previous bulk ingest. */
+   std::vector<ossim_int32> m_ingestedLevels;
+
    TYPE_DATA
 };
 
@@ -27,7 +27,9 @@ namespace ossim
       PNGA     = 3,  // PNG with alpha
       MIXED    = 4,  // full tiles=jpeg, partials=pnga
       JPEGPNGA = 4,  // full tiles=jpeg, partials=pnga(same as mixed)
-      JPEGPNG  = 5   // full tiles=jpeg, partials=png
+      JPEGPNG  = 5,  // full tiles=jpeg, partials=png
+      WEBP     = 6,  // WebP, partials with alpha
+      JPEGWEBP = 7   // full tiles=jpeg, partials=webp with alpha
    };
    
 } // End: namespace ossim
@@ -15,6 +15,10 @@
 #include <ossim/plugin/ossimPluginConstants.h>
 #include "ossimSqliteReaderFactory.h"
 #include "ossimSqliteWriterFactory.h"
+#if OSSIM_HAS_WEBP
+#  include "ossimWebpCodecFactory.h"
+#  include <ossim/imaging/ossimCodecFactoryRegistry.h>
+#endif
 #include <ossim/imaging/ossimImageHandlerRegistry.h>
 #include <ossim/imaging/ossimImageWriterFactoryRegistry.h>
 #include <ossim/support_data/ossimInfoFactoryRegistry.h>
@@ -73,10 +77,19 @@ extern "C"
       ossimImageWriterFactoryRegistry::instance()->
          registerFactory(ossimSqliteWriterFactory::instance());
       
+#if OSSIM_HAS_WEBP
+      /* Register the WebP tile codec... */
+      ossimCodecFactoryRegistry::instance()->
+         registerFactory(ossimWebpCodecFactory::instance());
+#endif
+      
       setSqliteDescription(theSqliteDescription);
       ossimSqliteReaderFactory::instance()->getTypeNameList(theSqliteObjList);
       ossimSqliteWriterFactory::instance()->getTypeNameList(theSqliteObjList);
       theSqliteObjList.push_back("ossimGpkgInfo");
+#if OSSIM_HAS_WEBP
+      theSqliteObjList.push_back("ossimWebpCodec");
+#endif
   }
 
    /* Note symbols need to be exported on windoze... */ 
@@ -90,5 +103,10 @@ extern "C"
         
      ossimImageWriterFactoryRegistry::instance()->
         unregisterFactory(ossimSqliteWriterFactory::instance());
+
+#if OSSIM_HAS_WEBP
+     ossimCodecFactoryRegistry::instance()->
+        unregisterFactory(ossimWebpCodecFactory::instance());
+#endif
   }
 }
@@ -0,0 +1,278 @@
+//----------------------------------------------------------------------------
+//
+// File: ossimWebpCodec.cpp
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: WebP codec(encoder/decoder) for GeoPackage tiles.
+//
+//----------------------------------------------------------------------------
+// $Id$
+
+#include "ossimWebpCodec.h"
+#include <ossim/base/ossimBooleanProperty.h>
+#include <ossim/base/ossimConstants.h>
+#include <ossim/base/ossimIrect.h>
+#include <ossim/base/ossimKeywordlist.h>
+#include <ossim/base/ossimNumericProperty.h>
+#include <ossim/imaging/ossimImageData.h>
+
+#include <webp/decode.h>
+#include <webp/encode.h>
+
+static const char ADD_ALPHA_CHANNEL_KW[] = "add_alpha_channel";
+static const char LOSSLESS_KW[]          = "lossless";
+static const char QUALITY_KW[]           = "quality";
+
+static const ossim_float32 DEFAULT_QUALITY = 75.0;
+
+ossimWebpCodec::ossimWebpCodec( bool addAlpha )
+   : m_addAlphaChannel( addAlpha ),
+     m_lossless( false ),
+     m_quality( DEFAULT_QUALITY ),
+     m_ext( "webp" )
+{
+}
+
+ossimString ossimWebpCodec::getCodecType()const
+{
+   return "webp";
+}
+
+const std::string& ossimWebpCodec::getExtension() const
+{
+   return m_ext; // "webp"
+}
+
+bool ossimWebpCodec::encode( const ossimRefPtr<ossimImageData>& in,
+                             std::vector<ossim_uint8>& out ) const
+{
+   out.clear();
+
+   if ( !in.valid() || !in->getBuf() || ( in->getScalarType() != OSSIM_UINT8 ) )
+   {
+      return false;
+   }
+
+   const ossim_uint32 BANDS = in->getNumberOfBands();
+   if ( ( BANDS != 1 ) && ( BANDS != 3 ) )
+   {
+      return false;
+   }
+
+   const int W = (int)in->getWidth();
+   const int H = (int)in->getHeight();
+   const ossim_uint32 PIXELS   = (ossim_uint32)( W * H );
+   const ossim_uint32 CHANNELS = m_addAlphaChannel ? 4 : 3;
+
+   // One band goes out as gray rgb.
+   const ossim_uint8* r = in->getUcharBuf( 0 );
+   const ossim_uint8* g = ( BANDS == 3 ) ? in->getUcharBuf( 1 ) : r;
+   const ossim_uint8* b = ( BANDS == 3 ) ? in->getUcharBuf( 2 ) : r;
+   const ossim_uint8 NR = (ossim_uint8)in->getNullPix( 0 );
+   const ossim_uint8 NG = (ossim_uint8)in->getNullPix( ( BANDS == 3 ) ? 1 : 0 );
+   const ossim_uint8 NB = (ossim_uint8)in->getNullPix( ( BANDS == 3 ) ? 2 : 0 );
+
+   std::vector<ossim_uint8> buf( PIXELS * CHANNELS );
+   ossim_uint8* p = &buf.front();
+   for ( ossim_uint32 i = 0; i < PIXELS; ++i )
+   {
+      p[0] = r[i];
+      p[1] = g[i];
+      p[2] = b[i];
+      if ( m_addAlphaChannel )
+      {
+         // Null where all bands are null.
+         p[3] = ( ( r[i] == NR ) && ( g[i] == NG ) && ( b[i] == NB ) ) ? 0 : 255;
+      }
+      p += CHANNELS;
+   }
+
+   uint8_t* encoded = 0;
+   size_t size = 0;
+   const int STRIDE = W * (int)CHANNELS;
+   if ( m_lossless )
+   {
+      size = m_addAlphaChannel ?
+         WebPEncodeLosslessRGBA( &buf.front(), W, H, STRIDE, &encoded ) :
+         WebPEncodeLosslessRGB( &buf.front(), W, H, STRIDE, &encoded );
+   }
+   else
+   {
+      size = m_addAlphaChannel ?
+         WebPEncodeRGBA( &buf.front(), W, H, STRIDE, m_quality, &encoded ) :
+         WebPEncodeRGB( &buf.front(), W, H, STRIDE, m_quality, &encoded );
+   }
+
+   if ( size && encoded )
+   {
+      out.assign( encoded, encoded + size );
+   }
+   WebPFree( encoded );
+
+   return ( out.size() != 0 );
+}
+
+bool ossimWebpCodec::decode( const std::vector<ossim_uint8>& in,
+                             ossimRefPtr<ossimImageData>& out ) const
+{
+   WebPBitstreamFeatures features;
+   if ( in.empty() ||
+        ( WebPGetFeatures( &in.front(), in.size(), &features ) != VP8_STATUS_OK ) )
+   {
+      return false;
+   }
+
+   const ossim_uint32 W        = (ossim_uint32)features.width;
+   const ossim_uint32 H        = (ossim_uint32)features.height;
+   const ossim_uint32 PIXELS   = W * H;
+   const ossim_uint32 CHANNELS = features.has_alpha ? 4 : 3;
+   const int STRIDE = (int)( W * CHANNELS );
+
+   std::vector<ossim_uint8> buf( PIXELS * CHANNELS );
+   uint8_t* decoded = features.has_alpha ?
+      WebPDecodeRGBAInto( &in.front(), in.size(), &buf.front(), buf.size(), STRIDE ) :
+      WebPDecodeRGBInto( &in.front(), in.size(), &buf.front(), buf.size(), STRIDE );
+   if ( !decoded )
+   {
+      return false;
+   }
+
+   if ( !out.valid() )
+   {
+      out = new ossimImageData( 0, OSSIM_UINT8, 3, W, H );
+      out->initialize();
+   }
+   else
+   {
+      out->setNumberOfDataComponents( 3 );
+      out->setImageRectangleAndBands( ossimIrect( 0, 0, W-1, H-1 ), 3 );
+      out->initialize();
+   }
+
+   ossim_uint8* r = out->getUcharBuf( 0 );
+   ossim_uint8* g = out->getUcharBuf( 1 );
+   ossim_uint8* b = out->getUcharBuf( 2 );
+   const ossim_uint8 NR = (ossim_uint8)out->getNullPix( 0 );
+   const ossim_uint8 NG = (ossim_uint8)out->getNullPix( 1 );
+   const ossim_uint8 NB = (ossim_uint8)out->getNullPix( 2 );
+
+   const ossim_uint8* p = &buf.front();
+   for ( ossim_uint32 i = 0; i < PIXELS; ++i )
+   {
+      if ( features.has_alpha && ( p[3] == 0 ) )
+      {
+         // Lossy alpha does not keep the rgb under transparent pixels.
+         r[i] = NR;
+         g[i] = NG;
+         b[i] = NB;
+      }
+      else
+      {
+         r[i] = p[0];
+         g[i] = p[1];
+         b[i] = p[2];
+      }
+      p += CHANNELS;
+   }
+
+   out->validate();
+
+   return true;
+}
+
+void ossimWebpCodec::setProperty(ossimRefPtr<ossimProperty> property)
+{
+   if ( property.valid() )
+   {
+      if ( property->getName() == ADD_ALPHA_CHANNEL_KW )
+      {
+         m_addAlphaChannel = property->valueToString().toBool();
+      }
+      else if ( property->getName() == LOSSLESS_KW )
+      {
+         m_lossless = property->valueToString().toBool();
+      }
+      else if ( property->getName() == QUALITY_KW )
+      {
+         ossim_float32 quality = property->valueToString().toFloat32();
+         if ( ( quality >= 0.0 ) && ( quality <= 100.0 ) )
+         {
+            m_quality = quality;
+         }
+      }
+      else
+      {
+         ossimCodecBase::setProperty(property);
+      }
+   }
+}
+
+ossimRefPtr<ossimProperty> ossimWebpCodec::getProperty(const ossimString& name)const
+{
+   ossimRefPtr<ossimProperty> result;
+
+   if ( name == ADD_ALPHA_CHANNEL_KW )
+   {
+      result = new ossimBooleanProperty( name, m_addAlphaChannel );
+   }
+   else if ( name == LOSSLESS_KW )
+   {
+      result = new ossimBooleanProperty( name, m_lossless );
+   }
+   else if ( name == QUALITY_KW )
+   {
+      result = new ossimNumericProperty( name, ossimString::toString( m_quality ), 0.0, 100.0 );
+   }
+   else
+   {
+      result = ossimCodecBase::getProperty(name);
+   }
+
+   return result;
+}
+
+void ossimWebpCodec::getPropertyNames(std::vector<ossimString>& propertyNames)const
+{
+   propertyNames.push_back(ADD_ALPHA_CHANNEL_KW);
+   propertyNames.push_back(LOSSLESS_KW);
+   propertyNames.push_back(QUALITY_KW);
+}
+
+bool ossimWebpCodec::loadState(const ossimKeywordlist& kwl, const char* prefix)
+{
+   ossimString value = kwl.find(prefix, ADD_ALPHA_CHANNEL_KW);
+   if ( !value.empty() )
+   {
+      m_addAlphaChannel = value.toBool();
+   }
+
+   value = kwl.find(prefix, LOSSLESS_KW);
+   if ( !value.empty() )
+   {
+      m_lossless = value.toBool();
+   }
+
+   value = kwl.find(prefix, QUALITY_KW);
+   if ( !value.empty() )
+   {
+      ossim_float32 quality = value.toFloat32();
+      if ( ( quality >= 0.0 ) && ( quality <= 100.0 ) )
+      {
+         m_quality = quality;
+      }
+   }
+
+   return ossimCodecBase::loadState(kwl, prefix);
+}
+
+bool ossimWebpCodec::saveState(ossimKeywordlist& kwl, const char* prefix)const
+{
+   kwl.add(prefix, ADD_ALPHA_CHANNEL_KW, m_addAlphaChannel);
+   kwl.add(prefix, LOSSLESS_KW, m_lossless);
+   kwl.add(prefix, QUALITY_KW, m_quality);
+
+   return ossimCodecBase::saveState(kwl, prefix);
+}
@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------------
+//
+// File: ossimWebpCodec.h
+//
+// License:  LGPL
+//
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: WebP codec(encoder/decoder) for GeoPackage tiles.
+//
+//----------------------------------------------------------------------------
+// $Id$
+#ifndef ossimWebpCodec_HEADER
+#define ossimWebpCodec_HEADER 1
+
+#include <ossim/imaging/ossimCodecBase.h>
+#include <string>
+
+/**
+ * @class ossimWebpCodec
+ *
+ * Eight bit, one or three band tiles.  One band input is written as gray
+ * RGB; decoded tiles are always three band.  With the alpha channel on,
+ * null pixels are written fully transparent and come back as null.
+ *
+ * Properties:
+ * - "quality" 0 to 100, lossy mode only, default 75.
+ * - "lossless" default false.
+ * - "add_alpha_channel" default false.
+ */
+class ossimWebpCodec : public ossimCodecBase
+{
+public:
+   ossimWebpCodec( bool addAlpha=false );
+
+   /** @return "webp" */
+   virtual ossimString getCodecType()const;
+
+   /**
+    * @brief Encode webp method.
+    * @param in Input data to encode.
+    * @param out Encoded output data.
+    * @return true on success, false on failure or unsupported input.
+    */
+   virtual bool encode( const ossimRefPtr<ossimImageData>& in,
+                        std::vector<ossim_uint8>& out ) const;
+
+   /**
+    * @brief Decode webp method.
+    *
+    * @param in Input data to decode.
+    * @param out Output tile.  If the pointer to ossimImageData is null
+    * internally it will be created.
+    *
+    * @note Caller should set "out's" image rectangle upon successful
+    * decode.
+    *
+    * @return true on success, false on failure.
+    */
+   virtual bool decode( const std::vector<ossim_uint8>& in,
+                        ossimRefPtr<ossimImageData>& out ) const;
+
+   /** @return "webp" */
+   virtual const std::string& getExtension() const;
+
+   virtual void setProperty(ossimRefPtr<ossimProperty> property);
+
+   virtual ossimRefPtr<ossimProperty> getProperty(const ossimString& name)const;
+
+   virtual void getPropertyNames(std::vector<ossimString>& propertyNames)const;
+
+   virtual bool loadState(const ossimKeywordlist& kwl, const char* prefix=0);
+
+   virtual bool saveState(ossimKeywordlist& kwl, const char* prefix=0)const;
+
+protected:
+   bool          m_addAlphaChannel;
+   bool          m_lossless;
+   ossim_float32 m_quality;
+   std::string   m_ext;
+};
+
+#endif /* #ifndef ossimWebpCodec_HEADER */
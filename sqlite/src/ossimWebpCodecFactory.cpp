@@ -0,0 +1,84 @@
+//----------------------------------------------------------------------------
+//
+// File: ossimWebpCodecFactory.cpp
+//
+// License:  LGPL
+// 
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: Factory for the WebP codec(encoder/decoder).
+// 
+//----------------------------------------------------------------------------
+// $Id$
+
+#include "ossimWebpCodecFactory.h"
+#include "ossimWebpCodec.h"
+#include <ossim/base/ossimKeywordlist.h>
+#include <ossim/base/ossimKeywordNames.h>
+#include <ossim/base/ossimRefPtr.h>
+#include <ossim/base/ossimString.h>
+
+ossimWebpCodecFactory* ossimWebpCodecFactory::m_instance = 0;
+
+ossimWebpCodecFactory::~ossimWebpCodecFactory()
+{}
+
+ossimWebpCodecFactory* ossimWebpCodecFactory::instance()
+{
+   if ( !m_instance )
+   {
+      m_instance = new ossimWebpCodecFactory();
+   }
+   return m_instance;
+}
+
+ossimCodecBase* ossimWebpCodecFactory::createCodec(const ossimString& type)const
+{
+   ossimRefPtr<ossimWebpCodec> result;
+   ossimString tempType = type.downcase();
+   if ( ( tempType == "webp" ) || ( tempType == "ossimwebpcodec" ) )
+   {
+      result = new ossimWebpCodec();
+   }
+   else if ( tempType == "webpa" )
+   {
+      result = new ossimWebpCodec(true);
+   }
+
+   return result.release();
+}
+
+ossimCodecBase* ossimWebpCodecFactory::createCodec(const ossimKeywordlist& kwl, const char* prefix)const
+{
+   ossimString type = kwl.find(prefix, ossimKeywordNames::TYPE_KW);
+   ossimCodecBase* result = 0;
+   if(!type.empty())
+   {
+      result = this->createCodec(type);
+      if(result)
+      {
+         result->loadState(kwl, prefix);
+      }
+   }
+
+   return result;
+}
+
+void ossimWebpCodecFactory::getTypeNameList(std::vector<ossimString>& typeNames)const
+{
+   typeNames.push_back("webp");
+   typeNames.push_back("webpa");
+   typeNames.push_back("ossimWebpCodec");
+}
+
+ossimWebpCodecFactory::ossimWebpCodecFactory()
+{}
+
+ossimWebpCodecFactory::ossimWebpCodecFactory(const ossimWebpCodecFactory& /* obj */ )
+{}
+
+const ossimWebpCodecFactory& ossimWebpCodecFactory::operator=(
+   const ossimWebpCodecFactory& /* rhs */)
+{
+   return *this;
+}
@@ -0,0 +1,71 @@
+//----------------------------------------------------------------------------
+//
+// File: ossimWebpCodecFactory.h
+//
+// License:  LGPL
+// 
+// See LICENSE.txt file in the top level directory for more details.
+//
+// Description: Factory for the WebP codec(encoder/decoder).
+// 
+//----------------------------------------------------------------------------
+// $Id$
+#ifndef ossimWebpCodecFactory_HEADER
+#define ossimWebpCodecFactory_HEADER 1
+
+#include <ossim/imaging/ossimCodecFactoryInterface.h>
+
+class ossimCodecBase;
+
+/**
+ * @brief WebP codec factory.  Types "webp" and "webpa"(alpha channel).
+ */
+class ossimWebpCodecFactory : public ossimCodecFactoryInterface
+{
+public:
+
+   /** virtual destructor */
+   virtual ~ossimWebpCodecFactory();
+
+   /**
+   * @return instance
+   */
+   static ossimWebpCodecFactory* instance();
+
+   /**
+   * createCodec takes a type and will return a new codec to encode decode image buffers
+   *
+   * @param in type.  Type identifer used to allocate the proper codec.
+   * @return ossimCodecBase type.
+   */
+   virtual ossimCodecBase* createCodec(const ossimString& type)const;
+
+
+   /**
+   * createCodec takes a type in the keywordlist and will return a new codec to encode decode image buffers
+   *
+   * @param in kwl.  Type identifer used to allocate the proper codec.
+   * @param in prefix.  prefix used to prefix keywords during the construction
+   *                    of the codec
+   * @return ossimCodecBase type.
+   */
+   virtual ossimCodecBase* createCodec(const ossimKeywordlist& kwl, const char* prefix=0)const;
+
+   virtual void getTypeNameList(std::vector<ossimString>& typeNames)const;
+   
+private:
+   
+   /** hidden from use default constructor */
+   ossimWebpCodecFactory();
+
+   /** hidden from use copy constructor */
+   ossimWebpCodecFactory(const ossimWebpCodecFactory& obj);
+
+   /** hidden from use operator = */
+   const ossimWebpCodecFactory& operator=(const ossimWebpCodecFactory& rhs);
+
+   /** The single instance of this class. */
+   static ossimWebpCodecFactory* m_instance;
+};
+
+#endif /* End of "#ifndef ossimWebpCodecFactory_HEADER" */